@@ -18,6 +18,8 @@ struct test_bmi_c_model {
     double current_model_time;
     double model_end_time;
     int time_step_size;
+    // Whether the extra variables INPUT_VAR_3, INPUT_VAR_4, INPUT_VAR_5, and OUTPUT_VAR_3 are used
+    int use_extra_vars;
 
     // ***********************************************************
     // ******************* Dynamic allocations *******************
@@ -28,9 +30,18 @@ struct test_bmi_c_model {
     double* output_var_1;
     double* output_var_2;
 
+    // Extra variables, only allocated when used
+    int* input_var_3;
+    double* input_var_4;
+    double* input_var_5;
+    double* output_var_3;
+
     int param_var_1;
     double param_var_2;
     double* param_var_3;
+
+    // Buffer of the serialized model state, between "serialization_create" and "serialization_free"
+    double* serialized_state;
 };
 typedef struct test_bmi_c_model test_bmi_c_model;
 
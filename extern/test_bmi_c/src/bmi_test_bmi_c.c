@@ -6,25 +6,31 @@
 #define DEFAULT_TIME_STEP_SIZE 3600
 #define DEFAULT_TIME_STEP_COUNT 24
 
-#define INPUT_VAR_NAME_COUNT 2
-#define OUTPUT_VAR_NAME_COUNT 2
+#define INPUT_VAR_NAME_COUNT 5
+#define OUTPUT_VAR_NAME_COUNT 3
+// Variables past these counts are only used when the "use_extra_vars" config param is set
+#define BASE_INPUT_VAR_NAME_COUNT 2
+#define BASE_OUTPUT_VAR_NAME_COUNT 2
 #define PARAM_VAR_NAME_COUNT 3
 
+// Serialized state: current time, the input and output values, and the parameters (PARAM_VAR_1 as a double)
+#define SERIALIZED_STATE_COUNT 9
+
 // Don't forget to update Get_value/Get_value_at_indices (and setter) implementation if these are adjusted
-static const char *output_var_names[OUTPUT_VAR_NAME_COUNT] = { "OUTPUT_VAR_1", "OUTPUT_VAR_2" };
-static const char *output_var_types[OUTPUT_VAR_NAME_COUNT] = { "double", "double" };
-static const int output_var_item_count[OUTPUT_VAR_NAME_COUNT] = { 1, 1 };
-static const char *output_var_units[OUTPUT_VAR_NAME_COUNT] = { "m", "m" };
-static const int output_var_grids[OUTPUT_VAR_NAME_COUNT] = { 0, 0 };
-static const char *output_var_locations[OUTPUT_VAR_NAME_COUNT] = { "node", "node" };
+static const char *output_var_names[OUTPUT_VAR_NAME_COUNT] = { "OUTPUT_VAR_1", "OUTPUT_VAR_2", "OUTPUT_VAR_3" };
+static const char *output_var_types[OUTPUT_VAR_NAME_COUNT] = { "double", "double", "double" };
+static const int output_var_item_count[OUTPUT_VAR_NAME_COUNT] = { 1, 1, 2 };
+static const char *output_var_units[OUTPUT_VAR_NAME_COUNT] = { "m", "m", "m" };
+static const int output_var_grids[OUTPUT_VAR_NAME_COUNT] = { 0, 0, 0 };
+static const char *output_var_locations[OUTPUT_VAR_NAME_COUNT] = { "node", "node", "node" };
 
 // Don't forget to update Get_value/Get_value_at_indices (and setter) implementation if these are adjusted
-static const char *input_var_names[INPUT_VAR_NAME_COUNT] = { "INPUT_VAR_1", "INPUT_VAR_2" };
-static const char *input_var_types[INPUT_VAR_NAME_COUNT] = { "double", "double" };
-static const char *input_var_units[INPUT_VAR_NAME_COUNT] = {  "m", "m/s" };
-static const int input_var_item_count[INPUT_VAR_NAME_COUNT] = { 1, 1 };
-static const char *input_var_grids[INPUT_VAR_NAME_COUNT] = { 0, 0 };
-static const char *input_var_locations[INPUT_VAR_NAME_COUNT] = { "node", "node" };
+static const char *input_var_names[INPUT_VAR_NAME_COUNT] = { "INPUT_VAR_1", "INPUT_VAR_2", "INPUT_VAR_3", "INPUT_VAR_4", "INPUT_VAR_5" };
+static const char *input_var_types[INPUT_VAR_NAME_COUNT] = { "double", "double", "int", "double", "double" };
+static const char *input_var_units[INPUT_VAR_NAME_COUNT] = {  "m", "m/s", "m", "mm", "m" };
+static const int input_var_item_count[INPUT_VAR_NAME_COUNT] = { 1, 1, 1, 1, 3 };
+static const char *input_var_grids[INPUT_VAR_NAME_COUNT] = { 0, 0, 0, 0, 0 };
+static const char *input_var_locations[INPUT_VAR_NAME_COUNT] = { "node", "node", "node", "node", "node" };
 
 // Don't forget to update Get_value/Get_value_at_indices (and setter) implementation if these are adjusted
 static const char *param_var_names[PARAM_VAR_NAME_COUNT] = { "PARAM_VAR_1", "PARAM_VAR_2", "PARAM_VAR_3" };
@@ -34,6 +40,28 @@ static const int param_var_item_count[PARAM_VAR_NAME_COUNT] = { 1, 1, 2 };
 static const char *param_var_grids[PARAM_VAR_NAME_COUNT] = { 0, 0, 0 };
 static const char *param_var_locations[PARAM_VAR_NAME_COUNT] = { "node", "node", "node" };
 
+/**
+ * Get the number of input variables the model uses, which depends on whether its extra variables are used.
+ *
+ * @param self Pointer to the struct representing the model.
+ * @return The number of leading entries of the input variable arrays that are used.
+ */
+static int input_var_name_count(Bmi *self)
+{
+    return ((test_bmi_c_model *) self->data)->use_extra_vars ? INPUT_VAR_NAME_COUNT : BASE_INPUT_VAR_NAME_COUNT;
+}
+
+/**
+ * Get the number of output variables the model uses, which depends on whether its extra variables are used.
+ *
+ * @param self Pointer to the struct representing the model.
+ * @return The number of leading entries of the output variable arrays that are used.
+ */
+static int output_var_name_count(Bmi *self)
+{
+    return ((test_bmi_c_model *) self->data)->use_extra_vars ? OUTPUT_VAR_NAME_COUNT : BASE_OUTPUT_VAR_NAME_COUNT;
+}
+
 static int Finalize (Bmi *self)
 {
     // Function assumes everything that is needed is retrieved from the model before Finalize is called.
@@ -47,8 +75,18 @@ static int Finalize (Bmi *self)
             free(model->output_var_1);
         if( model->output_var_2 != NULL )
             free(model->output_var_2);
+        if( model->input_var_3 != NULL )
+            free(model->input_var_3);
+        if( model->input_var_4 != NULL )
+            free(model->input_var_4);
+        if( model->input_var_5 != NULL )
+            free(model->input_var_5);
+        if( model->output_var_3 != NULL )
+            free(model->output_var_3);
         if (model->param_var_3 != NULL )
             free(model->param_var_3);
+        if (model->serialized_state != NULL )
+            free(model->serialized_state);
         free(self->data);
     }
 
@@ -209,7 +247,7 @@ static int Get_grid_z(Bmi *self, int grid, double *z)
 
 static int Get_input_var_names (Bmi *self, char ** names)
 {
-    for (size_t i = 0; i < INPUT_VAR_NAME_COUNT; i++)
+    for (size_t i = 0; i < input_var_name_count(self); i++)
         snprintf(names[i], BMI_MAX_VAR_NAME, "%s", input_var_names[i]);
     return BMI_SUCCESS;
 }
@@ -217,21 +255,21 @@ static int Get_input_var_names (Bmi *self, char ** names)
 
 static int Get_input_item_count (Bmi *self, int * count)
 {
-    *count = INPUT_VAR_NAME_COUNT;
+    *count = input_var_name_count(self);
     return BMI_SUCCESS;
 }
 
 
 static int Get_output_item_count (Bmi *self, int * count)
 {
-    *count = OUTPUT_VAR_NAME_COUNT;
+    *count = output_var_name_count(self);
     return BMI_SUCCESS;
 }
 
 
 static int Get_output_var_names (Bmi *self, char ** names)
 {
-    for (size_t i = 0; i < OUTPUT_VAR_NAME_COUNT; i++)
+    for (size_t i = 0; i < output_var_name_count(self); i++)
         snprintf(names[i], BMI_MAX_VAR_NAME, "%s", output_var_names[i]);
     return BMI_SUCCESS;
 }
@@ -281,6 +319,14 @@ static int Get_time_units (Bmi *self, char * units)
 
 static int Get_value (Bmi *self, const char *name, void *dest)
 {
+    if (strcmp(name, "serialization_state") == 0) {
+        test_bmi_c_model* model = (test_bmi_c_model *)(self->data);
+        if (model->serialized_state == NULL)
+            return BMI_FAILURE;
+        memcpy(dest, model->serialized_state, SERIALIZED_STATE_COUNT * sizeof(double));
+        return BMI_SUCCESS;
+    }
+
     int i = 0;
     int item_count = -1;
     for (i = 0; i < PARAM_VAR_NAME_COUNT; i++) {
@@ -289,6 +335,14 @@ static int Get_value (Bmi *self, const char *name, void *dest)
                 break;
             }
         }
+    for (i = 0; item_count < 1 && i < input_var_name_count(self); i++) {
+        if (strcmp(name, input_var_names[i]) == 0)
+            item_count = input_var_item_count[i];
+    }
+    for (i = 0; item_count < 1 && i < output_var_name_count(self); i++) {
+        if (strcmp(name, output_var_names[i]) == 0)
+            item_count = output_var_item_count[i];
+    }
     
     if( item_count < 1 ){
         // Since all the variables are scalar, use nested call to "by index" version, with just index 0
@@ -363,6 +417,21 @@ static int Get_value_ptr (Bmi *self, const char *name, void **dest)
         return BMI_SUCCESS;
     }
 
+    if (strcmp (name, "INPUT_VAR_3") == 0 && ((test_bmi_c_model *)(self->data))->use_extra_vars) {
+        *dest = ((test_bmi_c_model *)(self->data))->input_var_3;
+        return BMI_SUCCESS;
+    }
+
+    if (strcmp (name, "INPUT_VAR_4") == 0 && ((test_bmi_c_model *)(self->data))->use_extra_vars) {
+        *dest = ((test_bmi_c_model *)(self->data))->input_var_4;
+        return BMI_SUCCESS;
+    }
+
+    if (strcmp (name, "INPUT_VAR_5") == 0 && ((test_bmi_c_model *)(self->data))->use_extra_vars) {
+        *dest = ((test_bmi_c_model *)(self->data))->input_var_5;
+        return BMI_SUCCESS;
+    }
+
     if (strcmp (name, "OUTPUT_VAR_1") == 0) {
         *dest = ((test_bmi_c_model *)(self->data))->output_var_1;
         return BMI_SUCCESS;
@@ -373,6 +442,11 @@ static int Get_value_ptr (Bmi *self, const char *name, void **dest)
         return BMI_SUCCESS;
     }
 
+    if (strcmp (name, "OUTPUT_VAR_3") == 0 && ((test_bmi_c_model *)(self->data))->use_extra_vars) {
+        *dest = ((test_bmi_c_model *)(self->data))->output_var_3;
+        return BMI_SUCCESS;
+    }
+
     if (strcmp (name, "PARAM_VAR_1") == 0) {
         *dest = &((test_bmi_c_model *)(self->data))->param_var_1;
         return BMI_SUCCESS;
@@ -387,6 +461,11 @@ static int Get_value_ptr (Bmi *self, const char *name, void **dest)
         *dest = ((test_bmi_c_model *)(self->data))->param_var_3;
         return BMI_SUCCESS;
     }
+
+    if (strcmp (name, "serialization_state") == 0) {
+        *dest = ((test_bmi_c_model *)(self->data))->serialized_state;
+        return *dest == NULL ? BMI_FAILURE : BMI_SUCCESS;
+    }
     return BMI_FAILURE;
 }
 
@@ -434,14 +513,14 @@ static int Get_var_location (Bmi *self, const char *name, char * location)
 {
     size_t i;
     // Check to see if in output array first
-    for (i = 0; i < OUTPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < output_var_name_count(self); i++) {
         if (strcmp(name, output_var_names[i]) == 0) {
             snprintf(location, BMI_MAX_LOCATION_NAME, "%s", output_var_locations[i]);
             return BMI_SUCCESS;
         }
     }
     // Then check to see if in input array
-    for (i = 0; i < INPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < input_var_name_count(self); i++) {
         if (strcmp(name, input_var_names[i]) == 0) {
             snprintf(location, BMI_MAX_LOCATION_NAME, "%s", input_var_locations[i]);
             return BMI_SUCCESS;
@@ -455,20 +534,25 @@ static int Get_var_location (Bmi *self, const char *name, char * location)
 
 static int Get_var_nbytes (Bmi *self, const char *name, int * nbytes)
 {
+    if (strcmp(name, "serialization_state") == 0) {
+        *nbytes = SERIALIZED_STATE_COUNT * sizeof(double);
+        return BMI_SUCCESS;
+    }
+
     int item_size;
     if (self->get_var_itemsize(self, name, &item_size) != BMI_SUCCESS) {
         return BMI_FAILURE;
     }
     int item_count = -1;
     size_t i;
-    for (i = 0; i < INPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < input_var_name_count(self); i++) {
         if (strcmp(name, input_var_names[i]) == 0) {
             item_count = input_var_item_count[i];
             break;
         }
     }
     if (item_count < 1) {
-        for (i = 0; i < OUTPUT_VAR_NAME_COUNT; i++) {
+        for (i = 0; i < output_var_name_count(self); i++) {
             if (strcmp(name, output_var_names[i]) == 0) {
                 item_count = output_var_item_count[i];
                 break;
@@ -495,14 +579,14 @@ static int Get_var_type (Bmi *self, const char *name, char * type)
 {
     size_t i;
     // Check to see if in output array first
-    for (i = 0; i < OUTPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < output_var_name_count(self); i++) {
         if (strcmp(name, output_var_names[i]) == 0) {
             snprintf(type, BMI_MAX_TYPE_NAME, "%s", output_var_types[i]);
             return BMI_SUCCESS;
         }
     }
     // Then check to see if in input array
-    for (i = 0; i < INPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < input_var_name_count(self); i++) {
         if (strcmp(name, input_var_names[i]) == 0) {
             snprintf(type, BMI_MAX_TYPE_NAME, "%s", input_var_types[i]);
             return BMI_SUCCESS;
@@ -515,6 +599,11 @@ static int Get_var_type (Bmi *self, const char *name, char * type)
             return BMI_SUCCESS;
         }
     }
+    // The serialized state is exposed for checkpoints, though it is not an input or output
+    if (strcmp(name, "serialization_state") == 0) {
+        snprintf(type, BMI_MAX_TYPE_NAME, "%s", "double");
+        return BMI_SUCCESS;
+    }
     // If we get here, it means the variable name wasn't recognized
     type[0] = '\0';
     return BMI_FAILURE;
@@ -525,14 +614,14 @@ static int Get_var_units (Bmi *self, const char *name, char * units)
 {
     size_t i;
     // Check to see if in output array first
-    for (i = 0; i < OUTPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < output_var_name_count(self); i++) {
         if (strcmp(name, output_var_names[i]) == 0) {
             snprintf(units, BMI_MAX_UNITS_NAME, "%s", output_var_units[i]);
             return BMI_SUCCESS;
         }
     }
     // Then check to see if in input array
-    for (i = 0; i < INPUT_VAR_NAME_COUNT; i++) {
+    for (i = 0; i < input_var_name_count(self); i++) {
         if (strcmp(name, input_var_names[i]) == 0) {
             snprintf(units, BMI_MAX_UNITS_NAME, "%s", input_var_units[i]);
             return BMI_SUCCESS;
@@ -586,6 +675,13 @@ static int Initialize (Bmi *self, const char *file)
     model->output_var_1 = malloc(sizeof(double));
     model->output_var_2 = malloc(sizeof(double));
 
+    if (model->use_extra_vars) {
+        model->input_var_3 = malloc(sizeof(int));
+        model->input_var_4 = malloc(sizeof(double));
+        model->input_var_5 = malloc(3 * sizeof(double));
+        model->output_var_3 = malloc(2 * sizeof(double));
+    }
+
     model->param_var_1 = 0;
     model->param_var_2 = 0.0;
     model->param_var_3 = malloc(2*sizeof(double));
@@ -641,7 +737,66 @@ static int Set_value_at_indices (Bmi *self, const char *name, int * inds, int le
 }
 
 
+/**
+ * Serialize the full state of the model into its serialized state buffer.
+ *
+ * @param model The model struct instance.
+ * @return The BMI return code indicating success or failure as appropriate.
+ */
+static int serialize_state(test_bmi_c_model* model)
+{
+    if (model->serialized_state == NULL)
+        model->serialized_state = malloc(SERIALIZED_STATE_COUNT * sizeof(double));
+    if (model->serialized_state == NULL)
+        return BMI_FAILURE;
+
+    double* state = model->serialized_state;
+    state[0] = model->current_model_time;
+    state[1] = *model->input_var_1;
+    state[2] = *model->input_var_2;
+    state[3] = *model->output_var_1;
+    state[4] = *model->output_var_2;
+    state[5] = (double) model->param_var_1;
+    state[6] = model->param_var_2;
+    state[7] = model->param_var_3[0];
+    state[8] = model->param_var_3[1];
+    return BMI_SUCCESS;
+}
+
+/**
+ * Restore the model from a state written by @ref serialize_state.
+ *
+ * @param model The model struct instance.
+ * @param state The serialized state.
+ * @return The BMI return code indicating success or failure as appropriate.
+ */
+static int deserialize_state(test_bmi_c_model* model, const double* state)
+{
+    model->current_model_time = state[0];
+    *model->input_var_1 = state[1];
+    *model->input_var_2 = state[2];
+    *model->output_var_1 = state[3];
+    *model->output_var_2 = state[4];
+    model->param_var_1 = (int) state[5];
+    model->param_var_2 = state[6];
+    model->param_var_3[0] = state[7];
+    model->param_var_3[1] = state[8];
+    return BMI_SUCCESS;
+}
+
 static int Set_value (Bmi *self, const char *name, void *array) {
+    // Serialization extension, used to save and restore the model state for checkpoints
+    test_bmi_c_model* model = (test_bmi_c_model*)self->data;
+    if (strcmp(name, "serialization_create") == 0)
+        return serialize_state(model);
+    if (strcmp(name, "serialization_free") == 0) {
+        free(model->serialized_state);
+        model->serialized_state = NULL;
+        return BMI_SUCCESS;
+    }
+    if (strcmp(name, "serialization_state") == 0)
+        return deserialize_state(model, (const double*) array);
+
     void *dest = NULL;
     if (self->get_value_ptr(self, name, &dest) == BMI_FAILURE)
         return BMI_FAILURE;
@@ -705,6 +860,13 @@ test_bmi_c_model *new_bmi_model(void)
     data->input_var_2 = NULL;
     data->output_var_1 = NULL;
     data->output_var_2 = NULL;
+    data->use_extra_vars = FALSE;
+    data->input_var_3 = NULL;
+    data->input_var_4 = NULL;
+    data->input_var_5 = NULL;
+    data->output_var_3 = NULL;
+    data->param_var_3 = NULL;
+    data->serialized_state = NULL;
 
     return data;
 }
@@ -824,6 +986,10 @@ int read_init_config(const char* config_file, test_bmi_c_model* model)
             model->time_step_size = (int)strtol(param_value, NULL, 10);
             continue;
         }
+        if (strcmp(param_key, "use_extra_vars") == 0) {
+            model->use_extra_vars = TRUE;
+            continue;
+        }
     }
 
     if (is_epoch_start_time_set == FALSE) {
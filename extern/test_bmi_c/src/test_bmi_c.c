@@ -17,6 +17,10 @@ extern int run(test_bmi_c_model* model, long dt)
         *model->output_var_1 = *model->input_var_1 * (double) dt / model->time_step_size;
         *model->output_var_2 = 2.0 * *model->input_var_2 * (double) dt / model->time_step_size;
     }
+    if (model->output_var_3 != NULL) {
+        model->output_var_3[0] = *model->output_var_1;
+        model->output_var_3[1] = *model->output_var_2;
+    }
     model->current_model_time += (double)dt;
 
     return 0;
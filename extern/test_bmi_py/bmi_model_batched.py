@@ -0,0 +1,107 @@
+from pathlib import Path
+
+import numpy as np
+import yaml
+
+
+class bmi_model_batched():
+    """
+    Test Python model for the batch protocol, where one model object serves many catchments.
+
+    Each catchment is added with ``add_catchment`` instead of ``initialize``, and every variable is an array with one
+    value per catchment, in the order they were added.  The model computes the same outputs as ``bmi_model``.
+    """
+
+    _input_var_names = ['INPUT_VAR_1', 'INPUT_VAR_2']
+    _output_var_names = ['OUTPUT_VAR_1', 'OUTPUT_VAR_2']
+
+    def __init__(self):
+        self._values = {name: np.zeros(0, dtype=float) for name in self._input_var_names + self._output_var_names}
+        self._current_time = 0.0
+        self._time_step = 3600.0
+        # Number of update calls, so tests can check all catchments advance together
+        self.update_count = 0
+
+    def add_catchment(self, bmi_cfg_file_name: str):
+        bmi_cfg_file = Path(bmi_cfg_file_name).resolve()
+        if not bmi_cfg_file.is_file():
+            raise RuntimeError("No configuration provided, nothing to do...")
+        with bmi_cfg_file.open('r') as fp:
+            cfg = yaml.safe_load(fp)
+        self._current_time = float(cfg['initial_time'])
+        self._time_step = float(cfg['time_step_seconds'])
+        for name in self._values:
+            self._values[name] = np.append(self._values[name], 0.0)
+
+    def update(self):
+        self.update_until(self._current_time + self._time_step)
+
+    def update_until(self, future_time: float):
+        self._values['OUTPUT_VAR_1'][:] = self._values['INPUT_VAR_1']
+        self._values['OUTPUT_VAR_2'][:] = 2.0 * self._values['INPUT_VAR_2']
+        self._current_time = future_time
+        self.update_count += 1
+
+    def finalize(self):
+        self._values = {}
+
+    def get_component_name(self):
+        return 'Test batched Python model for Next Generation NWM'
+
+    def get_input_item_count(self):
+        return len(self._input_var_names)
+
+    def get_output_item_count(self):
+        return len(self._output_var_names)
+
+    def get_input_var_names(self):
+        return self._input_var_names
+
+    def get_output_var_names(self):
+        return self._output_var_names
+
+    def get_var_type(self, name):
+        return str(self._values[name].dtype)
+
+    def get_var_units(self, name):
+        return '-'
+
+    def get_var_itemsize(self, name):
+        return self._values[name].itemsize
+
+    def get_var_nbytes(self, name):
+        return self._values[name].nbytes
+
+    def get_var_location(self, name):
+        return 'node'
+
+    def get_var_grid(self, name):
+        return 0
+
+    def get_current_time(self):
+        return self._current_time
+
+    def get_start_time(self):
+        return 0.0
+
+    def get_end_time(self):
+        return np.finfo(float).max
+
+    def get_time_units(self):
+        return 'seconds'
+
+    def get_time_step(self):
+        return self._time_step
+
+    def get_value_ptr(self, name):
+        return self._values[name]
+
+    def get_value(self, name, dest):
+        dest[:] = self._values[name]
+        return dest
+
+    def set_value(self, name, values):
+        self._values[name][:] = values
+
+    def set_value_at_indices(self, name, inds, src):
+        self._values[name][inds] = src
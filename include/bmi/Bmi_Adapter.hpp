@@ -142,6 +142,43 @@ namespace models {
              */
             std::string get_model_name();
 
+            /**
+             * Get whether the backing model implements the optional serialization extension, so its state can be
+             * saved to and restored from a checkpoint.
+             *
+             * The extension is a convention over the standard BMI value functions, so it is available to models in
+             * any supported language without changes to the BMI itself:
+             *
+             * - ``SetValue("serialization_create", ...)`` has the model serialize its full state into a byte buffer
+             *   it holds (the value passed is an ignored, zeroed scalar);
+             * - the buffer is then exposed as the variable ``serialization_state``, whose ``GetVarNbytes`` is the
+             *   size of the serialized state and whose ``GetValue`` copies it out;
+             * - ``SetValue("serialization_free", ...)`` lets the model release the buffer;
+             * - ``SetValue("serialization_state", state)`` restores the model from a state it serialized earlier,
+             *   which therefore must record its own size.
+             *
+             * Models that have no unsigned byte type, e.g. Fortran ones, may expose ``serialization_state`` as an
+             * array of any supported numeric type, as only its bytes are used.
+             *
+             * @return Whether the backing model advertises a ``serialization_state`` variable.
+             */
+            virtual bool is_serializable();
+
+            /**
+             * Serialize the full state of the backing model, as described for @ref is_serializable.
+             *
+             * @return The serialized state, which the model can later be restored from with @ref set_serialized_state.
+             * @throws std::runtime_error If the model does not implement the serialization extension.
+             */
+            virtual std::vector<char> get_serialized_state();
+
+            /**
+             * Restore the backing model to a state previously returned by @ref get_serialized_state.
+             *
+             * @param state The serialized state.
+             */
+            virtual void set_serialized_state(const std::vector<char> &state);
+
         protected:
             /** Path (as a string) to the BMI config file for initializing the backing model (empty if none). */
             std::string bmi_init_config;
@@ -60,11 +60,10 @@ namespace models {
             template <typename T>
             void copy_to_array(const std::string& name, T *dest)
             {
-                py::array_t<T> backing_array = bmi_model->attr("get_value_ptr")(name);
-                auto uncheck_proxy = backing_array.template unchecked<1>();
-                for (ssize_t i = 0; i < backing_array.size(); ++i) {
-                    dest[i] = uncheck_proxy(i);
-                }
+                // Contiguous arrays of the requested type are copied in one block; others are converted first
+                py::array_t<T, py::array::c_style | py::array::forcecast> backing_array
+                        = bmi_model->attr("get_value_ptr")(name);
+                std::memcpy(dest, backing_array.data(), backing_array.size() * sizeof(T));
             }
 
             /**
@@ -77,13 +76,9 @@ namespace models {
             template <typename T>
             std::vector<T> copy_to_vector(const std::string& name)
             {
-                py::array_t<T> backing_array = bmi_model->attr("get_value_ptr")(name);
-                std::vector<T> dest(backing_array.size());
-                auto uncheck_proxy = backing_array.template unchecked<1>();
-                for (ssize_t i = 0; i < backing_array.size(); ++i) {
-                    dest[i] = uncheck_proxy(i);
-                }
-                return dest;
+                py::array_t<T, py::array::c_style | py::array::forcecast> backing_array
+                        = bmi_model->attr("get_value_ptr")(name);
+                return std::vector<T>(backing_array.data(), backing_array.data() + backing_array.size());
             }
 
             void Finalize() override {
@@ -229,6 +224,18 @@ namespace models {
              * @return The name string for the C++ type analogous to the described type in the Python backing model.
              */
             const std::string get_analogous_cxx_type(const std::string &py_type_name, const size_t item_size) override {
+                return python_analogous_cxx_type(py_type_name, item_size);
+            }
+
+            /**
+             * Get the name string for the C++ type analogous to the described Python type, without an adapter instance.
+             *
+             * @param py_type_name The string name of the analog type in Python.
+             * @param item_size The particular size in bytes for items of the involved analogous types.
+             * @return The name string for the C++ type analogous to the described type in Python.
+             * @see get_analogous_cxx_type
+             */
+            static std::string python_analogous_cxx_type(const std::string &py_type_name, const size_t item_size) {
                 /*
                  * Note that an implementation using a "switch" statement would be problematic.  It could be done by
                  * rewriting to separate the integer and non-integer type, then having cases based on size.  However,
@@ -520,6 +527,20 @@ namespace models {
 
             void UpdateUntil(double time) override;
 
+            /**
+             * Serialize the full state of the backing model, following the convention of
+             * @ref Bmi_Adapter::is_serializable.
+             *
+             * The state is read through the model's ``get_value_ptr("serialization_state")`` array, whatever its
+             * dtype, rather than copied element by element.
+             */
+            std::vector<char> get_serialized_state() override;
+
+            /**
+             * Restore the backing model to a serialized state, passed to its ``set_value`` as a ``uint8`` array.
+             */
+            void set_serialized_state(const std::vector<char> &state) override;
+
             void SetValue(std::string name, void *src) override {
                 int itemSize = GetVarItemsize(name);
                 std::string py_type = GetVarType(name);
@@ -0,0 +1,351 @@
+#ifndef NGEN_BMI_PY_BATCH_ADAPTER_H
+#define NGEN_BMI_PY_BATCH_ADAPTER_H
+
+#include <NGenConfig.h>
+
+#if NGEN_WITH_PYTHON
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
+
+#include "Bmi_Adapter.hpp"
+
+// Forward declaration to provide access to protected items in testing
+class Bmi_Py_Batch_Test;
+
+namespace models {
+    namespace bmi {
+
+        /**
+         * A single Python BMI model object serving many catchments, through the optional batch protocol.
+         *
+         * Instead of one model object per catchment, the Python type is constructed once, and each catchment is added
+         * to it with ``add_catchment(config_file)`` in place of ``initialize``, becoming the next row of the model.
+         * Every variable is then a flattened array of the values of all rows in row order, so ``get_var_nbytes`` is
+         * the size of all rows, and one ``update`` advances every catchment.  Time and metadata functions apply to
+         * all rows alike.
+         *
+         * Values set for a row are held here until the model is next updated, and then passed with one ``set_value``
+         * (or ``set_value_at_indices``, when not all rows were set) per variable.  Likewise, the values of a variable
+         * are read from the model once per update for all rows.  Because of this, every row must have been prepared
+         * with @ref prepare_update before the model is updated for any of them.
+         */
+        class Bmi_Py_Batch {
+
+        public:
+
+            /**
+             * Get the batch of the given Python type shared by the formulations of this process with the given model
+             * type name, creating it if there is none yet.
+             *
+             * Formulations configured with different model type names get separate batches, even for the same Python
+             * type, so that distinct formulations are never merged into one model.
+             *
+             * @param bmi_python_type The full name of the Python BMI type, as ``<python_module>.<python_class>``.
+             * @param model_type_name The model type name of the formulation config using the batch.
+             * @return The shared batch.
+             */
+            static std::shared_ptr<Bmi_Py_Batch> get_shared(const std::string &bmi_python_type,
+                                                            const std::string &model_type_name);
+
+            explicit Bmi_Py_Batch(const std::string &bmi_python_type);
+
+            Bmi_Py_Batch(Bmi_Py_Batch const&) = delete;
+            Bmi_Py_Batch(Bmi_Py_Batch&&) = delete;
+
+            ~Bmi_Py_Batch();
+
+            /**
+             * Add a catchment to the model, initialized from the given config file.
+             *
+             * @return The row of the added catchment.
+             * @throws std::runtime_error If the model was already updated, as rows cannot be added afterward.
+             */
+            std::size_t add_row(const std::string &bmi_init_config);
+
+            std::size_t num_rows() const {
+                return row_steps.size();
+            }
+
+            /** The metadata of a variable, which is the same for every row */
+            struct variable {
+                std::string type;
+                int item_size = 0;
+                //Bytes of the variable for one row
+                int row_nbytes = 0;
+                //The analogous C++ type, which values of the variable are exchanged as
+                std::string cxx_type;
+                std::string units;
+                std::string location;
+                int grid = 0;
+            };
+
+            const variable &get_variable(const std::string &name);
+
+            const std::vector<std::string> &get_input_var_names();
+
+            const std::vector<std::string> &get_output_var_names();
+
+            std::string get_component_name();
+
+            /**
+             * Get the model time of a row, which lags the model by one update until the row's own ``Update`` call.
+             */
+            double get_current_time(std::size_t row) const;
+
+            double get_start_time();
+
+            double get_end_time();
+
+            double get_time_step();
+
+            std::string get_time_units();
+
+            /**
+             * Hold the values of a row for a variable until the model is next updated.
+             *
+             * @param src The values of the row, of the size and type of the variable.
+             */
+            void set_row_value(const std::string &name, std::size_t row, const void *src);
+
+            /**
+             * Get the values of a row for a variable, read from the model at most once per update.
+             *
+             * @return Pointer to the values of the row, valid until the model is updated or the variable set.
+             */
+            const void *get_row_value_ptr(const std::string &name, std::size_t row);
+
+            /**
+             * Mark the inputs of a row as set for its next update.
+             */
+            void prepare_update(std::size_t row);
+
+            /**
+             * Advance a row by one model time step, updating the model if no other row already has.
+             *
+             * @throws std::runtime_error If the model must be updated, but not every row has been prepared.
+             */
+            void update(std::size_t row);
+
+            /**
+             * Advance a row to the given model time, updating the model if no other row already has.
+             *
+             * @see update
+             */
+            void update_until(std::size_t row, double time);
+
+        private:
+
+            /** Values set for rows since the last update */
+            struct staged_values {
+                std::vector<char> values;
+                std::vector<bool> is_set;
+                std::size_t set_count = 0;
+            };
+
+            /** Values of all rows as read from the model */
+            struct cached_values {
+                std::vector<char> values;
+                long step = -1;
+            };
+
+            void advance(std::size_t row, const double *until_time);
+
+            void pass_staged_values();
+
+            pybind11::array to_numpy(const variable &info, const char *data, std::size_t count) const;
+
+            std::string bmi_type_py_full_name;
+            std::shared_ptr<pybind11::object> bmi_model;
+
+            std::map<std::string, variable> variables;
+            std::map<std::string, staged_values> staged;
+            std::map<std::string, cached_values> cached;
+            std::shared_ptr<std::vector<std::string>> input_var_names;
+            std::shared_ptr<std::vector<std::string>> output_var_names;
+            std::shared_ptr<std::string> time_units;
+            std::shared_ptr<double> time_step;
+
+            //Number of updates of the model, and of each row
+            long steps = 0;
+            std::vector<long> row_steps;
+            //The update each row was last prepared for
+            std::vector<long> prepared_steps;
+            double current_time = 0.0;
+            double previous_time = 0.0;
+
+            friend class ::Bmi_Py_Batch_Test;
+        };
+
+        /**
+         * An adapter for one catchment (row) of a @ref Bmi_Py_Batch, so that the catchment's formulation uses it like
+         * a model of its own.
+         *
+         * Value functions exchange the values of this row only, without calling into Python, and ``Update`` advances
+         * the shared model only for the first row to reach a time step.  The serialization extension and grid
+         * functions are not supported.
+         */
+        class Bmi_Py_Batch_Adapter final : public Bmi_Adapter {
+
+        public:
+
+            Bmi_Py_Batch_Adapter(const std::string &type_name, std::string bmi_init_config,
+                                 std::shared_ptr<Bmi_Py_Batch> batch, bool has_fixed_time_step);
+
+            Bmi_Py_Batch_Adapter(Bmi_Py_Batch_Adapter const&) = delete;
+            Bmi_Py_Batch_Adapter(Bmi_Py_Batch_Adapter&&) = delete;
+
+            /**
+             * Mark the inputs set for this row as those of its next update.
+             *
+             * @see Bmi_Py_Batch::prepare_update
+             */
+            void prepare_update() {
+                batch->prepare_update(row);
+            }
+
+            std::size_t get_row() const {
+                return row;
+            }
+
+            const std::string get_analogous_cxx_type(const std::string &py_type_name, const size_t item_size) override;
+
+            bool is_model_initialized() override {
+                return model_initialized;
+            }
+
+            bool is_serializable() override {
+                return false;
+            }
+
+            /** The shared model is finalized by its batch once no catchment uses it */
+            void Finalize() override {}
+
+            void Update() override {
+                batch->update(row);
+            }
+
+            void UpdateUntil(double time) override {
+                batch->update_until(row, time);
+            }
+
+            std::string GetComponentName() override {
+                return batch->get_component_name();
+            }
+
+            int GetInputItemCount() override {
+                return batch->get_input_var_names().size();
+            }
+
+            int GetOutputItemCount() override {
+                return batch->get_output_var_names().size();
+            }
+
+            std::vector<std::string> GetInputVarNames() override {
+                return batch->get_input_var_names();
+            }
+
+            std::vector<std::string> GetOutputVarNames() override {
+                return batch->get_output_var_names();
+            }
+
+            int GetVarGrid(std::string name) override {
+                return batch->get_variable(name).grid;
+            }
+
+            std::string GetVarType(std::string name) override {
+                return batch->get_variable(name).type;
+            }
+
+            std::string GetVarUnits(std::string name) override {
+                return batch->get_variable(name).units;
+            }
+
+            int GetVarItemsize(std::string name) override {
+                return batch->get_variable(name).item_size;
+            }
+
+            int GetVarNbytes(std::string name) override {
+                return batch->get_variable(name).row_nbytes;
+            }
+
+            std::string GetVarLocation(std::string name) override {
+                return batch->get_variable(name).location;
+            }
+
+            double GetCurrentTime() override {
+                return batch->get_current_time(row);
+            }
+
+            double GetStartTime() override {
+                return batch->get_start_time();
+            }
+
+            double GetEndTime() override {
+                return batch->get_end_time();
+            }
+
+            std::string GetTimeUnits() override {
+                return batch->get_time_units();
+            }
+
+            double GetTimeStep() override {
+                return batch->get_time_step();
+            }
+
+            void GetValue(std::string name, void *dest) override;
+
+            void *GetValuePtr(std::string name) override;
+
+            void GetValueAtIndices(std::string name, void *dest, int *inds, int count) override;
+
+            void SetValue(std::string name, void *src) override {
+                batch->set_row_value(name, row, src);
+            }
+
+            void SetValueAtIndices(std::string name, int *inds, int count, void *src) override;
+
+            int GetGridRank(const int grid) override { throw_grid_unsupported(); }
+            int GetGridSize(const int grid) override { throw_grid_unsupported(); }
+            std::string GetGridType(const int grid) override { throw_grid_unsupported(); }
+            void GetGridShape(const int grid, int *shape) override { throw_grid_unsupported(); }
+            void GetGridSpacing(const int grid, double *spacing) override { throw_grid_unsupported(); }
+            void GetGridOrigin(const int grid, double *origin) override { throw_grid_unsupported(); }
+            void GetGridX(const int grid, double *x) override { throw_grid_unsupported(); }
+            void GetGridY(const int grid, double *y) override { throw_grid_unsupported(); }
+            void GetGridZ(const int grid, double *z) override { throw_grid_unsupported(); }
+            int GetGridNodeCount(const int grid) override { throw_grid_unsupported(); }
+            int GetGridEdgeCount(const int grid) override { throw_grid_unsupported(); }
+            int GetGridFaceCount(const int grid) override { throw_grid_unsupported(); }
+            void GetGridEdgeNodes(const int grid, int *edge_nodes) override { throw_grid_unsupported(); }
+            void GetGridFaceEdges(const int grid, int *face_edges) override { throw_grid_unsupported(); }
+            void GetGridFaceNodes(const int grid, int *face_nodes) override { throw_grid_unsupported(); }
+            void GetGridNodesPerFace(const int grid, int *nodes_per_face) override { throw_grid_unsupported(); }
+
+        protected:
+
+            /** The row is added to the batch on construction */
+            void construct_and_init_backing_model() override {}
+
+        private:
+
+            [[noreturn]] void throw_grid_unsupported() const {
+                throw std::runtime_error("Grid functions are not supported for batched Python model " + model_name);
+            }
+
+            std::shared_ptr<Bmi_Py_Batch> batch;
+            std::size_t row = 0;
+        };
+
+    }
+}
+
+#endif //NGEN_WITH_PYTHON
+
+#endif //NGEN_BMI_PY_BATCH_ADAPTER_H
@@ -0,0 +1,69 @@
+#ifndef NGEN_CHECKPOINT_HPP
+#define NGEN_CHECKPOINT_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Layer.hpp"
+#include "Simulation_Time.hpp"
+
+namespace ngen
+{
+    /**
+     * Checkpoints of the full state of a running simulation, so it can be restarted without simulating up to the
+     * checkpoint again.
+     *
+     * Each rank writes its own compact binary file, holding the next master time step, the time step position and
+     * catchment formulation states of every layer, and the flows not yet released by every nexus of the rank.  A
+     * checkpoint can only be restarted with the same hydrofabric, partitioning, realization and simulation start time
+     * and interval; the end time may differ, e.g. to extend a run.
+     */
+    namespace checkpoint
+    {
+        /** @return The file of @p rank in the checkpoint with path prefix @p prefix */
+        std::string rank_path(const std::string& prefix, int rank);
+
+        /**
+         * Check every formulation of every layer can save its state, before the first time step is simulated.
+         *
+         * This, @ref write and @ref read are collective over the @p num_ranks ranks: when any rank fails, all of them
+         * throw, so no rank is left waiting for the others.
+         *
+         * @param num_ranks The number of ranks of the simulation
+         * @param layers The layers of this rank
+         * @throws std::runtime_error If a formulation of any rank cannot save its state
+         */
+        void check(int num_ranks, std::vector<std::shared_ptr<Layer>>& layers);
+
+        /**
+         * Write the checkpoint file of this rank, after the time steps before @p next_time_index have completed.
+         *
+         * The file is written under a temporary name first, so an interrupted write never leaves a partial checkpoint.
+         *
+         * @param prefix The path prefix of the checkpoint, to which the rank and a suffix are added
+         * @param rank The rank writing the checkpoint
+         * @param num_ranks The number of ranks of the simulation
+         * @param time The master simulation time
+         * @param next_time_index The next master time step to simulate
+         * @param layers The layers of the simulation
+         * @param features The features of this rank
+         * @throws std::runtime_error If the file of any rank cannot be written or a formulation cannot save its state
+         */
+        void write(const std::string& prefix, int rank, int num_ranks, Simulation_Time& time, long next_time_index,
+                   std::vector<std::shared_ptr<Layer>>& layers, Layer::feature_type& features);
+
+        /**
+         * Restore the state of this rank from its checkpoint file.
+         *
+         * @return The next master time step to simulate
+         * @throws std::runtime_error If the file of any rank cannot be read or does not match this simulation, or the
+         *                            files of the ranks are of checkpoints at different time steps
+         * @see write
+         */
+        long read(const std::string& prefix, int rank, int num_ranks, Simulation_Time& time,
+                  std::vector<std::shared_ptr<Layer>>& layers, Layer::feature_type& features);
+    }
+}
+
+#endif // NGEN_CHECKPOINT_HPP
@@ -77,7 +77,30 @@ namespace ngen
             {
                simulation_time.advance_timestep();
             }
-    
+
+        }
+
+        bool is_thread_safe() const override{
+            return formulation == nullptr || formulation->is_thread_safe();
+        }
+
+        bool uses_python() const override{
+            return formulation != nullptr && formulation->uses_python();
+        }
+
+        void check_state_support() override{
+            formulation->check_state_support();
+        }
+
+        void write_state(std::ostream& out) override{
+            utils::state::write<std::int64_t>(out, output_time_index);
+            formulation->write_state(out);
+        }
+
+        void read_state(std::istream& in) override{
+            output_time_index = utils::state::read<std::int64_t>(in);
+            simulation_time.set_current_time_index(output_time_index);
+            formulation->read_state(in);
         }
 
         private:
@@ -122,10 +122,12 @@ namespace hy_features {
         /**
          * @brief An iterator of only the catchment feature ids from only the specified layer
          * 
+         * @param lyr The layer to return catchments for
+         * @param order The order to return catchments in
          * @return auto 
          */
-        inline auto catchments(long lyr) {
-            return network.filter(hy_features::identifiers::catchment,lyr);
+        inline auto catchments(long lyr, network::SortOrder order = network::SortOrder::Topological) {
+            return network.filter(hy_features::identifiers::catchment,lyr,order);
         }
 
         /**
@@ -10,6 +10,7 @@
 
 #include <HY_Catchment.hpp>
 #include <HY_PointHydroNexusRemote.hpp>
+#include <RemoteNexusExchange.hpp>
 #include <network.hpp>
 #include <Formulation_Manager.hpp>
 #include <Partition_Parser.hpp>
@@ -36,8 +37,49 @@ namespace hy_features {
             return _nexuses.find(id) != _nexuses.end() && _nexuses[id]->is_remote_sender();
         }
         
-        inline auto catchments(long lyr) {
-            return network.filter("cat",lyr);
+        /**
+         * @brief The percentage of the flow through a nexus that is passed to receiving catchments on this rank
+         */
+        inline double local_flow_share(const std::string& id) {
+            return _nexuses.find(id) != _nexuses.end() ? _nexuses[id]->get_local_share() : 100.0;
+        }
+        /**
+         * @brief Test if this rank holds the copy of a nexus that writes its output
+         */
+        inline bool is_primary_nexus(const std::string& id) {
+            return _nexuses.find(id) == _nexuses.end() || _nexuses[id]->is_primary_copy();
+        }
+        inline bool is_remote_nexus(const std::string& id) {
+            return _nexuses.find(id) != _nexuses.end()
+                   && _nexuses[id]->get_communicator_type() != HY_PointHydroNexusRemote::local;
+        }
+
+        /**
+         * @brief Test whether a catchment contributes to a nexus that sends flow to another rank
+         *
+         * Computing these catchments first lets the aggregated remote nexus messages leave while the rest of the
+         * catchments are computed.
+         */
+        inline bool is_boundary_catchment(const std::string& id) {
+            for(const auto& nex_id : network.get_destination_ids(id)) {
+                if(is_remote_sender_nexus(nex_id)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Complete the remote nexus communication, must be called before MPI_Finalize
+         */
+        void finalize() {
+            if(exchange) {
+                exchange->finalize();
+            }
+        }
+
+        inline auto catchments(long lyr, network::SortOrder order = network::SortOrder::Topological) {
+            return network.filter("cat",lyr,order);
         }
 
         /**
@@ -88,6 +130,7 @@ namespace hy_features {
       
       std::unordered_map<std::string, std::shared_ptr<HY_Catchment>> _catchments;
       std::unordered_map<std::string, std::shared_ptr<HY_PointHydroNexusRemote>> _nexuses;
+      std::shared_ptr<RemoteNexusExchange> exchange;
       network::Network network;
       std::shared_ptr<Formulation_Manager> formulations;
       std::set<long> hf_layers;
@@ -3,9 +3,20 @@
 
 #include <NGenConfig.h>
 
+#include "ColumnarOutputWriter.hpp"
 #include "LayerData.hpp"
 #include "Simulation_Time.hpp"
+#include "Profiler.hpp"
 #include "State_Exception.hpp"
+#include "StateStream.hpp"
+#include "ThreadPool.hpp"
+
+#include <boost/algorithm/string.hpp>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
 
 #if NGEN_WITH_MPI
 #include "HY_Features_MPI.hpp"
@@ -40,7 +51,7 @@ namespace ngen
             catchment_data(cd),
             output_time_index(idx)
         {
-
+            init_catchment_records();
         }
 
         /**
@@ -77,6 +88,11 @@ namespace ngen
         */
         time_t current_timestep_epoch_time() { return simulation_time.get_current_epoch_time(); }
 
+        /***
+         * @brief Return the number of output timesteps this layer has processed
+        */
+        long completed_time_steps() const { return output_time_index; }
+
 
         /***
          * @brief Return the numeric id of this layer
@@ -98,8 +114,134 @@ namespace ngen
         */
         const std::string& get_time_step_units() const { return this->description.time_step_units; }
 
+        /***
+         * @brief Set the thread pool used to execute the catchment formulations of this layer
+         *
+         * If any formulation of this layer cannot be executed concurrently, the pool is not used and the layer
+         * continues to run its catchments serially.
+         *
+         * @param pool The pool to use, or ``nullptr`` for serial execution
+        */
+        virtual void set_thread_pool(std::shared_ptr<utils::ThreadPool> pool)
+        {
+            thread_pool = nullptr;
+            if(pool == nullptr || pool->size() < 2) return;
+            std::size_t i = unsafe_catchment();
+            if(i < catchments.size()){
+                #if !NGEN_QUIET
+                std::cerr<<"WARNING: formulation for "<<processing_units[i]<<" in layer "<<get_name()
+                         <<" cannot be executed concurrently; running layer catchments serially"<<std::endl;
+                #endif
+                return;
+            }
+            thread_pool = pool;
+        }
+
+        /***
+         * @brief Get whether every catchment formulation of this layer may run concurrently with other threads
+         *
+         * This is false when any formulation depends on interpreter or other process-global state, e.g. Python BMI
+         * models.
+        */
+        virtual bool is_thread_safe() const
+        {
+            return unsafe_catchment() == catchments.size();
+        }
+
+        /***
+         * @brief Get whether any catchment formulation of this layer calls into Python, through its model or forcing
+         * provider, so updating the layer needs the interpreter's lock
+        */
+        virtual bool uses_python() const
+        {
+            for(const auto& record : catchments)
+            {
+                if(record.formulation != nullptr && record.formulation->uses_python()) return true;
+            }
+            return false;
+        }
+
+        /***
+         * @brief Check every catchment formulation of this layer can save its state, before any checkpoint is written
+         *
+         * @throws std::runtime_error If any formulation cannot save its state
+        */
+        virtual void check_state_support()
+        {
+            for(std::size_t i = 0; i < processing_units.size(); ++i)
+            {
+                formulation_of(i).check_state_support();
+            }
+        }
+
+        /***
+         * @brief Write the time step position of this layer and the state of each of its catchment formulations to a
+         * checkpoint
+         *
+         * @throws std::runtime_error If any formulation cannot save its state
+        */
+        virtual void write_state(std::ostream& out)
+        {
+            utils::state::write<std::int64_t>(out, output_time_index);
+            utils::state::write<std::uint64_t>(out, processing_units.size());
+            for(std::size_t i = 0; i < processing_units.size(); ++i)
+            {
+                utils::state::write_string(out, processing_units[i]);
+                formulation_of(i).write_state(out);
+            }
+        }
+
+        /***
+         * @brief Restore the state written by write_state, which must be for the same catchments in the same order
+        */
+        virtual void read_state(std::istream& in)
+        {
+            output_time_index = utils::state::read<std::int64_t>(in);
+            simulation_time.set_current_time_index(output_time_index);
+            std::uint64_t num_units = utils::state::read<std::uint64_t>(in);
+            if(num_units != processing_units.size())
+            {
+                throw std::runtime_error("Checkpoint holds " + std::to_string(num_units) + " catchments for layer "
+                                         + get_name() + ", which has " + std::to_string(processing_units.size()));
+            }
+            for(std::size_t i = 0; i < processing_units.size(); ++i)
+            {
+                utils::state::expect_string(in, processing_units[i], "catchment");
+                formulation_of(i).read_state(in);
+            }
+        }
+
+        /***
+         * @brief Set the writer receiving the output of the catchment formulations of this layer
+         *
+         * The layer adds a table to the writer named after it, with a row per catchment; catchment output is then
+         * no longer written to the formulations' own output streams.
+         *
+         * @param writer The writer to use, or ``nullptr`` to write each formulation's output to its own stream
+        */
+        virtual void set_output_writer(std::shared_ptr<utils::ColumnarOutputWriter> writer)
+        {
+            output_writer = writer;
+            if(output_writer == nullptr) return;
+
+            std::vector<std::vector<std::string>> variables;
+            variables.reserve(processing_units.size());
+            for(std::size_t i = 0; i < catchments.size(); ++i)
+            {
+                std::vector<std::string> fields;
+                boost::split(fields, formulation_of(i).get_output_header_line(","), boost::is_any_of(","));
+                variables.push_back(std::move(fields));
+            }
+            output_table = output_writer->add_table(get_name() + "_layer_" + std::to_string(get_id()), processing_units, variables);
+        }
+
         /***
          * @brief Run one simulation timestep for each model in this layer
+         *
+         * When a thread pool is set, model responses are computed concurrently, with catchments claimed in
+         * ``processing_units`` order.  Output writing and nexus contributions are applied on the calling thread in
+         * that same order as soon as each catchment's response is ready, so they overlap with the computation of later
+         * catchments while nexus sums and output files stay identical to a serial run.
         */
         virtual void update_models()
         {
@@ -109,57 +251,107 @@ namespace ngen
             //std::cout<<"Output Time Index: "<<output_time_index<<std::endl;
             if(output_time_index%100 == 0) std::cout<<"Running timestep " << output_time_index <<std::endl;
             std::string current_timestamp = simulation_time.get_timestamp(output_time_index);
-            for(const auto& id : processing_units) 
+
+            const std::size_t num_units = processing_units.size();
+            responses.resize(num_units);
+            if(output_writer == nullptr){
+                output_lines.resize(num_units);
+            }
+            else{
+                output_values.resize(num_units);
+            }
+            errors.assign(num_units, nullptr);
+
+            //Models serving many catchments take the inputs of all of them before any response is computed
+            for(std::size_t i = 0; i < num_units; ++i)
             {
-                int sub_time = output_time_index;
-                //std::cout<<"Running cat "<<id<<std::endl;
-                auto r = features.catchment_at(id);
-                //TODO redesign to avoid this cast
-                auto r_c = std::dynamic_pointer_cast<realization::Catchment_Formulation>(r);
-                double response(0.0);
                 try{
-                    response = r_c->get_response(output_time_index, simulation_time.get_output_interval_seconds());
+                    formulation_of(i).prepare_response(output_time_index, step);
                 }
                 catch(models::external::State_Exception& e){
                     std::string msg = e.what();
                     msg = msg+" at timestep "+std::to_string(output_time_index)
                              +" ("+current_timestamp+")"
-                             +" at feature id "+id;
+                             +" at feature id "+processing_units[i];
                     throw models::external::State_Exception(msg);
                 }
-                std::string output = std::to_string(output_time_index)+","+current_timestamp+","+
-                                    r_c->get_output_line_for_timestep(output_time_index)+"\n";
-                r_c->write_output(output);
-                //TODO put this somewhere else.  For now, just trying to ensure we get m^3/s into nexus output
-                double area;
+            }
+
+            auto run_unit = [this](std::size_t i)
+            {
+                const std::string& id = processing_units[i];
+                //std::cout<<"Running cat "<<id<<std::endl;
+                realization::Catchment_Formulation* r_c = catchments[i].formulation.get();
                 try{
-                    area = catchment_data->get_feature(id)->get_property("areasqkm").as_real_number();
+                    utils::Profile_Scope profile(utils::Profiler::CATCHMENT, id);
+                    responses[i] = r_c->get_response(output_time_index, simulation_time.get_output_interval_seconds());
+                    if(output_writer == nullptr){
+                        output_lines[i] = r_c->get_output_line_for_timestep(output_time_index);
+                    }
+                    else{
+                        output_values[i] = r_c->get_output_values_for_timestep(output_time_index);
+                    }
                 }
-                catch(std::invalid_argument &e)
-                {
-                    area = catchment_data->get_feature(id)->get_property("area_sqkm").as_real_number();
+                catch(...){
+                    // Hold on to the error so it is raised in catchment order below
+                    errors[i] = std::current_exception();
                 }
-                double response_m_s = response * (area * 1000000);
-                //TODO put this somewhere else as well, for now, an implicit assumption is that a module's get_response returns
-                //m/timestep
-                //since we are operating on a 1 hour (3600s) dt, we need to scale the output appropriately
-                //so no response is m^2/hr...m^2/hr * 1hr/3600s = m^3/hr
-                double response_m_h = response_m_s / 3600.0;
-                //update the nexus with this flow
-                for(auto& nexus : features.destination_nexuses(id)) {
-                    //TODO in a DENDRITIC network, only one destination nexus per catchment
-                    //If there is more than one, some form of catchment partitioning will be required.
-                    //for now, only contribute to the first one in the list
-                    if(nexus == nullptr){
-                        throw std::runtime_error("Invalid (null) nexus instantiation downstream of "+id+". "+SOURCE_LOC);
-                    }
-                    nexus->add_upstream_flow(response_m_h, id, output_time_index);
-                    /*std::cerr << "Add water to nexus ID = " << nexus->get_id() << " from catchment ID = " << id << " value = "
-                              << response << ", ID = " << id << ", time-index = " << output_time_index << std::endl; */
-                    break;
+            };
+
+            if(thread_pool != nullptr){
+                if(ready_size != num_units){
+                    ready.reset(new std::atomic<bool>[num_units]);
+                    ready_size = num_units;
+                }
+                for(std::size_t i = 0; i < num_units; ++i){
+                    ready[i].store(false, std::memory_order_relaxed);
                 }
-                
-            } //done catchments   
+                thread_pool->start(num_units, [this, run_unit](std::size_t i){
+                    run_unit(i);
+                    ready[i].store(true, std::memory_order_release);
+                });
+            }
+
+            std::size_t i = 0;
+            try{
+                for(; i < num_units; ++i)
+                {
+                    if(thread_pool != nullptr){
+                        //Help with outstanding catchments until this one is done
+                        while(!ready[i].load(std::memory_order_acquire)){
+                            if(!thread_pool->help()) std::this_thread::yield();
+                        }
+                    }
+                    else{
+                        run_unit(i);
+                    }
+                    if(errors[i] != nullptr){
+                        std::rethrow_exception(errors[i]);
+                    }
+                    apply_unit(i, current_timestamp);
+                    catchment_complete(i);
+                } //done catchments
+            }
+            catch(models::external::State_Exception& e){
+                if(thread_pool != nullptr) thread_pool->wait();
+                std::string msg = e.what();
+                msg = msg+" at timestep "+std::to_string(output_time_index)
+                         +" ("+current_timestamp+")"
+                         +" at feature id "+processing_units[i];
+                throw models::external::State_Exception(msg);
+            }
+            catch(...){
+                //Workers still reference this layer, so they must finish before the error propagates
+                if(thread_pool != nullptr) thread_pool->wait();
+                throw;
+            }
+            if(thread_pool != nullptr){
+                thread_pool->wait();
+            }
+            if(output_writer != nullptr){
+                //get_timestamp above set the current time to that of this timestep
+                output_writer->end_time_step(output_table, simulation_time.get_current_epoch_time());
+            }
 
             ++output_time_index;
             if ( output_time_index < simulation_time.get_total_output_times() )
@@ -171,6 +363,17 @@ namespace ngen
 
         protected:
 
+        /***
+         * @brief Called after the response of ``processing_units[unit_index]`` for the current timestep has been
+         * written and contributed to its destination nexus
+         *
+         * Catchments complete in ``processing_units`` order, on the thread calling update_models.  The default does
+         * nothing.
+         *
+         * @param unit_index The index of the completed catchment in ``processing_units``
+        */
+        virtual void catchment_complete(std::size_t unit_index) {}
+
         const LayerDescription description;
         //TODO is this really required at the top level?
         //See "minimum" constructor above used for DomainLayer impl...
@@ -180,6 +383,135 @@ namespace ngen
         //TODO is this really required at the top level? or can this be moved to SurfaceLayer?
         const geojson::GeoJSON catchment_data;
         long output_time_index;       
+        //Used to run catchment formulations concurrently; serial execution when null
+        std::shared_ptr<utils::ThreadPool> thread_pool;
+        //Receives catchment output when set, in place of the formulations' output streams
+        std::shared_ptr<utils::ColumnarOutputWriter> output_writer;
+        std::size_t output_table = 0;
+
+        private:
+
+        /***
+         * @brief What is needed to run and apply each of ``processing_units``, looked up once rather than every
+         * timestep
+         *
+         * Records are indexed like ``processing_units``, which is also each catchment's row of the output table.
+        */
+        struct catchment_record
+        {
+            std::shared_ptr<realization::Catchment_Formulation> formulation;
+            //Catchment area in square kilometers
+            double area_sqkm = 0.0;
+            //The nexus receiving the catchment's response, or null if there is none
+            std::shared_ptr<HY_HydroNexus> destination;
+            //The index of the catchment as a contributor to destination
+            std::size_t contributor = 0;
+        };
+
+        realization::Catchment_Formulation& formulation_of(std::size_t i)
+        {
+            if(catchments[i].formulation == nullptr)
+            {
+                throw std::runtime_error("Catchment " + processing_units[i] + " of layer " + get_name()
+                                         + " has no formulation");
+            }
+            return *catchments[i].formulation;
+        }
+
+        /***
+         * @brief The index of the first catchment whose formulation cannot run concurrently, or
+         * ``catchments.size()`` if there is none
+        */
+        std::size_t unsafe_catchment() const
+        {
+            for(std::size_t i = 0; i < catchments.size(); ++i)
+            {
+                const auto& r_c = catchments[i].formulation;
+                if(r_c != nullptr && !r_c->is_thread_safe()) return i;
+            }
+            return catchments.size();
+        }
+
+        void init_catchment_records()
+        {
+            catchments.clear();
+            catchments.reserve(processing_units.size());
+            for(const auto& id : processing_units)
+            {
+                catchment_record record;
+                //TODO redesign to avoid this cast
+                record.formulation = std::dynamic_pointer_cast<realization::Catchment_Formulation>(features.catchment_at(id));
+                #if !NGEN_QUIET
+                if(record.formulation == nullptr){
+                    std::cerr<<"WARNING: catchment "<<id<<" of layer "<<get_name()<<" has no formulation"<<std::endl;
+                }
+                #endif
+                //TODO put this somewhere else.  For now, just trying to ensure we get m^3/s into nexus output
+                try{
+                    record.area_sqkm = catchment_data->get_feature(id)->get_property("areasqkm").as_real_number();
+                }
+                catch(std::invalid_argument &e)
+                {
+                    record.area_sqkm = catchment_data->get_feature(id)->get_property("area_sqkm").as_real_number();
+                }
+                for(auto& nexus : features.destination_nexuses(id)) {
+                    //TODO in a DENDRITIC network, only one destination nexus per catchment
+                    //If there is more than one, some form of catchment partitioning will be required.
+                    //for now, only contribute to the first one in the list
+                    if(nexus == nullptr){
+                        throw std::runtime_error("Invalid (null) nexus instantiation downstream of "+id+". "+SOURCE_LOC);
+                    }
+                    record.destination = nexus;
+                    record.contributor = nexus->get_contributor_index(id);
+                    break;
+                }
+                catchments.push_back(std::move(record));
+            }
+        }
+
+        /***
+         * @brief Write the output of ``processing_units[i]`` and contribute its response to its destination nexus
+        */
+        void apply_unit(std::size_t i, const std::string& current_timestamp)
+        {
+            const catchment_record& catchment = catchments[i];
+            double response = responses[i];
+            {
+                static const std::string profile_name = "catchment";
+                utils::Profile_Scope profile(utils::Profiler::OUTPUT, profile_name);
+                if(output_writer == nullptr){
+                    std::string output = std::to_string(output_time_index)+","+current_timestamp+","+
+                                        output_lines[i]+"\n";
+                    catchment.formulation->write_output(output);
+                }
+                else{
+                    output_writer->set_values(output_table, i, output_values[i]);
+                }
+            }
+            double response_m_s = response * (catchment.area_sqkm * 1000000);
+            //TODO put this somewhere else as well, for now, an implicit assumption is that a module's get_response returns
+            //m/timestep
+            //since we are operating on a 1 hour (3600s) dt, we need to scale the output appropriately
+            //so no response is m^2/hr...m^2/hr * 1hr/3600s = m^3/hr
+            double response_m_h = response_m_s / 3600.0;
+            //update the nexus with this flow
+            if(catchment.destination != nullptr) {
+                catchment.destination->add_upstream_flow(response_m_h, catchment.contributor, output_time_index);
+                /*std::cerr << "Add water to nexus ID = " << catchment.destination->get_id() << " from catchment ID = " << id << " value = "
+                          << response << ", ID = " << id << ", time-index = " << output_time_index << std::endl; */
+            }
+        }
+
+        //Indexed like processing_units
+        std::vector<catchment_record> catchments;
+        //Per-timestep scratch space, indexed like processing_units
+        std::vector<double> responses;
+        std::vector<std::string> output_lines;
+        std::vector<std::vector<double>> output_values;
+        std::vector<std::exception_ptr> errors;
+        //Set by workers once the matching response is computed
+        std::unique_ptr<std::atomic<bool>[]> ready;
+        std::size_t ready_size = 0;
 
     };
 }
@@ -0,0 +1,68 @@
+#ifndef PARTITION_BISECTION_H
+#define PARTITION_BISECTION_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Weighted graph partitioner using multilevel recursive bisection.
+ *
+ * Vertices carry a cost (e.g. the estimated or measured run time of a catchment) and edges the cost of cutting them
+ * (e.g. the remote nexus messages needed when connected catchments are on different ranks).  The graph is split into
+ * the requested number of partitions of near equal total vertex cost, while keeping the total weight of cut edges low.
+ *
+ * Each bisection coarsens the graph by repeatedly merging vertices along their heaviest edges, bisects the small
+ * coarsest graph by greedy region growing, then projects the bisection back through the levels, improving it at each
+ * level with Fiduccia-Mattheyses refinement.  Partition counts other than powers of two are handled by bisecting with
+ * unequal target weights.
+ *
+ * The result is deterministic for a given graph.
+ */
+class Partition_Bisection {
+
+    public:
+
+        /**
+         * @param vertex_weights The cost of each vertex, which must be non-negative.
+         * @param edges Pairs of vertex indices, each adding a weight of 1 to the edge between them.  Self loops are
+         *              ignored and repeated pairs accumulate.
+         */
+        Partition_Bisection(const std::vector<double>& vertex_weights,
+                            const std::vector<std::pair<std::size_t, std::size_t>>& edges);
+
+        /**
+         * Partition the graph.
+         *
+         * @param num_partitions The number of partitions, which must be between 1 and the number of vertices.
+         * @param imbalance The allowed relative excess of a partition's cost over the average, e.g. 0.03 for 3%.
+         *                  It may be exceeded when single vertices are too heavy to balance.
+         * @return The partition of each vertex, in ``[0, num_partitions)``.  Every partition has at least one vertex.
+         */
+        std::vector<int> partition(int num_partitions, double imbalance = 0.03) const;
+
+        /** @return The total weight of the edges between vertices in different partitions. */
+        double edge_cut(const std::vector<int>& parts) const;
+
+        /** @return The total vertex cost of each partition. */
+        std::vector<double> partition_weights(const std::vector<int>& parts, int num_partitions) const;
+
+        /**
+         * Graph in compressed sparse row form: the neighbors of vertex ``v`` are
+         * ``adjacency[offsets[v]] .. adjacency[offsets[v + 1] - 1]``.
+         */
+        struct Graph {
+            std::vector<std::size_t> offsets;
+            std::vector<std::size_t> adjacency;
+            std::vector<double> edge_weights;
+            std::vector<double> vertex_weights;
+
+            std::size_t size() const { return vertex_weights.size(); }
+        };
+
+    private:
+
+        Graph graph;
+};
+
+#endif // PARTITION_BISECTION_H
@@ -2,6 +2,7 @@
 #define __NGEN_SURFACE_LAYER__
 
 #include "Layer.hpp"
+#include "NexusFlowBuffer.hpp"
 
 namespace ngen
 {
@@ -22,7 +23,7 @@ namespace ngen
                     nexus_ids(n_u), 
                     nexus_outfiles(output_files)
         {
-
+            init_nexus_release();
         }
 
         /***
@@ -30,11 +31,69 @@ namespace ngen
         */
         void update_models() override;
 
+        /***
+         * @brief Write the flow of the given nexuses to a ``nexus`` table of a columnar writer
+         *
+         * Nexuses with an open output file are still written to it as well.
+         *
+         * @param writer The writer to use, or ``nullptr`` to only write nexus output files
+         * @param ids The nexuses whose flow is written, e.g. those this rank is responsible for
+        */
+        void set_nexus_output_writer(std::shared_ptr<utils::ColumnarOutputWriter> writer, const std::vector<std::string>& ids);
+
+        /***
+         * @brief Keep the flow of nexuses in a buffer, e.g. to pass it to routing in memory
+         *
+         * Nexuses the buffer does not hold are not kept.  Nexus output files and tables are still written as well.
+         *
+         * @param buffer The buffer to use, or ``nullptr`` to not keep nexus flows
+        */
+        void set_nexus_flow_buffer(std::shared_ptr<NexusFlowBuffer> buffer);
+
+        protected:
+
+        /***
+         * @brief Release the destination nexus of a catchment once all of its contributing catchments are complete
+        */
+        void catchment_complete(std::size_t unit_index) override;
+
         private:
 
+        /***
+         * @brief Determine which nexuses can be released as soon as their contributing catchments are complete
+         *
+         * A nexus qualifies when all of its contributing catchments are in this layer and, for MPI, it has no remote
+         * counterpart.  All other nexuses are released only after every catchment of the layer is complete.
+        */
+        void init_nexus_release();
+
+        /***
+         * @brief Request the flow of ``release_ids[n]`` for the current timestep and write it to the nexus output
+        */
+        void release_nexus(std::size_t n, long time_index, const std::string& timestamp);
+
         std::vector<std::string> nexus_ids;
         std::unordered_map<std::string, std::ofstream>& nexus_outfiles;
+
+        //Nexuses to release every timestep, in network order
+        std::vector<std::string> release_ids;
+        //Number of catchments in this layer contributing to each nexus of release_ids, or 0 if it is released last
+        std::vector<std::size_t> contributor_counts;
+        //Index into release_ids of each processing unit's destination nexus, or -1 if that nexus is released last
+        std::vector<long> unit_release_index;
+        //Per-timestep state, indexed like release_ids
+        std::vector<std::size_t> remaining_contributors;
+        std::vector<bool> released;
+
+        std::shared_ptr<utils::ColumnarOutputWriter> nexus_output_writer;
+        std::size_t nexus_output_table = 0;
+        //Row of each nexus in the nexus output table
+        std::unordered_map<std::string, std::size_t> nexus_output_rows;
+
+        std::shared_ptr<NexusFlowBuffer> nexus_flow_buffer;
+        //Row of each of release_ids in the nexus flow buffer, or -1 if the buffer does not hold it
+        std::vector<long> nexus_flow_rows;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
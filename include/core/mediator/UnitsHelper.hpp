@@ -17,27 +17,86 @@
 #  include <udunits2.h>
 #endif
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include "all.h"
 
 class UnitsHelper {
 
     public:
 
+    /**
+     * A conversion between a pair of units.
+     *
+     * Conversions are interned by @ref get_conversion, so each pair of units is parsed once, and the returned
+     * conversion stays valid (at the same address) for the life of the program.  Converting with one does not lock
+     * anything and is safe to do from multiple threads.
+     *
+     * Most conversions are linear (a scale and an offset), which are applied directly; others (e.g., logarithmic) are
+     * passed to UDUNITS.
+     */
+    class conversion {
+        public:
+
+        double convert(double value) const {
+            if (identity) {
+                return value;
+            }
+            if (linear) {
+                return value * scale + offset;
+            }
+            return cv_convert_double(converter.get(), value);
+        }
+
+        /**
+         * Convert @p count values from @p in_values to @p out_values, which may be the same.
+         */
+        void convert(const double* in_values, double* out_values, size_t count) const;
+
+        bool is_identity() const { return identity; }
+
+        private:
+
+        friend class UnitsHelper;
+
+        bool identity = false;
+        bool linear = false;
+        double scale = 1.0;
+        double offset = 0.0;
+        std::shared_ptr<cv_converter> converter;
+        /** Why the units cannot be converted, or empty if they can. */
+        std::string error;
+    };
+
     static double get_converted_value(const std::string &in_units, const double &value, const std::string &out_units);
 
     static double* convert_values(const std::string &in_units, double* values, const std::string &out_units, double* out_values, const size_t & count);
 
+    /**
+     * Get the conversion between a pair of units, parsing them the first time the pair is requested.
+     *
+     * Callers converting many values between the same units (e.g., at each time step) should get the conversion
+     * once and keep a reference to it.
+     *
+     * @throws std::runtime_error If either units value is empty or cannot be parsed, or the units are not convertible.
+     */
+    static const conversion& get_conversion(const std::string& in_units, const std::string& out_units);
+
     private:
-     
-    // Theoretically thread-safe. //TODO: Test?
+
     static ut_system* unit_system;
 
-    static std::map<std::string, std::shared_ptr<cv_converter>> converters;
-    static std::mutex converters_mutex;
+    /** Interned conversions by input units, then output units. */
+    static std::unordered_map<std::string, std::unordered_map<std::string, const conversion*>> conversions;
+    /** Storage for interned conversions; elements never move. */
+    static std::deque<conversion> conversion_store;
+    static std::shared_timed_mutex conversions_mutex;
 
     static std::once_flag unit_system_inited;
     static void init_unit_system(){
@@ -46,7 +105,7 @@ class UnitsHelper {
         #else
         unit_system = ut_read_xml(NULL);
         #endif
-        if (unit_system == NULL) 
+        if (unit_system == NULL)
         {
             throw std::runtime_error("Unable to create UDUNITS2 Unit System." SOURCE_LOC);
         }
@@ -55,7 +114,7 @@ class UnitsHelper {
         #endif
     }
 
-    static std::shared_ptr<cv_converter> get_converter(const std::string& in_units, const std::string& out_units, utEncoding in_encoding = UT_UTF8, utEncoding out_encoding = UT_UTF8 );
+    static conversion make_conversion(const std::string& in_units, const std::string& out_units, utEncoding in_encoding = UT_UTF8, utEncoding out_encoding = UT_UTF8 );
 
 };
 
@@ -36,7 +36,13 @@ namespace network {
      * Transposed because the hydrograph "tree" is actually most like an inverted tree structure, with headwaters as the "root" nodes
      * and coastal drainage as the "leaves". This transposed traversal lets us traverse upstream instead of downstream.
      */
-    TransposedDepthFirstPreorder
+    TransposedDepthFirstPreorder,
+    /**
+     * @brief Ascending topological level ("wavefront") order. Headwaters are level 0 and every other feature is one level
+     * below its deepest upstream neighbor, so all features of a level only depend on features of earlier levels.
+     * Features within a level keep their relative topological order.
+     */
+    Level
   };
   /**
    * @brief The structure defining graph vertex properties.
@@ -291,6 +297,25 @@ namespace network {
          */
         std::vector<std::string> get_destination_ids(const std::string& id);
 
+        /**
+         * @brief Get the topological level of @p id, i.e. the length of the longest upstream path to a headwater.
+         * 
+         * Levels are computed once when the network is constructed.  Headwaters are level 0.
+         * 
+         * @param id 
+         * @return std::size_t
+         * 
+         * @throw std::invalid_argument if @p id is not a feature of this network
+         */
+        std::size_t get_level(const std::string& id);
+
+        /**
+         * @brief The number of topological levels in the network, i.e. one more than the largest level of any feature
+         * 
+         * @return std::size_t 
+         */
+        std::size_t num_levels();
+
         /**
          * @brief The number of features in the network (number of vertices)
          * 
@@ -340,6 +365,19 @@ namespace network {
 
         NetworkIndexT tdfp_order;
 
+        /**
+         * @brief Vector of features in descending topological level, see SortOrder::Level
+         * 
+         * Stored in descending order so that, like the other indices, reversing it gives upstream to downstream order.
+         */
+        NetworkIndexT level_order;
+
+        /**
+         * @brief Topological level of each feature, indexed by graph vertex descriptor
+         * 
+         */
+        std::vector<std::size_t> levels;
+
         /**
          * @brief Vector of headwater features
          * 
@@ -1,7 +1,10 @@
 #ifndef HY_HYDRONEXUS_H
 #define HY_HYDRONEXUS_H
 
+#include <cstddef>
+#include <istream>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 
@@ -31,6 +34,13 @@ class HY_HydroNexus
     /** Increase the downstream flow for timestep_t by input amount*/
     virtual void add_upstream_flow(double val, std::string catchement_id, time_step_t t)=0;
 
+    /** Get the index identifying a contributing catchment, for repeated calls of the indexed add_upstream_flow.
+    *   The index stays valid for the life of the nexus. */
+    virtual std::size_t get_contributor_index(const std::string& catchment_id)=0;
+
+    /** Increase the downstream flow for timestep_t by input amount, from the contributor with the given index */
+    virtual void add_upstream_flow(double val, std::size_t contributor, time_step_t t)=0;
+
     /** get a precentage of the downstream flow at requested time_step. Record the requesting percentage*/
     virtual double get_downstream_flow(std::string catchment_id, time_step_t t, double percent_flow)=0;
 
@@ -39,6 +49,13 @@ class HY_HydroNexus
 
     /** get the units that the flows are described in */
     virtual std::string get_flow_units()=0;
+
+    /** Write the flows of this nexus that have not yet been released to a checkpoint.
+    *   Nexus types that hold no such state do not need to override this. */
+    virtual void write_state(std::ostream& out) const {}
+
+    /** Restore the flows written by write_state, in place of any held by this nexus. */
+    virtual void read_state(std::istream& in) {}
     
     const Catchments& get_receiving_catchments() {
         return receiving_catchments;
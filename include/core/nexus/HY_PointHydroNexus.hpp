@@ -3,8 +3,8 @@
 
 #include <HY_HydroNexus.hpp>
 
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
+#include <vector>
 
 class HY_PointHydroNexus : public HY_HydroNexus
 {
@@ -19,6 +19,12 @@ class HY_PointHydroNexus : public HY_HydroNexus
         /** add flow to this nexus for timestep t. */
         void add_upstream_flow(double val, std::string catchment_id, time_step_t t) override;
 
+        /** get the index of a contributing catchment, adding it if it hasn't been seen before. */
+        std::size_t get_contributor_index(const std::string& catchment_id) override;
+
+        /** add flow to this nexus for timestep t, from the contributor with the given index. */
+        void add_upstream_flow(double val, std::size_t contributor, time_step_t t) override;
+
         /** inspect a nexus to see what flows are recorded at a time step. */
         std::pair<double, int> inspect_upstream_flows(time_step_t t) override;
 
@@ -30,18 +36,64 @@ class HY_PointHydroNexus : public HY_HydroNexus
 
         void set_mintime(time_step_t);
 
+        /** Write the time steps of this nexus that have not been completed, with their flows, requests and
+        *   contributors, to a checkpoint. */
+        void write_state(std::ostream& out) const override;
+
+        /** Replace the time steps of this nexus with those written by write_state. */
+        void read_state(std::istream& in) override;
+
     protected:
-    using flows = std::pair<std::string, double>;
-    using flow_vector = std::vector< flows >;
 
-    /** The current downstream flow through this Point Nexus.*/
-    std::unordered_map<time_step_t, flow_vector > upstream_flows;
-    std::unordered_map<time_step_t, flow_vector > downstream_requests;
-    std::unordered_map<time_step_t, double> summed_flows;
-    std::unordered_map<time_step_t, double> total_requests;
+    /** Test whether every catchment in ids has added flow for timestep t. */
+    bool has_upstream_flows_from(const Catchments& ids, time_step_t t);
+
+    private:
+
+    /** Bookkeeping for one time step that has received flow and has not yet been fully released. */
+    struct time_step_flows
+    {
+        /** The time step held by this slot, if used. */
+        time_step_t t;
+        /** Whether the slot holds a time step. */
+        bool used;
+        /** Whether all flow for this time step has been released. */
+        bool completed;
+        /** Whether flows have been summed by a first downstream request; no more flow may be added once true. */
+        bool summed;
+        int upstream_count;
+        int request_count;
+        /** Running total of added flows, in the order they were added. */
+        double upstream_total;
+        /** Running total of requested percentages. */
+        double total_requests;
+    };
+
+    /** Find the slot holding t, or nullptr if there is none. */
+    time_step_flows* find_slot(time_step_t t);
+
+    /** Find the slot holding t, claiming one (and growing the ring if needed) if there is none. */
+    time_step_flows& claim_slot(time_step_t t);
+
+    /** Get the small integer index of a contributor, adding it if it hasn't been seen before.
+    *   Contributors are never removed, so indices stay valid for the life of the nexus. */
+    std::size_t contributor_index(const std::string& catchment_id);
+
+    /** Mark the slot complete and advance completed_through past any contiguous completed time steps. */
+    void complete(time_step_flows& slot);
+
+    void grow();
+
+    /** Ring buffer of time step bookkeeping, indexed by t modulo its size. */
+    std::vector<time_step_flows> slots;
+    /** Per slot and contributor, the number of flows added; a (slots.size() x contributors.size()) row-major matrix. */
+    std::vector<std::uint16_t> contributions;
+    /** Contributor ids, addressed by index. Contributing catchments come first, others are added as they are seen. */
+    std::vector<std::string> contributors;
 
     time_step_t min_timestep{0};
-    std::unordered_set<time_step_t> completed;
+    /** Every time step up to and including this one has been completed (or is before min_timestep). */
+    time_step_t completed_through{-1};
 
 };
 
@@ -9,17 +9,28 @@
 #include <mpi.h>
 #include <vector>
 
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <list>
 #include <exception>
 
+class RemoteNexusExchange;
+
 /** This class represents a point nexus that can have both upstream and downstream connections to catchments that are
 *   in seperate MPI processes.
 *
 *   When attempting to add upstream flows from a remote catchment a MPI_Irecv call will be generated
-*   When attempting to send flows to remote downstream a MPI_Send will be generated
-*   In either case the change in local water amounts for the time step will be recorded when the MPI operation completes */
+*   When attempting to send flows to remote downstream a MPI_Isend will be generated
+*   In either case the change in local water amounts for the time step will be recorded when the MPI operation completes
+*
+*   The flow through the nexus is split evenly between its receiving catchments, which may be on several ranks.  The
+*   share of each downstream rank is sent to it, and percentages requested through get_downstream_flow are always of
+*   the total flow through the nexus, so a request yields the same flow however the receivers are partitioned.
+*
+*   When the nexus is attached to a RemoteNexusExchange, its flows are instead aggregated with those of all other
+*   nexuses communicating with the same rank, see RemoteNexusExchange. */
 
 class HY_PointHydroNexusRemote : public HY_PointHydroNexus
 {
@@ -34,13 +45,16 @@ class HY_PointHydroNexusRemote : public HY_PointHydroNexus
 
         virtual ~HY_PointHydroNexusRemote();
 
-        /** get the request percentage of downstream flow through this nexus at timestep t. If the indicated catchment is not local a async send will be
-            created. Will attempt to process all async receives currently queued before processing flows*/
+        /** get the request percentage of downstream flow through this nexus at timestep t. Remote flows for t are received first.
+            The percentage is of the total flow through the nexus, and requests on this rank may not exceed get_local_share() in total.*/
         double get_downstream_flow(std::string catchment_id, time_step_t t, double percent_flow) override;
 
         /** add flow to this nexus for timestep t. If the indicated catchment is not local an async receive will be started*/
         void add_upstream_flow(double val, std::string catchment_id, time_step_t t) override;
 
+        /** add flow to this nexus for timestep t, from the contributor with the given index. */
+        void add_upstream_flow(double val, std::size_t contributor, time_step_t t) override;
+
         /** extract a numeric id from the catchment id for use as a mpi tag */
         static long extract(std::string s) {  return std::stoi( s.substr( s.find(hy_features::identifiers::seperator)+1 ) ); }
         
@@ -48,6 +62,26 @@ class HY_PointHydroNexusRemote : public HY_PointHydroNexus
             return local_contributers;
         };
 
+        /** Route the communication of this nexus through a per-rank exchange rather than per-nexus messages.
+         *  This is set by RemoteNexusExchange::add_nexus, which must outlive this nexus' communication. */
+        void set_exchange(RemoteNexusExchange* exchange) { this->exchange = exchange; }
+
+        /** The ranks of the remote catchments receiving flow from this nexus */
+        const std::unordered_set<int>& get_downstream_ranks() const { return downstream_ranks; }
+
+        /** The percentage of the flow through this nexus passed to each downstream rank */
+        const std::map<int, double>& get_downstream_shares() const { return downstream_shares; }
+
+        /** The percentage of the flow through this nexus passed to receiving catchments on this rank */
+        double get_local_share() const { return local_share; }
+
+        /** Test if this rank holds the primary copy of the nexus, i.e. it hosts the first (by id) receiving catchment.
+         *  Exactly one rank holds the primary copy of a nexus with receiving catchments. */
+        bool is_primary_copy() const { return primary_copy; }
+
+        /** The ranks of the remote catchments contributing flow to this nexus */
+        const std::unordered_set<int>& get_upstream_ranks() const { return upstream_ranks; }
+
 		/** Test if this nexus is a sending nexus in a remote nexus pair */
         bool is_remote_sender()
         {
@@ -73,6 +107,15 @@ class HY_PointHydroNexusRemote : public HY_PointHydroNexus
     private:
         void process_communications();
 
+        /** Send flow for timestep t to the copy of this nexus on a downstream rank */
+        void send(int rank, time_step_t t, double flow);
+
+        /** Greatest time step for which flows from the upstream ranks were received */
+        time_step_t received_through = -1;
+
+        /** The exchange aggregating this nexus' messages, or nullptr to communicate per nexus */
+        RemoteNexusExchange* exchange = nullptr;
+
         int world_rank;
 
         long time_step;
@@ -110,6 +153,15 @@ class HY_PointHydroNexusRemote : public HY_PointHydroNexus
          *  Note that in a dendritic network, downstream_ranks.size() == 1 (only one downstream receiver on a single rank)
          */
         std::unordered_set<int> downstream_ranks; //Set
+        /** Percentage of flow to send to each downstream rank, ordered by rank
+         *
+         */
+        std::map<int, double> downstream_shares;
+        /** Percentage of flow passed to receiving catchments local to this rank
+         *
+         */
+        double local_share = 100.0;
+        bool primary_copy = true;
         /** List of ranks we expect to receive data from
          * 
          */
@@ -0,0 +1,105 @@
+#ifndef NEXUS_FLOW_BUFFER_H
+#define NEXUS_FLOW_BUFFER_H
+
+#include <NGenConfig.h>
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if NGEN_WITH_MPI
+#include <mpi.h>
+#endif
+
+/** The flow of a set of nexuses over every output time step of a simulation, in memory.
+*
+*   Flows are held in one contiguous row-major [nexus x time] array, so the whole simulation can be handed to routing
+*   without writing and re-reading a file per nexus.  Time steps not yet set hold NaN.
+*
+*   A buffer may also hold a window of the simulation's time steps, starting at @ref first_time_index(), so that
+*   flows can be handed off in chunks while the simulation continues (see @ref start_window).
+*/
+class NexusFlowBuffer
+{
+    public:
+        /** Create a buffer for the flow of @p ids over @p num_times time steps, starting at @p first_time */
+        NexusFlowBuffer(std::vector<std::string> ids, std::size_t num_times, long first_time = 0);
+
+        /** @return The row of nexus @p id, or -1 if the buffer does not hold it */
+        long row(const std::string& id) const;
+
+        /** Set the flow, in m^3/s, of the nexus in @p row for time step @p time_index
+        *
+        *   @throws std::out_of_range If the buffer does not hold @p row or @p time_index
+        */
+        void set(std::size_t row, long time_index, double flow)
+        {
+            if(row >= num_nexuses() || !holds_time(time_index)) {
+                throw std::out_of_range("Nexus flow buffer of " + std::to_string(num_nexuses()) + " rows and "
+                                        + std::to_string(times) + " time steps from " + std::to_string(first_time)
+                                        + " does not hold row " + std::to_string(row) + " at time step "
+                                        + std::to_string(time_index));
+            }
+            flows[row * times + (time_index - first_time)] = flow;
+        }
+
+        /** @return The flow, in m^3/s, of the nexus in @p row for time step @p time_index */
+        double get(std::size_t row, long time_index) const
+        {
+            assert(row < num_nexuses() && holds_time(time_index));
+            return flows[row * times + (time_index - first_time)];
+        }
+
+        /** @return Whether time step @p time_index is within the window of time steps held by the buffer */
+        bool holds_time(long time_index) const
+        {
+            return time_index >= first_time && time_index - first_time < static_cast<long>(times);
+        }
+
+        /** Replace the held time steps with @p num_times time steps starting at @p first_time, all NaN */
+        void start_window(long first_time, std::size_t num_times);
+
+        /** Move the held time steps into a new buffer for the same nexuses, leaving this one holding none until
+        *   @ref start_window */
+        NexusFlowBuffer take_window();
+
+        /** Hand over the row-major [nexus x time] array of flows, leaving the buffer holding no time steps until
+        *   @ref start_window */
+        std::vector<double> take_flows();
+
+        /** @return The nexus of each row */
+        const std::vector<std::string>& ids() const { return nexus_ids; }
+
+        std::size_t num_nexuses() const { return nexus_ids.size(); }
+
+        std::size_t num_times() const { return times; }
+
+        /** @return The simulation time step of the first column of the buffer */
+        long first_time_index() const { return first_time; }
+
+        /** @return The row-major [nexus x time] array of flows */
+        const double* data() const { return flows.data(); }
+
+        #if NGEN_WITH_MPI
+        /** Combine the buffers of every rank into the buffer of @p root.
+        *
+        *   This is collective over @p comm.  Rows from each rank are appended to those of @p root in rank order; every
+        *   rank must have the same number of time steps.  Buffers of other ranks are left unchanged.
+        *
+        *   @throws std::runtime_error On every rank, if the time steps differ between ranks or the combined flows or
+        *   ids exceed the INT_MAX elements a single MPI gather can address.
+        */
+        void gather(int root, MPI_Comm comm = MPI_COMM_WORLD);
+        #endif
+
+    private:
+        std::vector<std::string> nexus_ids;
+        std::size_t times;
+        long first_time;
+        std::vector<double> flows;
+        std::unordered_map<std::string, std::size_t> rows;
+};
+
+#endif //NEXUS_FLOW_BUFFER_H
@@ -0,0 +1,115 @@
+#ifndef REMOTE_NEXUS_EXCHANGE_H
+#define REMOTE_NEXUS_EXCHANGE_H
+
+#include <NGenConfig.h>
+#if NGEN_WITH_MPI
+
+#include <mpi.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <HY_HydroNexus.hpp>
+
+class HY_PointHydroNexusRemote;
+
+/** Per-rank exchange of remote nexus flows, aggregated by neighbor rank.
+*
+*   Every remote nexus pair between this rank and a neighbor rank is assigned a fixed slot in a single message, so all
+*   flows headed to the same neighbor for a time step travel in one message rather than one message per nexus.  Both
+*   ranks order the slots of a neighbor by nexus id, so a message carries only the time step followed by one flow per
+*   slot.  Messages use persistent requests on a private communicator:
+*
+*   - a neighbor's message is started as soon as its last slot is filled, so it is in flight while the rest of the
+*     catchments on this rank are still being computed;
+*   - receives for the next time step are posted as soon as the current one is delivered, so incoming messages land
+*     directly in their buffers.
+*
+*   The exchange is not thread safe; it is driven by the nexuses from the thread that applies catchment results.
+*/
+class RemoteNexusExchange
+{
+    public:
+        typedef HY_HydroNexus::time_step_t time_step_t;
+
+        /** Create an exchange over a duplicate of the given communicator.  This is collective over @p comm. */
+        explicit RemoteNexusExchange(MPI_Comm comm = MPI_COMM_WORLD);
+
+        RemoteNexusExchange(const RemoteNexusExchange&) = delete;
+        RemoteNexusExchange& operator=(const RemoteNexusExchange&) = delete;
+
+        virtual ~RemoteNexusExchange();
+
+        /** Route the communication of a remote nexus through this exchange.  Local nexuses are ignored.
+        *
+        *   Must be called for every remote nexus of this rank before @ref setup.
+        */
+        void add_nexus(std::shared_ptr<HY_PointHydroNexusRemote> nexus);
+
+        /** Assign message slots and create the persistent requests.
+        *
+        *   This is collective over the exchange communicator.  The number of slots and the ids of the nexuses in them
+        *   are verified against every neighbor rank, and a std::runtime_error is thrown on any mismatch.
+        */
+        void setup();
+
+        /** Set the flow a sender nexus passes to a rank for time step @p t.
+        *
+        *   The message to @p rank is started once every nexus sending to that rank has provided its flow for @p t.
+        */
+        void send(const std::string& nexus_id, int rank, time_step_t t, double flow);
+
+        /** Ensure the flows of every remote contributor for time step @p t have been added to the receiving nexuses.
+        *
+        *   Blocks until the messages of all upstream neighbor ranks for @p t have arrived.
+        */
+        void receive(time_step_t t);
+
+        /** Complete pending sends, cancel pre-posted receives and release all MPI resources.
+        *
+        *   Must be called before MPI_Finalize.  Once finalized the exchange can not be used again.
+        */
+        void finalize();
+
+        /** @return The number of neighbor ranks this rank sends flows to */
+        std::size_t num_send_neighbors() const { return send_channels.size(); }
+
+        /** @return The number of neighbor ranks this rank receives flows from */
+        std::size_t num_receive_neighbors() const { return receive_channels.size(); }
+
+    private:
+        /** The message stream between this rank and one neighbor rank in one direction */
+        struct channel
+        {
+            int rank;
+            /** Nexuses in slot order */
+            std::vector<std::shared_ptr<HY_PointHydroNexusRemote>> nexuses;
+            std::unordered_map<std::string, std::size_t> slot_of;
+            /** Time step followed by one flow per slot */
+            std::vector<double> buffer;
+            std::vector<bool> filled;
+            std::size_t num_filled = 0;
+            MPI_Request request = MPI_REQUEST_NULL;
+            bool active = false;
+        };
+
+        channel& channel_for(std::vector<channel>& channels, std::unordered_map<int, std::size_t>& index, int rank);
+
+        MPI_Comm comm = MPI_COMM_NULL;
+        int world_size = 0;
+        bool is_setup = false;
+        bool finalized = false;
+
+        std::vector<channel> send_channels;
+        std::unordered_map<int, std::size_t> send_index;
+        std::vector<channel> receive_channels;
+        std::unordered_map<int, std::size_t> receive_index;
+        std::vector<MPI_Request> receive_requests;
+
+        /** Greatest time step whose messages have been delivered */
+        time_step_t received_through = -1;
+};
+
+#endif // NGEN_WITH_MPI
+#endif // REMOTE_NEXUS_EXCHANGE_H
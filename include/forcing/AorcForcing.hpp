@@ -26,6 +26,7 @@
 #define AORC_FIELD_NAME_WIND_V_10M_AG "VGRD_10maboveground"
 #define AORC_FIELD_NAME_SPEC_HUMID_2M_AG "SPFH_2maboveground"
 
+#include <cstddef>
 #include <map>
 
 /**
@@ -40,11 +41,18 @@ struct forcing_params
   std::string provider;
   time_t simulation_start_t;
   time_t simulation_end_t;
+  // Number of time steps a provider reads at once, where supported; 0 for the provider's default
+  std::size_t timesteps_per_read;
+  // Number of such reads a provider performs ahead in the background, where supported; 0 to not read ahead
+  std::size_t prefetch_blocks;
+  // Whether a CSV provider reads and writes a binary sidecar (".ngenbin") of each parsed forcing file
+  bool binary_cache;
   /*
     Constructor for forcing_params
   */
-  forcing_params(std::string path, std::string provider, std::string start_time, std::string end_time):
-    path(path), provider(provider), start_time(start_time), end_time(end_time)
+  forcing_params(std::string path, std::string provider, std::string start_time, std::string end_time, std::size_t timesteps_per_read = 0, std::size_t prefetch_blocks = 0, bool binary_cache = false):
+    path(path), provider(provider), start_time(start_time), end_time(end_time), timesteps_per_read(timesteps_per_read),
+    prefetch_blocks(prefetch_blocks), binary_cache(binary_cache)
     {
       /// \todo converting to UTC can be tricky, especially if thread safety is a concern
       /* https://stackoverflow.com/questions/530519/stdmktime-and-timezone-info */
@@ -0,0 +1,260 @@
+#ifndef NGEN_CSV_FORCING_STORE_HPP
+#define NGEN_CSV_FORCING_STORE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace data_access {
+
+    /**
+     * Forcing values shared by the per-feature (e.g., per-catchment) CSV forcing providers of a process.
+     *
+     * Features whose forcing has the same record times share a store, which holds each variable's values for all of
+     * them in one array, laid out by time step and then feature, rather than each provider holding its own map of
+     * vectors.  Each provider is a view of one feature's values (its slot).
+     *
+     * Features are added while formulations are being constructed, which may move the values; once the run starts,
+     * values are only read, which needs no locking.
+     */
+    class CsvForcingStore {
+    public:
+
+        /** Index returned when a variable is not in the store. */
+        static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+        /**
+         * Get the store of this process for forcing with the given record times, creating it if there is none.
+         *
+         * Stores are released when no provider uses them anymore.
+         */
+        static std::shared_ptr<CsvForcingStore> get_shared_store(const std::vector<time_t>& times)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            // Only stores with the same first time, spacing and count can match, so only those are compared in full
+            std::vector<std::weak_ptr<CsvForcingStore>>& stores = registry()[registry_key(times)];
+            std::shared_ptr<CsvForcingStore> store;
+            for (auto it = stores.begin(); it != stores.end(); ) {
+                std::shared_ptr<CsvForcingStore> s = it->lock();
+                if (s == nullptr) {
+                    it = stores.erase(it);
+                    continue;
+                }
+                if (store == nullptr && s->times == times) {
+                    store = s;
+                }
+                ++it;
+            }
+            if (store == nullptr) {
+                store = std::shared_ptr<CsvForcingStore>(new CsvForcingStore(times));
+                stores.push_back(store);
+            }
+            return store;
+        }
+
+        /**
+         * Release the unused capacity of all stores, which is reserved for more features as they are added.
+         *
+         * This should be called once all forcing providers have been constructed.
+         */
+        static void shrink_shared_stores()
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            for (const auto& entry : registry()) {
+                for (const auto& weak : entry.second) {
+                    std::shared_ptr<CsvForcingStore> s = weak.lock();
+                    if (s != nullptr) {
+                        s->shrink_to_fit();
+                    }
+                }
+            }
+        }
+
+        /** Add a feature to the store, returning its slot, which initially has no values for any variable. */
+        std::size_t add_feature()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (num_slots == capacity) {
+                reserve(std::max<std::size_t>(4, capacity * 2));
+            }
+            for (auto& v : variables) {
+                v.slot_units.push_back(0);
+            }
+            return num_slots++;
+        }
+
+        /**
+         * Set a feature's values for a variable, replacing any it has.
+         *
+         * @param name The (canonical) name of the variable.
+         * @param slot The feature's slot.
+         * @param values A value for each record time.
+         * @param units The units of the values.
+         */
+        void set_values(const std::string& name, std::size_t slot, const std::vector<double>& values, const std::string& units)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (slot >= num_slots || values.size() != times.size()) {
+                throw std::invalid_argument("Cannot set " + std::to_string(values.size()) + " values of forcing "
+                                            + name + " for slot " + std::to_string(slot));
+            }
+            auto found = variable_indices.find(name);
+            if (found == variable_indices.end()) {
+                found = variable_indices.emplace(name, variables.size()).first;
+                variables.emplace_back();
+                variables.back().values.assign(times.size() * capacity, NAN);
+                variables.back().slot_units.assign(num_slots, 0);
+            }
+            variable& v = variables[found->second];
+            for (std::size_t t = 0; t < values.size(); ++t) {
+                v.values[t * capacity + slot] = values[t];
+            }
+            auto u = std::find(v.units.begin(), v.units.end(), units);
+            v.slot_units[slot] = static_cast<std::uint32_t>(u - v.units.begin()) + 1;
+            if (u == v.units.end()) {
+                v.units.push_back(units);
+            }
+        }
+
+        /** Get the index of a variable, or @ref npos if no feature has values for it. */
+        std::size_t find_variable(const std::string& name) const
+        {
+            auto found = variable_indices.find(name);
+            return found == variable_indices.end() ? npos : found->second;
+        }
+
+        /** Get whether a feature has values for a variable. */
+        bool has_values(std::size_t variable_index, std::size_t slot) const
+        {
+            return variables[variable_index].slot_units[slot] != 0;
+        }
+
+        double get_value(std::size_t variable_index, std::size_t time_index, std::size_t slot) const
+        {
+            return variables[variable_index].values[time_index * capacity + slot];
+        }
+
+        /** Get the units of a feature's values for a variable, which it must have. */
+        const std::string& get_units(std::size_t variable_index, std::size_t slot) const
+        {
+            const variable& v = variables[variable_index];
+            return v.units[v.slot_units[slot] - 1];
+        }
+
+        /** The record times. */
+        const std::vector<time_t>& get_times() const
+        {
+            return times;
+        }
+
+        /** The seconds between records, if they are evenly spaced (or too few to tell, in which case an hour), or 0. */
+        time_t get_record_spacing() const
+        {
+            return record_spacing;
+        }
+
+        /**
+         * Get a stored copy of a list of variable names, so features with the same variables share a single list.
+         *
+         * The returned list is valid for the life of the store.
+         */
+        const std::vector<std::string>& intern_names(std::vector<std::string> names)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return *name_lists.insert(std::move(names)).first;
+        }
+
+    private:
+
+        struct variable {
+            /** Values by time step, then slot (with a stride of the store's capacity). */
+            std::vector<double> values;
+            /** Each slot's index into @ref units plus one, or 0 if the slot has no values. */
+            std::vector<std::uint32_t> slot_units;
+            /** The distinct units of the variable's values. */
+            std::vector<std::string> units;
+        };
+
+        explicit CsvForcingStore(const std::vector<time_t>& times) : times(times)
+        {
+            record_spacing = times.size() < 2 ? 3600 : times[1] - times[0];
+            for (std::size_t i = 2; i < times.size() && record_spacing > 0; ++i) {
+                if (times[i] - times[i - 1] != record_spacing) {
+                    record_spacing = 0;
+                }
+            }
+            if (record_spacing < 0) {
+                record_spacing = 0;
+            }
+        }
+
+        static std::mutex& registry_mutex()
+        {
+            static std::mutex m;
+            return m;
+        }
+
+        /** The first record time, the time to the second record and the number of records. */
+        typedef std::tuple<time_t, time_t, std::size_t> times_key;
+
+        static times_key registry_key(const std::vector<time_t>& times)
+        {
+            if (times.empty()) {
+                return times_key(0, 0, 0);
+            }
+            return times_key(times[0], times.size() < 2 ? 0 : times[1] - times[0], times.size());
+        }
+
+        /** Stores by the key of their record times. */
+        static std::map<times_key, std::vector<std::weak_ptr<CsvForcingStore>>>& registry()
+        {
+            static std::map<times_key, std::vector<std::weak_ptr<CsvForcingStore>>> stores;
+            return stores;
+        }
+
+        /** Change the slot stride of all values; the caller must hold the lock. */
+        void reserve(std::size_t new_capacity)
+        {
+            for (auto& v : variables) {
+                std::vector<double> values(times.size() * new_capacity, NAN);
+                for (std::size_t t = 0; t < times.size(); ++t) {
+                    std::copy(v.values.begin() + t * capacity, v.values.begin() + t * capacity + num_slots,
+                              values.begin() + t * new_capacity);
+                }
+                v.values.swap(values);
+            }
+            capacity = new_capacity;
+        }
+
+        void shrink_to_fit()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (capacity != num_slots) {
+                reserve(num_slots);
+            }
+        }
+
+        const std::vector<time_t> times;
+        time_t record_spacing;
+        std::size_t num_slots = 0;
+        std::size_t capacity = 0;
+        std::vector<variable> variables;
+        std::unordered_map<std::string, std::size_t> variable_indices;
+        std::set<std::vector<std::string>> name_lists;
+        std::mutex mutex;
+    };
+
+} // namespace data_access
+
+#endif // NGEN_CSV_FORCING_STORE_HPP
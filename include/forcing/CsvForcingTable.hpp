@@ -0,0 +1,360 @@
+#ifndef NGEN_CSV_FORCING_TABLE_HPP
+#define NGEN_CSV_FORCING_TABLE_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace data_access {
+
+    /**
+     * The contents of a per-feature forcing CSV file: a time column, and a column of numeric values per variable.
+     *
+     * Files are memory-mapped and parsed in place, without splitting lines into strings.  Optionally, the parsed
+     * contents are saved to a binary sidecar file next to the CSV (the CSV path plus ``.ngenbin``), which later reads
+     * use instead of parsing the CSV, as long as the CSV's size and modification time have not changed.
+     */
+    class CsvForcingTable {
+    public:
+
+        /** Suffix appended to a CSV file's path to get the path of its binary sidecar. */
+        static constexpr const char* CACHE_SUFFIX = ".ngenbin";
+
+        /**
+         * Read a forcing CSV file.
+         *
+         * @param path The path of the CSV file.
+         * @param use_cache Whether to use the file's binary sidecar if it is current, and otherwise to write it after
+         *                  parsing the CSV.  Failure to write the sidecar (e.g., in a read-only directory) is ignored.
+         * @throws std::runtime_error If the file cannot be read, or a row has the wrong number of columns or a value
+         *                            that is not a number.
+         */
+        static CsvForcingTable read(const std::string& path, bool use_cache = false)
+        {
+            struct stat csv_stat;
+            errno = 0;
+            if (stat(path.c_str(), &csv_stat) != 0) {
+                throw std::runtime_error(open_error(path));
+            }
+            CsvForcingTable table;
+            if (use_cache && table.read_cache(path + CACHE_SUFFIX, csv_stat)) {
+                return table;
+            }
+            table.parse(path);
+            if (use_cache) {
+                table.write_cache(path + CACHE_SUFFIX, csv_stat);
+            }
+            return table;
+        }
+
+        /** The header of each value column, as in the file. */
+        std::vector<std::string> headers;
+        /** The epoch time of each row. */
+        std::vector<time_t> times;
+        /** The values of each column of @ref headers, by row. */
+        std::vector<std::vector<double>> columns;
+
+    private:
+
+        static std::string open_error(const std::string& path)
+        {
+            return errno == 0
+                ? "Error: failure opening " + path
+                : "Errno " + std::to_string(errno) + " (" + strerror(errno) + ") opening " + path;
+        }
+
+        static bool is_space(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+        }
+
+        /** Days from 1970-01-01 to the given proleptic Gregorian date. */
+        static long days_from_civil(long y, unsigned m, unsigned d)
+        {
+            y -= m <= 2;
+            const long era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned yoe = static_cast<unsigned>(y - era * 400);
+            const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<long>(doe) - 719468;
+        }
+
+        /** Parse a UTC ``%Y-%m-%d %H:%M:%S`` time, falling back to ``strptime`` for anything else. */
+        static time_t parse_time(const char* begin, const char* end)
+        {
+            static const char pattern[] = "dddd-dd-dd dd:dd:dd";
+            const std::size_t length = sizeof(pattern) - 1;
+            bool matches = static_cast<std::size_t>(end - begin) >= length;
+            for (std::size_t i = 0; matches && i < length; ++i) {
+                matches = pattern[i] == 'd' ? (begin[i] >= '0' && begin[i] <= '9') : begin[i] == pattern[i];
+            }
+            if (matches) {
+                auto number = [begin](std::size_t at, std::size_t digits) {
+                    long n = 0;
+                    for (std::size_t i = at; i < at + digits; ++i) {
+                        n = n * 10 + (begin[i] - '0');
+                    }
+                    return n;
+                };
+                long month = number(5, 2), day = number(8, 2);
+                if (month >= 1 && month <= 12 && day >= 1 && day <= 31) {
+                    return static_cast<time_t>(days_from_civil(number(0, 4), month, day)) * 86400
+                           + number(11, 2) * 3600 + number(14, 2) * 60 + number(17, 2);
+                }
+            }
+            //TODO: Support more time string formats? This is basically ISO8601 but not complete, support TZ?
+            struct tm time_utc = tm();
+            strptime(std::string(begin, end).c_str(), "%Y-%m-%d %H:%M:%S", &time_utc);
+            return timegm(&time_utc);
+        }
+
+        static double parse_value(const char* begin, const char* end, const std::string& path, std::size_t row)
+        {
+            while (begin < end && is_space(*begin)) ++begin;
+            while (end > begin && is_space(*(end - 1))) --end;
+            // strtod needs a terminated string; values are short enough to copy to the stack
+            char buffer[64];
+            const std::size_t length = static_cast<std::size_t>(end - begin);
+            if (length > 0 && length < sizeof(buffer)) {
+                memcpy(buffer, begin, length);
+                buffer[length] = '\0';
+                char* parsed_end;
+                double value = strtod(buffer, &parsed_end);
+                if (parsed_end == buffer + length) {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Invalid value '" + std::string(begin, end) + "' in row " + std::to_string(row)
+                                     + " of forcing file " + path);
+        }
+
+        void parse(const std::string& path)
+        {
+            errno = 0;
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error(open_error(path));
+            }
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+                close(fd);
+                throw std::runtime_error("Error: forcing file " + path + " is empty");
+            }
+            const std::size_t size = static_cast<std::size_t>(file_stat.st_size);
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error(open_error(path));
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            try {
+                parse(static_cast<const char*>(mapped), size, path);
+            }
+            catch (...) {
+                munmap(mapped, size);
+                throw;
+            }
+            munmap(mapped, size);
+        }
+
+        void parse(const char* data, std::size_t size, const std::string& path)
+        {
+            const char* const end = data + size;
+            const char* line = data;
+            std::size_t time_column = 0;
+            std::size_t num_columns = 0;
+            std::size_t row = 0;
+            // The beginning and end of each field of a line
+            std::vector<std::pair<const char*, const char*>> fields;
+
+            while (line < end) {
+                const char* line_end = static_cast<const char*>(memchr(line, '\n', end - line));
+                const char* next = line_end == nullptr ? end : line_end + 1;
+                if (line_end == nullptr) {
+                    line_end = end;
+                }
+                if (line_end > line && *(line_end - 1) == '\r') {
+                    --line_end;
+                }
+
+                fields.clear();
+                const char* field = line;
+                for (const char* c; (c = static_cast<const char*>(memchr(field, ',', line_end - field))) != nullptr; field = c + 1) {
+                    fields.emplace_back(field, c);
+                }
+                fields.emplace_back(field, line_end);
+
+                if (row == 0) {
+                    num_columns = fields.size();
+                    for (std::size_t c = 0; c < num_columns; ++c) {
+                        std::string header(fields[c].first, fields[c].second);
+                        if (header == "Time" || header == "time") {
+                            time_column = c;
+                        }
+                        else {
+                            headers.push_back(header);
+                        }
+                    }
+                    if (headers.size() == num_columns) {
+                        // Without a named time column, the first is the time
+                        headers.erase(headers.begin());
+                    }
+                    columns.resize(headers.size());
+                }
+                else if (line_end > line) {
+                    if (fields.size() != num_columns) {
+                        throw std::runtime_error("Row " + std::to_string(row) + " of forcing file " + path + " has "
+                                                 + std::to_string(fields.size()) + " columns, but its header has "
+                                                 + std::to_string(num_columns));
+                    }
+                    times.push_back(parse_time(fields[time_column].first, fields[time_column].second));
+                    std::size_t v = 0;
+                    for (std::size_t c = 0; c < num_columns; ++c) {
+                        if (c != time_column) {
+                            columns[v++].push_back(parse_value(fields[c].first, fields[c].second, path, row));
+                        }
+                    }
+                }
+                ++row;
+                line = next;
+            }
+        }
+
+        static time_t modification_time_ns(const struct stat& s)
+        {
+            #ifdef __APPLE__
+            return s.st_mtimespec.tv_nsec;
+            #else
+            return s.st_mtim.tv_nsec;
+            #endif
+        }
+
+        /**
+         * The sidecar layout: a magic string; the CSV's size and modification time (seconds and nanoseconds); the
+         * number of columns and rows; each header as its length and characters; the row times; then each column.
+         */
+        struct cache_prefix {
+            char magic[8];
+            std::int64_t csv_size;
+            std::int64_t csv_mtime_s;
+            std::int64_t csv_mtime_ns;
+            std::uint64_t num_columns;
+            std::uint64_t num_rows;
+        };
+
+        static cache_prefix make_prefix(const struct stat& csv_stat)
+        {
+            cache_prefix prefix;
+            memcpy(prefix.magic, "NGENCSV1", sizeof(prefix.magic));
+            prefix.csv_size = csv_stat.st_size;
+            prefix.csv_mtime_s = csv_stat.st_mtime;
+            prefix.csv_mtime_ns = modification_time_ns(csv_stat);
+            prefix.num_columns = 0;
+            prefix.num_rows = 0;
+            return prefix;
+        }
+
+        bool read_cache(const std::string& cache_path, const struct stat& csv_stat)
+        {
+            std::ifstream in(cache_path, std::ios::binary);
+            if (!in) {
+                return false;
+            }
+            cache_prefix expected = make_prefix(csv_stat);
+            cache_prefix prefix;
+            if (!in.read(reinterpret_cast<char*>(&prefix), sizeof(prefix))
+                || memcmp(prefix.magic, expected.magic, sizeof(prefix.magic)) != 0
+                || prefix.csv_size != expected.csv_size
+                || prefix.csv_mtime_s != expected.csv_mtime_s
+                || prefix.csv_mtime_ns != expected.csv_mtime_ns
+                || prefix.num_columns > (std::uint64_t(1) << 20)) {
+                return false;
+            }
+            headers.resize(prefix.num_columns);
+            for (std::string& header : headers) {
+                std::uint64_t length;
+                if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > (std::uint64_t(1) << 20)) {
+                    return false;
+                }
+                header.resize(length);
+                if (!in.read(&header[0], length)) {
+                    return false;
+                }
+            }
+            // Check the size of the rest of the file matches the row count before allocating for it
+            const std::streamoff data_start = in.tellg();
+            in.seekg(0, std::ios::end);
+            const std::streamoff data_size = in.tellg() - data_start;
+            in.seekg(data_start);
+            if (data_size < 0 || static_cast<std::uint64_t>(data_size) != prefix.num_rows * sizeof(std::int64_t) * (prefix.num_columns + 1)) {
+                headers.clear();
+                return false;
+            }
+
+            std::vector<std::int64_t> stored_times(prefix.num_rows);
+            in.read(reinterpret_cast<char*>(stored_times.data()), stored_times.size() * sizeof(std::int64_t));
+            times.assign(stored_times.begin(), stored_times.end());
+            columns.assign(prefix.num_columns, std::vector<double>(prefix.num_rows));
+            for (auto& column : columns) {
+                in.read(reinterpret_cast<char*>(column.data()), column.size() * sizeof(double));
+            }
+            if (!in) {
+                headers.clear();
+                times.clear();
+                columns.clear();
+                return false;
+            }
+            return true;
+        }
+
+        void write_cache(const std::string& cache_path, const struct stat& csv_stat) const
+        {
+            // Write to a temporary file first, so a reader never sees a partial sidecar
+            const std::string temp_path = cache_path + ".tmp" + std::to_string(getpid());
+            {
+                std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+                if (!out) {
+                    return;
+                }
+                cache_prefix prefix = make_prefix(csv_stat);
+                prefix.num_columns = headers.size();
+                prefix.num_rows = times.size();
+                out.write(reinterpret_cast<const char*>(&prefix), sizeof(prefix));
+                for (const std::string& header : headers) {
+                    std::uint64_t length = header.size();
+                    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                    out.write(header.data(), header.size());
+                }
+                std::vector<std::int64_t> stored_times(times.begin(), times.end());
+                out.write(reinterpret_cast<const char*>(stored_times.data()), stored_times.size() * sizeof(std::int64_t));
+                for (const auto& column : columns) {
+                    out.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(double));
+                }
+                if (!out) {
+                    out.close();
+                    std::remove(temp_path.c_str());
+                    return;
+                }
+            }
+            if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+                std::remove(temp_path.c_str());
+            }
+        }
+    };
+
+} // namespace data_access
+
+#endif // NGEN_CSV_FORCING_TABLE_HPP
@@ -10,14 +10,15 @@
 #include <iostream>
 #include <unordered_map>
 #include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
-#include "CSV_Reader.h"
+#include "CsvForcingStore.hpp"
+#include "CsvForcingTable.hpp"
 #include <ctime>
 #include <time.h>
 #include <memory>
 #include "AorcForcing.hpp"
 #include "GenericDataProvider.hpp"
 #include "DataProviderSelectors.hpp"
+#include "Profiler.hpp"
 #include <exception>
 #include <UnitsHelper.hpp>
 
@@ -36,7 +37,9 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
                                            current_date_time_epoch(forcing_config.simulation_start_t),
                                            forcing_vector_index(-1)
     {
-        read_csv(forcing_config.path);
+        static const std::string profile_name = "CsvPerFeatureForcingProvider::read_csv";
+        utils::Profile_Scope profile(utils::Profiler::FORCING, profile_name);
+        read_csv(forcing_config.path, forcing_config.binary_cache);
     }
 
     // BEGIN DataProvider interface methods
@@ -67,7 +70,7 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
      * @return The duration of one record of this forcing source
      */
     long record_duration() const override {
-        return time_epoch_vector[1] - time_epoch_vector[0];
+        return get_time_step_duration(0);
     }
 
     /**
@@ -83,22 +86,16 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
         if (epoch_time < start_date_time_epoch) {
             throw std::out_of_range("Forcing had bad pre-start time for index query: " + std::to_string(epoch_time));
         }
-        size_t i = 0;
-        // 1 hour
-        time_t seconds_in_time_step = 3600;
-        time_t time = start_date_time_epoch;
-        while (epoch_time >= time + seconds_in_time_step && time < end_date_time_epoch) {
-           i++;
-           time += seconds_in_time_step;
-        }
-        // The end_date_time_epoch is the epoch value of the BEGINNING of the last time step, not its end.
-        // I.e., to make sure we cover it, we have to go another time step beyond.
-        if (time >= end_date_time_epoch + 3600) {
-            throw std::out_of_range("Forcing had bad beyond-end time for index query: " + std::to_string(epoch_time));
-        }
-        else {
-            return i;
+        // Times beyond the end are in the last time step, which begins at end_date_time_epoch
+        const time_t record_spacing = store->get_record_spacing();
+        if (record_spacing > 0) {
+            const time_t last_index = (end_date_time_epoch - start_date_time_epoch + record_spacing - 1) / record_spacing;
+            return static_cast<size_t>(std::min((epoch_time - start_date_time_epoch) / record_spacing, std::max<time_t>(last_index, 0)));
         }
+        // Irregularly spaced records: the last one beginning at or before the time
+        const std::vector<time_t>& times = store->get_times();
+        auto after = std::upper_bound(times.begin(), times.end(), epoch_time);
+        return after == times.begin() ? 0 : static_cast<size_t>(after - times.begin() - 1);
     }
 
     /**
@@ -113,6 +110,8 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
      */
     double get_value(const CatchmentAggrDataSelector& selector, data_access::ReSampleMethod m) override
     {
+        static const std::string profile_name = "CsvPerFeatureForcingProvider::get_value";
+        utils::Profile_Scope profile(utils::Profiler::FORCING, profile_name);
         size_t current_index;
         long time_remaining = selector.get_duration_secs();
         auto init_time = selector.get_init_time();
@@ -125,28 +124,33 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
         catch (const std::out_of_range &e) {
             throw std::out_of_range("Forcing had bad init_time " + std::to_string(init_time) + " for value request");
         }
+        const size_t variable_index = get_variable_index(output_name);
 
         std::vector<double> involved_time_step_values;
 
         std::vector<long> involved_time_step_seconds;
+        std::vector<long> involved_time_step_durations;
         long ts_involved_s;
 
-        time_t first_time_step_start_epoch = start_date_time_epoch + (current_index * 3600);
+        time_t first_time_step_start_epoch = get_time_step_start(current_index);
         // Handle the first time step differently, since we need to do more to figure out how many seconds came from it
         // Total time step size minus the offset of the beginning, before the init time
-        ts_involved_s = 3600 - (init_time - first_time_step_start_epoch);
+        ts_involved_s = get_time_step_duration(current_index) - (init_time - first_time_step_start_epoch);
 
         involved_time_step_seconds.push_back(ts_involved_s);
-        involved_time_step_values.push_back(get_value_for_param_name(output_name, current_index));
+        involved_time_step_durations.push_back(get_time_step_duration(current_index));
+        involved_time_step_values.push_back(get_value_for_variable(variable_index, current_index));
         time_remaining -= ts_involved_s;
         current_index++;
 
         while (time_remaining > 0) {
-            if(current_index >= time_epoch_vector.size())
+            if(current_index >= store->get_times().size())
                 return involved_time_step_values[involved_time_step_values.size()-1]; //TODO: Is this the right answer? Is returning any value off the end of the range valid?
-            ts_involved_s = time_remaining > 3600 ? 3600 : time_remaining;
+            const long duration = get_time_step_duration(current_index);
+            ts_involved_s = time_remaining > duration ? duration : time_remaining;
             involved_time_step_seconds.push_back(ts_involved_s);
-            involved_time_step_values.push_back(get_value_for_param_name(output_name, current_index));
+            involved_time_step_durations.push_back(duration);
+            involved_time_step_values.push_back(get_value_for_variable(variable_index, current_index));
             time_remaining -= ts_involved_s;
             current_index++;
 
@@ -154,21 +158,14 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
         double value = 0;
         for (size_t i = 0; i < involved_time_step_values.size(); ++i) {
             if (is_param_sum_over_time_step(output_name))
-                value += involved_time_step_values[i] * ((double)involved_time_step_seconds[i] / 3600.0);
+                value += involved_time_step_values[i] * ((double)involved_time_step_seconds[i] / (double)involved_time_step_durations[i]);
             else
                 value += involved_time_step_values[i] * ((double)involved_time_step_seconds[i] / (double)selector.get_duration_secs());
         }
 
         // Convert units
-        try {
-            return UnitsHelper::get_converted_value(available_forcings_units[output_name], value, output_units);
-        }
-        catch (const std::runtime_error& e){
-            #ifndef UDUNITS_QUIET
-            std::cerr<<"WARN: Unit conversion unsuccessful - Returning unconverted value! (\""<<e.what()<<"\")"<<std::endl;
-            #endif
-            return value;
-        }
+        const UnitsHelper::conversion* conversion = get_units_conversion(variable_index, output_units);
+        return conversion == nullptr ? value : conversion->convert(value);
     }
 
     virtual std::vector<double> get_values(const CatchmentAggrDataSelector& selector, data_access::ReSampleMethod m) override
@@ -223,7 +220,7 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
     }
 
     boost::span<const std::string> get_available_variable_names() const override {
-        return available_forcings;
+        return *available_forcings;
     }
 
     private:
@@ -243,9 +240,9 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
         }
 
         //Check if forcing index is greater than or equal to the size of the size of the time vector and if so, set to zero.
-        else if (forcing_vector_index >= time_epoch_vector.size())
+        else if (forcing_vector_index >= store->get_times().size())
         {
-            forcing_vector_index = time_epoch_vector.size() - 1;
+            forcing_vector_index = store->get_times().size() - 1;
             /// \todo: Return appropriate warning
             std::cout << "WARNING: Reached beyond the size of the forcing vector. Therefore, setting index to last value of the vector." << std::endl;
         }
@@ -254,140 +251,194 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
     }
 
     /**
-     * Get the current value of a forcing param identified by its name.
+     * Get the beginning of the forcing time step at the given index, as a seconds-based epoch time.
+     */
+    inline time_t get_time_step_start(size_t index) const {
+        const time_t record_spacing = store->get_record_spacing();
+        if (record_spacing > 0) {
+            return start_date_time_epoch + static_cast<time_t>(index) * record_spacing;
+        }
+        const std::vector<time_t>& times = store->get_times();
+        return times[std::min(index, times.size() - 1)];
+    }
+
+    /**
+     * Get the length in seconds of the forcing time step at the given index.
      *
-     * @param name The name of the forcing param for which the current value is desired.
-     * @param index The index of the desired forcing time step from which to obtain the value.
-     * @return The particular param's value at the given forcing time step.
+     * For irregularly spaced records, this is the time until the next record, or for the last record, the length of
+     * the one before it.
      */
-    inline double get_value_for_param_name(const std::string& name, int index) {
-        if (index >= time_epoch_vector.size() ) {
-            throw std::out_of_range("Forcing had bad index " + std::to_string(index) + " for value lookup of " + name);
+    inline long get_time_step_duration(size_t index) const {
+        const time_t record_spacing = store->get_record_spacing();
+        if (record_spacing > 0) {
+            return record_spacing;
         }
+        const std::vector<time_t>& times = store->get_times();
+        const size_t i = std::min(index, times.size() - 2);
+        return times[i + 1] - times[i];
+    }
 
+    /**
+     * Get the index in the forcing store of a forcing param identified by its name.
+     *
+     * @param name The name of the forcing param, which may be its canonical (CSDMS) name or a well-known alias.
+     * @return The index of the param's values in the store.
+     * @throws std::runtime_error If this provider has no values for the param.
+     */
+    inline size_t get_variable_index(const std::string& name) const {
         std::string can_name = name;
         if(data_access::WellKnownFields.count(can_name) > 0){
             auto t = data_access::WellKnownFields.find(can_name)->second;
             can_name = std::get<0>(t);
         }
 
-        if (forcing_vectors.count(can_name) > 0) {
-            return forcing_vectors[can_name].at(index);
-        }
-        else {
+        size_t variable_index = store->find_variable(can_name);
+        if (variable_index == data_access::CsvForcingStore::npos || !store->has_values(variable_index, store_slot)) {
             throw std::runtime_error("Cannot get forcing value for unrecognized parameter name '" + name + "'.");
         }
+        return variable_index;
+    }
+
+    /**
+     * Get the conversion of a forcing param's values to the given units, resolving it the first time the param is
+     * requested in those units.
+     *
+     * @param variable_index The index of the forcing param, from @ref get_variable_index.
+     * @param output_units The units the values are requested in.
+     * @return The conversion, or null if the values are returned unconverted (the units are the same, or cannot be
+     *         converted).
+     */
+    inline const UnitsHelper::conversion* get_units_conversion(size_t variable_index, const std::string& output_units) {
+        if (variable_index >= unit_conversions.size()) {
+            unit_conversions.resize(variable_index + 1);
+        }
+        std::vector<units_conversion>& resolved = unit_conversions[variable_index];
+        for (const units_conversion& c : resolved) {
+            if (c.output_units == output_units) {
+                return c.conversion;
+            }
+        }
+
+        const std::string& units = store->get_units(variable_index, store_slot);
+        const UnitsHelper::conversion* conversion = nullptr;
+        if (units != output_units) {
+            try {
+                conversion = &UnitsHelper::get_conversion(units, output_units);
+            }
+            catch (const std::runtime_error& e){
+                #ifndef UDUNITS_QUIET
+                std::cerr<<"WARN: Unit conversion unsuccessful - Returning unconverted value! (\""<<e.what()<<"\")"<<std::endl;
+                #endif
+            }
+        }
+        resolved.push_back(units_conversion{output_units, conversion});
+        return conversion;
+    }
+
+    /**
+     * Get the current value of a forcing param identified by its index in the forcing store.
+     *
+     * @param variable_index The index of the forcing param, from @ref get_variable_index.
+     * @param index The index of the desired forcing time step from which to obtain the value.
+     * @return The particular param's value at the given forcing time step.
+     */
+    inline double get_value_for_variable(size_t variable_index, size_t index) const {
+        if (index >= store->get_times().size()) {
+            throw std::out_of_range("Forcing had bad index " + std::to_string(index) + " for value lookup");
+        }
+        return store->get_value(variable_index, index, store_slot);
     }
 
     /**
      * @brief Read Forcing Data from CSV
      * Reads only data within the specified model start and end date-times.
      * @param file_name Forcing file name
+     * @param use_binary_cache Whether to read and write the file's binary sidecar (see @ref data_access::CsvForcingTable)
      */
-    void read_csv(std::string file_name)
+    void read_csv(std::string file_name, bool use_binary_cache = false)
     {
-        int time_col_index = 0;
-        //std::map<std::string, int> col_indices;
-        std::vector<std::vector<double>*> local_valvec_index = {};
-
-        //Call CSVReader constuctor
-        CSVReader reader(file_name);
+        data_access::CsvForcingTable table = data_access::CsvForcingTable::read(file_name, use_binary_cache);
 
-        //Get the data from CSV File
-        std::vector<std::vector<std::string> > data_list = reader.getData();
+        std::vector<std::string> names;
+        // The canonical name and units of each column
+        std::vector<std::pair<std::string, std::string>> columns;
+        columns.reserve(table.headers.size());
 
         // Process the header (first) row..
-        int col_num = 0;
-        for (const auto& col_head : data_list[0]){
-            //std::cerr << s << std::endl;
-            if(col_head == "Time" || col_head == "time"){
-                time_col_index = col_num;
-                local_valvec_index.push_back(nullptr); // make sure the column indices line up!
-            } else {
-                std::string var_name = col_head;
-                std::string units = "";
-
-                boost::trim(var_name); // remove leading/trailing ws
-                const auto var_name_close = var_name.back();
-                if (var_name_close == ']' || var_name_close == ')') {
-                    // found closing bracket/parenth
-
-                    const bool is_bracket = var_name_close == ']';
-                    const size_t var_name_open = is_bracket ? var_name.rfind('[') : var_name.rfind('(');
-                    if (var_name_open != std::string::npos) {
-                        // found matching opening bracket/parenth
-
-                        units = var_name.substr(var_name_open + 1);
-                        units.pop_back(); // remove closing bracket
-
-                        var_name = var_name.substr(0, var_name_open);
-                        boost::trim(var_name); // trim again in case of ws between name and units
-                    }
-                }
+        for (const auto& col_head : table.headers){
+            std::string var_name = col_head;
+            std::string units = "";
+
+            boost::trim(var_name); // remove leading/trailing ws
+            const auto var_name_close = var_name.back();
+            if (var_name_close == ']' || var_name_close == ')') {
+                // found closing bracket/parenth
+
+                const bool is_bracket = var_name_close == ']';
+                const size_t var_name_open = is_bracket ? var_name.rfind('[') : var_name.rfind('(');
+                if (var_name_open != std::string::npos) {
+                    // found matching opening bracket/parenth
 
-                auto wkf = data_access::WellKnownFields.find(var_name);
-                if(wkf != data_access::WellKnownFields.end()){
-                    units = units.empty() ? std::get<1>(wkf->second) : units;
-                    available_forcings.push_back(var_name); // Allow lookup by non-canonical name
-                    available_forcings_units[var_name] = units; // Allow lookup of units by non-canonical name
-                    var_name = std::get<0>(wkf->second); // Use the CSDMS name from here on
+                    units = var_name.substr(var_name_open + 1);
+                    units.pop_back(); // remove closing bracket
+
+                    var_name = var_name.substr(0, var_name_open);
+                    boost::trim(var_name); // trim again in case of ws between name and units
                 }
+            }
 
-                forcing_vectors[var_name] = {};
-                local_valvec_index.push_back(&(forcing_vectors[var_name]));
-                available_forcings.push_back(var_name);
-                available_forcings_units[var_name] = units;
+            auto wkf = data_access::WellKnownFields.find(var_name);
+            if(wkf != data_access::WellKnownFields.end()){
+                units = units.empty() ? std::get<1>(wkf->second) : units;
+                names.push_back(var_name); // Allow lookup by non-canonical name
+                var_name = std::get<0>(wkf->second); // Use the CSDMS name from here on
             }
-            col_num++;
+
+            columns.emplace_back(var_name, units);
+            names.push_back(var_name);
         }
 
-        time_t current_row_date_time_epoch;
-        //Iterate through CSV starting on the second row
-        int i = 1;
-        for (i = 1; i < data_list.size(); i++)
+        //TODO: I am not sure this is a concern of this object. If forcing is retrieved that doesn't cover the
+        //needed time period, isn't that the requester's concern? (Methods exist to check this...)
+        //Ensure that forcing data covers the entire model period. Otherwise, throw an error.
+        if (!table.times.empty() && start_date_time_epoch < table.times.front())
         {
-            //Row vector
-            std::vector<std::string>& vec = data_list[i];
-
-            struct tm current_row_date_time_utc = tm();
-            std::string time_str = vec[time_col_index];
-            //TODO: Support more time string formats? This is basically ISO8601 but not complete, support TZ?
-            strptime(time_str.c_str(), "%Y-%m-%d %H:%M:%S", &current_row_date_time_utc);
-
-            //Convert current row date-time UTC to epoch time
-            current_row_date_time_epoch = timegm(&current_row_date_time_utc);
+            struct tm start_date_tm;
+            gmtime_r(&start_date_time_epoch, &start_date_tm);
+            struct tm first_row_tm;
+            gmtime_r(&table.times.front(), &first_row_tm);
+
+            char tm_buff[128];
+            strftime(tm_buff, 128, "%Y-%m-%d %H:%M:%S", &start_date_tm);
+            char first_row_buff[128];
+            strftime(first_row_buff, 128, "%Y-%m-%d %H:%M:%S", &first_row_tm);
+            throw std::runtime_error("Error: Forcing data " + file_name + " begins after the model start time:" + std::string(tm_buff) + " < " + std::string(first_row_buff));
+        }
 
-            //TODO: I am not sure this is a concern of this object. If forcing is retrieved that doesn't cover the
-            //needed time period, isn't that the requester's concern? (Methods exist to check this...)
-            //Ensure that forcing data covers the entire model period. Otherwise, throw an error.
-            if (i == 1 && start_date_time_epoch < current_row_date_time_epoch)
+        // Keep only the rows within the model period
+        std::vector<size_t> rows;
+        std::vector<time_t> times;
+        for (size_t i = 0; i < table.times.size(); i++)
+        {
+            if (start_date_time_epoch <= table.times[i] && table.times[i] <= end_date_time_epoch)
             {
-                struct tm start_date_tm;
-                gmtime_r(&start_date_time_epoch, &start_date_tm);
-                
-                char tm_buff[128];
-                strftime(tm_buff, 128, "%Y-%m-%d %H:%M:%S", &start_date_tm);
-                throw std::runtime_error("Error: Forcing data " + file_name + " begins after the model start time:" + std::string(tm_buff) + " < " + time_str);
+                rows.push_back(i);
+                times.push_back(table.times[i]);
             }
+        }
 
-            
-            if (start_date_time_epoch <= current_row_date_time_epoch && current_row_date_time_epoch <= end_date_time_epoch)
-            {
-                time_epoch_vector.push_back(current_row_date_time_epoch);
-
-                int c = -1;
-                for (auto& s : vec){
-                    c++;
-                    if(c == time_col_index)
-                        continue;
-                    boost::algorithm::trim(s);
-                    local_valvec_index[c]->push_back(boost::lexical_cast<double>(s)); // This is supposed to update the vector in the map...
-                }
-
+        store = data_access::CsvForcingStore::get_shared_store(times);
+        store_slot = store->add_feature();
+        available_forcings = &store->intern_names(std::move(names));
+        std::vector<double> values(rows.size());
+        for (size_t c = 0; c < columns.size(); ++c) {
+            for (size_t r = 0; r < rows.size(); ++r) {
+                values[r] = table.columns[c][rows[r]];
             }
-
+            store->set_values(columns[c].first, store_slot, values, columns[c].second);
         }
-        if (i <= 1 || current_row_date_time_epoch < end_date_time_epoch)
+
+        if (table.times.empty() || table.times.back() < end_date_time_epoch)
         {
             /// \todo TODO: Return appropriate error
             std::cout << "WARNING: Forcing data ends before the model end time." << std::endl;
@@ -395,14 +446,23 @@ class CsvPerFeatureForcingProvider : public data_access::GenericDataProvider
         }
     }
 
-    std::vector<std::string> available_forcings;
-    std::unordered_map<std::string, std::string> available_forcings_units;
+    /** Names of the available forcings (including aliases), shared with other features with the same columns. */
+    const std::vector<std::string>* available_forcings;
 
     /// \todo: Look into aggregation of data, relevant libraries, and storing frequency information
-    std::unordered_map<std::string, std::vector<double>> forcing_vectors;
-
-    /// \todo: Consider making epoch time the iterator
-    std::vector<time_t> time_epoch_vector;     
+    /** Values and times of this feature's forcing, shared with other features' providers. */
+    std::shared_ptr<data_access::CsvForcingStore> store;
+    /** This feature's slot in @ref store. */
+    size_t store_slot;
+
+    /** A conversion of a forcing param's values to the units they were requested in. */
+    struct units_conversion {
+        std::string output_units;
+        /** Null if values are returned unconverted. */
+        const UnitsHelper::conversion* conversion;
+    };
+    /** The conversions already resolved for each forcing param, by its index in @ref store. */
+    std::vector<std::vector<units_conversion>> unit_conversions;
     int forcing_vector_index;
 
     /// \todo: Are these used?
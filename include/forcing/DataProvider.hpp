@@ -98,6 +98,12 @@ namespace data_access
 
         virtual bool is_property_sum_over_time_step(const std::string& name) const {return false; }
 
+        /**
+         * Get whether getting values calls into Python, so it must only be done by a thread able to take the
+         * interpreter's lock.
+         */
+        virtual bool calls_python() const { return false; }
+
         private:
     };
 
@@ -1,6 +1,7 @@
 #ifndef NGEN_DATA_SELECTORS_HPP
 #define NGEN_DATA_SELECTORS_HPP
 
+#include <cstddef>
 #include <string>
 
 class CatchmentAggrDataSelector
@@ -104,7 +105,35 @@ class CatchmentAggrDataSelector
      * 
      * @param s 
      */
-    void set_id(std::string s) { id_str = s; }
+    void set_id(std::string s) { id_str = s; id_index_provider = nullptr; }
+
+    /**
+     * @brief Get the position of this selector's id in a data provider, if recorded by @ref set_id_index
+     *
+     * Providers that look up ids in a table record their position, so requests reusing this selector skip the lookup.
+     *
+     * @param provider The provider the position is for
+     * @param index Set to the position, if it is recorded for the provider
+     * @return Whether the position is recorded for the provider
+     */
+    bool get_id_index(const void* provider, std::size_t& index) const {
+        if (id_index_provider != provider) {
+            return false;
+        }
+        index = id_index;
+        return true;
+    }
+
+    /**
+     * @brief Record the position of this selector's id in a data provider
+     *
+     * @param provider The provider the position is for
+     * @param index The position of the id
+     */
+    void set_id_index(const void* provider, std::size_t index) const {
+        id_index_provider = provider;
+        id_index = index;
+    }
 
     private:
 
@@ -113,6 +142,8 @@ class CatchmentAggrDataSelector
     long duration_s;  //!< The duration of the query
     std::string output_units; //!< required units for the result to be return in
     std::string id_str; //< the catchment to access data for
+    mutable const void* id_index_provider = nullptr; //< the provider that id_index is a position in, if any
+    mutable std::size_t id_index = 0; //< the position of the id in id_index_provider
 };
 
 #endif
@@ -0,0 +1,302 @@
+#ifndef NGEN_FORCING_FILE_INDEX_HPP
+#define NGEN_FORCING_FILE_INDEX_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace data_access {
+
+    /**
+     * A listing of a forcing directory, for finding each catchment's file from a ``file_pattern``.
+     *
+     * The directory is read once, and its file names are indexed by the tokens in them that could be catchment ids
+     * (runs of letters and digits, optionally with ``-`` and ``_``).  A pattern such as ``.*{{id}}.*.csv`` is then
+     * compiled once, as the parts before and after ``{{id}}``, and each id's file is found among the few names
+     * containing it as a token, rather than by matching a newly compiled regular expression against every name in
+     * the directory.
+     *
+     * Patterns that cannot be split that way (e.g., with alternation) are matched as before, against the listing.
+     */
+    class ForcingFileIndex {
+    public:
+
+        /**
+         * List a directory.
+         *
+         * @param directory The path of the directory, ending in ``/``.
+         * @throws std::runtime_error If the directory cannot be opened.
+         */
+        explicit ForcingFileIndex(const std::string& directory) : directory(directory)
+        {
+            // A stream providing the functions necessary for evaluating a directory:
+            //    https://www.gnu.org/software/libc/manual/html_node/Opening-a-Directory.html#Opening-a-Directory
+            DIR* dir = opendir(directory.c_str());
+            // Allow for a few retries in certain failure situations
+            size_t attemptCount = 0;
+            std::string errMsg;
+            while (dir == nullptr && attemptCount++ < 5) {
+                // For several error codes, we should break immediately and not retry
+                if (errno == ENOENT) {
+                    errMsg = "No such file or directory.";
+                    break;
+                }
+                if (errno == ENXIO) {
+                    errMsg = "No such device or address.";
+                    break;
+                }
+                if (errno == EACCES) {
+                    errMsg = "Permission denied.";
+                    break;
+                }
+                if (errno == EPERM) {
+                    errMsg = "Operation not permitted.";
+                    break;
+                }
+                if (errno == ENOTDIR) {
+                    errMsg = "File at provided path is not a directory.";
+                    break;
+                }
+                if (errno == EMFILE) {
+                    errMsg = "The current process has too many open files.";
+                    break;
+                }
+                if (errno == ENFILE) {
+                    errMsg = "The system has too many open files.";
+                    break;
+                }
+                sleep(2);
+                dir = opendir(directory.c_str());
+                errMsg = "Received system error number " + std::to_string(errno);
+            }
+            if (dir == nullptr) {
+                // The directory wasn't found or otherwise couldn't be opened; forcing data cannot be retrieved
+                throw std::runtime_error("Error opening forcing data dir '" + directory + "' after " + std::to_string(attemptCount) + " attempts: " + errMsg);
+            }
+
+            // structure representing the member of a directory: https://www.gnu.org/software/libc/manual/html_node/Directory-Entries.html
+            struct dirent* dir_entry;
+            while ((dir_entry = readdir(dir))) {
+                entry e;
+                e.name = dir_entry->d_name;
+                #ifdef _DIRENT_HAVE_D_TYPE
+                e.type = dir_entry->d_type;
+                #else
+                e.type = DT_UNKNOWN;
+                #endif
+                index_tokens(e.name, entries.size());
+                entries.push_back(std::move(e));
+            }
+            closedir(dir);
+        }
+
+        /** The number of entries in the directory. */
+        size_t size() const
+        {
+            return entries.size();
+        }
+
+        /**
+         * Find the first file in the directory whose name matches a pattern, once any ``{{id}}`` in it is replaced
+         * by an identifier.
+         *
+         * @param file_pattern The (ECMAScript) regular expression file names must match.
+         * @param identifier The catchment id to substitute for ``{{id}}``.
+         * @return The path of the file (the directory followed by its name), or an empty string if none matches.
+         * @throws std::runtime_error If a matching entry's type is unknown and it is not a regular file (or link to one).
+         */
+        std::string find(const std::string& file_pattern, const std::string& identifier)
+        {
+            pattern& p = get_pattern(file_pattern);
+            if (!p.has_id) {
+                // The same file for every catchment
+                if (!p.resolved) {
+                    p.match = find_first([&p](const std::string& name) { return std::regex_match(name, p.whole); }, all_entries());
+                    p.resolved = true;
+                }
+                return p.match;
+            }
+            if (!p.splits || !is_token(identifier)) {
+                std::regex whole(p.prefix_source + identifier + p.suffix_source);
+                return find_first([&whole](const std::string& name) { return std::regex_match(name, whole); }, all_entries());
+            }
+
+            auto matches = [&p, &identifier](const std::string& name) {
+                for (size_t at = name.find(identifier); at != std::string::npos; at = name.find(identifier, at + 1)) {
+                    if (std::regex_match(name.begin(), name.begin() + at, p.prefix)
+                        && std::regex_match(name.begin() + at + identifier.size(), name.end(), p.suffix)) {
+                        return true;
+                    }
+                }
+                return false;
+            };
+            auto candidates = tokens.find(identifier);
+            if (candidates != tokens.end()) {
+                std::string found = find_first(matches, candidates->second);
+                if (!found.empty()) {
+                    return found;
+                }
+            }
+            // The id may only appear in a name as part of a longer token
+            return find_first(matches, all_entries());
+        }
+
+    private:
+
+        struct entry {
+            std::string name;
+            unsigned char type;
+        };
+
+        struct pattern {
+            bool has_id = false;
+            /** Whether the parts before and after ``{{id}}`` are regular expressions on their own. */
+            bool splits = false;
+            std::regex whole;
+            std::regex prefix;
+            std::regex suffix;
+            std::string prefix_source;
+            std::string suffix_source;
+            bool resolved = false;
+            std::string match;
+        };
+
+        static bool is_token_char(char c, bool dash, bool underscore)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                   || (dash && c == '-') || (underscore && c == '_');
+        }
+
+        /** Whether an identifier is made only of characters that may be in a token (and that are not special in a regular expression). */
+        static bool is_token(const std::string& identifier)
+        {
+            if (identifier.empty()) {
+                return false;
+            }
+            for (char c : identifier) {
+                if (!is_token_char(c, true, true)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void index_tokens(const std::string& name, size_t index)
+        {
+            // E.g., "cat-27_2015.csv" has "cat", "27", "cat-27", "cat-27_2015", "2015" and "csv"
+            for (int kind = 0; kind < 3; ++kind) {
+                const bool dash = kind > 0, underscore = kind > 1;
+                size_t begin = 0;
+                while (begin < name.size()) {
+                    while (begin < name.size() && !is_token_char(name[begin], dash, underscore)) {
+                        ++begin;
+                    }
+                    size_t end = begin;
+                    while (end < name.size() && is_token_char(name[end], dash, underscore)) {
+                        ++end;
+                    }
+                    if (end > begin) {
+                        std::vector<size_t>& indices = tokens[name.substr(begin, end - begin)];
+                        if (indices.empty() || indices.back() != index) {
+                            indices.push_back(index);
+                        }
+                    }
+                    begin = end;
+                }
+            }
+        }
+
+        pattern& get_pattern(const std::string& file_pattern)
+        {
+            auto found = patterns.find(file_pattern);
+            if (found != patterns.end()) {
+                return found->second;
+            }
+            pattern& p = patterns[file_pattern];
+            const size_t id_index = file_pattern.find("{{id}}");
+            p.has_id = id_index != std::string::npos;
+            if (!p.has_id) {
+                p.whole = std::regex(file_pattern);
+                return p;
+            }
+            // Only the first {{id}} is replaced
+            p.prefix_source = file_pattern.substr(0, id_index);
+            p.suffix_source = file_pattern.substr(id_index + sizeof("{{id}}") - 1);
+            // Alternation and back references can span {{id}}
+            p.splits = file_pattern.find('|') == std::string::npos
+                       && !std::regex_search(file_pattern, std::regex("\\\\[1-9]"));
+            if (p.splits) {
+                try {
+                    p.prefix = std::regex(p.prefix_source);
+                    p.suffix = std::regex(p.suffix_source);
+                }
+                catch (const std::regex_error&) {
+                    // E.g., a group around {{id}}
+                    p.splits = false;
+                }
+            }
+            return p;
+        }
+
+        const std::vector<size_t>& all_entries()
+        {
+            if (all_indices.size() != entries.size()) {
+                all_indices.resize(entries.size());
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    all_indices[i] = i;
+                }
+            }
+            return all_indices;
+        }
+
+        template <class Predicate>
+        std::string find_first(Predicate matches, const std::vector<size_t>& indices) const
+        {
+            for (size_t i : indices) {
+                const entry& e = entries[i];
+                if (!matches(e.name)) {
+                    continue;
+                }
+                // If the entry is a regular file or symlink AND the name matches the pattern,
+                //    we can consider this ready to be interpretted as valid forcing data (even if it isn't)
+                if (e.type == DT_REG || e.type == DT_LNK) {
+                    return directory + e.name;
+                }
+                if (e.type == DT_UNKNOWN) {
+                    //dirent is not guaranteed to provide propoer file type identification in d_type
+                    //so if a system returns unknown or it isn't supported, need to use stat to determine if it is a file
+                    struct stat st;
+                    if (stat((directory + e.name).c_str(), &st) != 0) {
+                        throw std::runtime_error("Could not stat file " + directory + e.name);
+                    }
+                    //Since we used stat and not lstat, we get the result of the target of links as well
+                    //so this covers both cases we are interested in.
+                    if (S_ISREG(st.st_mode)) {
+                        return directory + e.name;
+                    }
+                    throw std::runtime_error("Forcing data is path " + directory + e.name + " is not a file");
+                }
+            }
+            return "";
+        }
+
+        const std::string directory;
+        std::vector<entry> entries;
+        /** The entries containing each token, in directory order. */
+        std::unordered_map<std::string, std::vector<size_t>> tokens;
+        std::unordered_map<std::string, pattern> patterns;
+        std::vector<size_t> all_indices;
+    };
+
+} // namespace data_access
+
+#endif // NGEN_FORCING_FILE_INDEX_HPP
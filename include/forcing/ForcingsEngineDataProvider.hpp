@@ -139,6 +139,12 @@ struct ForcingsEngineDataProvider
         return (epoch - time_begin_) / time_step_;
     }
 
+    //! Values are read from the Python Forcings Engine model.
+    bool calls_python() const override
+    {
+        return true;
+    }
+
     std::shared_ptr<models::bmi::Bmi_Py_Adapter> model() noexcept
     {
         return bmi_;
@@ -16,12 +16,15 @@
 #include <sstream>
 #include <exception>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "assert.h"
 #include <iomanip>
-#include <boost/compute/detail/lru_cache.hpp>
+#include <boost/core/span.hpp>
 
 #include <UnitsHelper.hpp>
 #include <StreamHandler.hpp>
+#include <Prefetcher.hpp>
 
 #include "AorcForcing.hpp"
 
@@ -52,15 +55,27 @@ namespace data_access
          * @param input_path The path to a NetCDF file with lumped catchment forcing values.
          * @param log_s An output log stream for messages from the underlying library. If a provider object for
          * the given path already exists, this argument will be ignored.
+         * @param block_size The number of time steps read at once, or 0 for the default; see the constructor.  If a
+         * provider object for the given path already exists, this argument will be ignored.
+         * @param prefetch_blocks The number of blocks read ahead in the background; see the constructor.  If a
+         * provider object for the given path already exists, this argument will be ignored.
          */
-        static std::shared_ptr<NetCDFPerFeatureDataProvider> get_shared_provider(std::string input_path, time_t sim_start, time_t sim_end, utils::StreamHandler log_s);
+        static std::shared_ptr<NetCDFPerFeatureDataProvider> get_shared_provider(std::string input_path, time_t sim_start, time_t sim_end, utils::StreamHandler log_s, std::size_t block_size = 0, std::size_t prefetch_blocks = 0);
 
         /**
          * @brief Cleanup the shared providers cache, ensuring that the files get closed.
          */
         static void cleanup_shared_providers();
 
-        NetCDFPerFeatureDataProvider(std::string input_path, time_t sim_start, time_t sim_end,  utils::StreamHandler log_s);
+        /**
+         * @param block_size The number of time steps of a variable read at once, for all catchments, and kept in
+         * memory.  A value of 0 selects up to 24 time steps, fewer for files with many catchments so that a block
+         * holds at most 4M values.
+         * @param prefetch_blocks The number of following blocks of each variable to read on a background thread
+         * while the current one is used, hiding file system latency at the cost of that many more blocks in memory.
+         * With 0, blocks are read when first needed, by the requesting thread.
+         */
+        NetCDFPerFeatureDataProvider(std::string input_path, time_t sim_start, time_t sim_end,  utils::StreamHandler log_s, std::size_t block_size = 0, std::size_t prefetch_blocks = 0);
 
         // Default implementation defined in the .cpp file so that
         // client code doesn't need to have the full definition of
@@ -110,8 +125,46 @@ namespace data_access
 
         virtual std::vector<double> get_values(const CatchmentAggrDataSelector& selector, data_access::ReSampleMethod m) override;
 
+        /** Return the number of time steps of a variable read at once */
+        std::size_t get_block_size() const;
+
+        /**
+         * Get the position of a catchment id in the file.
+         *
+         * @throws std::out_of_range If the id is not in the file.
+         */
+        std::size_t get_id_index(const std::string& id) const;
+
         private:
 
+        /**
+         * Values of one variable for every catchment and a block of time steps, in some units.
+         */
+        struct value_block
+        {
+            std::string units;
+            std::size_t first_time_index = 0;
+            std::size_t num_times = 0;
+            // The converted value of 0 native units, i.e. the offset of an affine conversion such as K to degC
+            double zero_offset = 0.0;
+            // Row-major [catchment][time step], the layout of the file's variables
+            std::vector<double> values;
+        };
+
+        /**
+         * Identifies a block to read.
+         */
+        struct block_key
+        {
+            std::string name;
+            std::string units;
+            std::size_t first_time_index;
+            std::size_t num_times;
+
+            bool operator<(const block_key& other) const;
+            bool operator==(const block_key& other) const;
+        };
+
         time_t sim_start_date_time_epoch;
         time_t sim_end_date_time_epoch;
         time_t sim_to_data_time_offset; // Deliberately signed--sim should never start before data, yes?
@@ -122,7 +175,7 @@ namespace data_access
         std::vector<std::string> variable_names;
         std::vector<std::string> loc_ids;
         std::vector<double> time_vals;
-        std::map<std::string, std::size_t> id_pos;
+        std::unordered_map<std::string, std::size_t> id_pos;
         double start_time;                              // the begining of the first time for which data is stored
         double stop_time;                               // the end of the last time for which data is stored
         TimeUnit time_unit;                             // the unit that time was stored as in the file
@@ -134,14 +187,24 @@ namespace data_access
 
         std::map<std::string,netCDF::NcVar> ncvar_cache;
         std::map<std::string,std::string> units_cache;
-        boost::compute::detail::lru_cache<std::string, std::shared_ptr<std::vector<double>>> value_cache;
-        size_t cache_slice_t_size = 1;
-        size_t cache_slice_c_size = 1;
+        // Current blocks of each requested variable name, one per requested units
+        std::unordered_map<std::string, std::vector<value_block>> value_blocks;
+        std::size_t block_size;
+        std::size_t prefetch_blocks;
+        std::mutex read_mutex;
+        // When set, performs all reads of the file (after construction), on its own thread
+        std::unique_ptr<utils::Prefetcher<block_key, value_block>> prefetcher;
 
         const netCDF::NcVar& get_ncvar(const std::string& name);
 
         const std::string& get_ncvar_units(const std::string& name);
 
+        /** Get the block of a variable in the given units holding time steps ``first`` to ``last``, reading it if needed */
+        const value_block& get_block(const std::string& name, const std::string& units, std::size_t first, std::size_t last);
+
+        /** Read and convert a block */
+        value_block read_block(const block_key& key);
+
     };
 }
 
@@ -136,6 +136,10 @@ namespace data_access {
             return wrapped_provider->is_property_sum_over_time_step(name);
         }
 
+        bool calls_python() const override {
+            return wrapped_provider != nullptr && wrapped_provider->calls_python();
+        }
+
     protected:
         GenericDataProvider* wrapped_provider;
 
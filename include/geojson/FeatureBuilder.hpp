@@ -5,12 +5,14 @@
 #include <FeatureCollection.hpp>
 #include <JSONGeometry.hpp>
 
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <ostream>
 #include <exception>
 #include <string>
 #include <algorithm>
+#include <sstream>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -224,6 +226,101 @@ namespace geojson {
         throw std::invalid_argument("tree");
     }
 
+    /**
+     * @brief Create a feature of the given type
+     *
+     * @param type The type of the feature, which determines which kind of geometry is used
+     * @param geometry_object The geometry of the feature; unused for a GeometryCollection
+     * @param geometry_collection The geometries of a GeometryCollection feature
+     * @param id The ID of the feature
+     * @param properties The properties of the feature
+     * @param bounding_box The bounding box of the feature
+     * @param foreign_members Members of the feature that are not part of the GeoJSON specification
+     * @return The new feature
+     */
+    static Feature make_feature(
+        FeatureType type,
+        geometry geometry_object,
+        std::vector<geometry> geometry_collection,
+        std::string id,
+        PropertyMap properties,
+        std::vector<double> bounding_box,
+        PropertyMap foreign_members
+    ) {
+        switch (type) {
+            case FeatureType::Point:
+                return std::make_shared<PointFeature>(
+                    std::move(boost::get<coordinate_t>(geometry_object)),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+            case FeatureType::LineString:
+                return std::make_shared<LineStringFeature>(
+                    std::move(boost::get<linestring_t>(geometry_object)),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+            case FeatureType::Polygon:
+                return std::make_shared<PolygonFeature>(
+                    std::move(boost::get<polygon_t>(geometry_object)),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+            case FeatureType::MultiPoint:
+                return std::make_shared<MultiPointFeature>(
+                    std::move(boost::get<multipoint_t>(geometry_object)),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+            case FeatureType::MultiLineString:
+                return std::make_shared<MultiLineStringFeature>(
+                    std::move(boost::get<multilinestring_t>(geometry_object)),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+            case FeatureType::MultiPolygon:
+                return std::make_shared<MultiPolygonFeature>(
+                    std::move(boost::get<multipolygon_t>(geometry_object)),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+            default:
+                return std::make_shared<CollectionFeature>(
+                    std::move(geometry_collection),
+                    std::move(id),
+                    std::move(properties),
+                    std::move(bounding_box),
+                    std::vector<FeatureBase*>(),
+                    std::vector<FeatureBase*>(),
+                    std::move(foreign_members)
+                );
+        }
+    }
+
     static Feature build_feature(boost::property_tree::ptree &tree) {
         bool has_geometry_collection = false;
         bool has_geometry = false;
@@ -291,79 +388,16 @@ namespace geojson {
             }
         }
 
-        
-        switch (type) {
-            case FeatureType::Point:
-                return std::make_shared<PointFeature>(PointFeature(
-                    boost::get<coordinate_t>(geometry_object),
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-            case FeatureType::LineString:
-                return std::make_shared<LineStringFeature>(LineStringFeature(
-                    boost::get<linestring_t>(geometry_object),
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-            case FeatureType::Polygon:
-                return std::make_shared<PolygonFeature>(PolygonFeature(
-                    boost::get<polygon_t>(geometry_object),
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-            case FeatureType::MultiPoint:
-                return std::make_shared<MultiPointFeature>(MultiPointFeature(
-                    boost::get<multipoint_t>(geometry_object),
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-            case FeatureType::MultiLineString:
-                return std::make_shared<MultiLineStringFeature>(MultiLineStringFeature(
-                    boost::get<multilinestring_t>(geometry_object),
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-            case FeatureType::MultiPolygon:
-                return std::make_shared<MultiPolygonFeature>(MultiPolygonFeature(
-                    boost::get<multipolygon_t>(geometry_object),
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-            default:                
-                return std::make_shared<CollectionFeature>(CollectionFeature(
-                    geometry_collection,
-                    id,
-                    properties,
-                    bounding_box,
-                    std::vector<FeatureBase*>(),
-                    std::vector<FeatureBase*>(),
-                    foreign_members
-                ));
-        }
+
+        return make_feature(
+            type,
+            std::move(geometry_object),
+            std::move(geometry_collection),
+            std::move(id),
+            std::move(properties),
+            std::move(bounding_box),
+            std::move(foreign_members)
+        );
     }
 
     /**
@@ -441,16 +475,31 @@ namespace geojson {
         return collection;
     }
 
-    static GeoJSON read(const std::string &file_path, const std::vector<std::string> &ids = {}) {
-        boost::property_tree::ptree tree;
-        boost::property_tree::json_parser::read_json(file_path, tree);
-        return build_collection(tree, ids);
+    /**
+     * @brief Read a GeoJSON FeatureCollection from a stream, building each feature as it is parsed
+     *
+     * Unlike build_collection, the document is never held in memory as a whole: features are built directly from
+     * the stream, and features not in ``ids`` are discarded without building their geometry.  Property values are
+     * typed as they are by build_collection.
+     *
+     * @param input Stream holding the GeoJSON
+     * @param ids optional subset of string feature ids, only features with these ids will be in the collection
+     * @param with_geometry whether to build feature geometries; if false, coordinates are skipped and each feature
+     *                      has an empty geometry of its type, for when only topology and properties are needed
+     * @return The collection of features read
+     */
+    GeoJSON read_stream(std::istream& input, const std::vector<std::string>& ids = {}, bool with_geometry = true);
+
+    static GeoJSON read(const std::string &file_path, const std::vector<std::string> &ids = {}, bool with_geometry = true) {
+        std::ifstream input(file_path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("Unable to open GeoJSON file " + file_path);
+        }
+        return read_stream(input, ids, with_geometry);
     }
 
-    static GeoJSON read(std::stringstream &data, const std::vector<std::string> &ids = {}) {
-        boost::property_tree::ptree tree;
-        boost::property_tree::json_parser::read_json(data, tree);
-        return build_collection(tree, ids);
+    static GeoJSON read(std::stringstream &data, const std::vector<std::string> &ids = {}, bool with_geometry = true) {
+        return read_stream(data, ids, with_geometry);
     }
 
 
@@ -5,7 +5,9 @@
 #include "JSONProperty.hpp"
 #include "FeatureVisitor.hpp"
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <exception>
 #include <string>
@@ -113,6 +115,7 @@ namespace geojson {
                 }
                 else {
                     this->geom = feature.geom;
+                    this->deferred_geom = feature.deferred_geom;
                 }
 
                 for (FeatureBase *origination_feature : feature.origination_features()) {
@@ -525,18 +528,31 @@ namespace geojson {
             template<class T>
             T geometry() const {
                 try {
-                    return boost::get<T>(this->geom);
+                    return boost::get<T>(this->get_geom());
                 }
                 catch (boost::bad_get &exception) {
                     std::string template_name = boost::typeindex::type_id<T>().pretty_name();
-                    std::string expected_name = get_geometry_type(this->geom);
+                    std::string expected_name = get_geometry_type(this->get_geom());
                     std::cerr << "Asked for " << template_name << ", but only " << expected_name << " is valid" << std::endl;
                     throw;
                 }
             }
 
             ::geojson::geometry geometry() const {
-                return this->geom;
+                return this->get_geom();
+            }
+
+            /**
+             * Defer building the geometry of the feature until it is first used
+             *
+             * This lets a reader that can tell a feature's type and bounding box without decoding its coordinates
+             * (e.g., from a GeoPackage geometry header) skip decoding geometries that are never used.
+             *
+             * @param loader A function building the geometry, which must be of the feature's type; it is called at
+             *               most once, from whichever thread first uses the geometry
+             */
+            void set_geometry_loader(std::function<::geojson::geometry()> loader) {
+                this->deferred_geom = std::make_shared<deferred_geometry>(std::move(loader));
             }
 
             template<class T>
@@ -578,7 +594,7 @@ namespace geojson {
                         }
                     }
                 }
-                else if (not bg::equals(this->geom, rhs.geom)) {
+                else if (not bg::equals(this->get_geom(), rhs.get_geom())) {
                     return false;
                 }
 
@@ -637,6 +653,21 @@ namespace geojson {
             }
 
         protected:
+            /**
+             * Get the geometry of the feature, building it first if it was deferred
+             */
+            const ::geojson::geometry& get_geom() const {
+                if (this->deferred_geom == nullptr) {
+                    return this->geom;
+                }
+                deferred_geometry& deferred = *this->deferred_geom;
+                std::call_once(deferred.built, [&deferred]() {
+                    deferred.value = deferred.load();
+                    deferred.load = nullptr;
+                });
+                return deferred.value;
+            }
+
             virtual void break_links() {
                 // Go through all of the originators and remove the reference to this feature
                 for (auto originator : this->origination) {
@@ -706,8 +737,20 @@ namespace geojson {
                 }
             }
 
+            /**
+             * A geometry built on first use, shared by copies of the feature
+             */
+            struct deferred_geometry {
+                explicit deferred_geometry(std::function<::geojson::geometry()> load) : load(std::move(load)) {}
+
+                std::once_flag built;
+                std::function<::geojson::geometry()> load;
+                ::geojson::geometry value;
+            };
+
             FeatureType type;
             ::geojson::geometry geom;
+            std::shared_ptr<deferred_geometry> deferred_geom;
             std::vector<::geojson::geometry> geometry_collection;
 
             PropertyMap properties;
@@ -34,7 +34,7 @@ namespace geojson {
             }
 
             linestring_t geometry()  const {
-                return boost::get<linestring_t>(this->geom);
+                return boost::get<linestring_t>(this->get_geom());
             }
 
             void visit(FeatureVisitor& visitor) override {
@@ -34,7 +34,7 @@ namespace geojson {
             }
 
             multipolygon_t geometry() const {
-                return boost::get<multipolygon_t>(this->geom);
+                return boost::get<multipolygon_t>(this->get_geom());
             }
 
             void visit(FeatureVisitor& visitor) override {
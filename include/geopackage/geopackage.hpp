@@ -21,6 +21,31 @@ geojson::geometry build_geometry(
     std::vector<double>& bounding_box
 );
 
+/**
+ * Build a geometry object from GeoPackage WKB.
+ *
+ * @param[in] geometry_blob GPKG WKB of the geometry
+ * @param[out] bounding_box Bounding box of the geometry to output
+ * @return geojson::geometry GPKG WKB converted and projected to a boost geometry model
+ */
+geojson::geometry build_geometry(
+    const std::vector<uint8_t>& geometry_blob,
+    std::vector<double>& bounding_box
+);
+
+/**
+ * Read the type and bounding box of a geometry from the headers of GeoPackage WKB, without decoding its coordinates.
+ *
+ * @param[in] geometry_blob GPKG WKB of the geometry
+ * @param[out] bounding_box Bounding box of the geometry, from the envelope in its header
+ * @return geojson::FeatureType The type of feature for the geometry, or FeatureType::None if it
+ *         cannot be told without building the geometry (e.g., it is empty or has no envelope)
+ */
+geojson::FeatureType read_geometry_type(
+    const std::vector<uint8_t>& geometry_blob,
+    std::vector<double>& bounding_box
+);
+
 /**
  * Build properties from GeoPackage table columns.
  * 
@@ -35,6 +60,9 @@ geojson::PropertyMap build_properties(
 
 /**
  * Build a feature from a GPKG table row
+ *
+ * Unless the geometry is a point, or its type or bounding box can only be told by decoding it, the geometry
+ * is decoded when it is first used, rather than here.
  * 
  * @param[in] row SQLite iterator at the row to build a feature from
  * @param[in] geom_col Name of geometry column containing GPKG WKB
@@ -49,15 +77,25 @@ geojson::Feature build_feature(
 /**
  * Build a feature collection from a GPKG layer
  *
+ * A subset of IDs is looked up by the index on the ID column, in batches; if the column has no index,
+ * the subset is taken while scanning the layer once.  Large layers are scanned in ranges of rows,
+ * concurrently, each on its own connection to the GPKG file.
+ *
  * @param[in] gpkg_path Path to GPKG file
  * @param[in] layer Layer name within GPKG file to create a collection from
  * @param[in] ids optional subset of feature IDs to capture (if empty, the entire layer is converted)
+ * @param[in] columns optional subset of columns to make properties of (if empty, all columns are);
+ *                    columns the layer does not have are ignored, and the ID and geometry are always read
+ * @param[in] threads number of ranges to scan concurrently (if 0, it depends on the size of
+ *                    the layer and the hardware)
  * @return std::shared_ptr<geojson::FeatureCollection> 
  */
 std::shared_ptr<geojson::FeatureCollection> read(
     const std::string& gpkg_path,
     const std::string& layer,
-    const std::vector<std::string>& ids
+    const std::vector<std::string>& ids,
+    const std::vector<std::string>& columns = {},
+    unsigned int threads = 0
 );
 
 } // namespace geopackage
@@ -25,9 +25,11 @@
 #define BMI_REALIZATION_CFG_PARAM_OPT__OUTPUT_PRECISION "output_precision"
 #define BMI_REALIZATION_CFG_PARAM_OPT__ALLOW_EXCEED_END "allow_exceed_end_time"
 #define BMI_REALIZATION_CFG_PARAM_OPT__FIXED_TIME_STEP "fixed_time_step"
+#define BMI_REALIZATION_CFG_PARAM_OPT__THREAD_SAFE "thread_safe"
 #define BMI_REALIZATION_CFG_PARAM_OPT__LIB_FILE "library_file"
 #define BMI_REALIZATION_CFG_PARAM_OPT__PYTHON_TYPE_NAME "python_type"
 #define BMI_REALIZATION_CFG_PARAM_OPT__PYTHON_MODULE_PATH "module_path"
+#define BMI_REALIZATION_CFG_PARAM_OPT__PYTHON_BATCHED "python_batched"
 #define BMI_REALIZATION_CFG_PARAM_OPT__REGISTRATION_FUNC "registration_function"
 #define BMI_REALIZATION_CFG_PARAM_OPT__CPP_CREATE_FUNC "create_function"
 #define BMI_REALIZATION_CFG_PARAM_OPT__CPP_DESTROY_FUNC "destroy_function"
@@ -134,7 +136,7 @@ namespace realization {
          *
          * @return The name of the backing model object's type.
          */
-        std::string get_model_type_name() const {
+        const std::string& get_model_type_name() const {
             return model_type_name;
         }
 
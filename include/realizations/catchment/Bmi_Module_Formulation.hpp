@@ -3,10 +3,12 @@
 
 #include <utility>
 #include <memory>
+#include <unordered_map>
 #include "Bmi_Formulation.hpp"
 #include "Bmi_Adapter.hpp"
 #include <DataProvider.hpp>
 #include "bmi_utilities.hpp"
+#include <UnitsHelper.hpp>
 
 using data_access::MEAN;
 using data_access::SUM;
@@ -83,6 +85,8 @@ namespace realization {
          */
         std::string get_output_line_for_timestep(int timestep, std::string delimiter) override;
 
+        std::vector<double> get_output_values_for_timestep(int timestep) override;
+
         /**
          * Get the model response for a time step.
          *
@@ -250,6 +254,35 @@ namespace realization {
         const std::vector<std::string> get_bmi_input_variables() const override;
         const std::vector<std::string> get_bmi_output_variables() const override;
 
+        /**
+         * Get whether this instance may be executed concurrently with other formulations.
+         *
+         * Many BMI libraries keep module-level or global state, so this is only the case when the ``thread_safe``
+         * parameter of the formulation's config is ``true``, and the forcing provider does not call into Python.
+         *
+         * @return Whether the backing model was configured as safe to run concurrently with other instances.
+         */
+        bool is_thread_safe() const override {
+            return thread_safe && !uses_python();
+        }
+
+        /**
+         * Check the backing model implements the BMI serialization extension (see
+         * @ref models::bmi::Bmi_Adapter::is_serializable).
+         *
+         * @throws std::runtime_error If the backing model cannot serialize its state.
+         */
+        void check_state_support() override;
+
+        /**
+         * Write the time step position of this formulation and the serialized state of its backing model.
+         *
+         * @throws std::runtime_error If the backing model does not implement the BMI serialization extension.
+         */
+        void write_state(std::ostream &out) override;
+
+        void read_state(std::istream &in) override;
+
     protected:
 
         /**
@@ -387,6 +420,72 @@ namespace realization {
         time_t last_model_response_start_time = 0;
         std::map<std::string, std::shared_ptr<data_access::GenericDataProvider>> input_forcing_providers;
 
+        /**
+         * A model input variable resolved to everything needed to set its value each time step.
+         */
+        struct input_binding {
+            /** The model's name for the variable. */
+            std::string bmi_name;
+            /** The provider of the variable's values. */
+            data_access::GenericDataProvider *provider;
+            /** Selects the values from the provider, in the model's units; only the time changes between steps. */
+            CatchmentAggrDataSelector selector;
+            /** The number of values the model expects. */
+            std::size_t num_items;
+            /** The native type of the model's values. */
+            models::bmi::value_type type;
+            /** The name of the native type, for error messages. */
+            std::string type_name;
+            /** Storage for the values converted to the native type, passed to the model's ``SetValue``. */
+            std::vector<unsigned char> buffer;
+            /**
+             * For an input coupled directly to an output variable of another module with the same number of values,
+             * that module; otherwise null, and values are read through @ref provider.
+             */
+            Bmi_Module_Formulation *source = nullptr;
+            /** The source module's name for the output variable. */
+            std::string source_name;
+            /** The native type of the source module's values. */
+            models::bmi::value_type source_type = models::bmi::value_type::UNKNOWN;
+            /** The conversion from the source module's units to the model's, or null if none is needed. */
+            const UnitsHelper::conversion *conversion = nullptr;
+            /** Storage for the source module's values, when they must be converted before being set. */
+            std::vector<unsigned char> source_buffer;
+        };
+
+        /**
+         * Couple an input directly to the output variable of another module providing it, if possible.
+         *
+         * When the provider of an input is another BMI module (as within a multi-BMI formulation) and its output
+         * variable has as many values as the input, the values are copied straight from one model to the other each time
+         * step.  When they also have the same native type and units, this is a single copy into the binding's buffer;
+         * otherwise values are converted as needed on the way.
+         *
+         * @param binding The binding of an input, with its provider, number of values, type, and selector set.
+         */
+        void couple_input_binding(input_binding &binding);
+
+        /**
+         * Resolve each model input variable to its provider, number of values, and native type.
+         *
+         * This is done once, the first time inputs are set, so each time step only reads values and sets them.
+         */
+        void build_input_bindings();
+
+        /**
+         * Get the native type of a model variable, resolving it with the model the first time it is requested.
+         *
+         * @param var_name The model's name for the variable.
+         * @return The native type of the variable's values.
+         */
+        models::bmi::value_type get_var_value_type(const std::string &var_name);
+
+        /** The input variable binding plan built by @ref build_input_bindings. */
+        std::vector<input_binding> input_bindings;
+        bool input_bindings_built = false;
+        /** The native types of variables already resolved by @ref get_var_value_type. */
+        std::unordered_map<std::string, models::bmi::value_type> var_value_types;
+
         // Access for multi-BMI
         friend class Bmi_Multi_Formulation;
 
@@ -418,6 +517,12 @@ namespace realization {
          */
         int next_time_step_index = 0;
 
+        /**
+         * The time step whose model inputs were already set by @ref prepare_response, so @ref get_response does not
+         * set them again, or ``-1`` if there is none.
+         */
+        int prepared_time_step_index = -1;
+
     private:
         /**
          * Whether model ``Update`` calls are allowed and handled in some way by the backing model for time steps after
@@ -430,6 +535,8 @@ namespace realization {
         std::shared_ptr<models::bmi::Bmi_Adapter> bmi_model;
         /** Whether backing model has fixed time step size. */
         bool bmi_model_time_step_fixed = true;
+        /** Whether the backing model may run concurrently with other instances, as set in the config. */
+        bool thread_safe = false;
         /**
          * The offset, converted to seconds, from the model's start time to the start time of the initial forcing time
          * step.
@@ -131,6 +131,55 @@ namespace realization {
 
         const time_t &get_bmi_model_start_time_forcing_offset_s() const override;
 
+        /**
+         * Get whether this instance may be executed concurrently with other formulations.
+         *
+         * @return Whether every nested module formulation may be executed concurrently, and the forcing provider does
+         *         not call into Python.
+         */
+        bool is_thread_safe() const override {
+            if (Bmi_Formulation::uses_python()) {
+                return false;
+            }
+            for (const nested_module_ptr &module : modules) {
+                if (!module->is_thread_safe()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Get whether the forcing provider or any nested module calls into Python.
+         *
+         * @return Whether this formulation calls into Python.
+         */
+        bool uses_python() const override {
+            if (Bmi_Formulation::uses_python()) {
+                return true;
+            }
+            for (const nested_module_ptr &module : modules) {
+                if (module->uses_python()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Check every nested module can save and restore its state.
+         *
+         * @throws std::runtime_error If any nested module cannot save its state.
+         */
+        void check_state_support() override;
+
+        /**
+         * Write the time step position of this formulation, followed by the state of each nested module in order.
+         */
+        void write_state(std::ostream &out) override;
+
+        void read_state(std::istream &in) override;
+
         /**
          * Get the output variables of the last nested BMI model.
          *
@@ -344,6 +393,8 @@ namespace realization {
 
         std::string get_output_line_for_timestep(int timestep, std::string delimiter) override;
 
+        std::vector<double> get_output_values_for_timestep(int timestep) override;
+
         double get_response(time_step_t t_index, time_step_t t_delta) override;
 
         /**
@@ -9,6 +9,7 @@
 #include <string>
 #include "Bmi_Module_Formulation.hpp"
 #include "Bmi_Py_Adapter.hpp"
+#include "Bmi_Py_Batch_Adapter.hpp"
 #include "GenericDataProvider.hpp"
 #include "pybind11/pybind11.h"
 #include "pybind11/pytypes.h"
@@ -35,6 +36,33 @@ namespace realization {
 
         bool is_bmi_output_variable(const std::string &var_name) const override;
 
+        /**
+         * Python models require the interpreter's global lock, which is held by the main thread.
+         *
+         * @return ``false``, as this formulation must only be executed from the main thread.
+         */
+        bool is_thread_safe() const override {
+            return false;
+        }
+
+        bool uses_python() const override {
+            return true;
+        }
+
+        /**
+         * Set the inputs of this catchment for the given time step ahead of the update, when the backing model is
+         * batched, so the shared model can advance all of its catchments at once.
+         */
+        void prepare_response(time_step_t t_index, time_step_t t_delta) override;
+
+        /**
+         * Check the backing model can save its state, which a batched model cannot, as its state is shared by all of
+         * its catchments.
+         *
+         * @throws std::runtime_error If the backing model is batched or cannot serialize its state.
+         */
+        void check_state_support() override;
+
     protected:
 
         std::shared_ptr<models::bmi::Bmi_Adapter> construct_model(const geojson::PropertyMap &properties) override;
@@ -55,6 +83,9 @@ namespace realization {
          */
         bool is_model_initialized() const override;
 
+        /** This catchment's adapter of a batched model, when the ``python_batched`` option is set. */
+        std::shared_ptr<models::bmi::Bmi_Py_Batch_Adapter> batch_model;
+
         // Unit test access
         friend class ::Bmi_Formulation_Test;
         friend class ::Bmi_Py_Formulation_Test;
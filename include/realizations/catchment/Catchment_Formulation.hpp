@@ -1,7 +1,12 @@
 #ifndef CATCHMENT_FORMULATION_H
 #define CATCHMENT_FORMULATION_H
 
+#include <cstdlib>
+#include <istream>
+#include <limits>
 #include <memory>
+#include <ostream>
+#include <stdexcept>
 #include <vector>
 #include "Formulation.hpp"
 #include <HY_CatchmentArea.hpp>
@@ -96,6 +101,35 @@ namespace realization {
             virtual std::string get_output_line_for_timestep(int timestep,
                                                              std::string delimiter = DEFAULT_FORMULATION_OUTPUT_DELIMITER) = 0;
 
+            /**
+             * Get the output values for the given time step, one per field of ``get_output_header_line``.
+             *
+             * This is the numeric counterpart of ``get_output_line_for_timestep``, for output that is not written as
+             * text.  The default implementation parses that line; fields that are not numbers are NaN.
+             *
+             * @param timestep The time step for which data is desired.
+             * @return The output variable values for the given time step.
+             */
+            virtual std::vector<double> get_output_values_for_timestep(int timestep) {
+                const std::string line = get_output_line_for_timestep(timestep, DEFAULT_FORMULATION_OUTPUT_DELIMITER);
+                std::vector<double> values;
+                if (line.empty()) {
+                    return values;
+                }
+                std::size_t start = 0;
+                while (true) {
+                    std::size_t end = line.find(DEFAULT_FORMULATION_OUTPUT_DELIMITER, start);
+                    const std::string field = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+                    char* parsed_end = nullptr;
+                    double value = std::strtod(field.c_str(), &parsed_end);
+                    values.push_back(parsed_end == field.c_str() ? std::numeric_limits<double>::quiet_NaN() : value);
+                    if (end == std::string::npos) {
+                        return values;
+                    }
+                    start = end + 1;
+                }
+            }
+
             /**
              * Execute the backing model formulation for the given time step, where it is of the specified size, and
              * return the response output.
@@ -110,6 +144,74 @@ namespace realization {
              */
             virtual double get_response(time_step_t t_index, time_step_t t_delta) override = 0;
 
+            /**
+             * Prepare to compute the response for the given time step, before ``get_response`` is called for any
+             * catchment of the same layer.
+             *
+             * Formulations whose model serves many catchments at once use this to supply their catchment's inputs, so
+             * the model can advance all of its catchments in a single update.  The default does nothing.
+             *
+             * @param t_index The index of the time step for which the response will be computed.
+             * @param t_delta The duration, in seconds, of the time step.
+             */
+            virtual void prepare_response(time_step_t t_index, time_step_t t_delta) {}
+
+            /**
+             * Get whether ``get_response`` for this formulation may run on a worker thread, concurrently with
+             * ``get_response`` calls of other formulation instances.
+             *
+             * Formulations whose backing models depend on interpreter or otherwise process-global state that is not
+             * safe to access from multiple threads should override this to return ``false``.
+             *
+             * @return Whether this formulation may be executed concurrently with other formulations.
+             */
+            virtual bool is_thread_safe() const {
+                return true;
+            }
+
+            /**
+             * Get whether ``get_response`` for this formulation calls into Python, through its model or its forcing
+             * provider, so it needs the interpreter's lock on whichever thread runs it.
+             *
+             * @return Whether this formulation calls into Python.
+             */
+            virtual bool uses_python() const {
+                return forcing != nullptr && forcing->calls_python();
+            }
+
+            /**
+             * Check this formulation can save and restore its state, before any checkpoint is written.
+             *
+             * @throws std::runtime_error If this formulation cannot save its state.
+             * @see write_state
+             */
+            virtual void check_state_support() {
+                throw std::runtime_error("Formulation " + get_id() + " does not support saving its state to a checkpoint");
+            }
+
+            /**
+             * Write the state needed to resume this formulation from its current time step to a checkpoint.
+             *
+             * Formulations that cannot save the state of their models do not override this, so checkpointing a
+             * simulation that uses them fails rather than restarting from an incomplete state.
+             *
+             * @param out The checkpoint stream to write to.
+             * @throws std::runtime_error If this formulation cannot save its state.
+             */
+            virtual void write_state(std::ostream &out) {
+                throw std::runtime_error("Formulation " + get_id() + " does not support saving its state to a checkpoint");
+            }
+
+            /**
+             * Restore the state written by @ref write_state, in place of the initial state of this formulation.
+             *
+             * @param in The checkpoint stream to read from.
+             * @throws std::runtime_error If this formulation cannot restore its state or the checkpoint is invalid.
+             */
+            virtual void read_state(std::istream &in) {
+                throw std::runtime_error("Formulation " + get_id() + " does not support restoring its state from a checkpoint");
+            }
+
             const std::vector<std::string>& get_required_parameters() const override = 0;
 
             void create_formulation(boost::property_tree::ptree &config, geojson::PropertyMap *global = nullptr) override = 0;
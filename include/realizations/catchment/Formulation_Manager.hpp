@@ -14,12 +14,18 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <string>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <FeatureBuilder.hpp>
 #include "features/Features.hpp"
 #include "Formulation_Constructors.hpp"
+#include "ForcingFileIndex.hpp"
 #include "LayerData.hpp"
 #include "realizations/config/time.hpp"
 #include "realizations/config/routing.hpp"
@@ -182,6 +188,25 @@ namespace realization {
                         this->add_formulation(missing_formulation);
                     }
                 }
+
+                // All CSV forcing has been read, so the shared stores no longer need room for more catchments
+                data_access::CsvForcingStore::shrink_shared_stores();
+
+                #if !NGEN_QUIET
+                if (forcing_file_lookups > 0) {
+                    size_t indexed_entries = 0;
+                    for (const auto& index : forcing_file_indices) {
+                        indexed_entries += index.second->size();
+                    }
+                    // Matching each catchment's pattern against the whole directory would take this many matches
+                    std::cout << "Found forcing files for " << forcing_file_lookups << " catchments from "
+                              << forcing_file_indices.size() << " directory listing(s) of " << indexed_entries
+                              << " entries in " << forcing_file_lookup_seconds << " s, instead of about "
+                              << forcing_file_lookups * indexed_entries << " directory entry reads and pattern matches"
+                              << std::endl;
+                }
+                #endif
+                forcing_file_indices.clear();
             }
 
             void add_formulation(std::shared_ptr<Catchment_Formulation> formulation) {
@@ -244,6 +269,50 @@ namespace realization {
                     return "";
             }
 
+            /**
+             * @brief Get whether nexus flows are passed to routing in memory (``in_memory`` key of the ``routing``
+             * object, default false), instead of routing reading the nexus output files once the simulation is done.
+             *
+             * @code{.cpp}
+             * // Example config:
+             * // ...
+             * // "routing": {
+             * //     "t_route_config_file_with_path": "./config/troute.yaml",
+             * //     "in_memory": true
+             * // }
+             * // ...
+             * @endcode
+             *
+             * @return Whether nexus flows should be held in memory for routing
+             */
+            bool get_routing_in_memory() const {
+                return this->routing_config != nullptr && this->routing_config->in_memory;
+            }
+
+            /**
+             * @brief Get the number of output time steps of nexus flows passed to routing at a time
+             * (``chunk_time_steps`` key of the ``routing`` object, default 0).
+             *
+             * When positive, and flows are passed in memory, each chunk is routed while the simulation continues with
+             * the next one; otherwise all time steps are routed once the simulation is done.
+             *
+             * @code{.cpp}
+             * // Example config:
+             * // ...
+             * // "routing": {
+             * //     "t_route_config_file_with_path": "./config/troute.yaml",
+             * //     "in_memory": true,
+             * //     "chunk_time_steps": 24
+             * // }
+             * // ...
+             * @endcode
+             *
+             * @return The number of time steps per routing chunk, or 0 to route once the simulation is done
+             */
+            int get_routing_chunk_time_steps() const {
+                return this->routing_config != nullptr ? std::max(this->routing_config->chunk_time_steps, 0) : 0;
+            }
+
             /**
              * Release any resources that should not be held as the run is shutting down
              *
@@ -320,6 +389,192 @@ namespace realization {
                 return "./";
             }
 
+            /**
+             * @brief Get the number of threads to use when executing the catchment formulations of a layer.
+             *
+             * @code{.cpp}
+             * // Example config:
+             * // ...
+             * // "threads": 4
+             * // ...
+             * @endcode
+             *
+             * A missing key yields ``1`` (serial execution) and a value of ``0`` yields the number of hardware threads
+             * reported by the system.
+             *
+             * @return The number of threads, including the main thread, to use for catchment execution.
+             */
+            unsigned int get_thread_count() const {
+                const auto threads = this->tree.get_optional<int>("threads");
+                if (threads == boost::none) {
+                    return 1;
+                }
+                if (*threads < 0) {
+                    throw std::runtime_error("Realization config 'threads' must not be negative (got "
+                                             + std::to_string(*threads) + ")");
+                }
+                if (*threads == 0) {
+                    return std::max(std::thread::hardware_concurrency(), 1u);
+                }
+                return static_cast<unsigned int>(*threads);
+            }
+
+            /**
+             * @brief Get whether to profile the run, writing per-rank timing summaries to the output root at the end.
+             *
+             * @code{.cpp}
+             * // Example config:
+             * // ...
+             * // "profiling": {
+             * //     "enabled": true,
+             * //     "trace": false
+             * // }
+             * // ...
+             * @endcode
+             *
+             * Profiling is enabled by the presence of the ``profiling`` object, unless its ``enabled`` key is false.
+             *
+             * @return Whether profiling is enabled.
+             */
+            bool get_profiling_enabled() const {
+                return this->tree.get_child_optional("profiling") != boost::none
+                       && this->tree.get<bool>("profiling.enabled", true);
+            }
+
+            /**
+             * @brief Get whether profiling should also write a timeline of every timed call (``trace`` key, default
+             * false).
+             *
+             * @return Whether to write a Chrome trace of the run when profiling.
+             */
+            bool get_profiling_trace() const {
+                return this->tree.get<bool>("profiling.trace", false);
+            }
+
+            /**
+             * @brief Get the number of master time steps between checkpoints of the simulation state
+             * (``interval_time_steps`` key of the ``checkpoint`` object, default 0).
+             *
+             * @code{.cpp}
+             * // Example config:
+             * // ...
+             * // "checkpoint": {
+             * //     "path": "/path/to/dir/run",
+             * //     "interval_time_steps": 720,
+             * //     "at_end": true,
+             * //     "restart_from": "/path/to/dir/run"
+             * // }
+             * // ...
+             * @endcode
+             *
+             * When nexus flows are routed in memory, checkpoints must fall on the boundaries of routing chunks, so the
+             * flows of every time step before a checkpoint have been handed to routing when it is written.
+             *
+             * @return The number of time steps between checkpoints, or 0 to not checkpoint during the run.
+             * @throws std::runtime_error If the interval is negative, or routing is in memory and the interval is not a
+             *                            multiple of its ``chunk_time_steps``.
+             */
+            int get_checkpoint_interval() const {
+                int interval = this->tree.get<int>("checkpoint.interval_time_steps", 0);
+                if (interval < 0) {
+                    throw std::runtime_error("Realization config 'checkpoint.interval_time_steps' must not be negative (got "
+                                             + std::to_string(interval) + ")");
+                }
+                int chunk = get_routing_chunk_time_steps();
+                if (interval > 0 && get_routing_in_memory() && (chunk == 0 || interval % chunk != 0)) {
+                    throw std::runtime_error("Realization config 'checkpoint.interval_time_steps' (" + std::to_string(interval)
+                                             + ") must be a multiple of 'routing.chunk_time_steps' when routing is in memory,"
+                                             " so no flows before a checkpoint are left unrouted");
+                }
+                return interval;
+            }
+
+            /**
+             * @brief Get whether to checkpoint the simulation state once the last time step completes (``at_end`` key
+             * of the ``checkpoint`` object, default false), so a later run can extend it.
+             */
+            bool get_checkpoint_at_end() const {
+                return this->tree.get<bool>("checkpoint.at_end", false);
+            }
+
+            /**
+             * @brief Get the path prefix of checkpoints written by this run (``path`` key of the ``checkpoint``
+             * object), to which each rank adds its own suffix.
+             *
+             * @return The checkpoint path prefix, by default ``checkpoint`` in the output root.
+             */
+            std::string get_checkpoint_path() const {
+                const auto path = this->tree.get_optional<std::string>("checkpoint.path");
+                if (path == boost::none || *path == "") {
+                    return get_output_root() + "checkpoint";
+                }
+                return *path;
+            }
+
+            /**
+             * @brief Get the path prefix of the checkpoint to restart the simulation from (``restart_from`` key of the
+             * ``checkpoint`` object).
+             *
+             * @return The checkpoint path prefix, or an empty string to start the simulation from its start time.
+             */
+            std::string get_restart_path() const {
+                return this->tree.get<std::string>("checkpoint.restart_from", "");
+            }
+
+            /**
+             * @brief Get the format of catchment and nexus output (``format`` key of the ``output`` object).
+             *
+             * @code{.cpp}
+             * // Example config:
+             * // ...
+             * // "output": {
+             * //     "format": "netcdf",
+             * //     "timesteps_per_write": 24,
+             * //     "compression_level": 1
+             * // }
+             * // ...
+             * @endcode
+             *
+             * With ``csv`` (the default), each catchment and nexus is written to its own CSV file in the output root.
+             * With ``netcdf``, the output of each rank is written to one columnar NetCDF file in the output root.
+             *
+             * @return The output format, ``csv`` or ``netcdf``.
+             */
+            std::string get_output_format() const {
+                std::string format = boost::algorithm::to_lower_copy(this->tree.get<std::string>("output.format", "csv"));
+                if (format != "csv" && format != "netcdf") {
+                    throw std::runtime_error("Realization config 'output.format' must be 'csv' or 'netcdf' (got '"
+                                             + format + "')");
+                }
+                return format;
+            }
+
+            /**
+             * @brief Get the number of time steps of columnar output buffered between writes (``timesteps_per_write``
+             * key of the ``output`` object), or 0 (the default) to let the writer choose.
+             */
+            std::size_t get_output_timesteps_per_write() const {
+                const int timesteps = this->tree.get<int>("output.timesteps_per_write", 0);
+                if (timesteps < 0) {
+                    throw std::runtime_error("Realization config 'output.timesteps_per_write' must not be negative (got "
+                                             + std::to_string(timesteps) + ")");
+                }
+                return static_cast<std::size_t>(timesteps);
+            }
+
+            /**
+             * @brief Get the deflate level of columnar output, from 0 (uncompressed) to 9 (``compression_level`` key
+             * of the ``output`` object, default 1).
+             */
+            int get_output_compression_level() const {
+                const int level = this->tree.get<int>("output.compression_level", 1);
+                if (level < 0 || level > 9) {
+                    throw std::runtime_error("Realization config 'output.compression_level' must be from 0 to 9 (got "
+                                             + std::to_string(level) + ")");
+                }
+                return level;
+            }
+
             /**
              * @brief return the layer storage used for formulations
              * @return a reference to the LayerStorageObject
@@ -403,12 +658,35 @@ namespace realization {
                 if(forcing_prop_map.count("provider") != 0){
                     provider = forcing_prop_map.at("provider").as_string();
                 }
+                std::size_t timesteps_per_read = 0;
+                if(forcing_prop_map.count("timesteps_per_read") != 0){
+                    long n = forcing_prop_map.at("timesteps_per_read").as_natural_number();
+                    if (n < 0) {
+                        throw std::runtime_error("Error with NGEN config - 'timesteps_per_read' in forcing params must not be negative.");
+                    }
+                    timesteps_per_read = static_cast<std::size_t>(n);
+                }
+                std::size_t prefetch_blocks = 0;
+                if(forcing_prop_map.count("prefetch_blocks") != 0){
+                    long n = forcing_prop_map.at("prefetch_blocks").as_natural_number();
+                    if (n < 0) {
+                        throw std::runtime_error("Error with NGEN config - 'prefetch_blocks' in forcing params must not be negative.");
+                    }
+                    prefetch_blocks = static_cast<std::size_t>(n);
+                }
+                bool binary_cache = false;
+                if(forcing_prop_map.count("binary_cache") != 0){
+                    binary_cache = forcing_prop_map.at("binary_cache").as_boolean();
+                }
                 if (forcing_prop_map.count("file_pattern") == 0) {
                     return forcing_params(
                         path,
                         provider,
                         simulation_time_config.start_time,
-                        simulation_time_config.end_time
+                        simulation_time_config.end_time,
+                        timesteps_per_read,
+                        prefetch_blocks,
+                        binary_cache
                     );
                 }
 
@@ -424,112 +702,30 @@ namespace realization {
 
                 std::string filepattern = forcing_prop_map.at("file_pattern").as_string();
 
-                int id_index = filepattern.find("{{id}}");
-
-                // If an index for '{{id}}' was found, we can count on that being where the id for this realization can be found.
+                // The directory is listed once, and the listing used for every catchment.  If an index for '{{id}}'
+                //     is in the pattern, we can count on that being where the id for this realization can be found.
                 //     For instance, if we have a pattern of '.*{{id}}_14_15.csv' and this is named 'cat-87',
                 //     this will match on 'stuff_example_cat-87_14_15.csv'
-                if (id_index != std::string::npos) {
-                    filepattern = filepattern.replace(id_index, sizeof("{{id}}") - 1, identifier);
-                }
-
-                // Create a regular expression used to identify proper file names
-                std::regex pattern(filepattern);
-
-                // A stream providing the functions necessary for evaluating a directory:
-                //    https://www.gnu.org/software/libc/manual/html_node/Opening-a-Directory.html#Opening-a-Directory
-                DIR *directory = nullptr;
-
-                // structure representing the member of a directory: https://www.gnu.org/software/libc/manual/html_node/Directory-Entries.html
-                struct dirent *entry = nullptr;
-
-                // Attempt to open the directory for evaluation
-                directory = opendir(path.c_str());
-                // Allow for a few retries in certain failure situations
-                size_t attemptCount = 0;
-                std::string errMsg;
-                while (directory == nullptr && attemptCount++ < 5) {
-                    // For several error codes, we should break immediately and not retry
-                    if (errno == ENOENT) {
-                        errMsg = "No such file or directory.";
-                        break;
-                    }
-                    if (errno == ENXIO) {
-                        errMsg = "No such device or address.";
-                        break;
-                    }
-                    if (errno == EACCES) {
-                        errMsg = "Permission denied.";
-                        break;
-                    }
-                    if (errno == EPERM) {
-                        errMsg = "Operation not permitted.";
-                        break;
-                    }
-                    if (errno == ENOTDIR) {
-                        errMsg = "File at provided path is not a directory.";
-                        break;
-                    }
-                    if (errno == EMFILE) {
-                        errMsg = "The current process has too many open files.";
-                        break;
-                    }
-                    if (errno == ENFILE) {
-                        errMsg = "The system has too many open files.";
-                        break;
-                    }
-                    sleep(2);
-                    directory = opendir(path.c_str());
-                    errMsg = "Received system error number " + std::to_string(errno);
-                }
-
-                // If the directory could be found and opened, we can go ahead and iterate
-                if (directory != nullptr) {
-                    bool match;
-                    while ((entry = readdir(directory))) {
-                        match = std::regex_match(entry->d_name, pattern);
-                        if( match ) {
-                            // If the entry is a regular file or symlink AND the name matches the pattern, 
-                            //    we can consider this ready to be interpretted as valid forcing data (even if it isn't)
-                            #ifdef _DIRENT_HAVE_D_TYPE
-                            if ( entry->d_type == DT_REG or entry->d_type == DT_LNK ) {
-                                return forcing_params(
-                                    path + entry->d_name,
-                                    provider,
-                                    simulation_time_config.start_time,
-                                    simulation_time_config.end_time
-                                );
-                            }
-                            else if ( entry->d_type == DT_UNKNOWN )
-                            #endif
-                            {
-                                //dirent is not guaranteed to provide propoer file type identification in d_type
-                                //so if a system returns unknown or it isn't supported, need to use stat to determine if it is a file
-                                struct stat st;
-                                if( stat((path+entry->d_name).c_str(), &st) != 0) {
-                                    throw std::runtime_error("Could not stat file "+path+entry->d_name);
-                                }
-                                if( S_ISREG(st.st_mode) ) {
-                                    //Sinde we used stat and not lstat, we get the result of the target of links as well
-                                    //so this covers both cases we are interested in.
-                                    return forcing_params(
-                                        path + entry->d_name,
-                                        provider,
-                                        simulation_time_config.start_time,
-                                        simulation_time_config.end_time
-                                    );
-                                }
-                                throw std::runtime_error("Forcing data is path "+path+entry->d_name+" is not a file");
-                            }
-                        } //no match found, try next entry
-                    } // end while iter dir
-                } //end if directory
-                else {
-                    // The directory wasn't found or otherwise couldn't be opened; forcing data cannot be retrieved
-                    throw std::runtime_error("Error opening forcing data dir '" + path + "' after " + std::to_string(attemptCount) + " attempts: " + errMsg);
-                }
-
-                closedir(directory);
+                auto lookup_start = std::chrono::steady_clock::now();
+                std::shared_ptr<data_access::ForcingFileIndex>& index = forcing_file_indices[path];
+                if (index == nullptr) {
+                    index = std::make_shared<data_access::ForcingFileIndex>(path);
+                }
+                std::string file_path = index->find(filepattern, identifier);
+                forcing_file_lookup_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - lookup_start).count();
+                forcing_file_lookups++;
+
+                if (!file_path.empty()) {
+                    return forcing_params(
+                        file_path,
+                        provider,
+                        simulation_time_config.start_time,
+                        simulation_time_config.end_time,
+                        timesteps_per_read,
+                        prefetch_blocks,
+                        binary_cache
+                    );
+                }
 
                 throw std::runtime_error("Forcing data could not be found for '" + identifier + "'");
             }
@@ -667,6 +863,11 @@ namespace realization {
             //Store global layer formulation pointers
             std::map<int, std::shared_ptr<Catchment_Formulation> > domain_formulations;
 
+            /** Listings of forcing directories searched with a file pattern, by path, while reading the config. */
+            std::unordered_map<std::string, std::shared_ptr<data_access::ForcingFileIndex>> forcing_file_indices;
+            size_t forcing_file_lookups = 0;
+            double forcing_file_lookup_seconds = 0.0;
+
             std::shared_ptr<routing_params> routing_config;
 
             bool using_routing = false;
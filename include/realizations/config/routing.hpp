@@ -9,10 +9,13 @@ namespace realization{
   namespace config{
 
     static const std::string ROUTING_CONFIG_KEY = "t_route_config_file_with_path";
+    static const std::string ROUTING_IN_MEMORY_KEY = "in_memory";
+    static const std::string ROUTING_CHUNK_TIME_STEPS_KEY = "chunk_time_steps";
     struct Routing{
         std::shared_ptr<routing_params> params;
         Routing(const boost::property_tree::ptree& tree){
-            params = std::make_shared<routing_params>(tree.get(ROUTING_CONFIG_KEY, ""));
+            params = std::make_shared<routing_params>(tree.get(ROUTING_CONFIG_KEY, ""), tree.get(ROUTING_IN_MEMORY_KEY, false),
+                                                              tree.get(ROUTING_CHUNK_TIME_STEPS_KEY, 0));
         }
     };
 
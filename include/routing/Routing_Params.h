@@ -10,18 +10,33 @@ struct routing_params
 {
     std::string t_route_config_file_with_path;
 
+    /**
+     * Whether nexus flows are passed to routing in memory, rather than through nexus output files
+     */
+    bool in_memory;
+
+    /**
+     * The number of output time steps of nexus flows passed to routing at a time, while the simulation continues,
+     * or 0 to route all time steps once the simulation is done
+     */
+    int chunk_time_steps;
+
     /**
      * Default constructor, using empty strings for both member values
      */
-    routing_params() : t_route_config_file_with_path("") {}
+    routing_params() : t_route_config_file_with_path(""), in_memory(false), chunk_time_steps(0) {}
 
     /*
      * @brief Constructor for routing_params
      *
      * @param t_route_config_file_with_path
+     * @param in_memory
+     * @param chunk_time_steps
      */
-    routing_params(std::string t_route_config_file_with_path):
-        t_route_config_file_with_path(t_route_config_file_with_path)
+    routing_params(std::string t_route_config_file_with_path, bool in_memory = false, int chunk_time_steps = 0):
+        t_route_config_file_with_path(t_route_config_file_with_path),
+        in_memory(in_memory),
+        chunk_time_steps(chunk_time_steps)
         {
         }
 
@@ -0,0 +1,101 @@
+#ifndef NGEN_ROUTING_PIPELINE_H
+#define NGEN_ROUTING_PIPELINE_H
+
+#include <NGenConfig.h>
+
+#if NGEN_WITH_PYTHON
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Routing_Py_Adapter.hpp"
+
+namespace routing_py_adapter {
+
+    /**
+     * Routes the nexus flows of a simulation in chunks of time steps, in time order, as the simulation produces them.
+     *
+     * When concurrent, chunks are routed on a dedicated thread, so routing of one chunk overlaps the simulation of
+     * the next.  At most one chunk waits to be routed while another is routing; @ref submit blocks beyond that, which
+     * bounds the memory held for routing.  The thread creating a concurrent pipeline gives up the Python GIL until
+     * @ref finish, so it must not call into Python in between.  Otherwise, each chunk is routed as it is submitted.
+     */
+    class Routing_Pipeline {
+
+    public:
+        /**
+         * @param router The router to route chunks with, which must outlive this pipeline
+         * @param delta_time The time between time steps of the flows, in seconds
+         * @param concurrent Whether to route on a dedicated thread
+         */
+        Routing_Pipeline(Routing_Py_Adapter &router, int delta_time, bool concurrent);
+
+        Routing_Pipeline(const Routing_Pipeline&) = delete;
+        Routing_Pipeline& operator=(const Routing_Pipeline&) = delete;
+
+        /** Stops and joins the routing thread, waiting for a chunk being routed, but discarding any not yet begun */
+        ~Routing_Pipeline();
+
+        /**
+         * Route the next chunk of flows.
+         *
+         * If routing of an earlier chunk failed, its exception is rethrown here.
+         *
+         * @param nexus_ids The nexus of each row of @p flows
+         * @param flows Row-major [nexus x time] flows
+         * @param number_of_timesteps The number of time steps (columns) of @p flows
+         * @param start_time The epoch time of the first time step of the chunk
+         * @param final_chunk Whether this is the last chunk of the simulation
+         */
+        void submit(std::vector<std::string> nexus_ids, std::vector<double> flows, int number_of_timesteps,
+                    long start_time, bool final_chunk);
+
+        /**
+         * Wait for every submitted chunk to be routed, then reacquire the Python GIL if it was given up.
+         *
+         * If routing of any chunk failed, its exception is rethrown here.
+         */
+        void finish();
+
+    private:
+
+        struct chunk {
+            std::vector<std::string> nexus_ids;
+            std::vector<double> flows;
+            int number_of_timesteps;
+            long start_time;
+            bool final_chunk;
+        };
+
+        void route(const chunk &c);
+
+        void worker_loop();
+
+        /** Stop and join the routing thread, if it is running */
+        void stop();
+
+        Routing_Py_Adapter &router;
+        int delta_time;
+
+        std::mutex mutex;
+        std::condition_variable chunk_ready;
+        std::condition_variable slot_free;
+        std::unique_ptr<chunk> pending;
+        bool stopping = false;
+        bool discard = false;
+        std::exception_ptr failure;
+        std::thread worker;
+
+        //Held while the routing thread runs, so that it can take the GIL
+        std::unique_ptr<py::gil_scoped_release> released_gil;
+    };
+
+}
+
+#endif //NGEN_WITH_PYTHON
+
+#endif //NGEN_ROUTING_PIPELINE_H
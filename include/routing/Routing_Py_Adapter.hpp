@@ -8,6 +8,7 @@
 #include <exception>
 #include <memory>
 #include <string>
+#include <vector>
 #include "pybind11/pybind11.h"
 #include "pybind11/pytypes.h"
 #include "pybind11/numpy.h"
@@ -29,30 +30,62 @@ namespace routing_py_adapter {
         Routing_Py_Adapter(std::string t_route_config_file_with_path);
 
         /**
-         * Function to run @p number_of_timesteps of routing, extracting 
-         * lateral inflows from @p flow_vector
-         * 
-         * FIXME This is current unimplemented and will require some addtional
-         * work to properly map flows to the correct t-route network segments.
-         * This may not even be the correct concept to implement this type of
-         * "integrated" routing.  But the basic idea is that after a catchment 
-         * update occurs, it contributes some amount of lateral flow to the channel
-         * as represented by @p flow_vector and this flow should be routed down stream
-         * for @p number_of_timesteps .  Note though, that all lateral inflows are required
-         * for a single routing pass of the network, so this would probably end up being a
-         * flow map that we pass to a custom t-route function that extracts the lateral inflow
-         * vector for each identity and constructs the correct lateral inflow setup to make
-         * a full routing pass.
-         * 
+         * Function to run a full set of routing computations using nexus flows held in memory,
+         * instead of the nexus output files of an ngen simulation.
+         *
+         * The flows are passed to the routing entry point as a read-only NumPy view of @p flows,
+         * without copying, along with the routing configuration arguments and these keyword arguments:
+         *
+         * - ``nexus_ids``: the list of nexus ids, one per row of ``nexus_flows``
+         * - ``nexus_flows``: the [nexus x time] float64 array of flows, in m^3/s
+         * - ``start_time``: the epoch time, in seconds, of the first time step
+         * - ``delta_time``: the time between time steps, in seconds
+         *
+         * Check @ref accepts_flows() first; t-route versions whose entry point does not take these
+         * arguments can only route from the nexus output files.
+         *
          * See NOTE in @ref route(int, int) route() about python module availablity.
          *
-         * @param number_of_timesteps
-         * @param delta_time
-         * @param flow_vector
+         * @param nexus_ids The nexus of each row of @p flows
+         * @param flows Row-major [nexus x time] flows, which must stay valid until routing returns
+         * @param number_of_timesteps The number of time steps (columns) of @p flows
+         * @param start_time The epoch time of the first time step
+         * @param delta_time The time between time steps, in seconds
          */
-        void route(int number_of_timesteps, int delta_time,
-              const std::vector<double> &flow_vector);
+        void route(const std::vector<std::string> &nexus_ids, const double *flows,
+              int number_of_timesteps, long start_time, int delta_time);
 
+        /**
+         * @return Whether the routing entry point accepts nexus flows in memory, through the
+         * keyword arguments described for @ref route(const std::vector<std::string>&, const double*, int, long, int)
+         */
+        bool accepts_flows();
+
+        /**
+         * Function to route one chunk of the time steps of a simulation, while the simulation may continue.
+         *
+         * Chunks must be routed in time order.  The routing entry point is called as for
+         * @ref route(const std::vector<std::string>&, const double*, int, long, int), with the flows of just this
+         * chunk and the additional keyword argument ``final_chunk``, which is true for the last chunk of the
+         * simulation.  The routing module is expected to keep its channel states from one chunk to the next.
+         *
+         * This acquires the Python GIL, so it may be called from a thread other than the one running the interpreter.
+         * Check @ref accepts_flow_chunks() first.
+         *
+         * @param nexus_ids The nexus of each row of @p flows
+         * @param flows Row-major [nexus x time] flows, which must stay valid until routing returns
+         * @param number_of_timesteps The number of time steps (columns) of @p flows
+         * @param start_time The epoch time of the first time step of the chunk
+         * @param delta_time The time between time steps, in seconds
+         * @param final_chunk Whether this is the last chunk of the simulation
+         */
+        void route_chunk(const std::vector<std::string> &nexus_ids, const double *flows,
+              int number_of_timesteps, long start_time, int delta_time, bool final_chunk);
+
+        /**
+         * @return Whether the routing entry point accepts nexus flows in chunks, i.e. has a ``final_chunk`` parameter
+         */
+        bool accepts_flow_chunks();
 
         /**
          * Function to run a full set of routing computations using the nexus output files
@@ -109,6 +142,14 @@ namespace routing_py_adapter {
 
     private:
 
+        /** Get the routing entry point, ``ngen_main`` of a legacy t-route module or ``main_v04`` */
+        py::object get_main();
+
+        /** Get a read-only NumPy view of row-major [nexus x time] @p flows, without copying them */
+        static py::array_t<double> flow_view(const double *flows, std::size_t number_of_nexuses, int number_of_timesteps);
+
+        /** Get the names of the parameters of the routing entry point, and whether it takes ``**kwargs`` */
+        std::vector<std::string> main_parameters(bool &var_keyword);
 
         /** Handle to the interpreter util.
          * 
@@ -1,6 +1,7 @@
 #ifndef SIMULATION_TIME_H
 #define SIMULATION_TIME_H
 
+#include <algorithm>
 #include <ctime>
 #include <time.h>
 #include <string>
@@ -92,6 +93,15 @@ class Simulation_Time
         return output_interval_seconds;
     }
 
+    /**
+     * @brief Accessor to the simulation start time
+     * @return start_date_time_epoch
+    */
+    time_t get_start_epoch_time() const
+    {
+        return start_date_time_epoch;
+    }
+
     /**
      * @brief Accessor to the the current simulation time
      * @return current_date_time_epoch
@@ -102,6 +112,22 @@ class Simulation_Time
         return current_date_time_epoch;
     }   
 
+    /**
+     * @brief Move this simulation time object to the time it has after the output times before @p time_index have
+     * been simulated, e.g. when restarting from a checkpoint
+     *
+     * As with advance_timestep, the current time does not move past the last output time.
+     */
+    void set_current_time_index(long time_index)
+    {
+        if (time_index < 0)
+        {
+            throw std::runtime_error("Simulation time objects current time index set before its start");
+        }
+        long last_index = total_output_times - 1;
+        current_date_time_epoch = start_date_time_epoch + std::min(time_index, last_index) * output_interval_seconds;
+    }
+
     /**
      * @brief Accessor to the current timestamp string
      * @return current_timestamp
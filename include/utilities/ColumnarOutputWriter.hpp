@@ -0,0 +1,123 @@
+#ifndef NGEN_COLUMNAR_OUTPUT_WRITER_HPP
+#define NGEN_COLUMNAR_OUTPUT_WRITER_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+    /**
+     * Gathers the output values of many features per time step into contiguous buffers, written as columns.
+     *
+     * Output is organized in tables, e.g. the catchments of a layer or the nexuses of a rank.  A table has a fixed list
+     * of features and a fixed set of variables, the union of the output variables of its features; each variable is
+     * a [time][feature] array, with NaN where a feature has no value.  Values are buffered for a number of time steps,
+     * then handed to the implementation's @ref write_rows in one piece per table, so storage is written in large
+     * blocks rather than a line per feature and time step.
+     *
+     * Not thread safe: values are expected to be set by the thread driving the simulation.  Implementations must call
+     * @ref flush before they are destroyed; buffered values are otherwise lost.
+     */
+    class ColumnarOutputWriter {
+    public:
+
+        /**
+         * @param timesteps_per_write The number of time steps buffered for each table before writing, or 0 to
+         *                            buffer up to 24 while keeping each table's buffer to about 4M values.
+         */
+        explicit ColumnarOutputWriter(std::size_t timesteps_per_write = 0);
+
+        ColumnarOutputWriter(const ColumnarOutputWriter&) = delete;
+        ColumnarOutputWriter& operator=(const ColumnarOutputWriter&) = delete;
+
+        virtual ~ColumnarOutputWriter();
+
+        /**
+         * Add a table of features, each with its own output variables.
+         *
+         * @param name The name of the table.
+         * @param feature_ids The ids of the features (rows) of the table.
+         * @param feature_variables The names of the output variables of each feature, in the order values are set.
+         * @return The index of the table, for use with the other functions.
+         */
+        std::size_t add_table(const std::string& name, const std::vector<std::string>& feature_ids,
+                              const std::vector<std::vector<std::string>>& feature_variables);
+
+        /**
+         * Set the values of a feature for the current time step of a table.
+         *
+         * @param table The index of the table.
+         * @param feature The index of the feature in the table.
+         * @param values The values of the feature's output variables, in the order given when adding the table;
+         *               extra values are ignored.
+         * @param count The number of values.
+         */
+        void set_values(std::size_t table, std::size_t feature, const double* values, std::size_t count);
+
+        void set_values(std::size_t table, std::size_t feature, const std::vector<double>& values) {
+            set_values(table, feature, values.data(), values.size());
+        }
+
+        /**
+         * Complete the current time step of a table, writing the buffered time steps if the buffer is full.
+         *
+         * @param table The index of the table.
+         * @param epoch_time The time of the completed time step.
+         */
+        void end_time_step(std::size_t table, time_t epoch_time);
+
+        /**
+         * Write the buffered time steps of every table.
+         */
+        void flush();
+
+        /**
+         * @return The number of time steps of a table buffered before writing it.
+         */
+        std::size_t get_timesteps_per_write(std::size_t table) const;
+
+    protected:
+
+        struct table_data {
+            std::string name;
+            std::vector<std::string> feature_ids;
+            // The union of the features' variables, in order of first appearance
+            std::vector<std::string> variables;
+            // For each feature, the index in variables of each of its values
+            std::vector<std::vector<std::size_t>> feature_columns;
+            std::size_t timesteps_per_write = 1;
+            // The index of the first buffered time step among all of the table's time steps
+            std::size_t first_time_index = 0;
+            // The buffered time steps, as epoch times
+            std::vector<double> times;
+            // Per variable, buffered values as [time][feature]
+            std::vector<std::vector<double>> values;
+        };
+
+        /**
+         * Prepare storage for a table, which was just added.
+         */
+        virtual void define_table(std::size_t table) = 0;
+
+        /**
+         * Write the buffered time steps of a table; the first ``times.size()`` rows of each of its ``values``.
+         */
+        virtual void write_rows(std::size_t table) = 0;
+
+        const table_data& get_table(std::size_t table) const {
+            return tables.at(table);
+        }
+
+    private:
+
+        void flush_table(std::size_t table);
+
+        std::size_t timesteps_per_write;
+        std::vector<table_data> tables;
+    };
+
+} // namespace utils
+
+#endif // NGEN_COLUMNAR_OUTPUT_WRITER_HPP
@@ -0,0 +1,60 @@
+#ifndef NGEN_NETCDF_OUTPUT_WRITER_HPP
+#define NGEN_NETCDF_OUTPUT_WRITER_HPP
+
+#include <NGenConfig.h>
+
+#include "ColumnarOutputWriter.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+    /**
+     * Writes columnar output to a NetCDF-4 file, one group per table.
+     *
+     * Each group has an unlimited ``time`` dimension (with a ``time`` variable in seconds since the epoch), a
+     * ``feature`` dimension (with an ``ids`` string variable), and a chunked, compressed (time, feature) double
+     * variable per output variable of the table.  Characters NetCDF does not allow in names are replaced by ``_``; the
+     * original name is kept in the variable's ``long_name`` attribute.
+     *
+     * Requires a build with NetCDF support; otherwise construction throws.
+     */
+    class NetCDFOutputWriter : public ColumnarOutputWriter {
+    public:
+
+        /**
+         * @param path The path of the file to create, replacing any existing file.
+         * @param timesteps_per_write See @ref ColumnarOutputWriter.
+         * @param compression_level The deflate level of output variables, from 0 (uncompressed) to 9.
+         */
+        NetCDFOutputWriter(const std::string& path, std::size_t timesteps_per_write = 0, int compression_level = 1);
+
+        /**
+         * Writes any buffered values and closes the file.
+         */
+        ~NetCDFOutputWriter() override;
+
+        /**
+         * Write any buffered values and close the file.  Values set afterward are not written.
+         */
+        void close();
+
+    protected:
+
+        void define_table(std::size_t table) override;
+
+        void write_rows(std::size_t table) override;
+
+    private:
+
+        struct file_data;
+
+        int compression_level;
+        std::unique_ptr<file_data> file;
+    };
+
+} // namespace utils
+
+#endif // NGEN_NETCDF_OUTPUT_WRITER_HPP
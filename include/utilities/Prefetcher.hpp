@@ -0,0 +1,212 @@
+#ifndef NGEN_PREFETCHER_HPP
+#define NGEN_PREFETCHER_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace utils {
+
+    /**
+     * Loads values on a background thread ahead of their use.
+     *
+     * Keys are queued with @ref request and loaded in order by a single worker thread, so the loader does not need to
+     * be thread safe with respect to itself (e.g., for libraries such as NetCDF).  The consumer collects values with
+     * @ref take, which waits for a value still being loaded.
+     *
+     * At most ``capacity`` keys are queued, loading or loaded but not yet taken; further requests are refused until
+     * values are taken or discarded, which bounds the memory held and keeps the worker from running too far ahead.
+     *
+     * Requesting and discarding may be done from any thread, but @ref take must only be called by one thread at a time.
+     * A key being taken is never discarded, since @ref take holds on to its entry while waiting for it.
+     *
+     * @tparam Key The type identifying a value to load, which must be copyable and ordered by ``operator<``.
+     * @tparam Value The type of loaded values, which must be default constructible and movable.
+     */
+    template <typename Key, typename Value>
+    class Prefetcher {
+    public:
+
+        using loader_type = std::function<Value(const Key&)>;
+
+        /**
+         * @param loader The function loading the value of a key, on the worker thread.  Exceptions it throws are
+         *               rethrown by @ref take.
+         * @param capacity The maximum number of requested keys not yet taken.
+         */
+        Prefetcher(loader_type loader, std::size_t capacity)
+            : loader(std::move(loader)), capacity(std::max<std::size_t>(capacity, 1)), worker(&Prefetcher::worker_loop, this)
+        {}
+
+        Prefetcher(const Prefetcher&) = delete;
+        Prefetcher& operator=(const Prefetcher&) = delete;
+
+        /**
+         * Stops the worker once any value it is loading is loaded; queued keys are not loaded.
+         */
+        ~Prefetcher() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+            worker.join();
+        }
+
+        /**
+         * Queue a key to be loaded in the background.
+         *
+         * @return Whether the key is queued, loading or loaded; false if it was refused because the prefetcher is full.
+         */
+        bool request(const Key& key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                it->second.discarded = false;
+                return true;
+            }
+            if (entries.size() >= capacity) {
+                return false;
+            }
+            entries.emplace(key, entry());
+            queue.push_back(key);
+            changed.notify_all();
+            return true;
+        }
+
+        /**
+         * Get the value of a key, removing it from the prefetcher.
+         *
+         * A key that was not requested (or was refused or discarded) is loaded ahead of any queued keys, regardless
+         * of capacity.  Either way this waits until the value is loaded.
+         *
+         * @throws Whatever the loader threw for the key.
+         */
+        Value take(const Key& key) {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it == entries.end()) {
+                it = entries.emplace(key, entry()).first;
+                queue.push_front(key);
+                changed.notify_all();
+            }
+            else if (it->second.state == QUEUED) {
+                queue.erase(std::find(queue.begin(), queue.end(), key));
+                queue.push_front(key);
+            }
+            it->second.discarded = false;
+            it->second.taking = true;
+            changed.wait(lock, [&]() { return it->second.state == LOADED; });
+
+            entry taken = std::move(it->second);
+            entries.erase(it);
+            if (taken.error != nullptr) {
+                std::rethrow_exception(taken.error);
+            }
+            return std::move(taken.value);
+        }
+
+        /**
+         * Drop the requested keys matching a predicate, e.g. ones that will not be used after all.
+         *
+         * A value being loaded is dropped once it is loaded.  Keys being taken are kept, whatever the predicate.
+         */
+        template <typename Predicate>
+        void discard_if(Predicate predicate) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = entries.begin(); it != entries.end(); ) {
+                if (it->second.taking || !predicate(it->first)) {
+                    ++it;
+                }
+                else if (it->second.state == LOADING) {
+                    it->second.discarded = true;
+                    ++it;
+                }
+                else {
+                    if (it->second.state == QUEUED) {
+                        queue.erase(std::find(queue.begin(), queue.end(), it->first));
+                    }
+                    it = entries.erase(it);
+                }
+            }
+        }
+
+        /**
+         * @return The number of requested keys not yet taken or discarded.
+         */
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return entries.size();
+        }
+
+    private:
+
+        enum entry_state { QUEUED, LOADING, LOADED };
+
+        struct entry {
+            entry_state state = QUEUED;
+            bool discarded = false;
+            // Whether take is waiting on the entry, which must then stay until it is taken
+            bool taking = false;
+            Value value;
+            std::exception_ptr error;
+        };
+
+        void worker_loop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (stopping) {
+                    return;
+                }
+                Key key = queue.front();
+                queue.pop_front();
+                // Entries are only erased by other threads while queued or loaded, so this stays valid; take holds on
+                // to its entry the same way, since entries being taken are never discarded
+                auto it = entries.find(key);
+                it->second.state = LOADING;
+
+                lock.unlock();
+                Value value;
+                std::exception_ptr error;
+                try {
+                    value = loader(key);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                lock.lock();
+
+                if (it->second.discarded) {
+                    entries.erase(it);
+                }
+                else {
+                    it->second.value = std::move(value);
+                    it->second.error = error;
+                    it->second.state = LOADED;
+                }
+                changed.notify_all();
+            }
+        }
+
+        loader_type loader;
+        const std::size_t capacity;
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+        std::map<Key, entry> entries;
+        std::deque<Key> queue;
+        bool stopping = false;
+        // Last, so it starts after everything it uses is initialized
+        std::thread worker;
+    };
+
+} // namespace utils
+
+#endif // NGEN_PREFETCHER_HPP
@@ -0,0 +1,154 @@
+#ifndef NGEN_PROFILER_HPP
+#define NGEN_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace utils {
+
+    /**
+     * Opt-in, process wide wall time profiler.
+     *
+     * Instrumented code records timed intervals under a fixed @ref Category and a name (a catchment id, a BMI model
+     * type, a provider method, ...), typically through a @ref Profile_Scope.  While profiling is disabled (the default)
+     * a scope costs one relaxed atomic load.
+     *
+     * Each thread records into its own buffers, so recording never contends with other threads.  Totals per category
+     * and name are kept for the summary; when tracing is enabled every interval is also kept for a Chrome trace
+     * timeline (viewable in ``chrome://tracing`` or Perfetto), up to @ref MAX_TRACE_EVENTS per thread.
+     *
+     * Intervals nest: a catchment's time includes the BMI calls and forcing reads made while computing its response.
+     *
+     * The reporting functions and @ref reset must only be called while no instrumented code is running.
+     */
+    class Profiler {
+    public:
+
+        using clock = std::chrono::steady_clock;
+
+        enum Category {
+            CATCHMENT,      //!< A catchment formulation's ``get_response``, named by catchment id
+            BMI_UPDATE,     //!< A BMI module's ``Update``/``UpdateUntil``, named by model type
+            BMI_SET_VALUE,  //!< A BMI module's ``SetValue``, named by model type
+            BMI_GET_VALUE,  //!< A BMI module's ``GetValue``, named by model type
+            FORCING,        //!< A forcing provider read, named by provider method
+            MPI_WAIT,       //!< Time blocked on remote nexus communication, named by method
+            OUTPUT,         //!< Catchment and nexus output writes
+            NUM_CATEGORIES
+        };
+
+        //! Maximum number of trace events kept per thread; further intervals still count toward the summary
+        static constexpr std::size_t MAX_TRACE_EVENTS = std::size_t(1) << 22;
+
+        struct Stat {
+            std::size_t calls = 0;
+            double total_seconds = 0.0;
+            double max_seconds = 0.0;
+        };
+
+        /**
+         * @return Whether intervals are currently recorded.
+         */
+        static bool is_enabled() noexcept {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Start recording intervals.
+         *
+         * @param trace Whether to keep individual intervals for @ref write_trace, in addition to the summary totals.
+         */
+        static void enable(bool trace);
+
+        /**
+         * Stop recording intervals, keeping what was recorded so far.
+         */
+        static void disable();
+
+        /**
+         * Stop recording intervals and discard everything recorded so far.
+         */
+        static void reset();
+
+        /**
+         * Record an interval.  Normally called by @ref Profile_Scope.
+         */
+        static void record(Category category, const std::string& name, clock::time_point start, clock::time_point end);
+
+        /**
+         * @return The printable name of a category, e.g. ``bmi_update``.
+         */
+        static const char* category_name(Category category);
+
+        /**
+         * @return The totals recorded for each name in a category, merged across threads.
+         */
+        static std::map<std::string, Stat> summary(Category category);
+
+        /**
+         * Write the totals of every category and name as CSV, with a header line.
+         */
+        static void write_summary(std::ostream& stream);
+
+        /**
+         * Write the total time of each catchment as ``id,seconds`` CSV lines, the catchment weight format read by
+         * ``partitionGenerator``.
+         */
+        static void write_catchment_times(std::ostream& stream);
+
+        /**
+         * Write the recorded intervals in Chrome trace event (JSON) format.
+         *
+         * @param process_id The id to give this process in the timeline, e.g. its MPI rank.
+         */
+        static void write_trace(std::ostream& stream, int process_id);
+
+    private:
+
+        static std::atomic<bool> enabled;
+    };
+
+    /**
+     * Records the wall time from construction to destruction with the @ref Profiler, if profiling is enabled.
+     *
+     * The name is referenced rather than copied, so it must outlive the scope (e.g., a member or ``static`` string).
+     */
+    class Profile_Scope {
+    public:
+
+        Profile_Scope(Profiler::Category category, const std::string& name) noexcept
+            : category(category), name(Profiler::is_enabled() ? &name : nullptr)
+        {
+            if (this->name != nullptr) {
+                start = Profiler::clock::now();
+            }
+        }
+
+        Profile_Scope(const Profile_Scope&) = delete;
+        Profile_Scope& operator=(const Profile_Scope&) = delete;
+
+        ~Profile_Scope() {
+            if (name != nullptr) {
+                try {
+                    Profiler::record(category, *name, start, Profiler::clock::now());
+                }
+                catch (...) {
+                    // Losing a measurement is preferable to terminating, e.g. while unwinding
+                }
+            }
+        }
+
+    private:
+
+        Profiler::Category category;
+        const std::string* name;
+        Profiler::clock::time_point start;
+    };
+
+} // namespace utils
+
+#endif // NGEN_PROFILER_HPP
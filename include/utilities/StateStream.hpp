@@ -0,0 +1,85 @@
+#ifndef NGEN_STATE_STREAM_HPP
+#define NGEN_STATE_STREAM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+    /**
+     * Helpers for the binary checkpoint state of simulation objects.
+     *
+     * Values are written in native byte order and sizes, as checkpoints are only restarted by the same build on the
+     * same kind of machine.  Strings and byte blocks are prefixed with their 64-bit length.  Readers throw a
+     * ``std::runtime_error`` when the stream ends early, so a truncated checkpoint is never partially applied.
+     */
+    namespace state {
+
+        template <typename T>
+        void write(std::ostream &out, const T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        T read(std::istream &in) {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read");
+            T value;
+            if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+                throw std::runtime_error("Checkpoint state ended unexpectedly");
+            }
+            return value;
+        }
+
+        inline void write_bytes(std::ostream &out, const char *data, std::size_t size) {
+            write<std::uint64_t>(out, size);
+            out.write(data, size);
+        }
+
+        inline void write_bytes(std::ostream &out, const std::vector<char> &bytes) {
+            write_bytes(out, bytes.data(), bytes.size());
+        }
+
+        inline std::vector<char> read_bytes(std::istream &in) {
+            std::uint64_t size = read<std::uint64_t>(in);
+            std::vector<char> bytes;
+            // Grow as data arrives rather than trusting the length to allocate all at once
+            const std::uint64_t block = 1 << 20;
+            while (bytes.size() < size) {
+                std::size_t start = bytes.size();
+                bytes.resize(start + std::min(block, size - start));
+                if (!in.read(bytes.data() + start, bytes.size() - start)) {
+                    throw std::runtime_error("Checkpoint state ended unexpectedly");
+                }
+            }
+            return bytes;
+        }
+
+        inline void write_string(std::ostream &out, const std::string &value) {
+            write_bytes(out, value.data(), value.size());
+        }
+
+        inline std::string read_string(std::istream &in) {
+            std::vector<char> bytes = read_bytes(in);
+            return std::string(bytes.begin(), bytes.end());
+        }
+
+        /** Read a string and throw a ``std::runtime_error`` naming @p what unless it is @p expected */
+        inline void expect_string(std::istream &in, const std::string &expected, const std::string &what) {
+            std::string value = read_string(in);
+            if (value != expected) {
+                throw std::runtime_error("Checkpoint holds " + what + " '" + value + "' where '" + expected
+                                         + "' was expected; restart with the same configuration and partitioning");
+            }
+        }
+
+    } // namespace state
+} // namespace utils
+
+#endif //NGEN_STATE_STREAM_HPP
@@ -0,0 +1,221 @@
+#ifndef NGEN_THREADPOOL_HPP
+#define NGEN_THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+    /**
+     * Fixed-size pool of worker threads for data-parallel loops over independent items.
+     *
+     * Work is handed out dynamically: every participating thread (the workers plus the calling thread) repeatedly
+     * claims the next chunk of indices from a shared atomic counter until the range is exhausted.  This keeps the
+     * threads busy when per-item cost is uneven (e.g., catchments with very different model formulations) without the
+     * bookkeeping of per-thread queues.
+     *
+     * Workers are created once and reused for every loop, so the pool can be held for the lifetime of a simulation and
+     * invoked once per time step.  Loops are either run to completion with @ref parallel_for, or begun with @ref start
+     * so the calling thread can consume results while they are produced, then finished with @ref wait.
+     */
+    class ThreadPool {
+    public:
+
+        /**
+         * Create a pool that runs loops with the given total number of threads.
+         *
+         * The calling thread always participates in @ref parallel_for, so ``num_threads - 1`` workers are spawned.
+         * A value of ``0`` or ``1`` results in purely serial execution on the calling thread.
+         *
+         * @param num_threads The total number of threads to use, including the calling thread.
+         */
+        explicit ThreadPool(std::size_t num_threads) : num_threads(std::max<std::size_t>(num_threads, 1)) {
+            workers.reserve(this->num_threads - 1);
+            for (std::size_t i = 1; i < this->num_threads; ++i) {
+                workers.emplace_back(&ThreadPool::worker_loop, this);
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            work_ready.notify_all();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * @return The total number of threads used by loops run on this pool, including the calling thread.
+         */
+        std::size_t size() const {
+            return num_threads;
+        }
+
+        /**
+         * Invoke ``body(i)`` for every ``i`` in ``[0, count)``, distributing indices across the pool's threads.
+         *
+         * The call blocks until every index has been processed.  No ordering between indices is guaranteed, so
+         * ``body`` must only touch state that is private to its index or otherwise synchronized.
+         *
+         * If any invocation throws, remaining unclaimed indices are skipped and the first captured exception is
+         * rethrown on the calling thread once all threads have finished.
+         *
+         * This function is not reentrant: it must not be called concurrently or from within ``body``.
+         *
+         * @param count The number of indices to process.
+         * @param body The function to invoke for each index.
+         * @param chunk_size The number of consecutive indices claimed by a thread at a time.
+         */
+        void parallel_for(std::size_t count, const std::function<void(std::size_t)>& body, std::size_t chunk_size = 1) {
+            if (count == 0) {
+                return;
+            }
+            if (workers.empty() || count == 1) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    body(i);
+                }
+                return;
+            }
+            start(count, body, chunk_size);
+            wait();
+        }
+
+        /**
+         * Begin processing ``body(i)`` for every ``i`` in ``[0, count)`` on the pool's workers without blocking.
+         *
+         * Indices are claimed in increasing order, so lower indices tend to finish first.  This allows the calling
+         * thread to consume results in order while later indices are still being processed, calling @ref help to
+         * contribute work whenever the result it needs next is not yet available.
+         *
+         * Every call must be matched by a call to @ref wait before the next loop is started.
+         *
+         * @param count The number of indices to process.
+         * @param body The function to invoke for each index.
+         * @param chunk_size The number of consecutive indices claimed by a thread at a time.
+         */
+        void start(std::size_t count, std::function<void(std::size_t)> body, std::size_t chunk_size = 1) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job_body = std::move(body);
+                job_count = count;
+                job_chunk = std::max<std::size_t>(chunk_size, 1);
+                next_index.store(0);
+                job_error = nullptr;
+                active_workers = workers.size();
+                ++generation;
+            }
+            work_ready.notify_all();
+        }
+
+        /**
+         * Process one chunk of the loop begun by @ref start on the calling thread.
+         *
+         * @return Whether a chunk was processed; ``false`` once all indices have been claimed.
+         */
+        bool help() {
+            return run_chunk();
+        }
+
+        /**
+         * Participate in the loop begun by @ref start until all indices are claimed, then block until every thread
+         * has finished.
+         *
+         * If any invocation threw, the first captured exception is rethrown.
+         */
+        void wait() {
+            while (run_chunk()) {}
+
+            std::unique_lock<std::mutex> lock(mutex);
+            work_done.wait(lock, [this] { return active_workers == 0; });
+            job_body = nullptr;
+            if (job_error) {
+                std::exception_ptr error = job_error;
+                job_error = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+    private:
+
+        void worker_loop() {
+            std::size_t seen_generation = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen_generation = generation;
+                }
+
+                run_current_job();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --active_workers;
+                }
+                work_done.notify_one();
+            }
+        }
+
+        void run_current_job() {
+            while (run_chunk()) {}
+        }
+
+        bool run_chunk() {
+            std::size_t begin = next_index.fetch_add(job_chunk);
+            if (begin >= job_count) {
+                return false;
+            }
+            std::size_t end = std::min(begin + job_chunk, job_count);
+            try {
+                for (std::size_t i = begin; i < end; ++i) {
+                    job_body(i);
+                }
+            }
+            catch (...) {
+                // Stop handing out further indices and keep only the first error
+                next_index.store(job_count);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!job_error) {
+                    job_error = std::current_exception();
+                }
+                return false;
+            }
+            return true;
+        }
+
+        const std::size_t num_threads;
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+        bool stopping = false;
+        std::size_t generation = 0;
+        std::size_t active_workers = 0;
+
+        std::function<void(std::size_t)> job_body;
+        std::size_t job_count = 0;
+        std::size_t job_chunk = 1;
+        std::atomic<std::size_t> next_index{0};
+        std::exception_ptr job_error;
+    };
+
+}
+
+#endif //NGEN_THREADPOOL_HPP
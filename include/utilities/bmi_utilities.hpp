@@ -1,6 +1,8 @@
 #ifndef NGEN_BMI_UTILITIES_HPP
 #define NGEN_BMI_UTILITIES_HPP
 
+#include <cstddef>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <boost/type_index.hpp>
@@ -119,6 +121,130 @@ namespace models {
             }
             return result;
         }
+
+        /**
+         * @brief The native C++ types a BMI variable's values may have.
+         *
+         * Resolving a variable's type name to one of these once (see @ref get_value_type) allows its values to be read
+         * and written repeatedly without comparing type name strings.
+         */
+        enum class value_type {
+            LONG_DOUBLE, DOUBLE, FLOAT, SHORT, UNSIGNED_SHORT, INT, UNSIGNED_INT, LONG, UNSIGNED_LONG, LONG_LONG,
+            UNSIGNED_LONG_LONG, UNKNOWN
+        };
+
+        /**
+         * @brief Get the native type for a C++ (or analogous Fortran) type name, such as is returned by
+         * @ref Bmi_Adapter::get_analogous_cxx_type.
+         *
+         * @param type The name of the type.
+         * @return value_type The native type, or ``UNKNOWN`` if there is no logic for converting values of the type.
+         */
+        static inline value_type get_value_type(const std::string& type) {
+            if (type == "double" || type == "double precision")
+                return value_type::DOUBLE;
+            if (type == "float" || type == "real")
+                return value_type::FLOAT;
+            if (type == "long double")
+                return value_type::LONG_DOUBLE;
+            if (type == "short" || type == "short int" || type == "signed short" || type == "signed short int")
+                return value_type::SHORT;
+            if (type == "unsigned short" || type == "unsigned short int")
+                return value_type::UNSIGNED_SHORT;
+            if (type == "int" || type == "signed" || type == "signed int" || type == "integer")
+                return value_type::INT;
+            if (type == "unsigned" || type == "unsigned int")
+                return value_type::UNSIGNED_INT;
+            if (type == "long" || type == "long int" || type == "signed long" || type == "signed long int")
+                return value_type::LONG;
+            if (type == "unsigned long" || type == "unsigned long int")
+                return value_type::UNSIGNED_LONG;
+            if (type == "long long" || type == "long long int" || type == "signed long long" || type == "signed long long int")
+                return value_type::LONG_LONG;
+            if (type == "unsigned long long" || type == "unsigned long long int")
+                return value_type::UNSIGNED_LONG_LONG;
+            return value_type::UNKNOWN;
+        }
+
+        /**
+         * @brief Get the size in bytes of one value of a native type, or 0 if the type is ``UNKNOWN``.
+         */
+        static inline std::size_t get_value_type_size(value_type type) {
+            switch (type) {
+                case value_type::LONG_DOUBLE: return sizeof(long double);
+                case value_type::DOUBLE: return sizeof(double);
+                case value_type::FLOAT: return sizeof(float);
+                case value_type::SHORT: return sizeof(short);
+                case value_type::UNSIGNED_SHORT: return sizeof(unsigned short);
+                case value_type::INT: return sizeof(int);
+                case value_type::UNSIGNED_INT: return sizeof(unsigned int);
+                case value_type::LONG: return sizeof(long);
+                case value_type::UNSIGNED_LONG: return sizeof(unsigned long);
+                case value_type::LONG_LONG: return sizeof(long long);
+                case value_type::UNSIGNED_LONG_LONG: return sizeof(unsigned long long);
+                default: return 0;
+            }
+        }
+
+        /**
+         * @brief Read one value of a native type as a double.
+         *
+         * @param type The native type of the values @param data points to; must not be ``UNKNOWN``.
+         * @param data Pointer to the values.
+         * @param index Index of the value to read.
+         * @return double The value, cast to double.
+         */
+        static inline double get_value_as_double(value_type type, const void* data, std::size_t index) {
+            switch (type) {
+                case value_type::LONG_DOUBLE: return (double) static_cast<const long double*>(data)[index];
+                case value_type::DOUBLE: return static_cast<const double*>(data)[index];
+                case value_type::FLOAT: return (double) static_cast<const float*>(data)[index];
+                case value_type::SHORT: return (double) static_cast<const short*>(data)[index];
+                case value_type::UNSIGNED_SHORT: return (double) static_cast<const unsigned short*>(data)[index];
+                case value_type::INT: return (double) static_cast<const int*>(data)[index];
+                case value_type::UNSIGNED_INT: return (double) static_cast<const unsigned int*>(data)[index];
+                case value_type::LONG: return (double) static_cast<const long*>(data)[index];
+                case value_type::UNSIGNED_LONG: return (double) static_cast<const unsigned long*>(data)[index];
+                case value_type::LONG_LONG: return (double) static_cast<const long long*>(data)[index];
+                case value_type::UNSIGNED_LONG_LONG: return (double) static_cast<const unsigned long long*>(data)[index];
+                default: throw std::runtime_error("Unable to get value as double: unknown variable type");
+            }
+        }
+
+        namespace helper {
+            template<typename T>
+            static inline void store_values(const double* values, std::size_t count, void* dest) {
+                T* typed = static_cast<T*>(dest);
+                for (std::size_t i = 0; i < count; ++i) {
+                    typed[i] = static_cast<T>(values[i]);
+                }
+            }
+        }
+
+        /**
+         * @brief Convert double values to a native type, writing them to @param dest.
+         *
+         * @param type The native type to convert to; must not be ``UNKNOWN``.
+         * @param values The values to convert.
+         * @param count The number of values.
+         * @param dest Storage for at least @param count values of the native type.
+         */
+        static inline void store_values_as_type(value_type type, const double* values, std::size_t count, void* dest) {
+            switch (type) {
+                case value_type::LONG_DOUBLE: helper::store_values<long double>(values, count, dest); break;
+                case value_type::DOUBLE: helper::store_values<double>(values, count, dest); break;
+                case value_type::FLOAT: helper::store_values<float>(values, count, dest); break;
+                case value_type::SHORT: helper::store_values<short>(values, count, dest); break;
+                case value_type::UNSIGNED_SHORT: helper::store_values<unsigned short>(values, count, dest); break;
+                case value_type::INT: helper::store_values<int>(values, count, dest); break;
+                case value_type::UNSIGNED_INT: helper::store_values<unsigned int>(values, count, dest); break;
+                case value_type::LONG: helper::store_values<long>(values, count, dest); break;
+                case value_type::UNSIGNED_LONG: helper::store_values<unsigned long>(values, count, dest); break;
+                case value_type::LONG_LONG: helper::store_values<long long>(values, count, dest); break;
+                case value_type::UNSIGNED_LONG_LONG: helper::store_values<unsigned long long>(values, count, dest); break;
+                default: throw std::runtime_error("Unable to convert values: unknown variable type");
+            }
+        }
     }
 }
 
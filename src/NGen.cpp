@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_map>
 #include <chrono>
+#include <algorithm>
 
 #include <boost/core/span.hpp>
 
@@ -17,6 +18,8 @@
 #include "NGenConfig.h"
 
 #include <FileChecker.h>
+#include <NetCDFOutputWriter.hpp>
+#include <Profiler.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/range/algorithm/sort.hpp>
 
@@ -31,6 +34,7 @@
     
 #if NGEN_WITH_ROUTING
 #include "routing/Routing_Py_Adapter.hpp"
+#include "routing/Routing_Pipeline.hpp"
 #endif // NGEN_WITH_ROUTING
 
 std::string catchmentDataFile = "";
@@ -61,6 +65,7 @@ int mpi_num_procs;
 #include <Layer.hpp>
 #include <SurfaceLayer.hpp>
 #include <DomainLayer.hpp>
+#include <Checkpoint.hpp>
 
 std::unordered_map<std::string, std::ofstream> nexus_outfiles;
 
@@ -302,6 +307,16 @@ int main(int argc, char *argv[]) {
             error = error || !utils::FileChecker::file_is_readable(PARTITION_PATH, "Partition config");
         }
 
+        // Each rank reads only its partition's features from a GeoPackage, by their ids, so those need no subdividing
+        if (is_subdivided_hydrofabric_wanted && boost::algorithm::ends_with(catchmentDataFile, "gpkg")
+            && boost::algorithm::ends_with(nexusDataFile, "gpkg")) {
+            if (mpi_rank == 0) {
+                std::cout << "Reading each partition directly from the GeoPackage hydrofabric; ignoring "
+                          << MPI_HF_SUB_CLI_FLAG << std::endl;
+            }
+            is_subdivided_hydrofabric_wanted = false;
+        }
+
         // Do some extra steps if we expect to load a subdivided hydrofabric
         if (is_subdivided_hydrofabric_wanted) {
             // Ensure the hydrofabric is subdivided (either already or by doing it now), and then adjust these paths
@@ -367,7 +382,8 @@ int main(int argc, char *argv[]) {
       throw std::runtime_error("SQLite3 support required to read GeoPackage files.");
       #endif
     } else {
-      nexus_collection = geojson::read(nexusDataFile, nexus_subset_ids);
+      // Only the topology and properties of the hydrofabric are used, so its geometry is not read
+      nexus_collection = geojson::read(nexusDataFile, nexus_subset_ids, false);
     }
     std::cout << "Building Catchment collection" << std::endl;
 
@@ -380,7 +396,7 @@ int main(int argc, char *argv[]) {
       throw std::runtime_error("SQLite3 support required to read GeoPackage files.");
       #endif
     } else {
-      catchment_collection = geojson::read(catchmentDataFile, catchment_subset_ids);
+      catchment_collection = geojson::read(catchmentDataFile, catchment_subset_ids, false);
     }
     
     for(auto& feature: *catchment_collection)
@@ -394,6 +410,10 @@ int main(int argc, char *argv[]) {
     nexus_collection->update_ids("id");
     std::cout<<"Initializing formulations" << std::endl;
     std::shared_ptr<realization::Formulation_Manager> manager = std::make_shared<realization::Formulation_Manager>(REALIZATION_CONFIG_PATH);
+    //Enabled before formulations are created, so forcing data loaded at creation is included
+    if (manager->get_profiling_enabled()) {
+        utils::Profiler::enable(manager->get_profiling_trace());
+    }
     manager->read(catchment_collection, utils::getStdOut());
 
     //TODO refactor manager->read so certain configs can be queried before the entire
@@ -411,6 +431,34 @@ int main(int argc, char *argv[]) {
       std::cout<<"Not Using Routing"<<std::endl;
     }
     }
+    //Nexus flows are passed to routing in memory when configured and the routing module accepts them
+    bool routing_in_memory = false;
+    if(manager->get_using_routing() && manager->get_routing_in_memory()) {
+      if (mpi_rank == 0) {
+        routing_in_memory = router->accepts_flows();
+        if (!routing_in_memory) {
+          std::cout<<"WARN: Routing module does not accept nexus flows in memory; routing will read nexus output files"<<std::endl;
+        }
+      }
+      #if NGEN_WITH_MPI
+      int in_memory = routing_in_memory;
+      MPI_Bcast(&in_memory, 1, MPI_INT, 0, MPI_COMM_WORLD);
+      routing_in_memory = in_memory != 0;
+      #endif
+    }
+    //In memory flows are routed in chunks while the simulation continues when configured and the routing module accepts them
+    int routing_chunk_steps = 0;
+    if(routing_in_memory && manager->get_routing_chunk_time_steps() > 0) {
+      if (mpi_rank == 0) {
+        routing_chunk_steps = router->accepts_flow_chunks() ? manager->get_routing_chunk_time_steps() : 0;
+        if (routing_chunk_steps == 0) {
+          std::cout<<"WARN: Routing module does not accept nexus flows in chunks; routing will run once the simulation is done"<<std::endl;
+        }
+      }
+      #if NGEN_WITH_MPI
+      MPI_Bcast(&routing_chunk_steps, 1, MPI_INT, 0, MPI_COMM_WORLD);
+      #endif
+    }
     #endif //NGEN_WITH_ROUTING
     std::cout<<"Building Feature Index" <<std::endl;;
     std::string link_key = "toid";
@@ -435,19 +483,32 @@ int main(int argc, char *argv[]) {
     //catchment_collection.reset();
     nexus_collection.reset();
 
+    //Columnar output of all catchments and nexuses of this rank, in place of a CSV file per feature
+    std::shared_ptr<utils::NetCDFOutputWriter> output_writer;
+    if (manager->get_output_format() == "netcdf") {
+        std::string output_path = manager->get_output_root() + "output_rank_" + std::to_string(mpi_rank) + ".nc";
+        output_writer = std::make_shared<utils::NetCDFOutputWriter>(output_path, manager->get_output_timesteps_per_write(),
+                                                                    manager->get_output_compression_level());
+        std::cout << "Writing catchment and nexus output to " << output_path << std::endl;
+    }
+    //Routing reads the nexus CSV files, unless nexus flows are passed to it in memory
+    bool nexus_csv_output = output_writer == nullptr;
+    #if NGEN_WITH_ROUTING
+    nexus_csv_output = nexus_csv_output || (manager->get_using_routing() && !routing_in_memory);
+    #endif
+
     //Still hacking nexus output for the moment
+    std::vector<std::string> nexus_output_ids;
     for(const auto& id : features.nexuses()) {
         #if NGEN_WITH_MPI
-        if (mpi_num_procs > 1) {
-            if (!features.is_remote_sender_nexus(id)) {
-                nexus_outfiles[id].open(manager->get_output_root() + id + "_output.csv", std::ios::trunc);
-            }
-        } else {
-          nexus_outfiles[id].open(manager->get_output_root() + id + "_output.csv", std::ios::trunc);
+        if (mpi_num_procs > 1 && !features.is_primary_nexus(id)) {
+            continue;
         }
-        #else
-        nexus_outfiles[id].open(manager->get_output_root() + id + "_output.csv", std::ios::trunc);
         #endif
+        nexus_output_ids.push_back(id);
+        if (nexus_csv_output) {
+            nexus_outfiles[id].open(manager->get_output_root() + id + "_output.csv", std::ios::trunc);
+        }
     }
 
     std::cout<<"Running Models"<<std::endl;
@@ -475,6 +536,24 @@ int main(int argc, char *argv[]) {
     std::vector<std::shared_ptr<ngen::Layer> > layers;
     layers.resize(keys.size());
 
+    //The [nexus x time] flows of the surface layer, when they are passed to routing in memory
+    std::shared_ptr<NexusFlowBuffer> nexus_flow_buffer;
+    int nexus_flow_interval = 0;
+    long nexus_flow_times = 0;
+    std::shared_ptr<ngen::Layer> nexus_flow_layer;
+    //Nexus flow time steps per routing chunk, and master time steps per chunk, 0 when flows are routed once the
+    //simulation is done
+    long nexus_flow_window = 0;
+    long routing_chunk_master_steps = 0;
+
+    // shared by all layers, which are updated one at a time
+    std::shared_ptr<utils::ThreadPool> thread_pool;
+    unsigned int thread_count = manager->get_thread_count();
+    if (thread_count > 1) {
+      thread_pool = std::make_shared<utils::ThreadPool>(thread_count);
+      std::cout << "Executing catchment formulations with " << thread_count << " threads per process" << std::endl;
+    }
+
     for(long i = 0; i < keys.size(); ++i)
     {
       auto& desc = layer_meta_data.get_layer(keys[i]);
@@ -488,15 +567,43 @@ int main(int argc, char *argv[]) {
         layers[i] = std::make_shared<ngen::DomainLayer>(desc, sim_time, features, 0, formulation);
       }
       else{
-        for ( std::string id : features.catchments(keys[i]) ) { cat_ids.push_back(id); }
+        //Upstream to downstream wavefronts, so catchments sharing a nexus tend to complete close together
+        for ( std::string id : features.catchments(keys[i], network::SortOrder::Level) ) { cat_ids.push_back(id); }
+        #if NGEN_WITH_MPI
+        //Catchments feeding other ranks go first so their flows are sent while the rest are computed
+        std::stable_partition(cat_ids.begin(), cat_ids.end(), [&](const std::string& id) {
+          return features.is_boundary_catchment(id);
+        });
+        #endif
         if (keys[i] != 0 )
         {
           layers[i] = std::make_shared<ngen::Layer>(desc, cat_ids, sim_time, features, catchment_collection, 0);
         }
         else
         {
-          layers[i] = std::make_shared<ngen::SurfaceLayer>(desc, cat_ids, sim_time, features, catchment_collection, 0, nexus_subset_ids, nexus_outfiles);
+          auto surface_layer = std::make_shared<ngen::SurfaceLayer>(desc, cat_ids, sim_time, features, catchment_collection, 0, nexus_subset_ids, nexus_outfiles);
+          surface_layer->set_nexus_output_writer(output_writer, nexus_output_ids);
+          #if NGEN_WITH_ROUTING
+          if (routing_in_memory) {
+            nexus_flow_interval = sim_time.get_output_interval_seconds();
+            nexus_flow_times = sim_time.get_total_output_times();
+            long window = nexus_flow_times;
+            if (routing_chunk_steps > 0) {
+              //Chunks span whole simulation time steps, so the layer never overruns one before it is handed off
+              long layer_steps = std::max(1, manager->Simulation_Time_Object->get_output_interval_seconds() / nexus_flow_interval);
+              window = std::min(nexus_flow_times, (routing_chunk_steps + layer_steps - 1) / layer_steps * layer_steps);
+              nexus_flow_window = window;
+              routing_chunk_master_steps = window * nexus_flow_interval / manager->Simulation_Time_Object->get_output_interval_seconds();
+            }
+            nexus_flow_buffer = std::make_shared<NexusFlowBuffer>(nexus_output_ids, window);
+            nexus_flow_layer = surface_layer;
+            surface_layer->set_nexus_flow_buffer(nexus_flow_buffer);
+          }
+          #endif
+          layers[i] = surface_layer;
         }
+        layers[i]->set_thread_pool(thread_pool);
+        layers[i]->set_output_writer(output_writer);
       }
 
     }
@@ -504,9 +611,72 @@ int main(int argc, char *argv[]) {
     auto time_done_init = std::chrono::steady_clock::now();
     std::chrono::duration<double> time_elapsed_init = time_done_init - time_start;
 
+#if NGEN_WITH_ROUTING
+    //Routes each chunk of nexus flows on rank 0, on its own thread unless the simulation there calls into Python, since
+    //the simulation thread gives up the Python GIL while routing runs alongside it
+    std::unique_ptr<routing_py_adapter::Routing_Pipeline> routing_pipeline;
+    if (routing_chunk_steps > 0 && mpi_rank == 0) {
+      bool concurrent = std::none_of(layers.begin(), layers.end(), [](const std::shared_ptr<ngen::Layer>& layer) {
+        return layer->uses_python();
+      });
+      if (!concurrent) {
+        std::cout<<"WARN: Formulations or forcing providers call into Python; routing each chunk between time steps"<<std::endl;
+      }
+      routing_pipeline = std::make_unique<routing_py_adapter::Routing_Pipeline>(*router, nexus_flow_interval, concurrent);
+    }
+#endif
+
+    //Checkpoints hold the state of one rank, and are restarted by the same rank of the same number of ranks
+    #if NGEN_WITH_MPI
+    int checkpoint_ranks = mpi_num_procs;
+    #else
+    int checkpoint_ranks = 1;
+    #endif
+
+    //Resume from a checkpoint, after the time steps it completed
+    int first_count = 0;
+    std::string restart_path = manager->get_restart_path();
+    if (!restart_path.empty()) {
+      first_count = ngen::checkpoint::read(restart_path, mpi_rank, checkpoint_ranks, *manager->Simulation_Time_Object,
+                                           layers, features);
+      if (mpi_rank == 0) {
+        std::cout << "Restarted from checkpoint " << restart_path << " at timestep " << first_count << std::endl;
+      }
+#if NGEN_WITH_ROUTING
+      if (nexus_flow_buffer != nullptr) {
+        //Checkpoints are only written at routing chunk boundaries or the end, so the run that wrote this one handed
+        //the flows of every earlier time step to routing; they are not routed again.  A checkpoint at the end may be
+        //mid-chunk, so the first window ends at the next boundary, where later checkpoints fall.
+        long first_time = std::min<long>(nexus_flow_layer->completed_time_steps(), nexus_flow_times);
+        long window = nexus_flow_window > 0 ? nexus_flow_window - first_time % nexus_flow_window : nexus_flow_times;
+        nexus_flow_buffer->start_window(first_time, std::min<long>(window, nexus_flow_times - first_time));
+      }
+#endif
+    }
+    int checkpoint_interval = manager->get_checkpoint_interval();
+    std::string checkpoint_path = checkpoint_interval > 0 || manager->get_checkpoint_at_end()
+                                  ? manager->get_checkpoint_path() : "";
+#if NGEN_WITH_ROUTING
+    if (checkpoint_interval > 0 && nexus_flow_buffer != nullptr
+        && (routing_chunk_master_steps == 0 || checkpoint_interval % routing_chunk_master_steps != 0)) {
+      //Flows in memory are only routed at chunk boundaries, so those since the last one are lost when a run stops early
+      if (routing_chunk_master_steps == 0) {
+        throw std::runtime_error("Checkpoints during the run need nexus flows in memory to be routed in chunks, but "
+                                 "the routing module does not accept chunks");
+      }
+      throw std::runtime_error("Checkpoint interval of " + std::to_string(checkpoint_interval) + " time steps is not a "
+                               "multiple of the " + std::to_string(routing_chunk_master_steps) + " time steps of a "
+                               "routing chunk");
+    }
+#endif
+    if (!checkpoint_path.empty()) {
+      //Fail before simulating rather than at the first checkpoint, when any formulation cannot save its state
+      ngen::checkpoint::check(checkpoint_ranks, layers);
+    }
+
     //Now loop some time, iterate catchments, do stuff for total number of output times
     auto num_times = manager->Simulation_Time_Object->get_total_output_times();
-    for( int count = 0; count < num_times; count++) 
+    for( int count = first_count; count < num_times; count++) 
     {
       // The Inner loop will advance all layers unless doing so will break one of two constraints
       // 1) A layer may not proceed ahead of the master simulation object's current time
@@ -550,15 +720,64 @@ int main(int argc, char *argv[]) {
         } //done layers
       } while( layer_min_next_time < next_time );  // rerun the loop until the last layer would pass the master next time
 
+#if NGEN_WITH_ROUTING
+      if (nexus_flow_buffer != nullptr && routing_chunk_steps > 0 && nexus_flow_buffer->num_times() > 0) {
+        long chunk_end = nexus_flow_buffer->first_time_index() + nexus_flow_buffer->num_times();
+        if (nexus_flow_layer->completed_time_steps() >= chunk_end) {
+          //Hand the completed chunk to routing and keep simulating into the next one
+          long chunk_times = nexus_flow_buffer->num_times();
+          NexusFlowBuffer chunk = nexus_flow_buffer->take_window();
+          nexus_flow_buffer->start_window(chunk_end, std::min<long>(nexus_flow_window, nexus_flow_times - chunk_end));
+          #if NGEN_WITH_MPI
+          if (mpi_num_procs > 1) {
+            chunk.gather(0);
+          }
+          #endif
+          if (routing_pipeline != nullptr) {
+            long chunk_start = manager->Simulation_Time_Object->get_start_epoch_time()
+                               + chunk.first_time_index() * nexus_flow_interval;
+            routing_pipeline->submit(chunk.ids(), chunk.take_flows(), chunk_times, chunk_start,
+                                     chunk_end == nexus_flow_times);
+          }
+        }
+      }
+#endif
+
       if (count + 1 < num_times)
       {
         manager->Simulation_Time_Object->advance_timestep();
+
+        if (checkpoint_interval > 0 && (count + 1) % checkpoint_interval == 0) {
+          //Collective, so every rank has written this checkpoint before any rank can overwrite its file with the next one
+          ngen::checkpoint::write(checkpoint_path, mpi_rank, checkpoint_ranks, *manager->Simulation_Time_Object,
+                                  count + 1, layers, features);
+        }
       }
 
     } //done time
 
+    if (manager->get_checkpoint_at_end()) {
+      ngen::checkpoint::write(checkpoint_path, mpi_rank, checkpoint_ranks, *manager->Simulation_Time_Object,
+                              std::max(first_count, num_times), layers, features);
+    }
+
+    //Nexus output is not flushed per line, so complete it before it is read for routing
+    for (auto& outfile : nexus_outfiles) {
+        outfile.second.flush();
+    }
+    if (output_writer != nullptr) {
+        static const std::string profile_name = "close";
+        utils::Profile_Scope profile(utils::Profiler::OUTPUT, profile_name);
+        output_writer->close();
+    }
+
 #if NGEN_WITH_MPI
-    MPI_Barrier(MPI_COMM_WORLD);
+    {
+        //Time spent here is this rank waiting for the slowest one
+        static const std::string profile_name = "NGen::simulation";
+        utils::Profile_Scope profile(utils::Profiler::MPI_WAIT, profile_name);
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
 #endif
 
     if (mpi_rank == 0)
@@ -574,9 +793,24 @@ int main(int argc, char *argv[]) {
 #endif
 
 #if NGEN_WITH_ROUTING
+    #if NGEN_WITH_MPI
+    if (nexus_flow_buffer != nullptr && routing_chunk_steps == 0 && mpi_num_procs > 1) {
+        //Routing runs on rank 0, so it needs the flows of every rank
+        nexus_flow_buffer->gather(0);
+    }
+    #endif
     if (mpi_rank == 0)
     { // Run t-route from single process
-        if(manager->get_using_routing()) {
+        if(routing_pipeline != nullptr) {
+          //Only the chunks still routing when the simulation finished are waited for here
+          routing_pipeline->finish();
+        }
+        else if(nexus_flow_buffer != nullptr && routing_chunk_steps == 0) {
+          router->route(nexus_flow_buffer->ids(), nexus_flow_buffer->data(), nexus_flow_buffer->num_times(),
+                        manager->Simulation_Time_Object->get_start_epoch_time() + nexus_flow_buffer->first_time_index() * nexus_flow_interval,
+                        nexus_flow_interval);
+        }
+        else if(manager->get_using_routing()) {
           //Note: Currently, delta_time is set in the t-route yaml configuration file, and the
           //number_of_timesteps is determined from the total number of nexus outputs in t-route.
           //It is recommended to still pass these values to the routing_py_adapter object in
@@ -604,9 +838,36 @@ int main(int argc, char *argv[]) {
                   << std::endl;
     }
 
+    if (utils::Profiler::is_enabled()) {
+        utils::Profiler::disable();
+        std::string profile_path = manager->get_output_root() + "profile_rank_" + std::to_string(mpi_rank);
+        std::ofstream summary(profile_path + ".csv", std::ios::trunc);
+        utils::Profiler::write_summary(summary);
+        std::ofstream catchment_times(profile_path + "_catchments.csv", std::ios::trunc);
+        utils::Profiler::write_catchment_times(catchment_times);
+        if (manager->get_profiling_trace()) {
+            std::ofstream trace(profile_path + ".trace.json", std::ios::trunc);
+            utils::Profiler::write_trace(trace, mpi_rank);
+        }
+
+        if (mpi_rank == 0) {
+            std::cout << "NGen profile (rank 0, inclusive seconds):";
+            for (int c = 0; c < utils::Profiler::NUM_CATEGORIES; ++c) {
+                auto category = static_cast<utils::Profiler::Category>(c);
+                double total = 0.0;
+                for (const auto& entry : utils::Profiler::summary(category)) {
+                    total += entry.second.total_seconds;
+                }
+                std::cout << "\n\t" << utils::Profiler::category_name(category) << ": " << total;
+            }
+            std::cout << "\nProfiles written to " << manager->get_output_root() << "profile_rank_*" << std::endl;
+        }
+    }
+
   manager->finalize();
 
 #if NGEN_WITH_MPI
+    features.finalize();
     MPI_Finalize();
 #endif
 
@@ -3,6 +3,9 @@
 #include "utilities/FileChecker.h"
 #include "utilities/logging_utils.h"
 
+#include <cstdint>
+#include <stdexcept>
+
 namespace models {
 namespace bmi {
 
@@ -124,5 +127,44 @@ std::string Bmi_Adapter::get_model_name() {
     return model_name;
 }
 
+bool Bmi_Adapter::is_serializable() {
+    try {
+        GetVarType("serialization_state");
+        return true;
+    }
+    catch (std::exception& e) {
+        return false;
+    }
+}
+
+std::vector<char> Bmi_Adapter::get_serialized_state() {
+    // Big enough for any scalar type the model may give the control variables
+    std::int64_t ignored = 0;
+    try {
+        SetValue("serialization_create", &ignored);
+        int nbytes = GetVarNbytes("serialization_state");
+        if (nbytes < 0) {
+            throw std::runtime_error("negative serialized state size " + std::to_string(nbytes));
+        }
+        std::vector<char> state(nbytes);
+        GetValue("serialization_state", state.data());
+        SetValue("serialization_free", &ignored);
+        return state;
+    }
+    catch (std::exception& e) {
+        throw std::runtime_error("Failed to serialize the state of " + model_name + ": " + e.what());
+    }
+}
+
+void Bmi_Adapter::set_serialized_state(const std::vector<char>& state) {
+    try {
+        // BMI setters take mutable sources, but models only read the state from it
+        SetValue("serialization_state", const_cast<char*>(state.data()));
+    }
+    catch (std::exception& e) {
+        throw std::runtime_error("Failed to restore the serialized state of " + model_name + ": " + e.what());
+    }
+}
+
 } // namespace bmi
 } // namespace models
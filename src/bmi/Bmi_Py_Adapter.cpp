@@ -2,6 +2,7 @@
 
 #if NGEN_WITH_PYTHON
 
+#include <cstdint>
 #include <exception>
 #include <utility>
 #include <iostream>
@@ -222,4 +223,29 @@ void Bmi_Py_Adapter::UpdateUntil(double time) {
     bmi_model->attr("update_until")(time);
 }
 
+std::vector<char> Bmi_Py_Adapter::get_serialized_state() {
+    try {
+        py::array ignored = np.attr("zeros")(1);
+        bmi_model->attr("set_value")("serialization_create", ignored);
+        py::array state = bmi_model->attr("get_value_ptr")("serialization_state");
+        // Only the bytes of the state are kept, whatever its dtype
+        std::string bytes = py::bytes(state.attr("tobytes")());
+        bmi_model->attr("set_value")("serialization_free", ignored);
+        return std::vector<char>(bytes.begin(), bytes.end());
+    }
+    catch (std::exception& e) {
+        throw std::runtime_error("Failed to serialize the state of " + model_name + ": " + e.what());
+    }
+}
+
+void Bmi_Py_Adapter::set_serialized_state(const std::vector<char> &state) {
+    try {
+        py::array_t<std::uint8_t> array(state.size(), reinterpret_cast<const std::uint8_t*>(state.data()));
+        bmi_model->attr("set_value")("serialization_state", array);
+    }
+    catch (std::exception& e) {
+        throw std::runtime_error("Failed to restore the serialized state of " + model_name + ": " + e.what());
+    }
+}
+
 #endif //NGEN_WITH_PYTHON
@@ -0,0 +1,372 @@
+#include <NGenConfig.h>
+
+#if NGEN_WITH_PYTHON
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "bmi/Bmi_Py_Batch_Adapter.hpp"
+#include "bmi/Bmi_Py_Adapter.hpp"
+#include "utilities/python/InterpreterUtil.hpp"
+
+using namespace models::bmi;
+namespace py = pybind11;
+
+namespace {
+
+    /** Get the numpy dtype of the C++ type that values of a variable are exchanged as. */
+    py::dtype dtype_of_cxx_type(const std::string &cxx_type) {
+        if (cxx_type == "short") return py::dtype::of<short>();
+        if (cxx_type == "int") return py::dtype::of<int>();
+        if (cxx_type == "long") return py::dtype::of<long>();
+        if (cxx_type == "long long") return py::dtype::of<long long>();
+        if (cxx_type == "float") return py::dtype::of<float>();
+        if (cxx_type == "double") return py::dtype::of<double>();
+        if (cxx_type == "long double") return py::dtype::of<long double>();
+        throw std::runtime_error("Batched Python models do not support variables of C++ type " + cxx_type);
+    }
+
+}
+
+std::shared_ptr<Bmi_Py_Batch> Bmi_Py_Batch::get_shared(const std::string &bmi_python_type,
+                                                      const std::string &model_type_name) {
+    // Weak references, so a model is finalized once its last catchment's formulation is destroyed
+    static std::map<std::pair<std::string, std::string>, std::weak_ptr<Bmi_Py_Batch>> batches;
+    std::weak_ptr<Bmi_Py_Batch> &shared = batches[std::make_pair(bmi_python_type, model_type_name)];
+    std::shared_ptr<Bmi_Py_Batch> batch = shared.lock();
+    if (batch == nullptr) {
+        batch = std::make_shared<Bmi_Py_Batch>(bmi_python_type);
+        shared = batch;
+    }
+    return batch;
+}
+
+Bmi_Py_Batch::Bmi_Py_Batch(const std::string &bmi_python_type) : bmi_type_py_full_name(bmi_python_type) {
+    size_t pos = bmi_type_py_full_name.rfind('.');
+    if (pos == std::string::npos) {
+        throw std::runtime_error("Cannot interpret BMI Python model type '" + bmi_type_py_full_name
+                                 + "'; expected format is <python_module>.<python_class>");
+    }
+    std::vector<std::string> moduleComponents = {bmi_type_py_full_name.substr(0, pos),
+                                                 bmi_type_py_full_name.substr(pos + 1)};
+    py::object bmi_py_class = utils::ngenPy::InterpreterUtil::getPyModule(moduleComponents);
+    if (!py::hasattr(bmi_py_class, "add_catchment")) {
+        throw std::runtime_error("BMI Python model type '" + bmi_type_py_full_name
+                                 + "' cannot be batched, as it has no 'add_catchment' function");
+    }
+    bmi_model = std::make_shared<py::object>(bmi_py_class());
+}
+
+Bmi_Py_Batch::~Bmi_Py_Batch() {
+    try {
+        bmi_model->attr("finalize")();
+    }
+    catch (std::exception &e) {
+        std::cerr << "Failed to finalize batched Python model " << bmi_type_py_full_name << ": " << e.what()
+                  << std::endl;
+    }
+}
+
+std::size_t Bmi_Py_Batch::add_row(const std::string &bmi_init_config) {
+    if (steps > 0) {
+        throw std::runtime_error("Cannot add a catchment to batched Python model " + bmi_type_py_full_name
+                                 + " after it has been updated");
+    }
+    bmi_model->attr("add_catchment")(bmi_init_config);
+    row_steps.push_back(0);
+    prepared_steps.push_back(-1);
+    // The size of every variable changes, so values read so far no longer apply; values already set for earlier
+    // rows, like model parameters, are kept and grow with the rows when next set
+    variables.clear();
+    cached.clear();
+    current_time = py::float_(bmi_model->attr("get_current_time")());
+    previous_time = current_time;
+    return row_steps.size() - 1;
+}
+
+const Bmi_Py_Batch::variable &Bmi_Py_Batch::get_variable(const std::string &name) {
+    auto it = variables.find(name);
+    if (it != variables.end()) {
+        return it->second;
+    }
+    variable info;
+    info.type = bmi_model->attr("get_var_type")(name).cast<std::string>();
+    info.item_size = py::int_(bmi_model->attr("get_var_itemsize")(name));
+    int nbytes = py::int_(bmi_model->attr("get_var_nbytes")(name));
+    if (num_rows() == 0 || nbytes % num_rows() != 0 || (nbytes / num_rows()) % info.item_size != 0) {
+        throw std::runtime_error("Batched Python model " + bmi_type_py_full_name + " variable " + name + " has "
+                                 + std::to_string(nbytes) + " bytes, which cannot be split evenly among its "
+                                 + std::to_string(num_rows()) + " catchments");
+    }
+    info.row_nbytes = nbytes / num_rows();
+    info.cxx_type = Bmi_Py_Adapter::python_analogous_cxx_type(info.type, info.item_size);
+    info.units = bmi_model->attr("get_var_units")(name).cast<std::string>();
+    info.location = bmi_model->attr("get_var_location")(name).cast<std::string>();
+    info.grid = py::int_(bmi_model->attr("get_var_grid")(name));
+    return variables.emplace(name, std::move(info)).first->second;
+}
+
+const std::vector<std::string> &Bmi_Py_Batch::get_input_var_names() {
+    if (input_var_names == nullptr) {
+        input_var_names = std::make_shared<std::vector<std::string>>();
+        py::iterable names = bmi_model->attr("get_input_var_names")();
+        for (auto &&name : names) {
+            input_var_names->emplace_back(py::str(name));
+        }
+    }
+    return *input_var_names;
+}
+
+const std::vector<std::string> &Bmi_Py_Batch::get_output_var_names() {
+    if (output_var_names == nullptr) {
+        output_var_names = std::make_shared<std::vector<std::string>>();
+        py::iterable names = bmi_model->attr("get_output_var_names")();
+        for (auto &&name : names) {
+            output_var_names->emplace_back(py::str(name));
+        }
+    }
+    return *output_var_names;
+}
+
+std::string Bmi_Py_Batch::get_component_name() {
+    return py::str(bmi_model->attr("get_component_name")());
+}
+
+double Bmi_Py_Batch::get_current_time(std::size_t row) const {
+    return row_steps.at(row) == steps ? current_time : previous_time;
+}
+
+double Bmi_Py_Batch::get_start_time() {
+    return py::float_(bmi_model->attr("get_start_time")());
+}
+
+double Bmi_Py_Batch::get_end_time() {
+    return py::float_(bmi_model->attr("get_end_time")());
+}
+
+double Bmi_Py_Batch::get_time_step() {
+    if (time_step == nullptr) {
+        time_step = std::make_shared<double>(py::float_(bmi_model->attr("get_time_step")()));
+    }
+    return *time_step;
+}
+
+std::string Bmi_Py_Batch::get_time_units() {
+    if (time_units == nullptr) {
+        time_units = std::make_shared<std::string>(py::str(bmi_model->attr("get_time_units")()));
+    }
+    return *time_units;
+}
+
+void Bmi_Py_Batch::set_row_value(const std::string &name, std::size_t row, const void *src) {
+    const variable &info = get_variable(name);
+    const std::size_t rows = num_rows();
+    if (row >= rows) {
+        throw std::out_of_range("No catchment row " + std::to_string(row) + " in batched Python model "
+                                + bmi_type_py_full_name);
+    }
+    staged_values &stage = staged[name];
+    if (stage.is_set.size() != rows) {
+        stage.values.resize(rows * info.row_nbytes);
+        stage.is_set.resize(rows, false);
+    }
+    std::memcpy(&stage.values[row * info.row_nbytes], src, info.row_nbytes);
+    if (!stage.is_set[row]) {
+        stage.is_set[row] = true;
+        ++stage.set_count;
+    }
+}
+
+const void *Bmi_Py_Batch::get_row_value_ptr(const std::string &name, std::size_t row) {
+    const variable &info = get_variable(name);
+    const std::size_t rows = num_rows();
+    if (row >= rows) {
+        throw std::out_of_range("No catchment row " + std::to_string(row) + " in batched Python model "
+                                + bmi_type_py_full_name);
+    }
+
+    // Values set since the last update are what the model will see for the row
+    auto stage = staged.find(name);
+    if (stage != staged.end() && row < stage->second.is_set.size() && stage->second.is_set[row]) {
+        return &stage->second.values[row * info.row_nbytes];
+    }
+
+    cached_values &cache = cached[name];
+    if (cache.step != steps) {
+        py::dtype dtype = dtype_of_cxx_type(info.cxx_type);
+        py::array values = py::array::ensure(bmi_model->attr("get_value_ptr")(name), py::array::c_style);
+        if (!values) {
+            throw std::runtime_error("Batched Python model " + bmi_type_py_full_name + " variable " + name
+                                     + " is not an array");
+        }
+        if (values.dtype().kind() != dtype.kind() || values.itemsize() != dtype.itemsize()) {
+            values = py::array::ensure(values.attr("astype")(dtype), py::array::c_style);
+        }
+        if (static_cast<std::size_t>(values.nbytes()) != rows * info.row_nbytes) {
+            throw std::runtime_error("Batched Python model " + bmi_type_py_full_name + " variable " + name + " has "
+                                     + std::to_string(values.nbytes()) + " bytes, instead of "
+                                     + std::to_string(rows * info.row_nbytes) + " for its "
+                                     + std::to_string(rows) + " catchments");
+        }
+        const char *data = static_cast<const char *>(values.data());
+        cache.values.assign(data, data + values.nbytes());
+        cache.step = steps;
+    }
+    return &cache.values[row * info.row_nbytes];
+}
+
+void Bmi_Py_Batch::prepare_update(std::size_t row) {
+    if (row_steps.at(row) != steps) {
+        throw std::runtime_error("Catchment row " + std::to_string(row) + " of batched Python model "
+                                 + bmi_type_py_full_name + " cannot be prepared before it has caught up with "
+                                 + "the last model update");
+    }
+    prepared_steps[row] = steps;
+}
+
+void Bmi_Py_Batch::update(std::size_t row) {
+    advance(row, nullptr);
+}
+
+void Bmi_Py_Batch::update_until(std::size_t row, double time) {
+    advance(row, &time);
+}
+
+void Bmi_Py_Batch::advance(std::size_t row, const double *until_time) {
+    // The model was already updated for this step by an earlier row
+    if (row_steps.at(row) + 1 == steps) {
+        ++row_steps[row];
+        return;
+    }
+    for (std::size_t r = 0; r < prepared_steps.size(); ++r) {
+        if (prepared_steps[r] != steps) {
+            throw std::runtime_error("Batched Python model " + bmi_type_py_full_name + " cannot be updated, as "
+                                     + "the inputs of catchment row " + std::to_string(r) + " have not been "
+                                     + "prepared; a batched model must be the only formulation of each of its "
+                                     + "catchments, all in the same layer, and cannot be nested in a multi-BMI "
+                                     + "formulation");
+        }
+    }
+    pass_staged_values();
+    if (until_time == nullptr) {
+        bmi_model->attr("update")();
+    }
+    else {
+        bmi_model->attr("update_until")(*until_time);
+    }
+    previous_time = current_time;
+    current_time = py::float_(bmi_model->attr("get_current_time")());
+    ++steps;
+    ++row_steps[row];
+}
+
+void Bmi_Py_Batch::pass_staged_values() {
+    const std::size_t rows = num_rows();
+    for (auto &entry : staged) {
+        staged_values &stage = entry.second;
+        if (stage.set_count == 0) {
+            continue;
+        }
+        const variable &info = get_variable(entry.first);
+        const std::size_t row_items = info.row_nbytes / info.item_size;
+        if (stage.is_set.size() != rows) {
+            stage.values.resize(rows * info.row_nbytes);
+            stage.is_set.resize(rows, false);
+        }
+        if (stage.set_count == rows) {
+            bmi_model->attr("set_value")(entry.first, to_numpy(info, stage.values.data(), rows * row_items));
+        }
+        else {
+            std::vector<int> indices;
+            std::vector<char> values;
+            indices.reserve(stage.set_count * row_items);
+            values.reserve(stage.set_count * info.row_nbytes);
+            for (std::size_t r = 0; r < rows; ++r) {
+                if (!stage.is_set[r]) {
+                    continue;
+                }
+                for (std::size_t i = 0; i < row_items; ++i) {
+                    indices.push_back(static_cast<int>(r * row_items + i));
+                }
+                const char *row_values = &stage.values[r * info.row_nbytes];
+                values.insert(values.end(), row_values, row_values + info.row_nbytes);
+            }
+            py::array_t<int> index_array(indices.size(), indices.data());
+            bmi_model->attr("set_value_at_indices")(entry.first, index_array,
+                                                    to_numpy(info, values.data(), indices.size()));
+        }
+        std::fill(stage.is_set.begin(), stage.is_set.end(), false);
+        stage.set_count = 0;
+    }
+}
+
+py::array Bmi_Py_Batch::to_numpy(const variable &info, const char *data, std::size_t count) const {
+    // Without a base object, the array holds its own copy of the data
+    return py::array(dtype_of_cxx_type(info.cxx_type), {static_cast<py::ssize_t>(count)}, data);
+}
+
+Bmi_Py_Batch_Adapter::Bmi_Py_Batch_Adapter(const std::string &type_name, std::string bmi_init_config,
+                                           std::shared_ptr<Bmi_Py_Batch> batch, bool has_fixed_time_step)
+        : Bmi_Adapter(type_name + " (BMI Py batch)", std::move(bmi_init_config), has_fixed_time_step),
+          batch(std::move(batch))
+{
+    try {
+        row = this->batch->add_row(this->bmi_init_config);
+        model_initialized = true;
+        bmi_model_time_convert_factor = get_time_convert_factor();
+    }
+    catch (std::exception &e) {
+        model_initialized = true;
+        init_exception_msg = std::string(e.what());
+        throw std::runtime_error(init_exception_msg);
+    }
+}
+
+const std::string Bmi_Py_Batch_Adapter::get_analogous_cxx_type(const std::string &py_type_name,
+                                                                const size_t item_size) {
+    return Bmi_Py_Adapter::python_analogous_cxx_type(py_type_name, item_size);
+}
+
+void Bmi_Py_Batch_Adapter::GetValue(std::string name, void *dest) {
+    std::memcpy(dest, batch->get_row_value_ptr(name, row), GetVarNbytes(name));
+}
+
+void *Bmi_Py_Batch_Adapter::GetValuePtr(std::string name) {
+    // This row's values as last read from the model; the model does not see changes made through the pointer
+    return const_cast<void *>(batch->get_row_value_ptr(name, row));
+}
+
+void Bmi_Py_Batch_Adapter::GetValueAtIndices(std::string name, void *dest, int *inds, int count) {
+    const int item_size = GetVarItemsize(name);
+    const int row_items = GetVarNbytes(name) / item_size;
+    const char *values = static_cast<const char *>(batch->get_row_value_ptr(name, row));
+    char *dest_values = static_cast<char *>(dest);
+    for (int i = 0; i < count; ++i) {
+        if (inds[i] < 0 || inds[i] >= row_items) {
+            throw std::out_of_range("Index " + std::to_string(inds[i]) + " is out of range for variable " + name
+                                    + " of " + model_name);
+        }
+        std::memcpy(dest_values + i * item_size, values + inds[i] * item_size, item_size);
+    }
+}
+
+void Bmi_Py_Batch_Adapter::SetValueAtIndices(std::string name, int *inds, int count, void *src) {
+    const int item_size = GetVarItemsize(name);
+    const int row_nbytes = GetVarNbytes(name);
+    const int row_items = row_nbytes / item_size;
+    const char *current = static_cast<const char *>(batch->get_row_value_ptr(name, row));
+    std::vector<char> values(current, current + row_nbytes);
+    const char *src_values = static_cast<const char *>(src);
+    for (int i = 0; i < count; ++i) {
+        if (inds[i] < 0 || inds[i] >= row_items) {
+            throw std::out_of_range("Index " + std::to_string(inds[i]) + " is out of range for variable " + name
+                                    + " of " + model_name);
+        }
+        std::memcpy(&values[inds[i] * item_size], src_values + i * item_size, item_size);
+    }
+    batch->set_row_value(name, row, values.data());
+}
+
+#endif //NGEN_WITH_PYTHON
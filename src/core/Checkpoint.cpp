@@ -0,0 +1,221 @@
+#include "Checkpoint.hpp"
+
+#include <NGenConfig.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "StateStream.hpp"
+
+#if NGEN_WITH_MPI
+#include <mpi.h>
+#endif
+
+namespace
+{
+    const char checkpoint_magic[8] = {'N', 'G', 'E', 'N', 'C', 'K', 'P', 'T'};
+    const std::uint32_t checkpoint_version = 1;
+
+    /** Fixed-size start of a checkpoint file, identifying the simulation it can be restarted in */
+    struct checkpoint_prefix
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t rank;
+        std::int32_t num_ranks;
+        std::int64_t start_time;
+        std::int64_t output_interval;
+        std::int64_t next_time_index;
+        std::uint64_t num_layers;
+    };
+
+    /** Throw on every rank when @p error is set on any, so a rank failing alone never leaves the others waiting */
+    void fail_together(const std::string& error, int num_ranks)
+    {
+        int failed = error.empty() ? 0 : 1;
+#if NGEN_WITH_MPI
+        if (num_ranks > 1) {
+            MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        }
+#endif
+        if (failed) {
+            throw std::runtime_error(error.empty() ? "Checkpoint failed on another rank" : error);
+        }
+    }
+
+    /**
+     * Throw on every rank unless all of them restored the same next time step, i.e. from files of the same
+     * checkpoint rather than a mix of files left by different checkpoints of the simulation.
+     */
+    void check_same_time(long next_time_index, int num_ranks)
+    {
+#if NGEN_WITH_MPI
+        if (num_ranks > 1) {
+            long first = next_time_index;
+            long last = next_time_index;
+            MPI_Allreduce(MPI_IN_PLACE, &first, 1, MPI_LONG, MPI_MIN, MPI_COMM_WORLD);
+            MPI_Allreduce(MPI_IN_PLACE, &last, 1, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+            if (first != last) {
+                throw std::runtime_error("Checkpoint files of different ranks were written at different time steps ("
+                                         + std::to_string(first) + " to " + std::to_string(last)
+                                         + "), so they are not of the same checkpoint");
+            }
+        }
+#endif
+    }
+
+    void write_rank(const std::string& prefix, int rank, int num_ranks, Simulation_Time& time, long next_time_index,
+                    std::vector<std::shared_ptr<ngen::Layer>>& layers, ngen::Layer::feature_type& features)
+    {
+        const std::string path = ngen::checkpoint::rank_path(prefix, rank);
+        const std::string temp_path = path + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot write checkpoint file " + temp_path);
+            }
+            checkpoint_prefix header{};
+            std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+            header.version = checkpoint_version;
+            header.rank = rank;
+            header.num_ranks = num_ranks;
+            header.start_time = time.get_start_epoch_time();
+            header.output_interval = time.get_output_interval_seconds();
+            header.next_time_index = next_time_index;
+            header.num_layers = layers.size();
+            utils::state::write(out, header);
+
+            try {
+                for (auto& layer : layers) {
+                    utils::state::write_string(out, layer->get_name());
+                    layer->write_state(out);
+                }
+
+                std::vector<std::string> nexus_ids;
+                for (const auto& id : features.nexuses()) {
+                    if (features.nexus_at(id) != nullptr) {
+                        nexus_ids.push_back(id);
+                    }
+                }
+                utils::state::write<std::uint64_t>(out, nexus_ids.size());
+                for (const auto& id : nexus_ids) {
+                    utils::state::write_string(out, id);
+                    features.nexus_at(id)->write_state(out);
+                }
+            }
+            catch (...) {
+                out.close();
+                std::remove(temp_path.c_str());
+                throw;
+            }
+
+            if (!out.flush()) {
+                out.close();
+                std::remove(temp_path.c_str());
+                throw std::runtime_error("Failed writing checkpoint file " + temp_path);
+            }
+        }
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            throw std::runtime_error("Cannot move checkpoint file into place at " + path);
+        }
+    }
+
+    long read_rank(const std::string& prefix, int rank, int num_ranks, Simulation_Time& time,
+                   std::vector<std::shared_ptr<ngen::Layer>>& layers, ngen::Layer::feature_type& features)
+    {
+        const std::string path = ngen::checkpoint::rank_path(prefix, rank);
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Cannot read checkpoint file " + path);
+        }
+
+        auto header = utils::state::read<checkpoint_prefix>(in);
+        if (std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0 || header.version != checkpoint_version) {
+            throw std::runtime_error(path + " is not a checkpoint file of this version of ngen");
+        }
+        if (header.rank != rank || header.num_ranks != num_ranks) {
+            throw std::runtime_error("Checkpoint file " + path + " is of rank " + std::to_string(header.rank) + " of "
+                                     + std::to_string(header.num_ranks) + ", but is being restarted as rank "
+                                     + std::to_string(rank) + " of " + std::to_string(num_ranks));
+        }
+        if (header.start_time != time.get_start_epoch_time() || header.output_interval != time.get_output_interval_seconds()) {
+            throw std::runtime_error("Checkpoint file " + path + " is of a simulation with a different start time or "
+                                     "output interval");
+        }
+        if (header.num_layers != layers.size()) {
+            throw std::runtime_error("Checkpoint file " + path + " holds " + std::to_string(header.num_layers)
+                                     + " layers, but the simulation has " + std::to_string(layers.size()));
+        }
+        time.set_current_time_index(header.next_time_index);
+
+        for (auto& layer : layers) {
+            utils::state::expect_string(in, layer->get_name(), "layer");
+            layer->read_state(in);
+        }
+
+        std::uint64_t num_nexuses = utils::state::read<std::uint64_t>(in);
+        for (std::uint64_t i = 0; i < num_nexuses; ++i) {
+            std::string id = utils::state::read_string(in);
+            auto nexus = features.nexus_at(id);
+            if (nexus == nullptr) {
+                throw std::runtime_error("Checkpoint file " + path + " holds nexus " + id + ", which this rank does not have");
+            }
+            nexus->read_state(in);
+        }
+        return header.next_time_index;
+    }
+}
+
+std::string ngen::checkpoint::rank_path(const std::string& prefix, int rank)
+{
+    return prefix + "_rank_" + std::to_string(rank) + ".ckpt";
+}
+
+void ngen::checkpoint::check(int num_ranks, std::vector<std::shared_ptr<Layer>>& layers)
+{
+    std::string error;
+    try {
+        for (auto& layer : layers) {
+            layer->check_state_support();
+        }
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+    }
+    fail_together(error, num_ranks);
+}
+
+void ngen::checkpoint::write(const std::string& prefix, int rank, int num_ranks, Simulation_Time& time,
+                             long next_time_index, std::vector<std::shared_ptr<Layer>>& layers,
+                             Layer::feature_type& features)
+{
+    std::string error;
+    try {
+        write_rank(prefix, rank, num_ranks, time, next_time_index, layers, features);
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+    }
+    fail_together(error, num_ranks);
+}
+
+long ngen::checkpoint::read(const std::string& prefix, int rank, int num_ranks, Simulation_Time& time,
+                            std::vector<std::shared_ptr<Layer>>& layers, Layer::feature_type& features)
+{
+    std::string error;
+    long next_time_index = 0;
+    try {
+        next_time_index = read_rank(prefix, rank, num_ranks, time, layers, features);
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+    }
+    fail_together(error, num_ranks);
+    check_same_time(next_time_index, num_ranks);
+    return next_time_index;
+}
@@ -22,6 +22,8 @@ HY_Features::HY_Features(network::Network network, std::shared_ptr<Formulation_M
       std::string feat_id;
       std::string feat_type;
       std::vector<std::string> origins, destinations;
+      //Otherwise catchment output is gathered by the layers
+      const bool csv_output = formulations->get_output_format() == "csv";
 
       for(const auto& feat_idx : network){
         feat_id = network.get_id(feat_idx);//feature->get_id();
@@ -32,10 +34,12 @@ HY_Features::HY_Features(network::Network network, std::shared_ptr<Formulation_M
         {
           //Find and prepare formulation
           auto formulation = formulations->get_formulation(feat_id);
-          formulation->set_output_stream(formulations->get_output_root() + feat_id + ".csv");
-          // TODO: add command line or config option to have this be omitted
-          //FIXME why isn't default param working here??? get_output_header_line() fails.
-          formulation->write_output("Time Step,""Time,"+formulation->get_output_header_line(",")+"\n");
+          if (csv_output) {
+            formulation->set_output_stream(formulations->get_output_root() + feat_id + ".csv");
+            // TODO: add command line or config option to have this be omitted
+            //FIXME why isn't default param working here??? get_output_header_line() fails.
+            formulation->write_output("Time Step,""Time,"+formulation->get_output_header_line(",")+"\n");
+          }
           //Find upstream nexus ids
           origins = network.get_origination_ids(feat_id);
 
@@ -58,8 +62,9 @@ HY_Features::HY_Features(network::Network network, std::shared_ptr<Formulation_M
         }
         else if(hy_features::identifiers::isNexus(feat_type))
         {
+            origins = network.get_origination_ids(feat_id);
             _nexuses.emplace(feat_id, std::make_unique<HY_PointHydroNexus>(
-                                          HY_PointHydroNexus(feat_id, destinations) ));
+                                          HY_PointHydroNexus(feat_id, destinations, origins) ));
         }
         else
         {
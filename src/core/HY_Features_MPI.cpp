@@ -27,6 +27,9 @@ HY_Features_MPI::HY_Features_MPI( PartitionData partition_data, geojson::GeoJSON
         remote_connection_direction[remote_nexi][remote_catchments] = std::get<3>(remote_tuple);
       }
 
+      //Otherwise catchment output is gathered by the layers
+      const bool csv_output = formulations->get_output_format() == "csv";
+
       for(const auto& feat_idx : network){
         feat_id = network.get_id(feat_idx);//feature->get_id();
         feat_type = feat_id.substr(0, 3);
@@ -38,10 +41,12 @@ HY_Features_MPI::HY_Features_MPI( PartitionData partition_data, geojson::GeoJSON
         {
           //Find and prepare formulation
           auto formulation = formulations->get_formulation(feat_id);
-          formulation->set_output_stream(formulations->get_output_root() + feat_id + ".csv");
-          // TODO: add command line or config option to have this be omitted
-          //FIXME why isn't default param working here??? get_output_header_line() fails.
-          formulation->write_output("Time Step,""Time,"+formulation->get_output_header_line(",")+"\n");
+          if (csv_output) {
+            formulation->set_output_stream(formulations->get_output_root() + feat_id + ".csv");
+            // TODO: add command line or config option to have this be omitted
+            //FIXME why isn't default param working here??? get_output_header_line() fails.
+            formulation->write_output("Time Step,""Time,"+formulation->get_output_header_line(",")+"\n");
+          }
           
           // get the catchment layer from the hydro fabric
           const auto& cat_json_node = linked_hydro_fabric->get_feature(feat_id);
@@ -83,6 +88,13 @@ HY_Features_MPI::HY_Features_MPI( PartitionData partition_data, geojson::GeoJSON
           std::cerr<<"HY_Features::HY_Features unknown feature identifier type "<<feat_type<<" for feature id."<<feat_id
                    <<" Skipping feature"<<std::endl;
         }
-      }	
+      }
+
+      //Aggregate the messages of all remote nexuses by neighbor rank, this is collective over all ranks
+      exchange = std::make_shared<RemoteNexusExchange>(MPI_COMM_WORLD);
+      for(auto& nexus : _nexuses){
+        exchange->add_nexus(nexus.second);
+      }
+      exchange->setup();
 }
 #endif //NGEN_WITH_MPI
@@ -0,0 +1,514 @@
+#include "Partition_Bisection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using Graph = Partition_Bisection::Graph;
+
+namespace {
+
+    /** Stop coarsening once a graph has at most this many vertices */
+    const std::size_t coarsest_size = 100;
+    /** Number of region growing attempts for the initial bisection of the coarsest graph */
+    const int initial_tries = 8;
+    /** Maximum number of refinement passes per level */
+    const int refinement_passes = 8;
+
+    double total_weight(const Graph& g)
+    {
+        return std::accumulate(g.vertex_weights.begin(), g.vertex_weights.end(), 0.0);
+    }
+
+    /**
+     * Merge vertices along their heaviest edges (heavy edge matching).
+     *
+     * @param map Set to the coarse vertex of each vertex of @p g.
+     * @return The coarse graph.
+     */
+    Graph coarsen(const Graph& g, double max_vertex_weight, std::mt19937& rng, std::vector<std::size_t>& map)
+    {
+        const std::size_t n = g.size();
+        const std::size_t none = n;
+        std::vector<std::size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        std::vector<std::size_t> match(n, none);
+        for (std::size_t v : order) {
+            if (match[v] != none) {
+                continue;
+            }
+            std::size_t best = v;
+            double best_weight = -1.0;
+            for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                std::size_t u = g.adjacency[e];
+                if (match[u] == none && g.edge_weights[e] > best_weight
+                    && g.vertex_weights[v] + g.vertex_weights[u] <= max_vertex_weight) {
+                    best = u;
+                    best_weight = g.edge_weights[e];
+                }
+            }
+            match[v] = best;
+            match[best] = v;
+        }
+
+        map.assign(n, none);
+        std::vector<std::size_t> members;
+        members.reserve(n);
+        std::size_t coarse_n = 0;
+        for (std::size_t v = 0; v < n; ++v) {
+            if (map[v] == none) {
+                map[v] = map[match[v]] = coarse_n++;
+                members.push_back(v);
+            }
+        }
+
+        Graph coarse;
+        coarse.vertex_weights.assign(coarse_n, 0.0);
+        coarse.offsets.reserve(coarse_n + 1);
+        coarse.offsets.push_back(0);
+        std::vector<std::size_t> slot(coarse_n, none);
+        for (std::size_t c = 0; c < coarse_n; ++c) {
+            std::size_t v = members[c];
+            std::size_t begin = coarse.adjacency.size();
+            for (std::size_t w : {v, match[v]}) {
+                coarse.vertex_weights[c] += g.vertex_weights[w];
+                for (std::size_t e = g.offsets[w]; e < g.offsets[w + 1]; ++e) {
+                    std::size_t cu = map[g.adjacency[e]];
+                    if (cu == c) {
+                        continue;
+                    }
+                    if (slot[cu] == none) {
+                        slot[cu] = coarse.adjacency.size();
+                        coarse.adjacency.push_back(cu);
+                        coarse.edge_weights.push_back(0.0);
+                    }
+                    coarse.edge_weights[slot[cu]] += g.edge_weights[e];
+                }
+                if (match[v] == v) {
+                    break;
+                }
+            }
+            for (std::size_t e = begin; e < coarse.adjacency.size(); ++e) {
+                slot[coarse.adjacency[e]] = none;
+            }
+            coarse.offsets.push_back(coarse.adjacency.size());
+        }
+        return coarse;
+    }
+
+    /**
+     * Fiduccia-Mattheyses refinement of a bisection.
+     *
+     * Vertices are moved in order of decreasing gain (reduction of the edge cut), each at most once per pass, as long
+     * as the receiving side stays within its maximum weight.  The pass is then rolled back to the best bisection seen.
+     * An overweight side is relieved first, taking its vertices of highest gain.
+     */
+    void refine(const Graph& g, std::vector<char>& side, const double max_weight[2])
+    {
+        const std::size_t n = g.size();
+        double weight[2] = {0.0, 0.0};
+        for (std::size_t v = 0; v < n; ++v) {
+            weight[side[v]] += g.vertex_weights[v];
+        }
+
+        std::vector<double> gain(n, 0.0);
+        double cut = 0.0;
+        for (std::size_t v = 0; v < n; ++v) {
+            for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                if (side[g.adjacency[e]] != side[v]) {
+                    gain[v] += g.edge_weights[e];
+                    cut += g.edge_weights[e];
+                }
+                else {
+                    gain[v] -= g.edge_weights[e];
+                }
+            }
+        }
+        cut /= 2.0;
+
+        auto move = [&](std::size_t v) {
+            char from = side[v];
+            side[v] = 1 - from;
+            weight[from] -= g.vertex_weights[v];
+            weight[1 - from] += g.vertex_weights[v];
+            cut -= gain[v];
+            gain[v] = -gain[v];
+            for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                std::size_t u = g.adjacency[e];
+                gain[u] += side[u] == from ? 2.0 * g.edge_weights[e] : -2.0 * g.edge_weights[e];
+            }
+        };
+        auto excess = [&]() {
+            return std::max(0.0, weight[0] - max_weight[0]) + std::max(0.0, weight[1] - max_weight[1]);
+        };
+
+        using entry = std::pair<double, std::size_t>;
+
+        // relieve an overweight side
+        for (char s = 0; s < 2; ++s) {
+            if (weight[s] <= max_weight[s]) {
+                continue;
+            }
+            std::priority_queue<entry> heap;
+            for (std::size_t v = 0; v < n; ++v) {
+                if (side[v] == s) {
+                    heap.emplace(gain[v], v);
+                }
+            }
+            while (weight[s] > max_weight[s] && !heap.empty()) {
+                std::size_t v = heap.top().second;
+                double v_gain = heap.top().first;
+                heap.pop();
+                if (side[v] != s || v_gain != gain[v]) {
+                    if (side[v] == s) {
+                        heap.emplace(gain[v], v);
+                    }
+                    continue;
+                }
+                if (weight[1 - s] + g.vertex_weights[v] > max_weight[1 - s]
+                    && weight[1 - s] + g.vertex_weights[v] >= weight[s]) {
+                    continue;
+                }
+                move(v);
+                for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                    if (side[g.adjacency[e]] == s) {
+                        heap.emplace(gain[g.adjacency[e]], g.adjacency[e]);
+                    }
+                }
+            }
+        }
+
+        const std::size_t stall_limit = std::max<std::size_t>(50, n / 100);
+        std::vector<char> locked(n, 0);
+        std::vector<std::size_t> moves;
+        for (int pass = 0; pass < refinement_passes; ++pass) {
+            std::priority_queue<entry> heap;
+            for (std::size_t v = 0; v < n; ++v) {
+                for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                    if (side[g.adjacency[e]] != side[v]) {
+                        heap.emplace(gain[v], v);
+                        break;
+                    }
+                }
+            }
+
+            double start_cut = cut, best_cut = cut, best_excess = excess();
+            std::size_t best_moves = 0;
+            moves.clear();
+            while (!heap.empty() && moves.size() - best_moves < stall_limit) {
+                std::size_t v = heap.top().second;
+                double v_gain = heap.top().first;
+                heap.pop();
+                if (locked[v] || v_gain != gain[v]) {
+                    continue;
+                }
+                char to = 1 - side[v];
+                if (weight[to] + g.vertex_weights[v] > max_weight[to]) {
+                    continue;
+                }
+                move(v);
+                locked[v] = 1;
+                moves.push_back(v);
+                for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                    std::size_t u = g.adjacency[e];
+                    if (!locked[u]) {
+                        heap.emplace(gain[u], u);
+                    }
+                }
+                double current_excess = excess();
+                if (current_excess < best_excess || (current_excess == best_excess && cut < best_cut)) {
+                    best_cut = cut;
+                    best_excess = current_excess;
+                    best_moves = moves.size();
+                }
+            }
+
+            for (std::size_t v : moves) {
+                locked[v] = 0;
+            }
+            // roll back past the best bisection of this pass
+            while (moves.size() > best_moves) {
+                move(moves.back());
+                moves.pop_back();
+            }
+            if (best_cut >= start_cut) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * Bisect the (coarsest) graph by growing a region from a seed vertex, adding the frontier vertex of highest gain
+     * until the region reaches its target weight.  The best of several seeds is kept.
+     */
+    std::vector<char> initial_bisection(const Graph& g, double target, const double max_weight[2], std::mt19937& rng)
+    {
+        const std::size_t n = g.size();
+        const double total = total_weight(g);
+        std::vector<char> best;
+        double best_cut = 0.0, best_excess = 0.0;
+
+        for (int attempt = 0; attempt < initial_tries; ++attempt) {
+            // side 1 is the grown region
+            std::vector<char> side(n, 0);
+            std::vector<double> gain(n, 0.0);
+            for (std::size_t v = 0; v < n; ++v) {
+                for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                    gain[v] -= g.edge_weights[e];
+                }
+            }
+            std::priority_queue<std::pair<double, std::size_t>> frontier;
+            std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+            double grown = 0.0;
+            while (grown < target) {
+                std::size_t v = n;
+                while (!frontier.empty()) {
+                    std::size_t u = frontier.top().second;
+                    double u_gain = frontier.top().first;
+                    frontier.pop();
+                    if (side[u] == 0 && u_gain == gain[u]) {
+                        v = u;
+                        break;
+                    }
+                }
+                if (v == n) {
+                    // start a new region, e.g. in another connected component
+                    v = pick(rng);
+                    while (side[v] != 0) {
+                        v = (v + 1) % n;
+                    }
+                }
+                if (grown > 0.0 && grown + g.vertex_weights[v] > max_weight[0]) {
+                    break;
+                }
+                side[v] = 1;
+                grown += g.vertex_weights[v];
+                for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                    std::size_t u = g.adjacency[e];
+                    gain[u] += 2.0 * g.edge_weights[e];
+                    if (side[u] == 0) {
+                        frontier.emplace(gain[u], u);
+                    }
+                }
+                if (grown >= total) {
+                    break;
+                }
+            }
+
+            // side 1 was grown to the weight of side 0 of the result
+            for (auto& s : side) {
+                s = 1 - s;
+            }
+            refine(g, side, max_weight);
+
+            double cut = 0.0, weight[2] = {0.0, 0.0};
+            for (std::size_t v = 0; v < n; ++v) {
+                weight[side[v]] += g.vertex_weights[v];
+                for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                    if (side[g.adjacency[e]] != side[v]) {
+                        cut += g.edge_weights[e];
+                    }
+                }
+            }
+            double excess = std::max(0.0, weight[0] - max_weight[0]) + std::max(0.0, weight[1] - max_weight[1]);
+            if (best.empty() || excess < best_excess || (excess == best_excess && cut < best_cut)) {
+                best = std::move(side);
+                best_cut = cut;
+                best_excess = excess;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Bisect a graph so that side 0 has about @p fraction of its total weight.
+     */
+    std::vector<char> bisect(const Graph& g, double fraction, double imbalance, std::mt19937& rng)
+    {
+        const double total = total_weight(g);
+        const double max_weight[2] = {fraction * total * (1.0 + imbalance), (1.0 - fraction) * total * (1.0 + imbalance)};
+
+        std::vector<Graph> levels;
+        std::vector<std::vector<std::size_t>> maps;
+        const Graph* current = &g;
+        while (current->size() > coarsest_size) {
+            std::vector<std::size_t> map;
+            Graph coarse = coarsen(*current, 1.5 * total / coarsest_size, rng, map);
+            if (coarse.size() > 0.95 * current->size()) {
+                break;
+            }
+            maps.push_back(std::move(map));
+            levels.push_back(std::move(coarse));
+            current = &levels.back();
+        }
+
+        std::vector<char> side = initial_bisection(*current, fraction * total, max_weight, rng);
+        for (std::size_t level = levels.size(); level-- > 0;) {
+            const Graph& finer = level == 0 ? g : levels[level - 1];
+            std::vector<char> projected(finer.size());
+            for (std::size_t v = 0; v < finer.size(); ++v) {
+                projected[v] = side[maps[level][v]];
+            }
+            side = std::move(projected);
+            refine(finer, side, max_weight);
+        }
+        return side;
+    }
+
+    /** @return The subgraph induced by @p vertices */
+    Graph induced(const Graph& g, const std::vector<std::size_t>& vertices, std::vector<std::size_t>& local)
+    {
+        const std::size_t none = g.size();
+        local.assign(g.size(), none);
+        for (std::size_t i = 0; i < vertices.size(); ++i) {
+            local[vertices[i]] = i;
+        }
+        Graph sub;
+        sub.offsets.push_back(0);
+        for (std::size_t v : vertices) {
+            sub.vertex_weights.push_back(g.vertex_weights[v]);
+            for (std::size_t e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                if (local[g.adjacency[e]] != none) {
+                    sub.adjacency.push_back(local[g.adjacency[e]]);
+                    sub.edge_weights.push_back(g.edge_weights[e]);
+                }
+            }
+            sub.offsets.push_back(sub.adjacency.size());
+        }
+        return sub;
+    }
+
+    void recursive_bisection(const Graph& g, const std::vector<std::size_t>& ids, int num_partitions, int first_partition,
+                             double imbalance, std::mt19937& rng, std::vector<int>& parts)
+    {
+        if (num_partitions == 1) {
+            for (std::size_t id : ids) {
+                parts[id] = first_partition;
+            }
+            return;
+        }
+
+        int left_partitions = num_partitions / 2;
+        std::vector<char> side = bisect(g, double(left_partitions) / num_partitions, imbalance, rng);
+
+        // each side needs at least one vertex per partition, take the lightest vertices of the other side if not
+        std::size_t needed[2] = {std::size_t(left_partitions), std::size_t(num_partitions - left_partitions)};
+        for (char s = 0; s < 2; ++s) {
+            std::size_t count = std::count(side.begin(), side.end(), s);
+            if (count >= needed[s]) {
+                continue;
+            }
+            std::vector<std::size_t> others;
+            for (std::size_t v = 0; v < g.size(); ++v) {
+                if (side[v] != s) {
+                    others.push_back(v);
+                }
+            }
+            std::sort(others.begin(), others.end(), [&](std::size_t a, std::size_t b) {
+                return g.vertex_weights[a] < g.vertex_weights[b];
+            });
+            for (std::size_t i = 0; count < needed[s]; ++i, ++count) {
+                side[others[i]] = s;
+            }
+        }
+
+        for (char s = 0; s < 2; ++s) {
+            std::vector<std::size_t> vertices, sub_ids, local;
+            for (std::size_t v = 0; v < g.size(); ++v) {
+                if (side[v] == s) {
+                    vertices.push_back(v);
+                    sub_ids.push_back(ids[v]);
+                }
+            }
+            Graph sub = induced(g, vertices, local);
+            recursive_bisection(sub, sub_ids, s == 0 ? left_partitions : num_partitions - left_partitions,
+                                s == 0 ? first_partition : first_partition + left_partitions, imbalance, rng, parts);
+        }
+    }
+}
+
+Partition_Bisection::Partition_Bisection(const std::vector<double>& vertex_weights,
+                                         const std::vector<std::pair<std::size_t, std::size_t>>& edges)
+{
+    const std::size_t n = vertex_weights.size();
+    for (double w : vertex_weights) {
+        if (!(w >= 0.0) || std::isinf(w)) {
+            throw std::invalid_argument("Partition_Bisection: vertex weights must be finite and non-negative");
+        }
+    }
+    graph.vertex_weights = vertex_weights;
+
+    std::vector<std::vector<std::pair<std::size_t, double>>> neighbors(n);
+    for (const auto& edge : edges) {
+        if (edge.first >= n || edge.second >= n) {
+            throw std::out_of_range("Partition_Bisection: edge (" + std::to_string(edge.first) + ", " +
+                                    std::to_string(edge.second) + ") references a vertex beyond " + std::to_string(n));
+        }
+        if (edge.first != edge.second) {
+            neighbors[edge.first].emplace_back(edge.second, 1.0);
+            neighbors[edge.second].emplace_back(edge.first, 1.0);
+        }
+    }
+
+    graph.offsets.push_back(0);
+    for (auto& adjacent : neighbors) {
+        std::sort(adjacent.begin(), adjacent.end());
+        for (std::size_t i = 0; i < adjacent.size(); ++i) {
+            if (i > 0 && adjacent[i].first == adjacent[i - 1].first) {
+                graph.edge_weights.back() += adjacent[i].second;
+            }
+            else {
+                graph.adjacency.push_back(adjacent[i].first);
+                graph.edge_weights.push_back(adjacent[i].second);
+            }
+        }
+        graph.offsets.push_back(graph.adjacency.size());
+    }
+}
+
+std::vector<int> Partition_Bisection::partition(int num_partitions, double imbalance) const
+{
+    if (num_partitions < 1 || std::size_t(num_partitions) > graph.size()) {
+        throw std::invalid_argument("Partition_Bisection: can not split " + std::to_string(graph.size()) +
+                                    " vertices into " + std::to_string(num_partitions) + " partitions");
+    }
+
+    // spread the allowed imbalance over the levels of bisection, as it compounds
+    int depth = int(std::ceil(std::log2(num_partitions)));
+    double level_imbalance = depth > 0 ? std::pow(1.0 + imbalance, 1.0 / depth) - 1.0 : imbalance;
+
+    std::vector<int> parts(graph.size(), 0);
+    std::vector<std::size_t> ids(graph.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    std::mt19937 rng(20240229);
+    recursive_bisection(graph, ids, num_partitions, 0, level_imbalance, rng, parts);
+    return parts;
+}
+
+double Partition_Bisection::edge_cut(const std::vector<int>& parts) const
+{
+    double cut = 0.0;
+    for (std::size_t v = 0; v < graph.size(); ++v) {
+        for (std::size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+            if (parts[graph.adjacency[e]] != parts[v]) {
+                cut += graph.edge_weights[e];
+            }
+        }
+    }
+    return cut / 2.0;
+}
+
+std::vector<double> Partition_Bisection::partition_weights(const std::vector<int>& parts, int num_partitions) const
+{
+    std::vector<double> weights(num_partitions, 0.0);
+    for (std::size_t v = 0; v < graph.size(); ++v) {
+        weights[parts[v]] += graph.vertex_weights[v];
+    }
+    return weights;
+}
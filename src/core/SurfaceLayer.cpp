@@ -1,53 +1,171 @@
 #include "SurfaceLayer.hpp"
 
+void ngen::SurfaceLayer::init_nexus_release()
+{
+    std::unordered_map<std::string, long> release_index;
+    for(const auto& id : features.nexuses())
+    {
+        #if NGEN_WITH_MPI
+        if (features.local_flow_share(id) == 0.0) { //Ensures only the receiving sides of a remote nexus actually do this...
+            continue;
+        }
+        #endif
+        release_index.emplace(id, release_ids.size());
+        release_ids.push_back(id);
+    }
+    contributor_counts.assign(release_ids.size(), 0);
+    unit_release_index.assign(processing_units.size(), -1);
+
+    for(std::size_t i = 0; i < processing_units.size(); ++i)
+    {
+        //Layer::update_models only contributes to the first destination nexus
+        for(const auto& nexus : features.destination_nexuses(processing_units[i])) {
+            if(nexus != nullptr) {
+                auto it = release_index.find(nexus->get_id());
+                if(it != release_index.end()) {
+                    unit_release_index[i] = it->second;
+                    ++contributor_counts[it->second];
+                }
+            }
+            break;
+        }
+    }
+
+    //Only release early when every contributor is local to this layer; otherwise wait for the layer to finish,
+    //as flow from other layers or other ranks may still be outstanding
+    for(std::size_t n = 0; n < release_ids.size(); ++n)
+    {
+        const auto& id = release_ids[n];
+        bool early = contributor_counts[n] > 0
+                     && contributor_counts[n] == features.nexus_at(id)->get_contributing_catchments().size();
+        #if NGEN_WITH_MPI
+        early = early && !features.is_remote_nexus(id);
+        #endif
+        if(!early) {
+            contributor_counts[n] = 0;
+        }
+    }
+    for(auto& n : unit_release_index)
+    {
+        if(n >= 0 && contributor_counts[n] == 0) {
+            n = -1;
+        }
+    }
+}
+
+void ngen::SurfaceLayer::catchment_complete(std::size_t unit_index)
+{
+    long n = unit_release_index[unit_index];
+    if(n < 0) {
+        return;
+    }
+    if(--remaining_contributors[n] == 0) {
+        release_nexus(n, output_time_index, simulation_time.get_timestamp(output_time_index));
+        released[n] = true;
+    }
+}
+
+void ngen::SurfaceLayer::release_nexus(std::size_t n, long time_index, const std::string& timestamp)
+{
+    const std::string& id = release_ids[n];
+    //Get the correct "requesting" id for downstream_flow
+    const auto& nexus = features.nexus_at(id);
+    const auto& cat_ids = nexus->get_receiving_catchments();
+    std::string cat_id;
+    if( cat_ids.size() > 0 ) {
+        //Assumes dendridic, e.g. only a single downstream...it will consume 100%  of the available flow
+        cat_id = cat_ids[0];
+    }
+    else {
+        //This is a terminal node, SHOULDN'T be remote, so ID shouldn't matter too much
+        cat_id = "terminal";
+    }
+
+    //A remote nexus may split its flow between receivers on several ranks, this rank can only request its own share
+    double percent = 100.0;
+    #if NGEN_WITH_MPI
+    percent = features.local_flow_share(id);
+    #endif
+
+    //std::cerr << "Requesting water from nexus, id = " << id << " at time = " <<time_index << ",  percent = " << percent << ", destination = " << cat_id << std::endl;
+    double contribution_at_t = nexus->get_downstream_flow(cat_id, time_index, percent);
+    if(percent < 100.0) {
+        //the output is of the total flow through the nexus
+        contribution_at_t = contribution_at_t * 100.0 / percent;
+    }
+    
+    static const std::string profile_name = "nexus";
+    utils::Profile_Scope profile(utils::Profiler::OUTPUT, profile_name);
+    if(nexus_output_writer != nullptr) {
+        auto row = nexus_output_rows.find(id);
+        if(row != nexus_output_rows.end()) {
+            nexus_output_writer->set_values(nexus_output_table, row->second, &contribution_at_t, 1);
+        }
+    }
+    if(nexus_flow_buffer != nullptr && nexus_flow_rows[n] >= 0) {
+        nexus_flow_buffer->set(nexus_flow_rows[n], time_index, contribution_at_t);
+    }
+    auto outfile = nexus_outfiles.find(id);
+    if(outfile != nexus_outfiles.end() && outfile->second.is_open()) {
+    //Not flushed per line; the files are flushed once the simulation completes
+    outfile->second << time_index << ", " << timestamp << ", " << contribution_at_t << '\n';
+    }
+    //std::cout<<"\tNexus "<<id<<" has "<<contribution_at_t<<" m^3/s"<<std::endl;
+}
+
 /***
  * @brief Run one simulation timestep for each model in this layer, then gather catchment output
+ *
+ * Nexuses are released as soon as all of their contributing catchments complete; the rest are released once every
+ * catchment of the layer is complete.
 */
 
 void ngen::SurfaceLayer::update_models()
 {
     long current_time_index = output_time_index;
+    remaining_contributors = contributor_counts;
+    released.assign(release_ids.size(), false);
     
     Layer::update_models();
 
     //At this point, could make an internal routing pass, extracting flows from nexuses and routing
     //across the flowpath to the next nexus.
-    //Once everything is updated for this timestep, dump the nexus output
-    for(const auto& id : features.nexuses()) 
+    //Once everything is updated for this timestep, dump the remaining nexus output
+    std::string current_timestamp = simulation_time.get_timestamp(current_time_index);
+    for(std::size_t n = 0; n < release_ids.size(); ++n) 
     {
-        std::string current_timestamp = simulation_time.get_timestamp(current_time_index);
-        
-        #if NGEN_WITH_MPI
-        if (!features.is_remote_sender_nexus(id)) { //Ensures only one side of the dual sided remote nexus actually doing this...
-        #endif
-
-        //Get the correct "requesting" id for downstream_flow
-        const auto& nexus = features.nexus_at(id);
-        const auto& cat_ids = nexus->get_receiving_catchments();
-        std::string cat_id;
-        if( cat_ids.size() > 0 ) {
-            //Assumes dendridic, e.g. only a single downstream...it will consume 100%  of the available flow
-            cat_id = cat_ids[0];
-        }
-        else {
-            //This is a terminal node, SHOULDN'T be remote, so ID shouldn't matter too much
-            cat_id = "terminal";
-        }
-
-        //std::cerr << "Requesting water from nexus, id = " << id << " at time = " <<current_time_index << ",  percent = 100, destination = " << cat_id << std::endl;
-        double contribution_at_t = features.nexus_at(id)->get_downstream_flow(cat_id, current_time_index, 100.0);
-        
-        if(nexus_outfiles[id].is_open()) {
-        nexus_outfiles[id] << current_time_index << ", " << current_timestamp << ", " << contribution_at_t << std::endl;
+        if(!released[n]) {
+            release_nexus(n, current_time_index, current_timestamp);
         }
+    } //done nexuses
+    if(nexus_output_writer != nullptr) {
+        //get_timestamp above set the current time to that of this timestep
+        nexus_output_writer->end_time_step(nexus_output_table, simulation_time.get_current_epoch_time());
+    }
+}
 
-        #if NGEN_WITH_MPI
-        }
-        #endif
-        //std::cout<<"\tNexus "<<id<<" has "<<contribution_at_t<<" m^3/s"<<std::endl;
+void ngen::SurfaceLayer::set_nexus_output_writer(std::shared_ptr<utils::ColumnarOutputWriter> writer, const std::vector<std::string>& ids)
+{
+    nexus_output_writer = writer;
+    nexus_output_rows.clear();
+    if(nexus_output_writer == nullptr) {
+        return;
+    }
+    for(std::size_t i = 0; i < ids.size(); ++i) {
+        nexus_output_rows.emplace(ids[i], i);
+    }
+    nexus_output_table = nexus_output_writer->add_table("nexus", ids, std::vector<std::vector<std::string>>(ids.size(), {"flow"}));
+}
 
-        //Note: Use below if developing in-memory transfer of nexus flows to routing
-        //If using below, then another single time vector would be needed to hold the timestamp
-        //nexus_flows[id].push_back(contribution_at_t); 
-    } //done nexuses
+void ngen::SurfaceLayer::set_nexus_flow_buffer(std::shared_ptr<NexusFlowBuffer> buffer)
+{
+    nexus_flow_buffer = buffer;
+    nexus_flow_rows.clear();
+    if(nexus_flow_buffer == nullptr) {
+        return;
+    }
+    nexus_flow_rows.reserve(release_ids.size());
+    for(const auto& id : release_ids) {
+        nexus_flow_rows.push_back(nexus_flow_buffer->row(id));
+    }
 }
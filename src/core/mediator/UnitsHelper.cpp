@@ -1,58 +1,118 @@
 #include "UnitsHelper.hpp"
+#include <cmath>
 #include <cstring>
 #include <mutex>
 
 ut_system* UnitsHelper::unit_system;
 std::once_flag UnitsHelper::unit_system_inited;
-std::map<std::string, std::shared_ptr<cv_converter>> UnitsHelper::converters;
-std::mutex UnitsHelper::converters_mutex;
+std::unordered_map<std::string, std::unordered_map<std::string, const UnitsHelper::conversion*>> UnitsHelper::conversions;
+std::deque<UnitsHelper::conversion> UnitsHelper::conversion_store;
+std::shared_timed_mutex UnitsHelper::conversions_mutex;
 
-std::shared_ptr<cv_converter> UnitsHelper::get_converter(const std::string& in_units, const std::string& out_units, utEncoding in_encoding, utEncoding out_encoding ){
-    if(in_units == "" || out_units == ""){
-        throw std::runtime_error("Unable to process empty units value for pairing \"" + in_units + "\" \"" + out_units + "\"");
+void UnitsHelper::conversion::convert(const double* in_values, double* out_values, size_t count) const
+{
+    if (identity) {
+        if (in_values != out_values) {
+            memcpy(out_values, in_values, sizeof(double)*count);
+        }
     }
+    else if (linear) {
+        // Simple enough for the compiler to vectorize
+        const double s = scale, o = offset;
+        for (size_t i = 0; i < count; ++i) {
+            out_values[i] = in_values[i] * s + o;
+        }
+    }
+    else {
+        cv_convert_doubles(converter.get(), in_values, count, out_values);
+    }
+}
 
-    const std::lock_guard<std::mutex> lock(converters_mutex);
-
-    std::string key = in_units + "|" + out_units; //Better solution? Good enough? Bother with nested maps?
-    if(converters.count(key) == 1){
-        if(converters[key] == nullptr){
-            // same as last throw below
-            throw std::runtime_error("Unable to convert " + in_units + " to " + out_units);
+UnitsHelper::conversion UnitsHelper::make_conversion(const std::string& in_units, const std::string& out_units, utEncoding in_encoding, utEncoding out_encoding ){
+    conversion c;
+    if(in_units == "" || out_units == ""){
+        c.error = "Unable to process empty units value for pairing \"" + in_units + "\" \"" + out_units + "\"";
+        return c;
+    }
+    if(in_units == out_units){
+        c.identity = true;
+        return c;
+    }
+    ut_unit* from = ut_parse(unit_system, in_units.c_str(), in_encoding);
+    if (from == NULL)
+    {
+        c.error = "Unable to parse in_units value " + in_units;
+        return c;
+    }
+    ut_unit* to = ut_parse(unit_system, out_units.c_str(), out_encoding);
+    if (to == NULL)
+    {
+        ut_free(from);
+        c.error = "Unable to parse out_units value " + out_units;
+        return c;
+    }
+    cv_converter* conv = ut_get_converter(from, to);
+    if (conv == NULL)
+    {
+        ut_free(from);
+        ut_free(to);
+        c.error = "Unable to convert " + in_units + " to " + out_units;
+        return c;
+    }
+    c.converter = std::shared_ptr<cv_converter>(
+        conv,
+        [from,to](cv_converter* p) {
+            cv_free(p);
+            ut_free(from); // Captured via closure!
+            ut_free(to); // Captured via closure!
         }
-        return converters[key];
-    } else {
-        ut_unit* from = ut_parse(unit_system, in_units.c_str(), in_encoding);
-        if (from == NULL)
-        {
-            throw std::runtime_error("Unable to parse in_units value " + in_units);
+    );
+
+    // Use a scale and offset instead of UDUNITS if they reproduce the conversion
+    c.offset = cv_convert_double(conv, 0.0);
+    // With an offset, measure the scale over a wide span, so the offset's rounding error doesn't carry into it
+    c.scale = c.offset == 0.0 ? cv_convert_double(conv, 1.0) : (cv_convert_double(conv, 1.0e6) - c.offset) / 1.0e6;
+    c.linear = std::isfinite(c.scale) && std::isfinite(c.offset);
+    for (double x : {-1.0e6, -273.15, 0.5, 3.0, 1.0e3, 7.0e8}) {
+        double expected = cv_convert_double(conv, x);
+        double actual = x * c.scale + c.offset;
+        if (!c.linear || !(std::fabs(actual - expected) <= 1.0e-12 * std::fmax(1.0, std::fabs(expected)))) {
+            c.linear = false;
+            break;
         }
-        ut_unit* to = ut_parse(unit_system, out_units.c_str(), out_encoding);
-        if (to == NULL)
-        {
-            ut_free(from);
-            throw std::runtime_error("Unable to parse out_units value " + out_units);
+    }
+    c.identity = c.linear && c.scale == 1.0 && c.offset == 0.0;
+    return c;
+}
+
+const UnitsHelper::conversion& UnitsHelper::get_conversion(const std::string& in_units, const std::string& out_units)
+{
+    const conversion* c = nullptr;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(conversions_mutex);
+        auto in_it = conversions.find(in_units);
+        if (in_it != conversions.end()) {
+            auto out_it = in_it->second.find(out_units);
+            if (out_it != in_it->second.end()) {
+                c = out_it->second;
+            }
         }
-        cv_converter* conv = ut_get_converter(from, to);
-        if (conv == NULL)
-        {
-            ut_free(from);
-            ut_free(to);
-            converters[key] = nullptr;
-            throw std::runtime_error("Unable to convert " + in_units + " to " + out_units);
+    }
+    if (c == nullptr) {
+        std::call_once(unit_system_inited, init_unit_system);
+        // UDUNITS parsing is not thread safe, so it is also done holding the lock
+        std::unique_lock<std::shared_timed_mutex> lock(conversions_mutex);
+        const conversion*& entry = conversions[in_units][out_units];
+        if (entry == nullptr) {
+            conversion_store.push_back(make_conversion(in_units, out_units));
+            entry = &conversion_store.back();
         }
-        auto c = std::shared_ptr<cv_converter>(
-            conv,
-            [from,to](cv_converter* p) {
-                cv_free(p);
-                ut_free(from); // Captured via closure!
-                ut_free(to); // Captured via closure!
-            }
-        );
-        converters[key] = c;
-
-        return c;
+        c = entry;
     }
+    if (!c->error.empty()) {
+        throw std::runtime_error(c->error);
+    }
+    return *c;
 }
 
 double UnitsHelper::get_converted_value(const std::string &in_units, const double &value, const std::string &out_units)
@@ -60,12 +120,7 @@ double UnitsHelper::get_converted_value(const std::string &in_units, const doubl
     if(in_units == out_units){
         return value; // Early-out optimization
     }
-    std::call_once(unit_system_inited, init_unit_system);
-
-    auto converter = get_converter(in_units, out_units);
-
-    double r = cv_convert_double(converter.get(), value);
-    return r;
+    return get_conversion(in_units, out_units).convert(value);
 }
 
 double* UnitsHelper::convert_values(const std::string &in_units, double* in_values, const std::string &out_units, double* out_values, const size_t& count)
@@ -79,12 +134,6 @@ double* UnitsHelper::convert_values(const std::string &in_units, double* in_valu
             return out_values;
         }
     }
-    std::call_once(unit_system_inited, init_unit_system);
-    
-    auto converter = get_converter(in_units, out_units);
-
-    cv_convert_doubles(converter.get(), in_values, count, out_values);
-
+    get_conversion(in_units, out_units).convert(in_values, out_values, count);
     return out_values;
 }
-
@@ -1,6 +1,7 @@
 #include "network.hpp"
 #include <boost/graph/topological_sort.hpp>
 #include <stdexcept>
+#include <algorithm>
 #include <boost/graph/reverse_graph.hpp>
 #include <boost/graph/graph_utility.hpp>
 
@@ -98,6 +99,27 @@ void Network::init_indicies(){
 
   boost::topological_sort(this->graph, std::back_inserter(this->topo_order),
                    boost::vertex_index_map(get(boost::vertex_index, this->graph)));
+
+  //topo_order is downstream first, so walk it backwards to visit every vertex after all of its upstream vertices
+  this->levels.assign(num_vertices(this->graph), 0);
+  for(auto it = this->topo_order.rbegin(); it != this->topo_order.rend(); ++it)
+  {
+    Graph::out_edge_iterator e_begin, e_end;
+    boost::tie(e_begin, e_end) = boost::out_edges(*it, this->graph);
+    for(auto e = e_begin; e != e_end; ++e)
+    {
+      auto downstream = boost::target(*e, this->graph);
+      this->levels[downstream] = std::max(this->levels[downstream], this->levels[*it] + 1);
+    }
+  }
+
+  //Stable sort of the upstream-first topological order keeps topological order within each level
+  this->level_order.assign(this->topo_order.rbegin(), this->topo_order.rend());
+  std::stable_sort(this->level_order.begin(), this->level_order.end(),
+                   [this](Graph::vertex_descriptor a, Graph::vertex_descriptor b){
+                     return this->levels[a] < this->levels[b];
+                   });
+  std::reverse(this->level_order.begin(), this->level_order.end());
 }
 
 Network::Network( geojson::GeoJSON features, std::string* link_key ){
@@ -165,6 +187,24 @@ std::string Network::get_id( Graph::vertex_descriptor idx){
   return get(boost::vertex_name, this->graph)[idx];
 }
 
+std::size_t Network::get_level(const std::string& id){
+  auto it = this->descriptor_map.find(id);
+  if( it == this->descriptor_map.end() )
+  {
+    throw std::invalid_argument( std::string("Network::get_level: No feature "+id+" in network."));
+  }
+  return this->levels[it->second];
+}
+
+std::size_t Network::num_levels(){
+  if( this->level_order.empty() )
+  {
+    return 0;
+  }
+  //level_order is sorted in descending level
+  return this->levels[this->level_order.front()] + 1;
+}
+
 std::size_t Network::size(){
   return num_vertices(this->graph);
 }
@@ -204,6 +244,9 @@ const NetworkIndexT& Network::get_sorted_index(SortOrder order, bool cache){
                     boost::vertex_index_map(get(boost::vertex_index, this->graph)));
 
     return this->tdfp_order;
+  } else if (order == SortOrder::Level) {
+    // cached by the constructor
+    return this->level_order;
   } else {
     // we know this has already been cached by the constructor
     return this->topo_order;
@@ -2,6 +2,10 @@
 
 #include <boost/exception/all.hpp>
 
+#include <algorithm>
+
+#include "StateStream.hpp"
+
 typedef boost::error_info<struct tag_errmsg, std::string> errmsg_info;
 
 struct invalid_downstream_request : public boost::exception, public std::exception
@@ -29,12 +33,17 @@ struct invalid_time_step : public boost::exception, public std::exception
   const char *what() const noexcept override { return "Time step before minimum time step requested"; }
 };
 
-HY_PointHydroNexus::HY_PointHydroNexus(std::string nexus_id, Catchments receiving_catchments) : HY_HydroNexus( nexus_id, receiving_catchments), upstream_flows()
+struct invalid_contributor : public boost::exception, public std::exception
+{
+  const char *what() const noexcept override { return "Contributor index was not issued by this nexus"; }
+};
+
+HY_PointHydroNexus::HY_PointHydroNexus(std::string nexus_id, Catchments receiving_catchments) : HY_HydroNexus( nexus_id, receiving_catchments)
 {
 
 }
 
-HY_PointHydroNexus::HY_PointHydroNexus(std::string nexus_id, Catchments receiving_catchments, Catchments contributing_catchments) : HY_HydroNexus( nexus_id, receiving_catchments, contributing_catchments), upstream_flows()
+HY_PointHydroNexus::HY_PointHydroNexus(std::string nexus_id, Catchments receiving_catchments, Catchments contributing_catchments) : HY_HydroNexus( nexus_id, receiving_catchments, contributing_catchments), contributors(get_contributing_catchments())
 {
 
 }
@@ -48,9 +57,10 @@ double HY_PointHydroNexus::get_downstream_flow(std::string catchment_id, time_st
 {
 
     if ( t < min_timestep ) BOOST_THROW_EXCEPTION(invalid_time_step());
-    if ( completed.find(t) != completed.end() ) BOOST_THROW_EXCEPTION(completed_time_step());
 
-    auto s1 = upstream_flows.find(t);
+    time_step_flows* s1 = find_slot(t);
+
+    if ( t <= completed_through || (s1 != nullptr && s1->completed) ) BOOST_THROW_EXCEPTION(completed_time_step());
 
     if ( percent_flow > 100.0)
     {
@@ -58,205 +68,316 @@ double HY_PointHydroNexus::get_downstream_flow(std::string catchment_id, time_st
 
         BOOST_THROW_EXCEPTION(invalid_downstream_request());
     }
-    else if ( s1 == upstream_flows.end() )
+    else if ( s1 == nullptr )
     {
         // there are no recorded flows for this time.
         // throw exception
 
         BOOST_THROW_EXCEPTION(request_from_empty_nexus() );
     }
+
+    double released_flux;
+    if ( !s1->summed )
+    {
+        // the flows are summed as they are added, so just mark the time step
+        // summed to prevent any further additions
+
+        s1->summed = true;
+
+        // record the total requests for this time
+        s1->total_requests = percent_flow;
+        s1->request_count = 1;
+
+        // release flux
+        released_flux = s1->upstream_total * (percent_flow / 100);
+    }
     else
     {
-        auto s2 = summed_flows.find(t);
+        // flows have been summed so some water has allready been release
 
-        if ( s2 == summed_flows.end() )
+        if ( s1->total_requests + percent_flow > 100.0 )
         {
-            // the flows have not been summed calculate the sum
-            // and store it into summed_flows
-            double sum {};
-            for(auto& n : s1->second )
-            {
-                sum += n.second;
-            }
+            // if the amount of flow allready released plus the amount
+            // of this release is greater than 100 throw an error
+            BOOST_THROW_EXCEPTION(invalid_downstream_request());
+        }
 
-            summed_flows[t] = sum;
+        // update the total_request for this timesteo
+        s1->total_requests += percent_flow;
+        ++s1->request_count;
 
-            // mark downstream request with the amount of flow requested
-            // and the catchment making the request
+        released_flux = s1->upstream_total * (percent_flow / 100.0);
+    }
 
-            flow_vector v;
-            v.push_back(flows(catchment_id,percent_flow));
-            downstream_requests[t] = v;
+    if (100.0 - s1->total_requests < 0.00005 )
+    {
+        // all water has been requested, release the slot
+        complete(*s1);
+    }
 
-            // record the total requests for this time
-            total_requests[t] = percent_flow;
+    return released_flux;
+}
 
-            // release flux
-            return sum * (percent_flow / 100);
-        }
-        else
-        {
-            // flows have been summed so some water has allready been release
+void HY_PointHydroNexus::add_upstream_flow(double val, std::string catchment_id, time_step_t t)
+{
+    // qualified, so derived nexuses overriding the indexed form don't handle this flow twice
+    HY_PointHydroNexus::add_upstream_flow(val, contributor_index(catchment_id), t);
+}
 
-            if ( total_requests[t] + percent_flow > 100.0 )
-            {
-                    // if the amount of flow allready released plus the amount
-                    // of this release is greater than 100 throw an error
-                    BOOST_THROW_EXCEPTION(invalid_downstream_request());
-            }
-            else
-            {
-                // update the total_request for this timesteo
-                total_requests[t] += percent_flow;
+std::size_t HY_PointHydroNexus::get_contributor_index(const std::string& catchment_id)
+{
+    return contributor_index(catchment_id);
+}
 
-                // add this request to recorded downstream requests
-                downstream_requests[t].push_back(flows(catchment_id,percent_flow));
+void HY_PointHydroNexus::add_upstream_flow(double val, std::size_t c, time_step_t t)
+{
+    if ( c >= contributors.size() ) BOOST_THROW_EXCEPTION(invalid_contributor());
 
-                double released_flux = summed_flows[t] * (percent_flow / 100.0);
+    if ( t < min_timestep ) BOOST_THROW_EXCEPTION(invalid_time_step());
 
-                if (100.0 - total_requests[t] < 0.00005 )
-                {
-                    // all water has been requested remove bookeeping
+    time_step_flows* s1 = find_slot(t);
 
-                    upstream_flows.erase(upstream_flows.find(t));
-                    downstream_requests.erase(downstream_requests.find(t));
-                    summed_flows.erase(summed_flows.find(t));
-                    total_requests.erase(total_requests.find(t));
+    if ( t <= completed_through || (s1 != nullptr && s1->completed) ) BOOST_THROW_EXCEPTION(completed_time_step());
 
-                    completed.emplace(t);
-                }
+    if ( s1 != nullptr && s1->summed )
+    {
+        // summed flows exist we can not add water for a time step when
+        // one or more catchments have made downstream requests
 
-                return released_flux;
-            }
-        }
+        BOOST_THROW_EXCEPTION(add_to_summed_nexus());
     }
+
+    // there may be no upstream flow for this time yet, in which case a slot is claimed for it
+    time_step_flows& slot = s1 != nullptr ? *s1 : claim_slot(t);
+
+    slot.upstream_total += val;
+    ++slot.upstream_count;
+    ++contributions[(&slot - slots.data()) * contributors.size() + c];
 }
 
-void HY_PointHydroNexus::add_upstream_flow(double val, std::string catchment_id, time_step_t t)
+std::pair<double, int> HY_PointHydroNexus::inspect_upstream_flows(time_step_t t)
 {
-     if ( t < min_timestep ) BOOST_THROW_EXCEPTION(invalid_time_step());
-    if ( completed.find(t) != completed.end() ) BOOST_THROW_EXCEPTION(completed_time_step());
-
-    auto s1 = upstream_flows.find(t);
-    if (  s1 == upstream_flows.end() )
+    time_step_flows* s1 = find_slot(t);
+    if ( s1 == nullptr || s1->completed )
     {
-        // case 1 there are no upstream flow for this time
-        // create a new vector of flow id pairs and add the current flow
-        // and catchment id to the vector then insert the vector
-
-        flow_vector v;
-        v.push_back(flows(catchment_id,val));
-         upstream_flows[t] = v;
+        return std::pair<double,long>(0.0, 0);
     }
-    else
+    return std::pair<double, long>(s1->upstream_total, s1->upstream_count);
+}
+
+std::pair<double, int> HY_PointHydroNexus::inspect_downstream_requests(time_step_t t)
+{
+    time_step_flows* s1 = find_slot(t);
+    if ( s1 == nullptr || s1->completed || !s1->summed )
     {
-        auto s2 = summed_flows.find(t);
+        return std::pair<double,long>(0.0, 0);
+    }
+    return std::pair<double, long>(s1->total_requests, s1->request_count);
+}
 
-        if ( s2 == summed_flows.end() )
-        {
-            // case 2 there are no summed flow for the time
-            // this means there have been no downstream request and we can add water
+std::string HY_PointHydroNexus::get_flow_units()
+{
+    return std::string("m3/s");
+}
 
-             s1->second.push_back(flows(catchment_id,val));
-        }
-        else
+void HY_PointHydroNexus::set_mintime(time_step_t t)
+{
+    min_timestep = t;
+
+    // remove expired time steps
+    for( auto& slot : slots )
+    {
+        if ( slot.used && slot.t < min_timestep )
         {
-            // case 3 summed flows exist we can not add water for a time step when
-            // one or more catchments have made downstream requests
+            slot.used = false;
+        }
+    }
 
-             BOOST_THROW_EXCEPTION(add_to_summed_nexus());
-         }
+    // nothing before the minimum time step may be operated on anymore
+    if ( completed_through < min_timestep - 1 )
+    {
+        completed_through = min_timestep - 1;
+    }
+    for( time_step_flows* next = find_slot(completed_through + 1); next != nullptr && next->completed; next = find_slot(completed_through + 1) )
+    {
+        ++completed_through;
     }
 }
 
-std::pair<double, int> HY_PointHydroNexus::inspect_upstream_flows(time_step_t t)
+void HY_PointHydroNexus::write_state(std::ostream& out) const
 {
-    auto s1 = upstream_flows.find(t);
-    if ( s1 == upstream_flows.end() )
+    utils::state::write<std::int64_t>(out, min_timestep);
+    utils::state::write<std::int64_t>(out, completed_through);
+
+    // only time steps that may still be operated on are kept
+    std::vector<std::size_t> active;
+    for ( std::size_t row = 0; row < slots.size(); ++row )
     {
-        return std::pair<double,long>(0.0, 0);
+        const time_step_flows& slot = slots[row];
+        if ( slot.used && slot.t >= min_timestep && slot.t > completed_through )
+        {
+            active.push_back(row);
+        }
     }
-    else
+    utils::state::write<std::uint64_t>(out, active.size());
+    for ( std::size_t row : active )
     {
-        double total_upstream_flows = 0.0;
-
-        auto& id_flow_vector = s1->second;
-        for (auto& p : id_flow_vector )
+        const time_step_flows& slot = slots[row];
+        utils::state::write<std::int64_t>(out, slot.t);
+        utils::state::write<std::uint8_t>(out, slot.completed);
+        utils::state::write<std::uint8_t>(out, slot.summed);
+        utils::state::write<std::int32_t>(out, slot.upstream_count);
+        utils::state::write<std::int32_t>(out, slot.request_count);
+        utils::state::write<double>(out, slot.upstream_total);
+        utils::state::write<double>(out, slot.total_requests);
+
+        // contributors are written by id, as those first seen after the checkpoint are added in a different order
+        std::uint64_t num_contributed = 0;
+        for ( std::size_t c = 0; c < contributors.size(); ++c )
         {
-            total_upstream_flows += p.second;
+            num_contributed += contributions[row * contributors.size() + c] != 0;
+        }
+        utils::state::write<std::uint64_t>(out, num_contributed);
+        for ( std::size_t c = 0; c < contributors.size(); ++c )
+        {
+            std::uint16_t count = contributions[row * contributors.size() + c];
+            if ( count != 0 )
+            {
+                utils::state::write_string(out, contributors[c]);
+                utils::state::write<std::uint16_t>(out, count);
+            }
         }
-
-        return std::pair<double, long>(total_upstream_flows, id_flow_vector.size() );
     }
 }
 
-std::pair<double, int> HY_PointHydroNexus::inspect_downstream_requests(time_step_t t)
+void HY_PointHydroNexus::read_state(std::istream& in)
 {
-    auto s1 = downstream_requests.find(t);
-    if ( s1 == downstream_requests.end() )
+    slots.clear();
+    contributions.clear();
+    min_timestep = utils::state::read<std::int64_t>(in);
+    completed_through = utils::state::read<std::int64_t>(in);
+
+    std::uint64_t num_active = utils::state::read<std::uint64_t>(in);
+    for ( std::uint64_t i = 0; i < num_active; ++i )
     {
-        return std::pair<double,long>(0.0, 0);
+        time_step_t t = utils::state::read<std::int64_t>(in);
+        time_step_flows& claimed = claim_slot(t);
+        claimed.completed = utils::state::read<std::uint8_t>(in) != 0;
+        claimed.summed = utils::state::read<std::uint8_t>(in) != 0;
+        claimed.upstream_count = utils::state::read<std::int32_t>(in);
+        claimed.request_count = utils::state::read<std::int32_t>(in);
+        claimed.upstream_total = utils::state::read<double>(in);
+        claimed.total_requests = utils::state::read<double>(in);
+        std::size_t row = &claimed - slots.data();
+
+        std::uint64_t num_contributed = utils::state::read<std::uint64_t>(in);
+        for ( std::uint64_t j = 0; j < num_contributed; ++j )
+        {
+            std::string id = utils::state::read_string(in);
+            std::uint16_t count = utils::state::read<std::uint16_t>(in);
+            std::size_t c = contributor_index(id);
+            contributions[row * contributors.size() + c] = count;
+        }
     }
-    else
-    {
-        double total_downstream_requests = 0.0;
+}
 
-        auto& id_request_vector = s1->second;
-        for (auto& p : id_request_vector )
+bool HY_PointHydroNexus::has_upstream_flows_from(const Catchments& ids, time_step_t t)
+{
+    time_step_flows* s1 = find_slot(t);
+    for ( const auto& id : ids )
+    {
+        auto pos = std::find(contributors.begin(), contributors.end(), id);
+        if ( s1 == nullptr || pos == contributors.end()
+             || contributions[(s1 - slots.data()) * contributors.size() + (pos - contributors.begin())] == 0 )
         {
-            total_downstream_requests += p.second;
+            return false;
         }
-
-        return std::pair<double, long>(total_downstream_requests, id_request_vector.size() );
     }
+    return true;
 }
 
-std::string HY_PointHydroNexus::get_flow_units()
+HY_PointHydroNexus::time_step_flows* HY_PointHydroNexus::find_slot(time_step_t t)
 {
-    return std::string("m3/s");
+    if ( slots.empty() || t < 0 )
+    {
+        return nullptr;
+    }
+    time_step_flows& slot = slots[static_cast<std::size_t>(t) % slots.size()];
+    return slot.used && slot.t == t ? &slot : nullptr;
 }
 
-void HY_PointHydroNexus::set_mintime(time_step_t t)
+HY_PointHydroNexus::time_step_flows& HY_PointHydroNexus::claim_slot(time_step_t t)
 {
-    min_timestep = t;
-
-    // remove expired time steps from completed
-    for( auto& t: completed)
+    if ( slots.empty() )
     {
-        if ( t < min_timestep )
+        grow();
+    }
+    while ( true )
+    {
+        std::size_t index = static_cast<std::size_t>(t) % slots.size();
+        time_step_flows& slot = slots[index];
+        // a slot can be reused once its time step can no longer be operated on
+        if ( !slot.used || slot.t < min_timestep || slot.t <= completed_through )
         {
-            completed.erase(t);
+            slot = time_step_flows{t, true, false, false, 0, 0, 0.0, 0.0};
+            std::fill_n(contributions.begin() + index * contributors.size(), contributors.size(), 0);
+            return slot;
         }
+        // the slot is held by another time step that is still active
+        grow();
     }
+}
 
-    // C++ 2014 would allow this do be done with a single lambda
-    auto l1 = [](int min_v, std::unordered_map<long,flow_vector>& v)
+std::size_t HY_PointHydroNexus::contributor_index(const std::string& catchment_id)
+{
+    // contributors are few, so a linear search is cheaper than hashing the id
+    for ( std::size_t i = 0; i < contributors.size(); ++i )
     {
-        for( auto& t: v)
+        if ( contributors[i] == catchment_id )
         {
-            if ( t.first < min_v )
-            {
-                v.erase(t.first);
-            }
+            return i;
         }
-    };
+    }
 
-    // C++ 2014 would allow this do be done with a single lambda
-    auto l2 = [](int min_v, std::unordered_map<long,double>& v)
+    // widen the contribution counts by a column for the new contributor
+    std::size_t width = contributors.size();
+    std::vector<std::uint16_t> widened(slots.size() * (width + 1), 0);
+    for ( std::size_t row = 0; row < slots.size(); ++row )
     {
-        for( auto& t: v)
-        {
-            if ( t.first < min_v )
-            {
-                v.erase(t.first);
-            }
-        }
-    };
+        std::copy_n(contributions.begin() + row * width, width, widened.begin() + row * (width + 1));
+    }
+    contributions.swap(widened);
+    contributors.push_back(catchment_id);
+    return width;
+}
 
-    // remove expired time steps from all maps
-    l1(min_timestep,downstream_requests);
-    l1(min_timestep,upstream_flows);
-    l2(min_timestep,summed_flows);
-    l2(min_timestep,total_requests);
+void HY_PointHydroNexus::complete(time_step_flows& slot)
+{
+    slot.completed = true;
+    for( time_step_flows* next = &slot; next != nullptr && next->completed && next->t == completed_through + 1; next = find_slot(completed_through + 1) )
+    {
+        ++completed_through;
+    }
+}
 
+void HY_PointHydroNexus::grow()
+{
+    // double the ring, keeping every slot that may still be operated on
+    std::size_t width = contributors.size();
+    std::vector<time_step_flows> old_slots(std::max<std::size_t>(4, 2 * slots.size()),
+                                           time_step_flows{0, false, false, false, 0, 0, 0.0, 0.0});
+    std::vector<std::uint16_t> old_contributions(old_slots.size() * width, 0);
+    old_slots.swap(slots);
+    old_contributions.swap(contributions);
+
+    for ( std::size_t row = 0; row < old_slots.size(); ++row )
+    {
+        const time_step_flows& slot = old_slots[row];
+        if ( slot.used && slot.t >= min_timestep && slot.t > completed_through )
+        {
+            std::size_t index = static_cast<std::size_t>(slot.t) % slots.size();
+            slots[index] = slot;
+            std::copy_n(old_contributions.begin() + row * width, width, contributions.begin() + index * width);
+        }
+    }
 }
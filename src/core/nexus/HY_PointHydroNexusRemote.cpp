@@ -1,12 +1,14 @@
 #include "HY_PointHydroNexusRemote.hpp"
+#include "RemoteNexusExchange.hpp"
 #include "Constants.h"
+#include "Profiler.hpp"
 
 
 #if NGEN_WITH_MPI
 
 #include <HY_Features_Ids.hpp>
-#include <chrono>
-#include <thread>
+#include <algorithm>
+#include <cmath>
 
 // TODO add loggin to this function
 
@@ -69,6 +71,12 @@ HY_PointHydroNexusRemote::HY_PointHydroNexusRemote(std::string nexus_id, Catchme
         }
     }
 
+    //When the receivers are split between ranks, the copy of a rank that only receives also knows the receivers on
+    //other ranks, to determine its share, but the flow to them is sent by the ranks with the contributing catchments
+    if( is_receiver && local_contributers.empty() ){
+        is_sender = false;
+    }
+
     if( is_sender && !is_receiver ){
         type = sender;
     }
@@ -82,6 +90,17 @@ HY_PointHydroNexusRemote::HY_PointHydroNexusRemote(std::string nexus_id, Catchme
         type = local;
     }
 
+    //Split the flow evenly between the receiving catchments, wherever they are
+    const auto& receivers = get_receiving_catchments();
+    if( !receivers.empty() ){
+        double share = 100.0 / receivers.size();
+        for(const auto& receiver : remote_receivers){
+            downstream_shares[catchment_id_to_mpi_rank.at(receiver)] += share;
+        }
+        local_share = remote_receivers.empty() ? 100.0 : share * local_receivers.size();
+        primary_copy = std::find(local_receivers.begin(), local_receivers.end(),
+                                 *std::min_element(receivers.begin(), receivers.end())) != local_receivers.end();
+    }
 }
 
 HY_PointHydroNexusRemote::HY_PointHydroNexusRemote(std::string nexus_id, Catchments receiving_catchments, catcment_location_map_t loc_map)
@@ -92,27 +111,20 @@ HY_PointHydroNexusRemote::HY_PointHydroNexusRemote(std::string nexus_id, Catchme
 
 HY_PointHydroNexusRemote::~HY_PointHydroNexusRemote()
 {
-    long wait_time = 0;
-
     // This destructore might be called after MPI_Finalize so do not attempt communication if
     // this has occured
     int mpi_finalized;
     MPI_Finalized(&mpi_finalized);
 
-    while ( (stored_receives.size() > 0 || stored_sends.size() > 0) && !mpi_finalized )
+    if ( !mpi_finalized )
     {
-        //std::cerr << "Neuxs with rank " << id << " has pending communications\n";
-
-        process_communications();
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-        wait_time += 1;
-
-        if ( wait_time > 120000 )
+        for ( auto& r : stored_receives )
         {
-            // TODO log warning message that some comunications could not complete
-
+            MPI_Wait(&r.mpi_request, MPI_STATUS_IGNORE);
+        }
+        for ( auto& s : stored_sends )
+        {
+            MPI_Wait(&s.mpi_request, MPI_STATUS_IGNORE);
         }
     }
 }
@@ -120,7 +132,7 @@ HY_PointHydroNexusRemote::~HY_PointHydroNexusRemote()
 double HY_PointHydroNexusRemote::get_downstream_flow(std::string catchment_id, time_step_t t, double percent_flow)
 {
     double remote_flow = 0.0;
-    if ( type == sender )
+    if ( type == sender && local_receivers.empty() )
     {
         //At this point, calling `get_downstream_flow` on a remote sender is undefined behaviour
         //because the `add_upstream_flow` call triggers a `send` which removes from the local accounting
@@ -128,8 +140,14 @@ double HY_PointHydroNexusRemote::get_downstream_flow(std::string catchment_id, t
         std::string msg = "Nexus "+id+" attempted to get_downstream_flow, but its communicator type is sender only.";
         throw std::runtime_error(msg);
     }
-    else if ( type == receiver || type == sender_receiver )
+    else if ( exchange != nullptr && (type == receiver || type == sender_receiver) )
+    {
+        // delivers the flows of all remote contributors for t, to this and every other nexus
+        exchange->receive(t);
+    }
+    else if ( (type == receiver || type == sender_receiver) && t > received_through )
     {
+        // every upstream rank sends once per time step, however many local receivers request flow
     	for ( int rank : upstream_ranks )
     	{
        		int status;
@@ -155,77 +173,113 @@ double HY_PointHydroNexusRemote::get_downstream_flow(std::string catchment_id, t
     	}
     	
         //std::cerr << "Waiting on receives\n";
-        while ( stored_receives.size() > 0 )
-    	{
-    		process_communications();
-    		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    	}
+        {
+            static const std::string profile_name = "HY_PointHydroNexusRemote::get_downstream_flow";
+            utils::Profile_Scope profile(utils::Profiler::MPI_WAIT, profile_name);
+            for ( auto& r : stored_receives )
+            {
+                MPI_Handle_Error( MPI_Wait(&r.mpi_request, MPI_STATUS_IGNORE) );
+            }
+        }
+        process_communications();
+        received_through = t;
     }
     
+    if ( local_share < 100.0 )
+    {
+        // this rank only holds the share of its own receivers, so scale the request of the total flow to it
+        percent_flow = percent_flow * 100.0 / local_share;
+        if ( std::abs(percent_flow - 100.0) < 0.00005 )
+        {
+            percent_flow = 100.0;
+        }
+    }
+
     return HY_PointHydroNexus::get_downstream_flow(catchment_id, t, percent_flow);
 }
 
 void HY_PointHydroNexusRemote::add_upstream_flow(double val, std::string catchment_id, time_step_t t)
+{
+	add_upstream_flow(val, get_contributor_index(catchment_id), t);
+}
+
+void HY_PointHydroNexusRemote::add_upstream_flow(double val, std::size_t contributor, time_step_t t)
 {
 	// first add flow to local copy
-	HY_PointHydroNexus::add_upstream_flow(val, catchment_id, t);
+	HY_PointHydroNexus::add_upstream_flow(val, contributor, t);
 	
 	// if we are a sender check to see if all of our upstreams have been added for the indicated time step
 	if ( type == sender || type  == sender_receiver )
 	{
-		auto& flows_for_timestep = upstream_flows[t];
-		bool all_found = true;
-		
-		// check for stored data for each contributer
-		for ( auto& id : get_local_contributing_catchments() )
-		{
-			auto pos = std::find_if(flows_for_timestep.begin(), flows_for_timestep.end(), [&id] (flows& v) { return v.first == id; } );
-			
-			if ( pos == flows_for_timestep.end() )
-			{
-				all_found = false;
-				break;
-			}
-		}
-		
 		// if we have all of our upstreams for this time step send the data
-		if ( all_found )
+		if ( has_upstream_flows_from(get_local_contributing_catchments(), t) )
 		{
-		    // allocate the message buffer
-		    stored_sends.resize(stored_sends.size() + 1);
-		    stored_sends.back().buffer = std::make_shared<time_step_and_flow_t>();
-
-		    // fill the message buffer
-		    stored_sends.back().buffer->time_step = t;
-		    stored_sends.back().buffer->catchment_id = std::stoi( id.substr( id.find(hy_features::identifiers::seperator)+1 ) );
-
-		    // get the correct amount of flow using the inherted function this means are local bookkeeping is accurate
-		    stored_sends.back().buffer->flow = HY_PointHydroNexus::get_downstream_flow(id, t, 100.0);;
-
-		    int tag = extract(id);
-
-		    //Send downstream_flow from this Upstream Remote Nexus to the Downstream Remote Nexus
-		    MPI_Isend(
-		        stored_sends.back().buffer.get(),
-		        1,
-		        time_step_and_flow_type,
-		        *downstream_ranks.begin(), //TODO currently only support a SINGLE downstream message pairing
-		        tag,
-		        MPI_COMM_WORLD,
-		        &stored_sends.back().mpi_request);
-		        
-		    //std::cerr << "Creating send with target_rank=" << *downstream_ranks.begin() << " on tag=" << tag << "\n";	
-		        
-		    
-		    while ( stored_sends.size() > 0 )
+		    std::vector<std::pair<int, double>> outgoing;
+		    if ( local_receivers.empty() )
+		    {
+		        // all water leaves this rank, get the correct amount of flow using the inherted function this means are local bookkeeping is accurate
+		        for ( const auto& share : downstream_shares )
+		        {
+		            outgoing.emplace_back(share.first, HY_PointHydroNexus::get_downstream_flow(id, t, share.second));
+		        }
+		    }
+		    else
 		    {
-		    	process_communications();  
-		    	std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		    }		
+		        // local receivers request their share later, possibly after remote flows are added, so the shares
+		        // leaving this rank are recorded as a negative contribution rather than as requests
+		        double local_flow = inspect_upstream_flows(t).first;
+		        double sent = 0.0;
+		        for ( const auto& share : downstream_shares )
+		        {
+		            outgoing.emplace_back(share.first, local_flow * (share.second / 100.0));
+		            sent += outgoing.back().second;
+		        }
+		        HY_PointHydroNexus::add_upstream_flow(-sent, id, t);
+		    }
+
+		    for ( const auto& flow : outgoing )
+		    {
+		        send(flow.first, t, flow.second);
+		    }
 		}
 	}
 }
 
+void HY_PointHydroNexusRemote::send(int rank, time_step_t t, double flow)
+{
+    if ( exchange != nullptr )
+    {
+        exchange->send(id, rank, t, flow);
+        return;
+    }
+
+    // allocate the message buffer
+    stored_sends.resize(stored_sends.size() + 1);
+    stored_sends.back().buffer = std::make_shared<time_step_and_flow_t>();
+
+    // fill the message buffer
+    stored_sends.back().buffer->time_step = t;
+    stored_sends.back().buffer->catchment_id = extract(id);
+    stored_sends.back().buffer->flow = flow;
+
+    int tag = extract(id);
+
+    //Send downstream_flow from this Upstream Remote Nexus to the Downstream Remote Nexus
+    MPI_Isend(
+        stored_sends.back().buffer.get(),
+        1,
+        time_step_and_flow_type,
+        rank,
+        tag,
+        MPI_COMM_WORLD,
+        &stored_sends.back().mpi_request);
+
+    //std::cerr << "Creating send with target_rank=" << rank << " on tag=" << tag << "\n";
+
+    // the send completes in the background, only release the buffers of sends that already have
+    process_communications();
+}
+
 void HY_PointHydroNexusRemote::process_communications()
 {
     int flag;                                      // boolean value for if a request has completed
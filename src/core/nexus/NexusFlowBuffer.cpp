@@ -0,0 +1,125 @@
+#include "NexusFlowBuffer.hpp"
+
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+NexusFlowBuffer::NexusFlowBuffer(std::vector<std::string> ids, std::size_t num_times, long first_time) :
+    nexus_ids(std::move(ids)),
+    times(num_times),
+    first_time(first_time),
+    flows(nexus_ids.size() * num_times, std::numeric_limits<double>::quiet_NaN())
+{
+    rows.reserve(nexus_ids.size());
+    for(std::size_t i = 0; i < nexus_ids.size(); ++i) {
+        rows.emplace(nexus_ids[i], i);
+    }
+}
+
+long NexusFlowBuffer::row(const std::string& id) const
+{
+    auto it = rows.find(id);
+    return it == rows.end() ? -1 : static_cast<long>(it->second);
+}
+
+void NexusFlowBuffer::start_window(long first_time, std::size_t num_times)
+{
+    this->first_time = first_time;
+    times = num_times;
+    flows.assign(nexus_ids.size() * num_times, std::numeric_limits<double>::quiet_NaN());
+}
+
+NexusFlowBuffer NexusFlowBuffer::take_window()
+{
+    NexusFlowBuffer window(nexus_ids, 0, first_time);
+    window.times = times;
+    window.flows = take_flows();
+    return window;
+}
+
+std::vector<double> NexusFlowBuffer::take_flows()
+{
+    std::vector<double> taken;
+    taken.swap(flows);
+    times = 0;
+    return taken;
+}
+
+#if NGEN_WITH_MPI
+void NexusFlowBuffer::gather(int root, MPI_Comm comm)
+{
+    int rank = 0, num_procs = 1;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &num_procs);
+
+    //Ids are sent as one block of null-terminated strings
+    std::string joined_ids;
+    for(const auto& id : nexus_ids) {
+        joined_ids.append(id);
+        joined_ids.push_back('\0');
+    }
+
+    //Sizes are gathered as 64 bits, so that totals too large for an MPI count are caught rather than wrapped
+    unsigned long long counts[3] = { times, joined_ids.size(), flows.size() };
+    std::vector<unsigned long long> rank_counts(rank == root ? 3 * num_procs : 0);
+    MPI_Gather(counts, 3, MPI_UNSIGNED_LONG_LONG, rank_counts.data(), 3, MPI_UNSIGNED_LONG_LONG, root, comm);
+
+    std::string error;
+    std::vector<int> id_counts, id_offsets, flow_counts, flow_offsets;
+    std::vector<char> all_ids;
+    std::vector<double> all_flows;
+    if(rank == root) {
+        const unsigned long long max_count = std::numeric_limits<int>::max();
+        unsigned long long total_ids = 0, total_flows = 0;
+        for(int r = 0; r < num_procs && error.empty(); ++r) {
+            if(rank_counts[3 * r] != times) {
+                error = "Rank " + std::to_string(r) + " has " + std::to_string(rank_counts[3 * r])
+                        + " nexus flow time steps, but rank " + std::to_string(root) + " has " + std::to_string(times);
+            }
+            total_ids += rank_counts[3 * r + 1];
+            total_flows += rank_counts[3 * r + 2];
+        }
+        if(error.empty() && (total_ids > max_count || total_flows > max_count)) {
+            error = "Nexus flows of all ranks hold " + std::to_string(total_flows) + " values and "
+                    + std::to_string(total_ids) + " id characters, more than the " + std::to_string(max_count)
+                    + " a single gather can hold; route in chunks instead";
+        }
+        if(error.empty()) {
+            for(int r = 0; r < num_procs; ++r) {
+                id_counts.push_back(static_cast<int>(rank_counts[3 * r + 1]));
+                flow_counts.push_back(static_cast<int>(rank_counts[3 * r + 2]));
+            }
+            id_offsets.resize(num_procs);
+            flow_offsets.resize(num_procs);
+            std::partial_sum(id_counts.begin(), id_counts.end() - 1, id_offsets.begin() + 1);
+            std::partial_sum(flow_counts.begin(), flow_counts.end() - 1, flow_offsets.begin() + 1);
+            all_ids.resize(total_ids);
+            all_flows.resize(total_flows);
+        }
+    }
+    //Every rank fails together, as a rank left waiting in the gathers below would never return
+    int failed = error.empty() ? 0 : 1;
+    MPI_Bcast(&failed, 1, MPI_INT, root, comm);
+    if(failed) {
+        throw std::runtime_error(rank == root ? error : "Nexus flows could not be gathered on rank " + std::to_string(root));
+    }
+
+    MPI_Gatherv(joined_ids.data(), static_cast<int>(counts[1]), MPI_CHAR, all_ids.data(), id_counts.data(),
+                id_offsets.data(), MPI_CHAR, root, comm);
+    MPI_Gatherv(flows.data(), static_cast<int>(counts[2]), MPI_DOUBLE, all_flows.data(), flow_counts.data(),
+                flow_offsets.data(), MPI_DOUBLE, root, comm);
+
+    if(rank != root) {
+        return;
+    }
+    nexus_ids.clear();
+    rows.clear();
+    for(std::size_t start = 0; start < all_ids.size(); ) {
+        std::string id(all_ids.data() + start);
+        start += id.size() + 1;
+        rows.emplace(id, nexus_ids.size());
+        nexus_ids.push_back(std::move(id));
+    }
+    flows = std::move(all_flows);
+}
+#endif
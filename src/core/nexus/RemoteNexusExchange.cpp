@@ -0,0 +1,298 @@
+#include "RemoteNexusExchange.hpp"
+
+#if NGEN_WITH_MPI
+
+#include "HY_PointHydroNexusRemote.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    /** FNV-1a hash of the slot ids of a channel, used to verify both ranks agree on the slot order */
+    std::uint64_t hash_ids(const std::vector<std::shared_ptr<HY_PointHydroNexusRemote>>& nexuses)
+    {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for ( const auto& nexus : nexuses )
+        {
+            for ( char c : nexus->get_id() )
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ULL;
+            }
+            // separate ids so that e.g. {"ab", "c"} and {"a", "bc"} differ
+            hash ^= 0xff;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    void check_mpi(int status, const std::string& call)
+    {
+        if ( status != MPI_SUCCESS )
+        {
+            throw std::runtime_error("RemoteNexusExchange: " + call + " failed with MPI error " + std::to_string(status));
+        }
+    }
+}
+
+RemoteNexusExchange::RemoteNexusExchange(MPI_Comm comm)
+{
+    // a private communicator keeps these messages from matching any per-nexus messages
+    check_mpi(MPI_Comm_dup(comm, &this->comm), "MPI_Comm_dup");
+    MPI_Comm_size(this->comm, &world_size);
+}
+
+RemoteNexusExchange::~RemoteNexusExchange()
+{
+    // This destructor might be called after MPI_Finalize, in which case there is nothing left to release
+    int mpi_finalized;
+    MPI_Finalized(&mpi_finalized);
+    if ( !mpi_finalized && !finalized )
+    {
+        finalize();
+    }
+}
+
+RemoteNexusExchange::channel& RemoteNexusExchange::channel_for(std::vector<channel>& channels, std::unordered_map<int, std::size_t>& index, int rank)
+{
+    auto it = index.find(rank);
+    if ( it != index.end() )
+    {
+        return channels[it->second];
+    }
+    index[rank] = channels.size();
+    channels.emplace_back();
+    channels.back().rank = rank;
+    return channels.back();
+}
+
+void RemoteNexusExchange::add_nexus(std::shared_ptr<HY_PointHydroNexusRemote> nexus)
+{
+    if ( is_setup )
+    {
+        throw std::logic_error("RemoteNexusExchange: nexus " + nexus->get_id() + " added after setup");
+    }
+    if ( nexus->get_communicator_type() == HY_PointHydroNexusRemote::local )
+    {
+        return;
+    }
+
+    if ( nexus->is_remote_sender() )
+    {
+        for ( int rank : nexus->get_downstream_ranks() )
+        {
+            channel_for(send_channels, send_index, rank).nexuses.push_back(nexus);
+        }
+    }
+    for ( int rank : nexus->get_upstream_ranks() )
+    {
+        channel_for(receive_channels, receive_index, rank).nexuses.push_back(nexus);
+    }
+
+    nexus->set_exchange(this);
+}
+
+void RemoteNexusExchange::setup()
+{
+    if ( is_setup )
+    {
+        return;
+    }
+
+    // counts and id hashes each neighbor expects to receive from / send to this rank
+    std::vector<unsigned long long> outgoing(2 * world_size, 0), incoming(2 * world_size, 0);
+
+    auto by_id = [](const std::shared_ptr<HY_PointHydroNexusRemote>& a, const std::shared_ptr<HY_PointHydroNexusRemote>& b) {
+        return a->get_id() < b->get_id();
+    };
+
+    for ( auto* channels : { &send_channels, &receive_channels } )
+    {
+        for ( channel& c : *channels )
+        {
+            std::sort(c.nexuses.begin(), c.nexuses.end(), by_id);
+            for ( std::size_t i = 0; i < c.nexuses.size(); ++i )
+            {
+                c.slot_of[c.nexuses[i]->get_id()] = i;
+            }
+            c.buffer.assign(c.nexuses.size() + 1, 0.0);
+            c.filled.assign(c.nexuses.size(), false);
+        }
+    }
+
+    for ( const channel& c : send_channels )
+    {
+        outgoing[2 * c.rank] = c.nexuses.size();
+        outgoing[2 * c.rank + 1] = hash_ids(c.nexuses);
+    }
+
+    check_mpi(MPI_Alltoall(outgoing.data(), 2, MPI_UNSIGNED_LONG_LONG, incoming.data(), 2, MPI_UNSIGNED_LONG_LONG, comm), "MPI_Alltoall");
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    for ( int r = 0; r < world_size; ++r )
+    {
+        auto it = receive_index.find(r);
+        unsigned long long count = it == receive_index.end() ? 0 : receive_channels[it->second].nexuses.size();
+        unsigned long long hash = it == receive_index.end() ? 0 : hash_ids(receive_channels[it->second].nexuses);
+        if ( incoming[2 * r] != count || incoming[2 * r + 1] != hash )
+        {
+            throw std::runtime_error("RemoteNexusExchange: rank " + std::to_string(r) + " sends flows for " +
+                                     std::to_string(incoming[2 * r]) + " nexuses to rank " + std::to_string(rank) +
+                                     ", which expects " + std::to_string(count) + " with matching ids");
+        }
+    }
+
+    for ( channel& c : send_channels )
+    {
+        check_mpi(MPI_Send_init(c.buffer.data(), c.buffer.size(), MPI_DOUBLE, c.rank, 0, comm, &c.request), "MPI_Send_init");
+    }
+    for ( channel& c : receive_channels )
+    {
+        check_mpi(MPI_Recv_init(c.buffer.data(), c.buffer.size(), MPI_DOUBLE, c.rank, 0, comm, &c.request), "MPI_Recv_init");
+        receive_requests.push_back(c.request);
+    }
+
+    // pre-post the receives of the first time step
+    if ( !receive_requests.empty() )
+    {
+        check_mpi(MPI_Startall(receive_requests.size(), receive_requests.data()), "MPI_Startall");
+    }
+
+    is_setup = true;
+}
+
+void RemoteNexusExchange::send(const std::string& nexus_id, int rank, time_step_t t, double flow)
+{
+    auto it = send_index.find(rank);
+    if ( !is_setup || finalized || it == send_index.end() )
+    {
+        throw std::logic_error("RemoteNexusExchange: no message to rank " + std::to_string(rank) + " for nexus " + nexus_id);
+    }
+    channel& c = send_channels[it->second];
+    std::size_t slot = c.slot_of.at(nexus_id);
+
+    if ( c.num_filled == 0 )
+    {
+        // the buffer can only be reused once the previous message has left it
+        if ( c.active )
+        {
+            static const std::string profile_name = "RemoteNexusExchange::send";
+            utils::Profile_Scope profile(utils::Profiler::MPI_WAIT, profile_name);
+            check_mpi(MPI_Wait(&c.request, MPI_STATUS_IGNORE), "MPI_Wait");
+            c.active = false;
+        }
+        c.buffer[0] = static_cast<double>(t);
+    }
+    else if ( c.buffer[0] != static_cast<double>(t) )
+    {
+        throw std::logic_error("RemoteNexusExchange: nexus " + nexus_id + " sent flow for time step " + std::to_string(t) +
+                               " before the flows to rank " + std::to_string(rank) + " for time step " +
+                               std::to_string(static_cast<time_step_t>(c.buffer[0])) + " were complete");
+    }
+    if ( c.filled[slot] )
+    {
+        throw std::logic_error("RemoteNexusExchange: nexus " + nexus_id + " sent flow for time step " + std::to_string(t) + " twice");
+    }
+
+    c.buffer[slot + 1] = flow;
+    c.filled[slot] = true;
+
+    if ( ++c.num_filled == c.nexuses.size() )
+    {
+        check_mpi(MPI_Start(&c.request), "MPI_Start");
+        c.active = true;
+        c.num_filled = 0;
+        std::fill(c.filled.begin(), c.filled.end(), false);
+    }
+}
+
+void RemoteNexusExchange::receive(time_step_t t)
+{
+    if ( !is_setup || finalized )
+    {
+        throw std::logic_error("RemoteNexusExchange: receive called without an active exchange");
+    }
+
+    while ( received_through < t )
+    {
+        if ( receive_requests.empty() )
+        {
+            received_through = t;
+            return;
+        }
+
+        {
+            static const std::string profile_name = "RemoteNexusExchange::receive";
+            utils::Profile_Scope profile(utils::Profiler::MPI_WAIT, profile_name);
+            check_mpi(MPI_Waitall(receive_requests.size(), receive_requests.data(), MPI_STATUSES_IGNORE), "MPI_Waitall");
+        }
+
+        time_step_t message_t = static_cast<time_step_t>(receive_channels.front().buffer[0]);
+        for ( channel& c : receive_channels )
+        {
+            if ( static_cast<time_step_t>(c.buffer[0]) != message_t )
+            {
+                throw std::runtime_error("RemoteNexusExchange: received flows for time step " +
+                                         std::to_string(static_cast<time_step_t>(c.buffer[0])) + " from rank " +
+                                         std::to_string(c.rank) + " while expecting time step " + std::to_string(message_t));
+            }
+            for ( std::size_t i = 0; i < c.nexuses.size(); ++i )
+            {
+                // the remote contributors of a nexus are accounted for under the id of the nexus itself
+                c.nexuses[i]->HY_PointHydroNexus::add_upstream_flow(c.buffer[i + 1], c.nexuses[i]->get_id(), message_t);
+            }
+        }
+        received_through = message_t;
+
+        // persistent requests stay in place, only their activation is repeated
+        check_mpi(MPI_Startall(receive_requests.size(), receive_requests.data()), "MPI_Startall");
+    }
+}
+
+void RemoteNexusExchange::finalize()
+{
+    if ( finalized )
+    {
+        return;
+    }
+
+    for ( channel& c : send_channels )
+    {
+#ifndef NGEN_QUIET
+        if ( c.num_filled != 0 )
+        {
+            std::cerr << "Warning: RemoteNexusExchange: incomplete flows for time step "
+                      << static_cast<time_step_t>(c.buffer[0]) << " were never sent to rank " << c.rank << std::endl;
+        }
+#endif
+        if ( c.active )
+        {
+            MPI_Wait(&c.request, MPI_STATUS_IGNORE);
+        }
+        if ( c.request != MPI_REQUEST_NULL )
+        {
+            MPI_Request_free(&c.request);
+        }
+    }
+    if ( is_setup )
+    {
+        // the receives for the time step after the last one are always pending
+        for ( MPI_Request& request : receive_requests )
+        {
+            MPI_Cancel(&request);
+        }
+        MPI_Waitall(receive_requests.size(), receive_requests.data(), MPI_STATUSES_IGNORE);
+        for ( MPI_Request& request : receive_requests )
+        {
+            MPI_Request_free(&request);
+        }
+    }
+    MPI_Comm_free(&comm);
+    finalized = true;
+}
+
+#endif // NGEN_WITH_MPI
@@ -1,6 +1,7 @@
 #include "DataProvider.hpp"
 #include <chrono>
 #include <forcing/ForcingsEngineLumpedDataProvider.hpp>
+#include <utilities/Profiler.hpp>
 
 namespace data_access {
 
@@ -74,6 +75,9 @@ Provider::data_type Provider::get_value(
     data_access::ReSampleMethod m
 )
 {
+    static const std::string profile_name = "ForcingsEngineLumpedDataProvider::get_value";
+    utils::Profile_Scope profile(utils::Profiler::FORCING, profile_name);
+
     assert(divide_id_ == convert_divide_id_stoi(selector.get_id()));
 
     auto variable = ensure_variable(selector.get_variable_name());
@@ -110,6 +114,9 @@ std::vector<Provider::data_type> Provider::get_values(
     data_access::ReSampleMethod /* unused */
 )
 {
+    static const std::string profile_name = "ForcingsEngineLumpedDataProvider::get_values";
+    utils::Profile_Scope profile(utils::Profiler::FORCING, profile_name);
+
     assert(divide_id_ == convert_divide_id_stoi(selector.get_id()));
 
     auto variable = ensure_variable(selector.get_variable_name());
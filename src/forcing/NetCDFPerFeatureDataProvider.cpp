@@ -2,22 +2,24 @@
 
 #if NGEN_WITH_NETCDF
 #include "NetCDFPerFeatureDataProvider.hpp"
+#include "Profiler.hpp"
 
 #include <netcdf>
+#include <tuple>
 
 std::mutex data_access::NetCDFPerFeatureDataProvider::shared_providers_mutex;
 std::map<std::string, std::shared_ptr<data_access::NetCDFPerFeatureDataProvider>> data_access::NetCDFPerFeatureDataProvider::shared_providers;
 
 namespace data_access {
 
-std::shared_ptr<NetCDFPerFeatureDataProvider> NetCDFPerFeatureDataProvider::get_shared_provider(std::string input_path, time_t sim_start, time_t sim_end, utils::StreamHandler log_s)
+std::shared_ptr<NetCDFPerFeatureDataProvider> NetCDFPerFeatureDataProvider::get_shared_provider(std::string input_path, time_t sim_start, time_t sim_end, utils::StreamHandler log_s, std::size_t block_size, std::size_t prefetch_blocks)
 {
     const std::lock_guard<std::mutex> lock(shared_providers_mutex);
     std::shared_ptr<NetCDFPerFeatureDataProvider> p;
     if(shared_providers.count(input_path) > 0){
         p = shared_providers[input_path];
     } else {
-        p = std::make_shared<data_access::NetCDFPerFeatureDataProvider>(input_path, sim_start, sim_end, log_s);
+        p = std::make_shared<data_access::NetCDFPerFeatureDataProvider>(input_path, sim_start, sim_end, log_s, block_size, prefetch_blocks);
         shared_providers[input_path] = p;
     }
     return p;
@@ -30,9 +32,11 @@ void NetCDFPerFeatureDataProvider::cleanup_shared_providers()
     shared_providers.clear();
 }
 
-NetCDFPerFeatureDataProvider::NetCDFPerFeatureDataProvider(std::string input_path, time_t sim_start, time_t sim_end,  utils::StreamHandler log_s) : log_stream(log_s), value_cache(20),
+NetCDFPerFeatureDataProvider::NetCDFPerFeatureDataProvider(std::string input_path, time_t sim_start, time_t sim_end,  utils::StreamHandler log_s, std::size_t block_size, std::size_t prefetch_blocks) : log_stream(log_s),
     sim_start_date_time_epoch(sim_start),
-    sim_end_date_time_epoch(sim_end)
+    sim_end_date_time_epoch(sim_end),
+    block_size(block_size),
+    prefetch_blocks(prefetch_blocks)
 {
     //size_t sizep = 1073741824, nelemsp = 202481;
     //float preemptionp = 0.75;
@@ -104,8 +108,11 @@ NetCDFPerFeatureDataProvider::NetCDFPerFeatureDataProvider(std::string input_pat
 
     auto num_ids = id_dim.getSize();
 
-    //TODO: split into smaller slices if num_ids is large.
-    cache_slice_c_size = num_ids;
+    // Blocks span all catchments, so keep them to a bounded size for large domains
+    if ( this->block_size == 0 )
+    {
+        this->block_size = std::max<std::size_t>(1, std::min<std::size_t>(24, (std::size_t(1) << 22) / std::max<std::size_t>(num_ids, 1)));
+    }
 
     // allocate an array of character pointers 
     std::vector< char* > string_buffers(num_ids);
@@ -260,12 +267,22 @@ NetCDFPerFeatureDataProvider::NetCDFPerFeatureDataProvider(std::string input_pat
     stop_time = time_vals.back() + time_stride;
 
     sim_to_data_time_offset = sim_start_date_time_epoch - start_time;
+
+    // From here on, the file is only read by the prefetcher's thread
+    if ( prefetch_blocks > 0 )
+    {
+        prefetcher = std::make_unique<utils::Prefetcher<block_key, value_block>>(
+            [this](const block_key& key) { return read_block(key); },
+            prefetch_blocks * variable_names.size());
+    }
 }
 
 NetCDFPerFeatureDataProvider::~NetCDFPerFeatureDataProvider() = default;
 
 void NetCDFPerFeatureDataProvider::finalize()
 {
+    // Stop any background read before closing the file
+    prefetcher = nullptr;
     if (nc_file != nullptr) {
         nc_file->close();
     }
@@ -321,6 +338,14 @@ size_t NetCDFPerFeatureDataProvider::get_ts_index_for_time(const time_t &epoch_t
 
 double NetCDFPerFeatureDataProvider::get_value(const CatchmentAggrDataSelector& selector, ReSampleMethod m) 
 {
+    // Includes time spent waiting for other catchments' reads
+    static const std::string profile_name = "NetCDFPerFeatureDataProvider::get_value";
+    utils::Profile_Scope profile(utils::Profiler::FORCING, profile_name);
+
+    // Shared by all catchments, which may be executing concurrently; neither the caches nor the NetCDF library are
+    // safe for concurrent access
+    const std::lock_guard<std::mutex> lock(read_mutex);
+
     auto init_time = selector.get_init_time();
     auto stop_time = init_time + selector.get_duration_secs(); // scope hiding! BAD JUJU!
     
@@ -333,73 +358,46 @@ double NetCDFPerFeatureDataProvider::get_value(const CatchmentAggrDataSelector&
         idx2 = get_ts_index_for_time(this->stop_time-1); //to the edge
     }
 
-    auto stride = idx2 - idx1;
-
-    std::vector<std::size_t> start, count;
-
-    auto cat_pos = id_pos[selector.get_id()];
-
-
+    // Formulations reuse a selector for each request, so the id is looked up on the first only
+    std::size_t cat_pos;
+    if ( !selector.get_id_index(this, cat_pos) )
+    {
+        cat_pos = get_id_index(selector.get_id());
+        selector.set_id_index(this, cat_pos);
+    }
 
     double t1 = time_vals[idx1];
     double t2 = time_vals[idx2];
 
-    double rvalue = 0.0;
-    
-    auto ncvar = get_ncvar(selector.get_variable_name());
-
-    std::string native_units = get_ncvar_units(selector.get_variable_name());
-
+    // Already converted to the requested units, once for the whole block
+    const value_block& block = get_block(selector.get_variable_name(), selector.get_output_units(), idx1, idx2);
+    const double* values = &block.values[cat_pos * block.num_times + (idx1 - block.first_time_index)];
     auto read_len = idx2 - idx1 + 1;
 
-    std::vector<double> raw_values;
-    raw_values.resize(read_len);
-
-    //TODO: Currently assuming a whole variable cache slice across all catchments for a single timestep...but some stuff here to support otherwise.
-    size_t cache_slices_t_n = read_len / cache_slice_t_size; // Integer division!
-    // For reference: https://stackoverflow.com/a/72030286
-    for( size_t i = 0; i < cache_slices_t_n; i++ ) {
-        std::shared_ptr<std::vector<double>> cached;
-        int cache_t_idx = (idx1 - (idx1 % cache_slice_t_size) + i);
-        std::string key = ncvar.getName() + "|" + std::to_string(cache_t_idx);
-        if(value_cache.contains(key)){
-            cached = value_cache.get(key).get();
-        } else {
-            cached = std::make_shared<std::vector<double>>(cache_slice_c_size * cache_slice_t_size);
-            start.clear();
-            start.push_back(0); // only always 0 when cache_slice_c_size = numids!
-            start.push_back(cache_t_idx * cache_slice_t_size);
-            count.clear();
-            count.push_back(cache_slice_c_size);
-            count.push_back(cache_slice_t_size); // Must be 1 for now!...probably...
-            ncvar.getVar(start,count,&(*cached)[0]);
-            value_cache.insert(key, cached);
-        }
-        for( size_t j = 0; j < cache_slice_t_size; j++){
-            raw_values[i+j] = cached->at((j*cache_slice_t_size) + cat_pos);
-        }
-    }
-
-    
-    rvalue = 0.0;
+    double rvalue = 0.0;
+    double weight = 0.0;
 
     double a , b = 0.0;
     
     a = 1.0 - ( (t1 - init_time) / time_stride );
-    rvalue += (a * raw_values[0]);
+    rvalue += (a * values[0]);
+    weight += a;
 
-    for( size_t i = 1; i < raw_values.size() -1; ++i )
+    for( size_t i = 1; i < read_len -1; ++i )
     {
-        rvalue += raw_values[i];
+        rvalue += values[i];
+        weight += 1.0;
     }
 
-    if (  raw_values.size() > 1) // likewise the last data value may not be fully in the window
+    if (  read_len > 1) // likewise the last data value may not be fully in the window
     {
         b = (stop_time - t2) / time_stride;
-        rvalue += (b * raw_values.back() );
+        rvalue += (b * values[read_len - 1] );
+        weight += b;
     }
 
     // account for the resampling methods
+    double scale_factor = 1.0;
     switch(m)
     {
         case SUM:   // we allready have the sum so do nothing
@@ -412,7 +410,7 @@ double NetCDFPerFeatureDataProvider::get_value(const CatchmentAggrDataSelector&
             // the data values where allready scaled for where there was only partial use of a data value
             // so we just need to do a final scale to account for the differnce between time_stride and duration_s
 
-            double scale_factor = (selector.get_duration_secs() > time_stride ) ? (time_stride / selector.get_duration_secs()) : (1.0 / (a + b));
+            scale_factor = (selector.get_duration_secs() > time_stride ) ? (time_stride / selector.get_duration_secs()) : (1.0 / (a + b));
             rvalue *= scale_factor;
         }
         break;
@@ -421,16 +419,11 @@ double NetCDFPerFeatureDataProvider::get_value(const CatchmentAggrDataSelector&
             ;
     }
 
-    try 
-    {
-        return UnitsHelper::get_converted_value(native_units, rvalue, selector.get_output_units());
-    }
-    catch (const std::runtime_error& e)
+    // Converting before aggregating adds the offset of an affine conversion (e.g. K to degC) once per unit of weight,
+    // rather than once as when converting the aggregate
+    if ( block.zero_offset != 0.0 )
     {
-        #ifndef UDUNITS_QUIET
-        std::cerr<<"WARN: Unit conversion unsuccessful - Returning unconverted value! (\""<<e.what()<<"\")"<<std::endl;
-        #endif
-        return rvalue;
+        rvalue += block.zero_offset * (1.0 - scale_factor * weight);
     }
 
     return rvalue;
@@ -441,6 +434,21 @@ std::vector<double> NetCDFPerFeatureDataProvider::get_values(const CatchmentAggr
     return std::vector<double>(1, get_value(selector, m));
 }
 
+std::size_t NetCDFPerFeatureDataProvider::get_block_size() const
+{
+    return block_size;
+}
+
+std::size_t NetCDFPerFeatureDataProvider::get_id_index(const std::string& id) const
+{
+    auto it = id_pos.find(id);
+    if ( it == id_pos.end() )
+    {
+        throw std::out_of_range("Id " + id + " is not in the NetCDF forcing file\n" + SOURCE_LOC);
+    }
+    return it->second;
+}
+
 // private:
 
 const netCDF::NcVar& NetCDFPerFeatureDataProvider::get_ncvar(const std::string& name){
@@ -461,6 +469,99 @@ const std::string& NetCDFPerFeatureDataProvider::get_ncvar_units(const std::stri
     throw std::runtime_error("Got units request for variable " + name + " but it was not found in the cache. This should not happen." + SOURCE_LOC);
 }
 
+const NetCDFPerFeatureDataProvider::value_block& NetCDFPerFeatureDataProvider::get_block(const std::string& name, const std::string& units, std::size_t first, std::size_t last)
+{
+    auto blocks = value_blocks.find(name);
+    if ( blocks != value_blocks.end() )
+    {
+        for ( const value_block& block : blocks->second )
+        {
+            if ( block.units == units && block.first_time_index <= first && last < block.first_time_index + block.num_times )
+            {
+                return block;
+            }
+        }
+    }
+
+    // One hyperslab read of every catchment for the block's time steps
+    block_key key{name, units, first, std::min(std::max(block_size, last - first + 1), time_vals.size() - first)};
+    value_block loaded;
+    if ( prefetcher == nullptr )
+    {
+        loaded = read_block(key);
+    }
+    else
+    {
+        loaded = prefetcher->take(key);
+
+        // Read ahead the blocks of this variable that follow, dropping any requested for a position no longer needed
+        std::vector<block_key> next;
+        for ( std::size_t n = first + key.num_times; next.size() < prefetch_blocks && n < time_vals.size(); n += next.back().num_times )
+        {
+            next.push_back(block_key{name, units, n, std::min(block_size, time_vals.size() - n)});
+        }
+        prefetcher->discard_if([&](const block_key& k) {
+            return k.name == name && k.units == units && std::find(next.begin(), next.end(), k) == next.end();
+        });
+        for ( const block_key& k : next )
+        {
+            prefetcher->request(k);
+        }
+    }
+
+    // Replace the previous block of the variable in these units, if any
+    std::vector<value_block>& variable_blocks = value_blocks[name];
+    auto block = std::find_if(variable_blocks.begin(), variable_blocks.end(), [&](const value_block& b) { return b.units == units; });
+    if ( block == variable_blocks.end() )
+    {
+        variable_blocks.push_back(std::move(loaded));
+        return variable_blocks.back();
+    }
+    *block = std::move(loaded);
+    return *block;
+}
+
+NetCDFPerFeatureDataProvider::value_block NetCDFPerFeatureDataProvider::read_block(const block_key& key)
+{
+    static const std::string profile_name = "NetCDFPerFeatureDataProvider::read_block";
+    utils::Profile_Scope profile(utils::Profiler::FORCING, profile_name);
+
+    auto ncvar = get_ncvar(key.name);
+    const std::string& native_units = get_ncvar_units(key.name);
+
+    value_block block;
+    block.units = key.units;
+    block.first_time_index = key.first_time_index;
+    block.num_times = key.num_times;
+    block.values.resize(loc_ids.size() * key.num_times);
+    std::vector<std::size_t> start = { 0, key.first_time_index };
+    std::vector<std::size_t> count = { loc_ids.size(), key.num_times };
+    ncvar.getVar(start, count, block.values.data());
+
+    try
+    {
+        UnitsHelper::convert_values(native_units, block.values.data(), key.units, block.values.data(), block.values.size());
+        block.zero_offset = UnitsHelper::get_converted_value(native_units, 0.0, key.units);
+    }
+    catch (const std::runtime_error& e)
+    {
+        #ifndef UDUNITS_QUIET
+        std::cerr<<"WARN: Unit conversion unsuccessful - Returning unconverted value! (\""<<e.what()<<"\")"<<std::endl;
+        #endif
+    }
+    return block;
+}
+
+bool NetCDFPerFeatureDataProvider::block_key::operator<(const block_key& other) const
+{
+    return std::tie(name, units, first_time_index, num_times) < std::tie(other.name, other.units, other.first_time_index, other.num_times);
+}
+
+bool NetCDFPerFeatureDataProvider::block_key::operator==(const block_key& other) const
+{
+    return std::tie(name, units, first_time_index, num_times) == std::tie(other.name, other.units, other.first_time_index, other.num_times);
+}
+
 }
 
 #endif
@@ -0,0 +1,646 @@
+#include "FeatureBuilder.hpp"
+
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+#include <unordered_set>
+
+using namespace geojson;
+
+namespace {
+
+// Size of each read from the input stream
+constexpr std::size_t read_buffer_size = 1 << 16;
+
+/**
+ * A forward-only reader of JSON tokens, over a stream read in blocks or over text already in memory
+ *
+ * Whitespace between tokens is skipped by peek.  While a capture string is set, every character consumed (other
+ * than that skipped whitespace) is appended to it, so a value can be kept as text and parsed later.
+ */
+class json_cursor {
+    public:
+        explicit json_cursor(std::istream& input) : input(&input), buffer(read_buffer_size) {}
+
+        json_cursor(const char* begin, const char* end) : buffer_start(begin), position(begin), end(end) {}
+
+        /**
+         * Get the next character that isn't whitespace, without consuming it; '\0' at the end of the input
+         */
+        char peek() {
+            while (available() && std::isspace(static_cast<unsigned char>(*position))) {
+                ++position;
+            }
+            return available() ? *position : '\0';
+        }
+
+        /**
+         * Consume the next character that isn't whitespace, failing if it isn't ``expected``
+         */
+        void expect(char expected) {
+            if (peek() != expected) {
+                fail(std::string("expected '") + expected + "'");
+            }
+            next();
+        }
+
+        /**
+         * Consume the next character that isn't whitespace if it is ``c``
+         */
+        bool consume(char c) {
+            if (peek() != c) {
+                return false;
+            }
+            next();
+            return true;
+        }
+
+        /**
+         * Read a string, decoding its escape sequences
+         */
+        std::string read_string() {
+            expect('"');
+            std::string value;
+            for (char c = next(); c != '"'; c = next()) {
+                if (c != '\\') {
+                    value.push_back(c);
+                    continue;
+                }
+                switch (c = next()) {
+                    case 'b': value.push_back('\b'); break;
+                    case 'f': value.push_back('\f'); break;
+                    case 'n': value.push_back('\n'); break;
+                    case 'r': value.push_back('\r'); break;
+                    case 't': value.push_back('\t'); break;
+                    case 'u': append_utf8(value, read_code_point()); break;
+                    default: value.push_back(c); break;
+                }
+            }
+            return value;
+        }
+
+        /**
+         * Read the text of a number, ``true``, ``false`` or ``null``
+         */
+        std::string read_scalar() {
+            peek();
+            std::string value;
+            while (available() && is_scalar_character(*position)) {
+                value.push_back(next());
+            }
+            if (value.empty()) {
+                fail("expected a value");
+            }
+            return value;
+        }
+
+        double read_number() {
+            const std::string text = read_scalar();
+            char* parsed_end = nullptr;
+            const double value = std::strtod(text.c_str(), &parsed_end);
+            if (parsed_end != text.c_str() + text.size()) {
+                fail("expected a number, not " + text);
+            }
+            return value;
+        }
+
+        /**
+         * Skip over a value of any type, without decoding it
+         */
+        void skip_value() {
+            const char c = peek();
+            if (c == '"') {
+                skip_string();
+            }
+            else if (c == '{' || c == '[') {
+                int depth = 0;
+                do {
+                    const char token = peek();
+                    if (token == '"') {
+                        skip_string();
+                        continue;
+                    }
+                    next();
+                    if (token == '{' || token == '[') {
+                        ++depth;
+                    }
+                    else if (token == '}' || token == ']') {
+                        --depth;
+                    }
+                } while (depth > 0);
+            }
+            else {
+                read_scalar();
+            }
+        }
+
+        /**
+         * Set the string receiving consumed characters, or stop capturing with ``nullptr``
+         */
+        void capture_into(std::string* text) {
+            capture = text;
+        }
+
+        [[noreturn]] void fail(const std::string& message) const {
+            throw std::runtime_error(
+                "Invalid GeoJSON at byte " + std::to_string(buffer_offset + (position - buffer_start)) + ": " + message
+            );
+        }
+
+    private:
+        bool available() {
+            if (position == end && input != nullptr && *input) {
+                buffer_offset += end - buffer_start;
+                input->read(buffer.data(), buffer.size());
+                buffer_start = position = buffer.data();
+                end = position + input->gcount();
+            }
+            return position != end;
+        }
+
+        char next() {
+            if (!available()) {
+                fail("unexpected end of input");
+            }
+            const char c = *position++;
+            if (capture != nullptr) {
+                capture->push_back(c);
+            }
+            return c;
+        }
+
+        void skip_string() {
+            expect('"');
+            for (char c = next(); c != '"'; c = next()) {
+                if (c == '\\') {
+                    next();
+                }
+            }
+        }
+
+        unsigned long read_hex() {
+            unsigned long value = 0;
+            for (int i = 0; i < 4; ++i) {
+                const char c = next();
+                if (!std::isxdigit(static_cast<unsigned char>(c))) {
+                    fail("invalid \\u escape");
+                }
+                value = value * 16 + (std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (std::tolower(c) - 'a' + 10));
+            }
+            return value;
+        }
+
+        unsigned long read_code_point() {
+            unsigned long code_point = read_hex();
+            // A high surrogate is followed by the low surrogate of the pair
+            if (code_point >= 0xD800 && code_point < 0xDC00 && available() && *position == '\\') {
+                next();
+                if (next() != 'u') {
+                    fail("expected a low surrogate");
+                }
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (read_hex() - 0xDC00);
+            }
+            return code_point;
+        }
+
+        static void append_utf8(std::string& value, unsigned long code_point) {
+            if (code_point < 0x80) {
+                value.push_back(static_cast<char>(code_point));
+            }
+            else if (code_point < 0x800) {
+                value.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+                value.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else if (code_point < 0x10000) {
+                value.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+                value.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else {
+                value.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+                value.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+        }
+
+        static bool is_scalar_character(char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+        }
+
+        std::istream* input = nullptr;
+        std::vector<char> buffer;
+        const char* buffer_start = nullptr;
+        const char* position = nullptr;
+        const char* end = nullptr;
+        // Bytes of the input before buffer_start
+        std::size_t buffer_offset = 0;
+        std::string* capture = nullptr;
+};
+
+/**
+ * Read any value into a property tree, the way boost::property_tree::json_parser would
+ *
+ * Properties are read into property trees so that they are typed exactly as they are when the whole document is
+ * parsed into one.
+ */
+void read_tree(json_cursor& cursor, boost::property_tree::ptree& tree) {
+    const char c = cursor.peek();
+    if (c == '{') {
+        cursor.expect('{');
+        if (cursor.consume('}')) {
+            return;
+        }
+        do {
+            std::string key = cursor.read_string();
+            cursor.expect(':');
+            auto& child = tree.push_back(std::make_pair(std::move(key), boost::property_tree::ptree()))->second;
+            read_tree(cursor, child);
+        } while (cursor.consume(','));
+        cursor.expect('}');
+    }
+    else if (c == '[') {
+        cursor.expect('[');
+        if (cursor.consume(']')) {
+            return;
+        }
+        do {
+            auto& child = tree.push_back(std::make_pair(std::string(), boost::property_tree::ptree()))->second;
+            read_tree(cursor, child);
+        } while (cursor.consume(','));
+        cursor.expect(']');
+    }
+    else if (c == '"') {
+        tree.data() = cursor.read_string();
+    }
+    else {
+        tree.data() = cursor.read_scalar();
+    }
+}
+
+JSONProperty read_property(json_cursor& cursor, const std::string& key) {
+    boost::property_tree::ptree tree;
+    read_tree(cursor, tree);
+    return JSONProperty(key, tree);
+}
+
+std::vector<double> read_numbers(json_cursor& cursor) {
+    std::vector<double> values;
+    cursor.expect('[');
+    if (!cursor.consume(']')) {
+        do {
+            values.push_back(cursor.read_number());
+        } while (cursor.consume(','));
+        cursor.expect(']');
+    }
+    return values;
+}
+
+/**
+ * The positions of a "coordinates" member, and where the arrays of positions within it end
+ */
+struct coordinates {
+    std::vector<coordinate_t> points;
+    // Index in points after the last position of each array of positions, for arrays nested more deeply
+    std::vector<std::size_t> line_ends;
+    // How deeply the arrays are nested; 1 for a single position
+    int depth = 0;
+};
+
+/**
+ * Read the rest of an array of positions or of nested arrays of them, having consumed its '['
+ *
+ * @return How deeply the array is nested; 1 if it is a single position
+ */
+int read_coordinates(json_cursor& cursor, coordinates& shape) {
+    const char c = cursor.peek();
+    if (c != '[' && c != ']') {
+        // A position; any dimensions past the second are not kept
+        std::array<double, 2> position{};
+        std::size_t dimensions = 0;
+        do {
+            const double value = cursor.read_number();
+            if (dimensions < position.size()) {
+                position[dimensions] = value;
+            }
+            ++dimensions;
+        } while (cursor.consume(','));
+        cursor.expect(']');
+        if (dimensions < position.size()) {
+            cursor.fail("a position needs at least two coordinates");
+        }
+        shape.points.emplace_back(position[0], position[1]);
+        return 1;
+    }
+
+    int element_depth = 0;
+    if (!cursor.consume(']')) {
+        do {
+            cursor.expect('[');
+            element_depth = read_coordinates(cursor, shape);
+            if (element_depth == 2) {
+                shape.line_ends.push_back(shape.points.size());
+            }
+        } while (cursor.consume(','));
+        cursor.expect(']');
+    }
+    return element_depth + 1;
+}
+
+template<class Line>
+Line make_line(const coordinates& shape, std::size_t line) {
+    const std::size_t first = line == 0 ? 0 : shape.line_ends[line - 1];
+    return Line(shape.points.begin() + first, shape.points.begin() + shape.line_ends[line]);
+}
+
+/**
+ * Build a geometry from its coordinates, as build_geometry would from a property tree
+ */
+geometry make_geometry(FeatureType type, const coordinates& shape) {
+    switch (type) {
+        case FeatureType::Point:
+            if (shape.points.empty()) {
+                throw std::runtime_error("Invalid GeoJSON: Point without coordinates");
+            }
+            return shape.points[0];
+        case FeatureType::LineString:
+            return linestring_t(shape.points.begin(), shape.points.end());
+        case FeatureType::MultiPoint:
+            return multipoint_t(shape.points.begin(), shape.points.end());
+        case FeatureType::Polygon: {
+            polygon_t polygon;
+            if (!shape.line_ends.empty()) {
+                polygon.outer() = make_line<polygon_t::ring_type>(shape, 0);
+                polygon.inners().reserve(shape.line_ends.size() - 1);
+                for (std::size_t i = 1; i < shape.line_ends.size(); ++i) {
+                    polygon.inners().push_back(make_line<polygon_t::ring_type>(shape, i));
+                }
+            }
+            return polygon;
+        }
+        case FeatureType::MultiLineString: {
+            multilinestring_t lines;
+            lines.reserve(shape.line_ends.size());
+            for (std::size_t i = 0; i < shape.line_ends.size(); ++i) {
+                lines.push_back(make_line<linestring_t>(shape, i));
+            }
+            return lines;
+        }
+        case FeatureType::MultiPolygon: {
+            // Each ring becomes a polygon, as in build_multipolygon
+            multipolygon_t polygons;
+            polygons.resize(shape.line_ends.size());
+            for (std::size_t i = 0; i < shape.line_ends.size(); ++i) {
+                polygons[i].outer() = make_line<polygon_t::ring_type>(shape, i);
+            }
+            return polygons;
+        }
+        default:
+            throw std::runtime_error("Invalid GeoJSON: unsupported geometry type");
+    }
+}
+
+FeatureType get_feature_type(const std::string& geometry_type) {
+    if (geometry_type == "Point") {
+        return FeatureType::Point;
+    }
+    else if (geometry_type == "LineString") {
+        return FeatureType::LineString;
+    }
+    else if (geometry_type == "Polygon") {
+        return FeatureType::Polygon;
+    }
+    else if (geometry_type == "MultiPoint") {
+        return FeatureType::MultiPoint;
+    }
+    else if (geometry_type == "MultiLineString") {
+        return FeatureType::MultiLineString;
+    }
+    else if (geometry_type == "MultiPolygon") {
+        return FeatureType::MultiPolygon;
+    }
+    throw std::runtime_error("Invalid GeoJSON: unsupported geometry type " + geometry_type);
+}
+
+/**
+ * Read a geometry object, or only its type if ``with_coordinates`` is false
+ *
+ * @param[out] type The type of the feature holding the geometry; None for a null geometry
+ * @return The geometry, or an empty geometry of its type if its coordinates are skipped
+ */
+geometry read_geometry(json_cursor& cursor, FeatureType& type, bool with_coordinates) {
+    type = FeatureType::None;
+    if (cursor.peek() != '{') {
+        // null
+        cursor.skip_value();
+        return geometry();
+    }
+
+    std::string geometry_type;
+    coordinates shape;
+    cursor.expect('{');
+    if (!cursor.consume('}')) {
+        do {
+            const std::string key = cursor.read_string();
+            cursor.expect(':');
+            if (key == "type") {
+                geometry_type = cursor.read_string();
+            }
+            else if (key == "coordinates" && with_coordinates) {
+                cursor.expect('[');
+                shape.depth = read_coordinates(cursor, shape);
+            }
+            else {
+                cursor.skip_value();
+            }
+        } while (cursor.consume(','));
+        cursor.expect('}');
+    }
+
+    type = get_feature_type(geometry_type);
+    if (with_coordinates) {
+        return make_geometry(type, shape);
+    }
+    switch (type) {
+        case FeatureType::Point:
+            return coordinate_t(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+        case FeatureType::LineString:
+            return linestring_t();
+        case FeatureType::Polygon:
+            return polygon_t();
+        case FeatureType::MultiPoint:
+            return multipoint_t();
+        case FeatureType::MultiLineString:
+            return multilinestring_t();
+        default:
+            return multipolygon_t();
+    }
+}
+
+/**
+ * Read a feature object, as build_feature would from a property tree
+ *
+ * @param filter IDs of the features to build, or nullptr to build every feature
+ * @param geometry_text Scratch space for a geometry read before the feature's ID is known
+ * @return The feature, or nullptr if it is not in the filter
+ */
+Feature read_feature(
+    json_cursor& cursor,
+    const std::unordered_set<std::string>* filter,
+    bool with_geometry,
+    std::string& geometry_text
+) {
+    geometry geometry_object;
+    std::vector<geometry> geometry_collection;
+    FeatureType type = FeatureType::None;
+    std::string id;
+    std::vector<double> bounding_box;
+    PropertyMap properties;
+    PropertyMap foreign_members;
+    bool has_geometry_text = false;
+
+    cursor.expect('{');
+    if (!cursor.consume('}')) {
+        do {
+            std::string key = cursor.read_string();
+            cursor.expect(':');
+            if (key == "geometry") {
+                if (filter != nullptr && !with_geometry) {
+                    // Only the type is needed, so there is little to save by waiting for the ID
+                    geometry_object = read_geometry(cursor, type, false);
+                }
+                else if (filter != nullptr) {
+                    // The ID may only be known once the properties are read, so keep the geometry as text until
+                    // the feature is known to be wanted
+                    geometry_text.clear();
+                    cursor.capture_into(&geometry_text);
+                    cursor.skip_value();
+                    cursor.capture_into(nullptr);
+                    has_geometry_text = true;
+                }
+                else {
+                    geometry_object = read_geometry(cursor, type, with_geometry);
+                }
+            }
+            else if (key == "geometries") {
+                type = FeatureType::GeometryCollection;
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        FeatureType member_type;
+                        geometry_collection.push_back(read_geometry(cursor, member_type, with_geometry));
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            }
+            else if (key == "id") {
+                if (cursor.peek() == '"') {
+                    id = cursor.read_string();
+                }
+                else {
+                    id = cursor.read_scalar();
+                }
+            }
+            else if (key == "bbox") {
+                bounding_box = read_numbers(cursor);
+            }
+            else if (key == "properties") {
+                if (cursor.peek() != '{') {
+                    cursor.skip_value();
+                    continue;
+                }
+                cursor.expect('{');
+                if (!cursor.consume('}')) {
+                    do {
+                        std::string property_key = cursor.read_string();
+                        cursor.expect(':');
+                        JSONProperty property = read_property(cursor, property_key);
+                        properties.emplace(std::move(property_key), std::move(property));
+                    } while (cursor.consume(','));
+                    cursor.expect('}');
+                }
+            }
+            else {
+                JSONProperty member = read_property(cursor, key);
+                foreign_members.emplace(std::move(key), std::move(member));
+            }
+        } while (cursor.consume(','));
+        cursor.expect('}');
+    }
+
+    //TODO feature identity isn't 100% spec compliant; see build_collection
+    if (id.empty()) {
+        auto id_property = properties.find("id");
+        if (id_property != properties.end()) {
+            id = id_property->second.as_string();
+        }
+    }
+
+    if (filter != nullptr && filter->count(id) == 0) {
+        return nullptr;
+    }
+
+    if (has_geometry_text) {
+        json_cursor geometry_cursor(geometry_text.data(), geometry_text.data() + geometry_text.size());
+        geometry_object = read_geometry(geometry_cursor, type, with_geometry);
+    }
+
+    return make_feature(
+        type,
+        std::move(geometry_object),
+        std::move(geometry_collection),
+        std::move(id),
+        std::move(properties),
+        std::move(bounding_box),
+        std::move(foreign_members)
+    );
+}
+
+} // anonymous namespace
+
+GeoJSON geojson::read_stream(std::istream& input, const std::vector<std::string>& ids, bool with_geometry) {
+    const std::unordered_set<std::string> wanted_ids(ids.begin(), ids.end());
+    const std::unordered_set<std::string>* filter = wanted_ids.empty() ? nullptr : &wanted_ids;
+
+    json_cursor cursor(input);
+    std::vector<double> bbox_values;
+    std::vector<Feature> features;
+    std::string geometry_text;
+    bool has_features = false;
+
+    cursor.expect('{');
+    if (!cursor.consume('}')) {
+        do {
+            const std::string key = cursor.read_string();
+            cursor.expect(':');
+            if (key == "bbox") {
+                bbox_values = read_numbers(cursor);
+            }
+            else if (key == "features") {
+                has_features = true;
+                cursor.expect('[');
+                if (!cursor.consume(']')) {
+                    do {
+                        Feature feature = read_feature(cursor, filter, with_geometry, geometry_text);
+                        if (feature != nullptr) {
+                            features.push_back(std::move(feature));
+                        }
+                    } while (cursor.consume(','));
+                    cursor.expect(']');
+                }
+            }
+            else {
+                // Foreign members of the collection are not kept
+                cursor.skip_value();
+            }
+        } while (cursor.consume(','));
+        cursor.expect('}');
+    }
+
+    if (!has_features) {
+        std::cout << "No features were found" << std::endl;
+    }
+
+    return std::make_shared<FeatureCollection>(FeatureCollection(std::move(features), std::move(bbox_values)));
+}
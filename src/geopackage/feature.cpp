@@ -10,6 +10,30 @@ inline void build_point_bbox(const geojson::geometry& geom, std::vector<double>&
     bbox[3] = pt.get<1>();
 }
 
+// Features of each type, with a default geometry, to be replaced by a deferred one
+inline geojson::Feature build_empty_feature(
+    geojson::FeatureType type,
+    std::string id,
+    geojson::PropertyMap properties,
+    std::vector<double> bounding_box
+)
+{
+    switch(type) {
+        case geojson::FeatureType::LineString:
+            return std::make_shared<geojson::LineStringFeature>(geojson::linestring_t{}, std::move(id), std::move(properties), std::move(bounding_box));
+        case geojson::FeatureType::Polygon:
+            return std::make_shared<geojson::PolygonFeature>(geojson::polygon_t{}, std::move(id), std::move(properties), std::move(bounding_box));
+        case geojson::FeatureType::MultiPoint:
+            return std::make_shared<geojson::MultiPointFeature>(geojson::multipoint_t{}, std::move(id), std::move(properties), std::move(bounding_box));
+        case geojson::FeatureType::MultiLineString:
+            return std::make_shared<geojson::MultiLineStringFeature>(geojson::multilinestring_t{}, std::move(id), std::move(properties), std::move(bounding_box));
+        case geojson::FeatureType::MultiPolygon:
+            return std::make_shared<geojson::MultiPolygonFeature>(geojson::multipolygon_t{}, std::move(id), std::move(properties), std::move(bounding_box));
+        default:
+            throw std::runtime_error("invalid WKB feature type. Received: " + std::to_string(static_cast<int>(type)));
+    }
+}
+
 geojson::Feature ngen::geopackage::build_feature(
   const ngen::sqlite::database::iterator& row,
   const std::string& id_col,
@@ -19,7 +43,25 @@ geojson::Feature ngen::geopackage::build_feature(
     std::vector<double> bounding_box(4);
     std::string id                   = row.get<std::string>(id_col);
     geojson::PropertyMap properties  = build_properties(row, geom_col);
-    geojson::geometry geometry       = build_geometry(row, geom_col, bounding_box);
+    std::vector<uint8_t> blob        = row.get<std::vector<uint8_t>>(geom_col);
+
+    // Points are cheap to build, and are their own bounding box, but
+    // other geometries are built when (and if) they are first used
+    const auto deferred_type = read_geometry_type(blob, bounding_box);
+    if (deferred_type != geojson::FeatureType::None && deferred_type != geojson::FeatureType::Point) {
+        geojson::Feature feature = build_empty_feature(deferred_type, std::move(id), std::move(properties), std::move(bounding_box));
+        feature->set_geometry_loader([deferred_type, blob = std::move(blob)]() {
+            std::vector<double> unused_bounding_box(4);
+            geojson::geometry geometry = build_geometry(blob, unused_bounding_box);
+            if (static_cast<geojson::FeatureType>(geometry.which() + 1) != deferred_type) {
+                throw std::runtime_error("GeoPackage WKB geometry does not match the type in its header");
+            }
+            return geometry;
+        });
+        return feature;
+    }
+
+    geojson::geometry geometry       = build_geometry(blob, bounding_box);
 
     // Convert variant type (0-based) to FeatureType
     const auto wkb_type = static_cast<geojson::FeatureType>(geometry.which() + 1);
@@ -3,69 +3,49 @@
 #include "wkb.hpp"
 #include "proj.hpp"
 
-geojson::geometry ngen::geopackage::build_geometry(
-    const ngen::sqlite::database::iterator& row,
-    const std::string& geom_col,
-    std::vector<double>& bounding_box
-)
+#include <unordered_map>
+
+namespace {
+
+//! The parts of a GeoPackage geometry header needed to read its geometry
+struct gpkg_header
+{
+    bool     is_empty     = false;
+    bool     has_envelope = false;
+    uint8_t  endian       = 0;
+    uint32_t srs_id       = 0;
+    double   min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+
+    //! Index of the WKB following the header
+    int      wkb_index    = 0;
+};
+
+gpkg_header read_header(const std::vector<uint8_t>& geometry_blob)
 {
-    const std::vector<uint8_t> geometry_blob = row.get<std::vector<uint8_t>>(geom_col);
     if (geometry_blob[0] != 'G' || geometry_blob[1] != 'P') {
         throw std::runtime_error("expected geopackage WKB, but found invalid format instead");
     }
 
+    gpkg_header header;
     int index = 3; // skip version
 
     // flags
     const bool is_extended  =  geometry_blob[index] & 0x00100000;
-    const bool is_empty     =  geometry_blob[index] & 0x00010000;
+    header.is_empty         =  geometry_blob[index] & 0x00010000;
     const uint8_t indicator = (geometry_blob[index] >> 1) & 0x00000111;
-    const uint8_t endian    =  geometry_blob[index] & 0x00000001;
+    header.endian           =  geometry_blob[index] & 0x00000001;
     index++;
 
     // Read srs_id
-    uint32_t srs_id = 0;
-    utils::copy_from(geometry_blob, index, srs_id, endian);
-    
-    const auto epsg = ngen::srs::epsg::get(srs_id);
-    const bg::srs::transformation<> prj{epsg, ngen::srs::epsg::get(ngen::srs::epsg::wgs84)};
-    wkb::wgs84 pvisitor{srs_id, prj};
-    
+    utils::copy_from(geometry_blob, index, header.srs_id, header.endian);
+
     if (indicator > 0 && indicator < 5) {
         // not an empty envelope
-
-        double min_x = 0, max_x = 0, min_y = 0, max_y = 0;
-        utils::copy_from(geometry_blob, index, min_x, endian); // min_x
-        utils::copy_from(geometry_blob, index, max_x, endian); // max_x
-        utils::copy_from(geometry_blob, index, min_y, endian); // min_y
-        utils::copy_from(geometry_blob, index, max_y, endian); // max_y
-
-        // we need to transform the bounding box from its initial SRS
-        // to EPSG: 4326 -- so, we construct a temporary WKB linestring_t type
-        // which will get projected to a geojson::geometry (aka geojson::linestring_t) type.
-
-        // create a wkb::linestring_t bbox object
-        wkb::point_t max{max_x, max_y};
-        wkb::point_t min{min_x, min_y};
-        geojson::coordinate_t max_prj{};
-        geojson::coordinate_t min_prj{};
-
-        // project the raw bounding box
-        if (srs_id == srs::epsg::wgs84) {
-            max_prj = geojson::coordinate_t{max.get<0>(), max.get<1>()};
-            min_prj = geojson::coordinate_t{min.get<0>(), min.get<1>()};
-        } else {
-            prj.forward(max, max_prj);
-            prj.forward(min, min_prj);
-        }
-
-        // assign the projected values to the bounding_box parameter
-        bounding_box.clear();
-        bounding_box.resize(4); // only 4, not supporting Z or M dims
-        bounding_box[0] = min_prj.get<0>(); // min_x
-        bounding_box[1] = min_prj.get<1>(); // min_y
-        bounding_box[2] = max_prj.get<0>(); // max_x
-        bounding_box[3] = max_prj.get<1>(); // max_y
+        header.has_envelope = true;
+        utils::copy_from(geometry_blob, index, header.min_x, header.endian); // min_x
+        utils::copy_from(geometry_blob, index, header.max_x, header.endian); // max_x
+        utils::copy_from(geometry_blob, index, header.min_y, header.endian); // min_y
+        utils::copy_from(geometry_blob, index, header.max_y, header.endian); // max_y
 
         // ensure `index` is at beginning of data
         if (indicator == 2 || indicator == 3) {
@@ -75,8 +55,80 @@ geojson::geometry ngen::geopackage::build_geometry(
         }
     }
 
-    if (!is_empty) {
-        const boost::span<const uint8_t> geometry_data(geometry_blob.data() + index,
+    header.wkb_index = index;
+    return header;
+}
+
+//! Get the transformation from an SRS to EPSG:4326.
+//! These are costly to construct, so each thread makes one per SRS, rather than one per geometry.
+const bg::srs::transformation<>& get_transformation(uint32_t srs_id)
+{
+    thread_local std::unordered_map<uint32_t, std::unique_ptr<bg::srs::transformation<>>> transformations;
+
+    auto& prj = transformations[srs_id];
+    if (prj == nullptr) {
+        const auto epsg = ngen::srs::epsg::get(srs_id);
+        prj.reset(new bg::srs::transformation<>{epsg, ngen::srs::epsg::get(ngen::srs::epsg::wgs84)});
+    }
+    return *prj;
+}
+
+void project_envelope(const gpkg_header& header, const bg::srs::transformation<>& prj, std::vector<double>& bounding_box)
+{
+    // we need to transform the bounding box from its initial SRS
+    // to EPSG: 4326 -- so, we construct a temporary WKB linestring_t type
+    // which will get projected to a geojson::geometry (aka geojson::linestring_t) type.
+
+    // create a wkb::linestring_t bbox object
+    ngen::geopackage::wkb::point_t max{header.max_x, header.max_y};
+    ngen::geopackage::wkb::point_t min{header.min_x, header.min_y};
+    geojson::coordinate_t max_prj{};
+    geojson::coordinate_t min_prj{};
+
+    // project the raw bounding box
+    if (header.srs_id == ngen::srs::epsg::wgs84) {
+        max_prj = geojson::coordinate_t{max.get<0>(), max.get<1>()};
+        min_prj = geojson::coordinate_t{min.get<0>(), min.get<1>()};
+    } else {
+        prj.forward(max, max_prj);
+        prj.forward(min, min_prj);
+    }
+
+    // assign the projected values to the bounding_box parameter
+    bounding_box.clear();
+    bounding_box.resize(4); // only 4, not supporting Z or M dims
+    bounding_box[0] = min_prj.get<0>(); // min_x
+    bounding_box[1] = min_prj.get<1>(); // min_y
+    bounding_box[2] = max_prj.get<0>(); // max_x
+    bounding_box[3] = max_prj.get<1>(); // max_y
+}
+
+} // anonymous namespace
+
+geojson::geometry ngen::geopackage::build_geometry(
+    const ngen::sqlite::database::iterator& row,
+    const std::string& geom_col,
+    std::vector<double>& bounding_box
+)
+{
+    return build_geometry(row.get<std::vector<uint8_t>>(geom_col), bounding_box);
+}
+
+geojson::geometry ngen::geopackage::build_geometry(
+    const std::vector<uint8_t>& geometry_blob,
+    std::vector<double>& bounding_box
+)
+{
+    const gpkg_header header = read_header(geometry_blob);
+    const bg::srs::transformation<>& prj = get_transformation(header.srs_id);
+    wkb::wgs84 pvisitor{header.srs_id, prj};
+
+    if (header.has_envelope) {
+        project_envelope(header, prj, bounding_box);
+    }
+
+    if (!header.is_empty) {
+        const boost::span<const uint8_t> geometry_data(geometry_blob.data() + header.wkb_index,
                                                        geometry_blob.data() + geometry_blob.size());
         auto wkb_geometry = wkb::read(geometry_data);
         geojson::geometry geometry = boost::apply_visitor(pvisitor, wkb_geometry);
@@ -85,3 +137,29 @@ geojson::geometry ngen::geopackage::build_geometry(
         return geojson::geometry{};
     }
 }
+
+geojson::FeatureType ngen::geopackage::read_geometry_type(
+    const std::vector<uint8_t>& geometry_blob,
+    std::vector<double>& bounding_box
+)
+{
+    const gpkg_header header = read_header(geometry_blob);
+    if (header.is_empty || !header.has_envelope || geometry_blob.size() < static_cast<size_t>(header.wkb_index) + 5) {
+        return geojson::FeatureType::None;
+    }
+
+    // WKB begins with its byte order and geometry type
+    int index = header.wkb_index;
+    const uint8_t order = geometry_blob[index];
+    index++;
+    uint32_t type = 0;
+    utils::copy_from(geometry_blob, index, type, order);
+    if (type < 1 || type > 6) {
+        return geojson::FeatureType::None;
+    }
+
+    project_envelope(header, get_transformation(header.srs_id), bounding_box);
+
+    // OGC geometry types 1-6 are in the same order as feature types
+    return static_cast<geojson::FeatureType>(type);
+}
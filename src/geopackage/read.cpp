@@ -1,7 +1,11 @@
 #include "geopackage.hpp"
 
+#include <algorithm>
+#include <exception>
 #include <numeric>
 #include <regex>
+#include <thread>
+#include <unordered_set>
 
 void check_table_name(const std::string& table)
 {
@@ -15,10 +19,62 @@ void check_table_name(const std::string& table)
     }
 }
 
+namespace {
+
+// Fewest features for each concurrent read of a layer, when the number of reads isn't given
+constexpr int min_features_per_thread = 2048;
+
+// Most ids to bind to a single statement; SQLite limits bound parameters to 999 before version 3.32
+constexpr size_t max_ids_per_query = 500;
+
+// Check whether a column of a table is the first column of an index, so it can be used to look up rows
+bool has_index(ngen::sqlite::database& db, const std::string& table, const std::string& column)
+{
+    auto query_get_indexed = db.query(
+        "SELECT COUNT(*) FROM pragma_index_list(?) AS il, pragma_index_info(il.name) AS ii WHERE ii.seqno = 0 AND ii.name = ?",
+        table, column
+    );
+    query_get_indexed.next();
+    return query_get_indexed.get<int>(0) > 0;
+}
+
+// Build the features in the rows of a query of a layer, optionally only those with ids in a filter
+void build_features(
+    ngen::sqlite::database& db,
+    const std::string& statement,
+    const std::vector<std::string>& ids,
+    const std::string& id_column,
+    const std::string& geometry_column,
+    const std::unordered_set<std::string>* filter,
+    std::vector<geojson::Feature>& features
+)
+{
+    auto query_get_layer = db.query(statement, ids);
+    query_get_layer.next();
+
+    // build features out of layer query
+    while(!query_get_layer.done()) {
+        if (filter != nullptr && filter->count(query_get_layer.get<std::string>(id_column)) == 0) {
+            query_get_layer.next();
+            continue;
+        }
+        features.push_back(ngen::geopackage::build_feature(
+            query_get_layer,
+            id_column,
+            geometry_column
+        ));
+        query_get_layer.next();
+    }
+}
+
+} // anonymous namespace
+
 std::shared_ptr<geojson::FeatureCollection> ngen::geopackage::read(
     const std::string& gpkg_path,
-    const std::string& layer = "",
-    const std::vector<std::string>& ids = {}
+    const std::string& layer,
+    const std::vector<std::string>& ids,
+    const std::vector<std::string>& columns,
+    unsigned int threads
 )
 {
     // Check for malicious/invalid layer input
@@ -62,63 +118,145 @@ std::shared_ptr<geojson::FeatureCollection> ngen::geopackage::read(
         }
     }
 
-    // Layer exists, getting statement for it
-    //
-    // this creates a string in the form:
-    //     WHERE id IN (?, ?, ?, ...)
-    // so that it can be bound by SQLite.
-    // This is safer than trying to concatenate
-    // the IDs together.
-    std::string joined_ids = "";
-    if (!ids.empty()) {
-        joined_ids = " WHERE "+id_column+" IN (?";
-        for (size_t i = 1; i < ids.size(); i++) {
-            joined_ids += ", ?";
+    // Get layer feature metadata (geometry column name + type)
+    auto query_get_layer_geom_meta = db.query("SELECT column_name FROM gpkg_geometry_columns WHERE table_name = ?", layer);
+    query_get_layer_geom_meta.next();
+    const std::string layer_geometry_column = query_get_layer_geom_meta.get<std::string>(0);
+
+    // Select only the columns needed, quoted since they may be any name
+    std::string selected_columns = "*";
+    if (!columns.empty()) {
+        selected_columns = "\"" + id_column + "\", \"" + layer_geometry_column + "\"";
+        auto query_get_layer_columns = db.query("SELECT name FROM pragma_table_info(?)", layer);
+        query_get_layer_columns.next();
+        while(!query_get_layer_columns.done()) {
+            const std::string column = query_get_layer_columns.get<std::string>(0);
+            if (column != id_column && column != layer_geometry_column
+                && std::find(columns.begin(), columns.end(), column) != columns.end()) {
+                selected_columns += ", \"" + column + "\"";
+            }
+            query_get_layer_columns.next();
         }
-        joined_ids += ")";
     }
 
-    // Get number of features
-    auto query_get_layer_count = db.query("SELECT COUNT(*) FROM " + layer + joined_ids, ids);
-    query_get_layer_count.next();
-    const int layer_feature_count = query_get_layer_count.get<int>(0);
+    // Deduplicate the subset, since each id is looked up separately
+    std::vector<std::string> subset_ids;
+    std::unordered_set<std::string> wanted_ids;
+    subset_ids.reserve(ids.size());
+    for (const auto& id : ids) {
+        if (wanted_ids.insert(id).second) {
+            subset_ids.push_back(id);
+        }
+    }
+
+    std::vector<std::vector<geojson::Feature>> ranges(1);
+    if (!subset_ids.empty() && has_index(db, layer, id_column)) {
+        // Look up the subset by the index, in batches of ids bound to
+        // statements in the form:
+        //     WHERE id IN (?, ?, ?, ...)
+        // This is safer than trying to concatenate the IDs together, and
+        // keeps under SQLite's limit on the number of bound parameters.
+        ranges[0].reserve(subset_ids.size());
+        for (size_t first = 0; first < subset_ids.size(); first += max_ids_per_query) {
+            const std::vector<std::string> batch(
+                subset_ids.begin() + first,
+                subset_ids.begin() + std::min(first + max_ids_per_query, subset_ids.size())
+            );
+            std::string joined_ids = " WHERE \"" + id_column + "\" IN (?";
+            for (size_t i = 1; i < batch.size(); i++) {
+                joined_ids += ", ?";
+            }
+            joined_ids += ")";
+            build_features(db, "SELECT " + selected_columns + " FROM " + layer + joined_ids, batch, id_column, layer_geometry_column, nullptr, ranges[0]);
+        }
+    }
+    else {
+        // Without an index, a subset is taken while scanning the layer once,
+        // rather than with a statement for each batch of ids
+        const std::unordered_set<std::string>* filter = subset_ids.empty() ? nullptr : &wanted_ids;
+        #ifndef NGEN_QUIET
+        if (filter != nullptr) {
+            std::cout << "WARN: Column `" << id_column << "` of layer " << layer << " has no index; scanning the layer for the id subset." << std::endl;
+        }
+        #endif
+
+        // Get number of features
+        auto query_get_layer_count = db.query("SELECT COUNT(*) FROM " + layer);
+        query_get_layer_count.next();
+        const int layer_feature_count = query_get_layer_count.get<int>(0);
+
+        // Split large layers into ranges of rowids, each read on its own connection
+        if (threads == 0) {
+            threads = std::min<unsigned int>(
+                std::max(std::thread::hardware_concurrency(), 1u),
+                std::max(layer_feature_count / min_features_per_thread, 1)
+            );
+        }
+        threads = std::min<unsigned int>(threads, std::max(layer_feature_count, 1));
+
+        if (threads > 1) {
+            auto query_get_layer_rowids = db.query("SELECT MIN(rowid), MAX(rowid) FROM " + layer);
+            query_get_layer_rowids.next();
+            // rowids are 64-bit, but within the precision of a double for any layer that fits in memory
+            const long long min_rowid = static_cast<long long>(query_get_layer_rowids.get<double>(0));
+            const long long max_rowid = static_cast<long long>(query_get_layer_rowids.get<double>(1));
+            const long long range_size = (max_rowid - min_rowid) / threads + 1;
+
+            ranges.resize(threads);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> readers;
+            readers.reserve(threads);
+            for (unsigned int i = 0; i < threads; i++) {
+                const long long first = min_rowid + i * range_size;
+                const std::string statement = "SELECT " + selected_columns + " FROM " + layer
+                    + " WHERE rowid BETWEEN " + std::to_string(first) + " AND " + std::to_string(first + range_size - 1);
+                readers.emplace_back([&, i, statement]() {
+                    try {
+                        ngen::sqlite::database range_db{gpkg_path};
+                        build_features(range_db, statement, {}, id_column, layer_geometry_column, filter, ranges[i]);
+                    }
+                    catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                });
+            }
+            for (auto& reader : readers) {
+                reader.join();
+            }
+            for (const auto& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+        else {
+            ranges[0].reserve(filter == nullptr ? layer_feature_count : subset_ids.size());
+            build_features(db, "SELECT " + selected_columns + " FROM " + layer, {}, id_column, layer_geometry_column, filter, ranges[0]);
+        }
+    }
+
+    std::vector<geojson::Feature> features = std::move(ranges[0]);
+    for (size_t i = 1; i < ranges.size(); i++) {
+        std::move(ranges[i].begin(), ranges[i].end(), std::back_inserter(features));
+    }
 
     #ifndef NGEN_QUIET
     // output debug info on what is read exactly
-    std::cout << "Reading " << layer_feature_count << " features from layer " << layer << " using ID column `"<< id_column << "`";
-    if (!ids.empty()) {
+    std::cout << "Read " << features.size() << " features from layer " << layer << " using ID column `"<< id_column << "`";
+    if (!ids.empty() && ids.size() <= 10) {
         std::cout << " (id subset:";
         for (auto& id : ids) {
             std::cout << " " << id;
         }
         std::cout << ")";
     }
+    else if (!ids.empty()) {
+        // e.g., a partition of an MPI run
+        std::cout << " (subset of " << ids.size() << " ids)";
+    }
     std::cout << std::endl;
     #endif
 
-    // Get layer feature metadata (geometry column name + type)
-    auto query_get_layer_geom_meta = db.query("SELECT column_name FROM gpkg_geometry_columns WHERE table_name = ?", layer);
-    query_get_layer_geom_meta.next();
-    const std::string layer_geometry_column = query_get_layer_geom_meta.get<std::string>(0);
-
-    // Get layer
-    auto query_get_layer = db.query("SELECT * FROM " + layer + joined_ids, ids);
-    query_get_layer.next();
-
-    // build features out of layer query
-    std::vector<geojson::Feature> features;
-    features.reserve(layer_feature_count);
-    while(!query_get_layer.done()) {
-        geojson::Feature feature = build_feature(
-            query_get_layer,
-            id_column,
-            layer_geometry_column
-        );
-
-        features.push_back(feature);
-        query_get_layer.next();
-    }
-
     // get layer bounding box from features
     //
     // GeoPackage contains a bounding box in the SQLite DB,
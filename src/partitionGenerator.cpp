@@ -11,7 +11,13 @@
 #include <stdexcept>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <algorithm>
+#include <functional>
+#include <numeric>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <tuple>
 
@@ -20,6 +26,7 @@
 #endif
 
 #include "core/Partition_Parser.hpp"
+#include "core/Partition_Bisection.hpp"
 
 using PartitionVSet = std::vector<std::unordered_set<std::string> >;
 /**
@@ -100,96 +107,182 @@ void write_remote_connections(const PartitionVSet& catchment_part, const Partiti
 }
 
 /**
- * @brief Generate a vector of PartitionVSets by iterating the network and assigning catchments to partitions.
- * 
- * @param network 
- * @param num_partitions 
- * @param num_catchments
- * @param catchment_part 
+ * @brief Read per-catchment weights from files of ``id,weight`` lines
+ *
+ * Lines whose weight is not a number, such as a header, are skipped, and additional columns are ignored.  When a
+ * catchment appears in more than one file, e.g. in the per-rank timing outputs of a previous run, its weights are summed.
+ *
+ * @param paths Comma separated list of weight files
+ * @return The weight of each listed catchment
  */
-void generate_partitions(network::Network& network, const int& num_partitions, const int& num_catchments, PartitionVSet& catchment_part,
-     PartitionVSet& nexus_part)
+std::unordered_map<std::string, double> read_weight_files(const std::string& paths)
 {
-    int partition = 0;
-    int counter = 0;
-    int total = num_catchments;
-    int partition_size = total/num_partitions;
-    int partition_size_norm = partition_size;
-    int remainder;
-    remainder = total - partition_size*num_partitions;
-    //int partition_size_plus1 = partition_size + 1;
-    int partition_size_plus1 = ++partition_size;
-    /**
-    std::cout << "num_partition:" << num_partitions << std::endl;
-    std::cout << "partition_size_norm:" << partition_size_norm << std::endl;
-    std::cout << "partition_size_plus1:" << partition_size_plus1 << std::endl;
-    std::cout << "remainder:" << remainder << std::endl;
-    **/
-    std::unordered_set<std::string> catchment_set, nexus_set;
-    //We know we want ~partition_size catchments in the set, so reserve enough space for that to avoid a lot of realloction/rehash
-    catchment_set.reserve(partition_size);
-    nexus_set.reserve(partition_size);
-    std::string part_id, partition_str;
-
-    std::string up_nexus;
-    std::string down_nexus;
-    for(const auto& catchment : network.filter("cat", network::SortOrder::TransposedDepthFirstPreorder)){
-            if (partition < remainder)
-                partition_size = partition_size_plus1;
-            else
-                partition_size = partition_size_norm;
-
-            //Find all associated nexuses and add to nexus list
-            //Some of these will end up being "remote" but still must be present in the
-            //list of all required nexus the partition needs to worry about
-            for( auto downstream : network.get_destination_ids(catchment) ){
-                nexus_set.emplace(downstream);
-            }
-            if(nexus_set.size() == 0){
-                std::cerr<<"Error: Catchment "<<catchment<<" has no destination nexus.\n";
-                exit(1);
+    std::unordered_map<std::string, double> weights;
+    std::vector<std::string> files;
+    boost::split(files, paths, [](char c){return c == ','; } );
+    for( const auto& path : files ){
+        std::ifstream in(path);
+        if( !in ){
+            throw std::runtime_error("Could not open catchment weight file "+path);
+        }
+        std::string line;
+        while( std::getline(in, line) ){
+            std::vector<std::string> columns;
+            boost::split(columns, line, [](char c){return c == ','; } );
+            if( columns.size() < 2 ){
+                continue;
             }
-            for( auto upstream : network.get_origination_ids(catchment) ){
-                nexus_set.emplace(upstream);
+            boost::trim(columns[0]);
+            boost::trim(columns[1]);
+            double weight;
+            if( !boost::conversion::try_lexical_convert(columns[1], weight) || !(weight >= 0.0) ){
+                continue;
             }
-            //std::cout<<catchment<<" -> "<<nexus<<std::endl;
+            weights[columns[0]] += weight;
+        }
+    }
+    return weights;
+}
 
-            //keep track of all the features in this partition
-            catchment_set.emplace(catchment);
-            counter++;
-            if(counter == partition_size)
-            {
-                //std::cout<<"nexus "<<nexus<<" is remote DOWN on partition "<<partition<<std::endl;
-                //FIXME partitioning shouldn't have to assume dendritic network
-                std::vector<std::string> destinations = network.get_destination_ids(catchment);
-                if(destinations.size() == 0){
-                    std::cerr<<"Error: Catchment "<<catchment<<" has no destination nexus.\n";
-                    exit(1);
-                }
-                down_nexus = destinations[0];
+/**
+ * @brief Estimate per-catchment weights from a realization config as the number of BMI modules of each formulation
+ *
+ * A ``bmi_multi`` formulation counts each of its (nested) modules, any other formulation counts 1.  Catchments without
+ * their own formulation use the global one.
+ *
+ * @param realization_path Path to the realization config
+ * @param network The network of the catchments to weight
+ * @return The weight of each catchment in @p network
+ */
+std::unordered_map<std::string, double> estimate_weights(const std::string& realization_path, network::Network& network)
+{
+    boost::property_tree::ptree config;
+    boost::property_tree::read_json(realization_path, config);
 
-                part_id = std::to_string(partition);  // Is id used?
-                partition_str = std::to_string(partition);
+    std::function<double(const boost::property_tree::ptree&)> count_modules = [&](const boost::property_tree::ptree& formulation){
+        if( formulation.get<std::string>("name", "") != "bmi_multi" ){
+            return 1.0;
+        }
+        double count = 0.0;
+        auto modules = formulation.get_child_optional("params.modules");
+        if( modules ){
+            for( const auto& module : *modules ){
+                count += count_modules(module.second);
+            }
+        }
+        return std::max(count, 1.0);
+    };
+    auto first_formulation_weight = [&](const boost::property_tree::ptree& node){
+        auto formulations = node.get_child_optional("formulations");
+        if( !formulations || formulations->empty() ){
+            return 1.0;
+        }
+        return count_modules(formulations->begin()->second);
+    };
 
-                //push the catchment_set and nexus_set on to a vector (can be a 1-d vector)
-                catchment_part.push_back(catchment_set);
-                nexus_part.push_back(nexus_set);
-                catchment_set.clear();
-                nexus_set.clear();
+    double global_weight = 1.0;
+    if( auto global = config.get_child_optional("global") ){
+        global_weight = first_formulation_weight(*global);
+    }
+    auto catchment_configs = config.get_child_optional("catchments");
+
+    std::unordered_map<std::string, double> weights;
+    for( const auto& catchment : network.filter("cat") ){
+        weights[catchment] = global_weight;
+        if( catchment_configs ){
+            auto own = catchment_configs->get_child_optional(boost::property_tree::ptree::path_type(catchment, '\0'));
+            if( own ){
+                weights[catchment] = first_formulation_weight(*own);
+            }
+        }
+    }
+    return weights;
+}
 
-                partition_str = std::to_string(partition);
+/**
+ * @brief Generate a vector of PartitionVSets by weighted graph partitioning of the catchments.
+ *
+ * Catchments are partitioned by multilevel recursive bisection (see Partition_Bisection), balancing the total weight
+ * of each partition while minimizing the number of catchment-nexus-catchment connections cut, as each of these
+ * requires remote nexus communication.
+ *
+ * @param network 
+ * @param num_partitions 
+ * @param weights The weight of each catchment, catchments not listed use the average listed weight, or 1 if none are
+ * @param catchment_part 
+ */
+void generate_partitions(network::Network& network, const int& num_partitions, const std::unordered_map<std::string, double>& weights,
+     PartitionVSet& catchment_part, PartitionVSet& nexus_part)
+{
+    std::vector<std::string> catchments;
+    std::unordered_map<std::string, std::size_t> catchment_index;
+    for(const auto& catchment : network.filter("cat", network::SortOrder::TransposedDepthFirstPreorder)){
+        catchment_index.emplace(catchment, catchments.size());
+        catchments.push_back(catchment);
+    }
 
-                partition++;
-                counter = 0;
-                //std::cout<<"\nnexus "<<nexus<<" is remote UP on partition "<<partition<<std::endl;
+    double default_weight = 1.0;
+    if( !weights.empty() ){
+        default_weight = 0.0;
+        for( const auto& weight : weights ){
+            default_weight += weight.second;
+        }
+        default_weight /= weights.size();
+    }
 
-                //this nexus overlaps partitions
-                //Handled above by ensure all up/down stream nexuses are recorded
-                up_nexus = down_nexus;
-                //std::cout<<"\nin partition "<<partition<<":"<<std::endl;
+    std::vector<double> vertex_weights;
+    std::vector<std::pair<std::size_t, std::size_t>> edges;
+    std::size_t weighted = 0;
+    for(std::size_t i = 0; i < catchments.size(); ++i){
+        auto weight = weights.find(catchments[i]);
+        if( weight != weights.end() ){
+            ++weighted;
+        }
+        vertex_weights.push_back(weight != weights.end() ? weight->second : default_weight);
+
+        std::vector<std::string> destinations = network.get_destination_ids(catchments[i]);
+        if(destinations.size() == 0){
+            std::cerr<<"Error: Catchment "<<catchments[i]<<" has no destination nexus.\n";
+            exit(1);
+        }
+        //Connect the catchment to those its nexuses flow to, these connections become remote nexuses when cut
+        for( const auto& nexus : destinations ){
+            for( const auto& downstream : network.get_destination_ids(nexus) ){
+                auto j = catchment_index.find(downstream);
+                if( j != catchment_index.end() ){
+                    edges.emplace_back(i, j->second);
+                }
             }
+        }
+    }
+    if( !weights.empty() ){
+        std::cout<<"Catchment weights given for "<<weighted<<" of "<<catchments.size()<<" catchments."<<std::endl;
+    }
+
+    Partition_Bisection partitioner(vertex_weights, edges);
+    std::vector<int> parts = partitioner.partition(num_partitions);
+
+    catchment_part.assign(num_partitions, std::unordered_set<std::string>());
+    nexus_part.assign(num_partitions, std::unordered_set<std::string>());
+    for(std::size_t i = 0; i < catchments.size(); ++i){
+        catchment_part[parts[i]].emplace(catchments[i]);
+        //Find all associated nexuses and add to nexus list
+        //Some of these will end up being "remote" but still must be present in the
+        //list of all required nexus the partition needs to worry about
+        for( const auto& downstream : network.get_destination_ids(catchments[i]) ){
+            nexus_part[parts[i]].emplace(downstream);
+        }
+        for( const auto& upstream : network.get_origination_ids(catchments[i]) ){
+            nexus_part[parts[i]].emplace(upstream);
+        }
     }
 
+    std::vector<double> part_weights = partitioner.partition_weights(parts, num_partitions);
+    double total_weight = std::accumulate(part_weights.begin(), part_weights.end(), 0.0);
+    auto minmax = std::minmax_element(part_weights.begin(), part_weights.end());
+    std::cout<<"Partition weights: min "<<*minmax.first<<", max "<<*minmax.second<<", average "<<total_weight/num_partitions
+             <<"; "<<partitioner.edge_cut(parts)<<" of "<<edges.size()<<" connections cut."<<std::endl;
+
     // validating catchment partition
     std::cout << "Validating catchments..." << std::endl;
     std::vector<std::string> cat_id_vec;
@@ -261,6 +354,8 @@ int find_remote_rank(const std::string& id, const PartitionVSet& catchment_parti
  * Any @p nexus which is connected to a @p destination_ids_to_find id is mapped
  * as a remote connection where the @p nexus is considered to be a `nex-to-dest_cat`
  * which indicates that the nexus must send to the partition containing the destination catchment.
+ * Destinations may be in several partitions; a partition which only receives from @p nexus is told about the
+ * destinations in other partitions too, as they determine the share of flow it receives.
  * 
  * Any @p nexus which is connected to a @p origin_ids_to_find id is mapped
  * as a remote connection if and only if the @p partition_number contains a destination feature in @p destination_ids_to_find
@@ -331,6 +426,8 @@ int find_partition_connections(const std::string& nexus, const PartitionVSet& ca
                     int pos = find_remote_rank(id, catchment_partitions);
                     remote_connections.push_back(std::make_tuple(pos, nexus, id, origination_cat_to_nex));
                     ++remote_catchments;
+                    //one connection per remote origin, however many of the destinations this partition operates
+                    break;
                 }
             }
         }
@@ -353,13 +450,17 @@ void read_arguments(int argc, char* argv[],
                     std::string& partitionOutFile,
                     int& numPartitions,
                     std::vector<std::string>& catchment_subset_ids,
-                    std::vector<std::string>& nexus_subset_ids)
+                    std::vector<std::string>& nexus_subset_ids,
+                    std::string& catchmentWeights)
 {
     if( argc < 7 ){
         std::cout << "Missing required args:" << std::endl;
-        std::cout << argv[0] << " <catchment_data_path> <nexus_data_path> <partition_output_name> <number of partitions> <catchment_subset_ids> <nexus_subset_ids> " << std::endl;
+        std::cout << argv[0] << " <catchment_data_path> <nexus_data_path> <partition_output_name> <number of partitions> <catchment_subset_ids> <nexus_subset_ids> [catchment_weights]" << std::endl;
         std::cout << "Use empty strings for subset_ids for no subsetting, e.g ''\nUse \'cat-X,cat-Y\', \'nex-X,nex-Y\' to partition only the defined catchment and nexus"<<std::endl;
         std::cout << "Note the use of single quotes, and no spaces between the ids.  (no quotes will also work, but  \"\" will not."<<std::endl;
+        std::cout << "The optional catchment_weights balance the partitions by the cost of each catchment, either:\n"
+                  << "  a realization config (.json), to estimate costs from the number of BMI modules of each formulation, or\n"
+                  << "  comma separated files of 'id,weight' lines, e.g. measured run times of a previous run"<<std::endl;
         exit(-1);
     }
 
@@ -406,6 +507,10 @@ void read_arguments(int argc, char* argv[],
         nexus_subset_ids.pop_back();
     }
 
+    if( argc > 7 ){
+        catchmentWeights = argv[7];
+    }
+
     if (error) exit(-1);
 }
 
@@ -416,29 +521,34 @@ int main(int argc, char* argv[])
     std::string partitionOutFile;
     std::vector<std::string> catchment_subset_ids;
     std::vector<std::string> nexus_subset_ids;
+    std::string catchmentWeights;
     int num_partitions = 0;
 
     read_arguments(argc, argv,
                    catchmentDataFile, nexusDataFile, partitionOutFile,
                    num_partitions,
-                   catchment_subset_ids, nexus_subset_ids);
+                   catchment_subset_ids, nexus_subset_ids,
+                   catchmentWeights);
 
     std::ofstream outFile;
     outFile.open(partitionOutFile, std::ios::trunc);
 
+    // Partitioning only needs the features' links and layers; other GeoPackage columns are not read
+    const std::vector<std::string> partition_columns{"id", "toid", "layer"};
+
     //Get the feature collection for the given hydrofabric
     geojson::GeoJSON catchment_collection;
     if (boost::algorithm::ends_with(catchmentDataFile, "gpkg"))
     {
         #if NGEN_WITH_SQLITE3
-        catchment_collection = ngen::geopackage::read(catchmentDataFile, "divides", catchment_subset_ids);
+        catchment_collection = ngen::geopackage::read(catchmentDataFile, "divides", catchment_subset_ids, partition_columns);
         #else
         throw std::runtime_error("SQLite3 support required to read GeoPackage files.");
         #endif
     }
     else
     {
-        catchment_collection = geojson::read(catchmentDataFile, catchment_subset_ids);
+        catchment_collection = geojson::read(catchmentDataFile, catchment_subset_ids, false);
     }
     int num_catchments = catchment_collection->get_size();
     std::cout<<"Partitioning "<<num_catchments<<" catchments into "<<num_partitions<<" partitions."<<std::endl;
@@ -463,14 +573,14 @@ int main(int argc, char* argv[])
     if (boost::algorithm::ends_with(nexusDataFile, "gpkg")) 
     {
       #if NGEN_WITH_SQLITE3
-      global_nexus_collection = ngen::geopackage::read(nexusDataFile, "nexus", nexus_subset_ids);
+      global_nexus_collection = ngen::geopackage::read(nexusDataFile, "nexus", nexus_subset_ids, partition_columns);
       #else
       throw std::runtime_error("SQLite3 support required to read GeoPackage files.");
       #endif
     } 
     else 
     {
-      global_nexus_collection = geojson::read(nexusDataFile, nexus_subset_ids);
+      global_nexus_collection = geojson::read(nexusDataFile, nexus_subset_ids, false);
     }
 
     //Now read the collection of catchments, iterate it and add them to the nexus collection
@@ -490,8 +600,16 @@ int main(int argc, char* argv[])
     // make a global network
     Network global_network(global_nexus_collection);
 
+    std::unordered_map<std::string, double> weights;
+    if( boost::algorithm::ends_with(catchmentWeights, ".json") ){
+        weights = estimate_weights(catchmentWeights, global_network);
+    }
+    else if( !catchmentWeights.empty() ){
+        weights = read_weight_files(catchmentWeights);
+    }
+
     //Generate the partitioning
-    generate_partitions(global_network, num_partitions, num_catchments, catchment_part, nexus_part);
+    generate_partitions(global_network, num_partitions, weights, catchment_part, nexus_part);
 
     //global_network.print_network();
 
@@ -45,45 +45,8 @@ std::shared_ptr<Bmi_Adapter> Bmi_Cpp_Formulation::construct_model(const geojson:
 double Bmi_Cpp_Formulation::get_var_value_as_double(const int& index, const std::string& var_name) {
     // TODO: consider different way of handling (and how to document) cases like long double or unsigned long long that
     //  don't fit or might convert inappropriately
-
-    auto model = std::dynamic_pointer_cast<Bmi_Cpp_Adapter>(get_bmi_model());
-
-    std::string type = model->GetVarType(var_name);
-    if (type == "long double")
-        return (double) (model->GetValuePtr<long double>(var_name))[index];
-
-    if (type == "double")
-        return (double) (model->GetValuePtr<double>(var_name))[index];
-
-    if (type == "float")
-        return (double) (model->GetValuePtr<float>(var_name))[index];
-
-    if (type == "short" || type == "short int" || type == "signed short" || type == "signed short int")
-        return (double) (model->GetValuePtr<short>(var_name))[index];
-
-    if (type == "unsigned short" || type == "unsigned short int")
-        return (double) (model->GetValuePtr<unsigned short>(var_name))[index];
-
-    if (type == "int" || type == "signed" || type == "signed int")
-        return (double) (model->GetValuePtr<int>(var_name))[index];
-
-    if (type == "unsigned" || type == "unsigned int")
-        return (double) (model->GetValuePtr<unsigned int>(var_name))[index];
-
-    if (type == "long" || type == "long int" || type == "signed long" || type == "signed long int")
-        return (double) (model->GetValuePtr<long>(var_name))[index];
-
-    if (type == "unsigned long" || type == "unsigned long int")
-        return (double) (model->GetValuePtr<unsigned long>(var_name))[index];
-
-    if (type == "long long" || type == "long long int" || type == "signed long long" || type == "signed long long int")
-        return (double) (model->GetValuePtr<long long>(var_name))[index];
-
-    if (type == "unsigned long long" || type == "unsigned long long int")
-        return (double) (model->GetValuePtr<unsigned long long>(var_name))[index];
-
-    throw std::runtime_error("Unable to get value of variable " + var_name + " from " + get_model_type_name() +
-                             " as double: no logic for converting variable type " + type);
+    // The type is resolved once per variable; the pointer is fetched each time, since the model may reallocate it
+    return models::bmi::get_value_as_double(get_var_value_type(var_name), get_bmi_model()->GetValuePtr(var_name), index);
 }
 
 bool Bmi_Cpp_Formulation::is_bmi_input_variable(const std::string &var_name) const {
@@ -10,6 +10,7 @@ namespace realization
                 BMI_REALIZATION_CFG_PARAM_OPT__OUT_HEADER_FIELDS,
                 BMI_REALIZATION_CFG_PARAM_OPT__ALLOW_EXCEED_END,
                 BMI_REALIZATION_CFG_PARAM_OPT__FIXED_TIME_STEP,
+                BMI_REALIZATION_CFG_PARAM_OPT__THREAD_SAFE,
                 BMI_REALIZATION_CFG_PARAM_OPT__LIB_FILE
         };
         const std::vector<std::string> Bmi_Formulation::REQUIRED_PARAMETERS = {
@@ -50,44 +50,15 @@ double Bmi_Fortran_Formulation::get_var_value_as_double(const int &index, const
 
     // TODO: consider different way of handling (and how to document) cases like long double or unsigned long long that
     //  don't fit or might convert inappropriately
-    std::string type = model->GetVarType(var_name);
-    //Can cause a segfault here if GetValue returns an empty vector...a "fix" in bmi_utilities GetValue
-    //will throw a relevant runtime_error if the vector is empty, so this is safe to use this way for now...
-    if (type == "long double")
-        return (double) (models::bmi::GetValue<long double>(*model, var_name))[index];
-
-    if (type == "double" || type == "double precision")
-        return (double) (models::bmi::GetValue<double>(*model, var_name))[index];
-
-    if (type == "float" || type == "real")
-        return (double) (models::bmi::GetValue<float>(*model, var_name))[index];
-
-    if (type == "short" || type == "short int" || type == "signed short" || type == "signed short int")
-        return (double) (models::bmi::GetValue<short>(*model, var_name))[index];
-
-    if (type == "unsigned short" || type == "unsigned short int")
-        return (double) (models::bmi::GetValue<unsigned short>(*model, var_name))[index];
-
-    if (type == "int" || type == "signed" || type == "signed int" || type == "integer")
-        return (double) (models::bmi::GetValue<int>(*model, var_name))[index];
-
-    if (type == "unsigned" || type == "unsigned int")
-        return (double) (models::bmi::GetValue<unsigned int>(*model, var_name))[index];
-
-    if (type == "long" || type == "long int" || type == "signed long" || type == "signed long int")
-        return (double) (models::bmi::GetValue<long>(*model, var_name))[index];
-
-    if (type == "unsigned long" || type == "unsigned long int")
-        return (double) (models::bmi::GetValue<unsigned long>(*model, var_name))[index];
-
-    if (type == "long long" || type == "long long int" || type == "signed long long" || type == "signed long long int")
-        return (double) (models::bmi::GetValue<long long>(*model, var_name))[index];
-
-    if (type == "unsigned long long" || type == "unsigned long long int")
-        return (double) (models::bmi::GetValue<unsigned long long>(*model, var_name))[index];
-
-    throw std::runtime_error("Unable to get value of variable " + var_name + " from " + get_model_type_name() +
-    " as double: no logic for converting variable type " + type);
+    models::bmi::value_type type = get_var_value_type(var_name);
+    int nbytes = model->GetVarNbytes(var_name);
+    if (index < 0 || nbytes < (index + 1) * (int) models::bmi::get_value_type_size(type)) {
+        throw std::runtime_error("Unable to get value of variable " + var_name + ". Model " + model->get_model_name() +
+                                 " reports " + std::to_string(nbytes) + " bytes, too few for index " + std::to_string(index));
+    }
+    std::vector<unsigned char> values(nbytes);
+    model->GetValue(var_name, values.data());
+    return models::bmi::get_value_as_double(type, values.data(), index);
 }
 
 #endif // NGEN_WITH_BMI_FORTRAN
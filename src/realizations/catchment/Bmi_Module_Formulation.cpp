@@ -1,5 +1,7 @@
 #include "Bmi_Module_Formulation.hpp"
 #include "utilities/logging_utils.h"
+#include "Profiler.hpp"
+#include "StateStream.hpp"
 #include <UnitsHelper.hpp>
 
 namespace realization {
@@ -24,12 +26,28 @@ namespace realization {
             }
             std::string output_str;
 
+            utils::Profile_Scope profile(utils::Profiler::BMI_GET_VALUE, get_model_type_name());
             for (const std::string& name : get_output_variable_names()) {
                 output_str += (output_str.empty() ? "" : ",") + std::to_string(get_var_value_as_double(0, name));
             }
             return output_str;
         }
 
+        std::vector<double> Bmi_Module_Formulation::get_output_values_for_timestep(int timestep) {
+            if (timestep != (next_time_step_index - 1)) {
+                throw std::invalid_argument("Only current time step valid when getting output for BMI C++ formulation");
+            }
+            const std::vector<std::string>& names = get_output_variable_names();
+            std::vector<double> values;
+            values.reserve(names.size());
+
+            utils::Profile_Scope profile(utils::Profiler::BMI_GET_VALUE, get_model_type_name());
+            for (const std::string& name : names) {
+                values.push_back(get_var_value_as_double(0, name));
+            }
+            return values;
+        }
+
         double Bmi_Module_Formulation::get_response(time_step_t t_index, time_step_t t_delta) {
             if (get_bmi_model() == nullptr) {
                 throw std::runtime_error("Trying to process response of improperly created BMI formulation of type '" + get_formulation_type() + "'.");
@@ -60,7 +78,10 @@ namespace realization {
 
             while (next_time_step_index <= t_index) {
                 double model_initial_time = get_bmi_model()->GetCurrentTime();
-                set_model_inputs_prior_to_update(model_initial_time, t_delta);
+                if (prepared_time_step_index != next_time_step_index) {
+                    set_model_inputs_prior_to_update(model_initial_time, t_delta);
+                }
+                utils::Profile_Scope profile(utils::Profiler::BMI_UPDATE, get_model_type_name());
                 if (t_delta_model_units == get_bmi_model()->GetTimeStep())
                     get_bmi_model()->Update();
                 else
@@ -68,6 +89,7 @@ namespace realization {
                 // TODO: again, consider whether we should store any historic response, ts_delta, or other var values
                 next_time_step_index++;
             }
+            utils::Profile_Scope profile(utils::Profiler::BMI_GET_VALUE, get_model_type_name());
             return get_var_value_as_double(0, get_bmi_main_output_var());
         }
 
@@ -143,6 +165,7 @@ namespace realization {
             if( !bmi_var_name.empty() )
             {
                 auto model = get_bmi_model().get();
+                utils::Profile_Scope profile(utils::Profiler::BMI_GET_VALUE, get_model_type_name());
                 //Get vector of double values for variable
                 //The return type of the vector here dependent on what
                 //needs to use it.  For other BMI moudles, that is runtime dependent
@@ -194,6 +217,7 @@ namespace realization {
             if( !bmi_var_name.empty() )
             {
                 //Get forcing value from BMI variable
+                utils::Profile_Scope profile(utils::Profiler::BMI_GET_VALUE, get_model_type_name());
                 double value = get_var_value_as_double(0, bmi_var_name);
 
                 // Convert units
@@ -239,6 +263,30 @@ namespace realization {
             return get_bmi_model()->GetOutputVarNames();
         }
 
+        void Bmi_Module_Formulation::check_state_support() {
+            auto model = get_bmi_model();
+            if (!model->is_serializable()) {
+                throw std::runtime_error(get_formulation_type() + " model " + model->get_model_name() + " of " + get_id()
+                                         + " does not implement the BMI serialization extension needed for checkpoints");
+            }
+        }
+
+        void Bmi_Module_Formulation::write_state(std::ostream &out) {
+            check_state_support();
+            auto model = get_bmi_model();
+            utils::state::write<std::int64_t>(out, next_time_step_index);
+            utils::state::write<std::int64_t>(out, last_model_response_delta);
+            utils::state::write<std::int64_t>(out, last_model_response_start_time);
+            utils::state::write_bytes(out, model->get_serialized_state());
+        }
+
+        void Bmi_Module_Formulation::read_state(std::istream &in) {
+            next_time_step_index = utils::state::read<std::int64_t>(in);
+            last_model_response_delta = utils::state::read<std::int64_t>(in);
+            last_model_response_start_time = utils::state::read<std::int64_t>(in);
+            get_bmi_model()->set_serialized_state(utils::state::read_bytes(in));
+        }
+
         void Bmi_Module_Formulation::get_bmi_output_var_name(const std::string &name, std::string &bmi_var_name)
         {
             //check standard output names first
@@ -315,6 +363,9 @@ namespace realization {
                 set_bmi_model_time_step_fixed(
                         properties.at(BMI_REALIZATION_CFG_PARAM_OPT__FIXED_TIME_STEP).as_boolean());
             }
+            if (properties.find(BMI_REALIZATION_CFG_PARAM_OPT__THREAD_SAFE) != properties.end()) {
+                thread_safe = properties.at(BMI_REALIZATION_CFG_PARAM_OPT__THREAD_SAFE).as_boolean();
+            }
 
             auto std_names_it = properties.find(BMI_REALIZATION_CFG_PARAM_OPT__VAR_STD_NAMES);
             if (std_names_it != properties.end()) {
@@ -570,6 +621,9 @@ namespace realization {
         }
         void Bmi_Module_Formulation::set_bmi_model(std::shared_ptr<models::bmi::Bmi_Adapter> model) {
             bmi_model = model;
+            input_bindings.clear();
+            input_bindings_built = false;
+            var_value_types.clear();
         }
 
         void Bmi_Module_Formulation::set_bmi_model_start_time_forcing_offset_s(const time_t &offset_s) {
@@ -622,62 +676,155 @@ namespace realization {
                 "': no logic for converting value to variable's type.");
         }
 
-        void Bmi_Module_Formulation::set_model_inputs_prior_to_update(const double &model_init_time, time_step_t t_delta) {
-            std::vector<std::string> in_var_names = get_bmi_model()->GetInputVarNames();
-            time_t model_epoch_time = convert_model_time(model_init_time) + get_bmi_model_start_time_forcing_offset_s();
-
-            for (std::string & var_name : in_var_names) {
-                data_access::GenericDataProvider *provider;
+        void Bmi_Module_Formulation::build_input_bindings() {
+            input_bindings.clear();
+            for (const std::string &var_name : get_bmi_model()->GetInputVarNames()) {
+                input_binding binding;
+                binding.bmi_name = var_name;
                 std::string var_map_alias = get_config_mapped_variable_name(var_name);
-                if (input_forcing_providers.find(var_map_alias) != input_forcing_providers.end()) {
-                    provider = input_forcing_providers[var_map_alias].get();
-                }
-                else if (var_map_alias != var_name && input_forcing_providers.find(var_name) != input_forcing_providers.end()) {
-                    provider = input_forcing_providers[var_name].get();
-                }
-                else {
-                    provider = forcing.get();
+                auto provider_it = input_forcing_providers.find(var_map_alias);
+                if (provider_it == input_forcing_providers.end() && var_map_alias != var_name) {
+                    provider_it = input_forcing_providers.find(var_name);
                 }
+                binding.provider = provider_it != input_forcing_providers.end() ? provider_it->second.get() : forcing.get();
 
                 // TODO: probably need to actually allow this by default and warn, but have config option to activate
                 //  this type of behavior
-                // TODO: account for arrays later
                 int nbytes = get_bmi_model()->GetVarNbytes(var_name);
                 int varItemSize = get_bmi_model()->GetVarItemsize(var_name);
-                int numItems = nbytes / varItemSize;
                 assert(nbytes % varItemSize == 0);
+                binding.num_items = nbytes / varItemSize;
+
+                binding.type_name = get_bmi_model()->get_analogous_cxx_type(get_bmi_model()->GetVarType(var_name),
+                                                                             varItemSize);
+                binding.type = models::bmi::get_value_type(binding.type_name);
+                binding.buffer.resize(binding.num_items * models::bmi::get_value_type_size(binding.type));
+                binding.selector = CatchmentAggrDataSelector(this->get_catchment_id(), var_map_alias, 0, 0,
+                                                             get_bmi_model()->GetVarUnits(var_name));
+                if (binding.type != models::bmi::value_type::UNKNOWN) {
+                    couple_input_binding(binding);
+                }
+                input_bindings.push_back(std::move(binding));
+            }
+            input_bindings_built = true;
+        }
 
-                std::shared_ptr<void> value_ptr;
-                // Finally, use the value obtained to set the model input
+        void Bmi_Module_Formulation::couple_input_binding(input_binding &binding) {
+            auto source = dynamic_cast<Bmi_Module_Formulation*>(binding.provider);
+            if (source == nullptr || source == this || binding.num_items == 0) {
+                return;
+            }
+            std::string source_name;
+            source->get_bmi_output_var_name(binding.selector.get_variable_name(), source_name);
+            if (source_name.empty()) {
+                return;
+            }
+            std::shared_ptr<models::bmi::Bmi_Adapter> source_model = source->get_bmi_model();
+            int source_item_size = source_model->GetVarItemsize(source_name);
+            if (source_item_size <= 0 || source_model->GetVarNbytes(source_name) != binding.num_items * source_item_size) {
+                return;
+            }
+            models::bmi::value_type source_type = models::bmi::get_value_type(
+                    source_model->get_analogous_cxx_type(source_model->GetVarType(source_name), source_item_size));
+            if (source_type == models::bmi::value_type::UNKNOWN) {
+                return;
+            }
+
+            const std::string source_units = source_model->GetVarUnits(source_name);
+            const std::string units = binding.selector.get_output_units();
+            if (source_units != units) {
+                try {
+                    binding.conversion = &UnitsHelper::get_conversion(source_units, units);
+                    if (binding.conversion->is_identity()) {
+                        binding.conversion = nullptr;
+                    }
+                }
+                catch (const std::runtime_error& e) {
+                    // As when reading through the provider, use values that cannot be converted as they are
+                    #ifndef UDUNITS_QUIET
+                    logging::warning((std::string("WARN: Unit conversion unsuccessful - Using unconverted values for ") +
+                                      binding.bmi_name + "! (\"" + e.what() + "\")\n").c_str());
+                    #endif
+                }
+            }
+            binding.source = source;
+            binding.source_name = source_name;
+            binding.source_type = source_type;
+            if (source_type != binding.type || binding.conversion != nullptr) {
+                binding.source_buffer.resize(binding.num_items * source_item_size);
+            }
+        }
+
+        models::bmi::value_type Bmi_Module_Formulation::get_var_value_type(const std::string &var_name) {
+            auto it = var_value_types.find(var_name);
+            if (it == var_value_types.end()) {
                 std::string type = get_bmi_model()->get_analogous_cxx_type(get_bmi_model()->GetVarType(var_name),
-                                                                           varItemSize);
-                if (numItems != 1) {
+                                                                           get_bmi_model()->GetVarItemsize(var_name));
+                models::bmi::value_type value_type = models::bmi::get_value_type(type);
+                if (value_type == models::bmi::value_type::UNKNOWN) {
+                    throw std::runtime_error("Unable to get value of variable " + var_name + " from " +
+                                             get_model_type_name() + " as double: no logic for converting variable type " + type);
+                }
+                it = var_value_types.emplace(var_name, value_type).first;
+            }
+            return it->second;
+        }
+
+        void Bmi_Module_Formulation::set_model_inputs_prior_to_update(const double &model_init_time, time_step_t t_delta) {
+            if (!input_bindings_built) {
+                build_input_bindings();
+            }
+            time_t model_epoch_time = convert_model_time(model_init_time) + get_bmi_model_start_time_forcing_offset_s();
+
+            std::vector<double> values;
+            for (input_binding &binding : input_bindings) {
+                if (binding.type == models::bmi::value_type::UNKNOWN) {
+                    throw std::runtime_error("Unable to get value of variable as type '" + binding.type_name +
+                                             "': no logic for converting value to variable's type.");
+                }
+                binding.selector.set_init_time(model_epoch_time);
+                binding.selector.set_duration_secs(t_delta);
+
+                if (binding.source != nullptr) {
+                    utils::Profile_Scope profile(utils::Profiler::BMI_GET_VALUE, binding.source->get_model_type_name());
+                    models::bmi::Bmi_Adapter &source_model = *binding.source->get_bmi_model();
+                    if (binding.source_buffer.empty()) {
+                        source_model.GetValue(binding.source_name, binding.buffer.data());
+                    }
+                    else {
+                        source_model.GetValue(binding.source_name, binding.source_buffer.data());
+                        values.resize(binding.num_items);
+                        for (std::size_t i = 0; i < binding.num_items; ++i) {
+                            values[i] = models::bmi::get_value_as_double(binding.source_type, binding.source_buffer.data(), i);
+                        }
+                        if (binding.conversion != nullptr) {
+                            binding.conversion->convert(values.data(), values.data(), values.size());
+                        }
+                        models::bmi::store_values_as_type(binding.type, values.data(), values.size(), binding.buffer.data());
+                    }
+                }
+                else if (binding.num_items != 1) {
                     //more than a single value needed for var_name
-                    auto values = provider->get_values(CatchmentAggrDataSelector(this->get_catchment_id(),var_map_alias, model_epoch_time, t_delta,
-                                                   get_bmi_model()->GetVarUnits(var_name)));
-                    //need to marshal data types to the receiver as well
-                    //this could be done a little more elegantly if the provider interface were
-                    //"type aware", but for now, this will do (but requires yet another copy)
+                    values = binding.provider->get_values(binding.selector);
                     if(values.size() == 1){
                         //FIXME this isn't generic broadcasting, but works for scalar implementations
                         #ifndef NGEN_QUIET
-                        std::cerr << "WARN: broadcasting variable '" << var_name << "' from scalar to expected array\n";
+                        std::cerr << "WARN: broadcasting variable '" << binding.bmi_name << "' from scalar to expected array\n";
                         #endif
-                        values.resize(numItems, values[0]);
-                    } else if (values.size() != numItems) {
-                        throw std::runtime_error("Mismatch in item count for variable '" + var_name + "': model expects " +
-                                                 std::to_string(numItems) + ", provider returned " + std::to_string(values.size()) +
+                        values.resize(binding.num_items, values[0]);
+                    } else if (values.size() != binding.num_items) {
+                        throw std::runtime_error("Mismatch in item count for variable '" + binding.bmi_name + "': model expects " +
+                                                 std::to_string(binding.num_items) + ", provider returned " + std::to_string(values.size()) +
                                                  " items\n");
                     }
-                    value_ptr = get_values_as_type( type, values.begin(), values.end() );
-
+                    models::bmi::store_values_as_type(binding.type, values.data(), values.size(), binding.buffer.data());
                 } else {
                     //scalar value
-                    double value = provider->get_value(CatchmentAggrDataSelector(this->get_catchment_id(),var_map_alias, model_epoch_time, t_delta,
-                                                   get_bmi_model()->GetVarUnits(var_name)));
-                    value_ptr = get_value_as_type(type, value);
+                    double value = binding.provider->get_value(binding.selector);
+                    models::bmi::store_values_as_type(binding.type, &value, 1, binding.buffer.data());
                 }
-                get_bmi_model()->SetValue(var_name, value_ptr.get());
+                utils::Profile_Scope profile(utils::Profiler::BMI_SET_VALUE, get_model_type_name());
+                get_bmi_model()->SetValue(binding.bmi_name, binding.buffer.data());
             }
         }
 }
@@ -6,6 +6,7 @@
 #include <iostream>
 #include "Bmi_Py_Formulation.hpp"
 #include <WrappedDataProvider.hpp>
+#include "StateStream.hpp"
 
 #include "Bmi_Cpp_Formulation.hpp"
 #include "Bmi_C_Formulation.hpp"
@@ -322,6 +323,49 @@ std::string Bmi_Multi_Formulation::get_output_line_for_timestep(int timestep, st
     return modules.back()->get_output_line_for_timestep(timestep, delimiter);
 }
 
+std::vector<double> Bmi_Multi_Formulation::get_output_values_for_timestep(int timestep) {
+    if (timestep != (next_time_step_index - 1)) {
+        throw std::invalid_argument("Only current time step valid when getting multi-module BMI formulation output");
+    }
+    // As with get_output_line_for_timestep, values are the last module's unless other output variables were configured
+    if (is_out_vars_from_last_mod) {
+        return modules.back()->get_output_values_for_timestep(timestep);
+    }
+    const std::vector<std::string> &output_var_names = get_output_variable_names();
+    std::vector<double> values;
+    values.reserve(output_var_names.size());
+    for (const std::string &name : output_var_names) {
+        values.push_back(get_var_value_as_double(0, name));
+    }
+    return values;
+}
+
+void Bmi_Multi_Formulation::check_state_support() {
+    for (const nested_module_ptr &module : modules) {
+        module->check_state_support();
+    }
+}
+
+void Bmi_Multi_Formulation::write_state(std::ostream &out) {
+    utils::state::write<std::int64_t>(out, next_time_step_index);
+    utils::state::write<std::uint64_t>(out, modules.size());
+    for (const nested_module_ptr &module : modules) {
+        module->write_state(out);
+    }
+}
+
+void Bmi_Multi_Formulation::read_state(std::istream &in) {
+    next_time_step_index = utils::state::read<std::int64_t>(in);
+    std::uint64_t num_modules = utils::state::read<std::uint64_t>(in);
+    if (num_modules != modules.size()) {
+        throw std::runtime_error("Checkpoint holds " + std::to_string(num_modules) + " nested modules for " + get_id()
+                                 + ", which has " + std::to_string(modules.size()));
+    }
+    for (const nested_module_ptr &module : modules) {
+        module->read_state(in);
+    }
+}
+
 double Bmi_Multi_Formulation::get_response(time_step_t t_index, time_step_t t_delta) {
     if (modules.empty()) {
         throw std::runtime_error("Trying to get response of improperly created empty BMI multi-module formulation.");
@@ -24,6 +24,16 @@ std::shared_ptr<Bmi_Adapter> Bmi_Py_Formulation::construct_model(const geojson::
     }
     std::string python_type_name = python_type_name_iter->second.as_string();
 
+    auto python_batched_iter = properties.find(BMI_REALIZATION_CFG_PARAM_OPT__PYTHON_BATCHED);
+    if (python_batched_iter != properties.end() && python_batched_iter->second.as_boolean()) {
+        batch_model = std::make_shared<Bmi_Py_Batch_Adapter>(
+                get_model_type_name(),
+                get_bmi_init_config(),
+                Bmi_Py_Batch::get_shared(python_type_name, get_model_type_name()),
+                is_bmi_model_time_step_fixed());
+        return batch_model;
+    }
+
     return std::make_shared<Bmi_Py_Adapter>(
                     get_model_type_name(),
                     get_bmi_init_config(),
@@ -47,7 +57,30 @@ std::string Bmi_Py_Formulation::get_formulation_type() const {
     return "bmi_py";
 }
 
+void Bmi_Py_Formulation::prepare_response(time_step_t t_index, time_step_t t_delta) {
+    if (batch_model == nullptr || next_time_step_index != t_index) {
+        return;
+    }
+    set_model_inputs_prior_to_update(batch_model->GetCurrentTime(), t_delta);
+    batch_model->prepare_update();
+    prepared_time_step_index = t_index;
+}
+
+void Bmi_Py_Formulation::check_state_support() {
+    if (batch_model != nullptr) {
+        throw std::runtime_error("Batched Python model " + get_model_type_name() + " of " + get_id()
+                                 + " cannot save its state to a checkpoint");
+    }
+    Bmi_Module_Formulation::check_state_support();
+}
+
 double Bmi_Py_Formulation::get_var_value_as_double(const int &index, const std::string &var_name) {
+    // Values of a batched model's row are already in memory, so read them directly
+    if (batch_model != nullptr) {
+        return models::bmi::get_value_as_double(get_var_value_type(var_name), batch_model->GetValuePtr(var_name),
+                                                index);
+    }
+
     auto model = std::dynamic_pointer_cast<models::bmi::Bmi_Py_Adapter>(get_bmi_model());
 
     std::string val_type = model->GetVarType(var_name);
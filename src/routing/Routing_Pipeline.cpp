@@ -0,0 +1,99 @@
+#include <NGenConfig.h>
+
+#if NGEN_WITH_PYTHON
+
+#include <utility>
+#include "Routing_Pipeline.hpp"
+
+using namespace routing_py_adapter;
+
+Routing_Pipeline::Routing_Pipeline(Routing_Py_Adapter &router, int delta_time, bool concurrent):
+  router(router), delta_time(delta_time)
+{
+  if (concurrent) {
+    released_gil = std::make_unique<py::gil_scoped_release>();
+    worker = std::thread(&Routing_Pipeline::worker_loop, this);
+  }
+}
+
+Routing_Pipeline::~Routing_Pipeline()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    discard = true;
+  }
+  stop();
+}
+
+void Routing_Pipeline::submit(std::vector<std::string> nexus_ids, std::vector<double> flows, int number_of_timesteps,
+                              long start_time, bool final_chunk)
+{
+  std::unique_ptr<chunk> c(new chunk{std::move(nexus_ids), std::move(flows), number_of_timesteps, start_time, final_chunk});
+  if (!worker.joinable()) {
+    route(*c);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  slot_free.wait(lock, [this]{ return pending == nullptr || failure != nullptr; });
+  if (failure != nullptr) {
+    std::rethrow_exception(failure);
+  }
+  pending = std::move(c);
+  chunk_ready.notify_one();
+}
+
+void Routing_Pipeline::finish()
+{
+  stop();
+  released_gil.reset();
+  if (failure != nullptr) {
+    std::rethrow_exception(failure);
+  }
+}
+
+void Routing_Pipeline::route(const chunk &c)
+{
+  router.route_chunk(c.nexus_ids, c.flows.data(), c.number_of_timesteps, c.start_time, delta_time, c.final_chunk);
+}
+
+void Routing_Pipeline::worker_loop()
+{
+  while (true) {
+    std::unique_ptr<chunk> c;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      chunk_ready.wait(lock, [this]{ return pending != nullptr || stopping; });
+      if (pending == nullptr || discard) {
+        return;
+      }
+      c = std::move(pending);
+    }
+    slot_free.notify_one();
+    try {
+      route(*c);
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      failure = std::current_exception();
+      //Later chunks cannot be routed without the states of this one
+      discard = true;
+      slot_free.notify_one();
+      return;
+    }
+  }
+}
+
+void Routing_Pipeline::stop()
+{
+  if (!worker.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  chunk_ready.notify_one();
+  worker.join();
+}
+
+#endif //NGEN_WITH_PYTHON
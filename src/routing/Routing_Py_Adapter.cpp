@@ -2,6 +2,7 @@
 
 #if NGEN_WITH_PYTHON
 
+#include <algorithm>
 #include <exception>
 #include <utility>
 #include <iostream>
@@ -31,9 +32,111 @@ Routing_Py_Adapter::Routing_Py_Adapter(std::string t_route_config_file_with_path
   }
 }
 
-void Routing_Py_Adapter::route(int number_of_timesteps, int delta_time,
-                          const std::vector<double> &flow_vector){
-  throw "Routing_Py_Adapter::route overload with flow_vector unimplemented.";
+py::object Routing_Py_Adapter::get_main()
+{
+  try {
+    // Try the legacy method first... this time because if we lose an exeption, we should favor one from the newer version.
+    return t_route_module.attr("ngen_main");
+  }
+  catch (const pybind11::error_already_set& e){
+    return t_route_module.attr("main_v04");
+  }
+}
+
+std::vector<std::string> Routing_Py_Adapter::main_parameters(bool &var_keyword)
+{
+  py::module_ inspect = py::module_::import("inspect");
+  py::object parameters = inspect.attr("signature")(get_main()).attr("parameters");
+  py::object var_keyword_kind = inspect.attr("Parameter").attr("VAR_KEYWORD");
+  std::vector<std::string> names;
+  var_keyword = false;
+  for (auto parameter : parameters.attr("values")()) {
+    if (parameter.attr("kind").equal(var_keyword_kind)) {
+      var_keyword = true;
+    }
+    else {
+      names.push_back(parameter.attr("name").cast<std::string>());
+    }
+  }
+  return names;
+}
+
+bool Routing_Py_Adapter::accepts_flows()
+{
+  bool var_keyword;
+  std::vector<std::string> names = main_parameters(var_keyword);
+  return var_keyword || std::find(names.begin(), names.end(), "nexus_flows") != names.end();
+}
+
+bool Routing_Py_Adapter::accepts_flow_chunks()
+{
+  //Unlike flows, chunks are not assumed from **kwargs; routing a chunk as a whole run would be silently wrong
+  bool var_keyword;
+  std::vector<std::string> names = main_parameters(var_keyword);
+  return std::find(names.begin(), names.end(), "final_chunk") != names.end();
+}
+
+py::array_t<double> Routing_Py_Adapter::flow_view(const double *flows, std::size_t number_of_nexuses, int number_of_timesteps)
+{
+  //A view of the flows rather than a copy; the base keeps NumPy from taking ownership of them
+  py::array_t<double> view(
+    {static_cast<py::ssize_t>(number_of_nexuses), static_cast<py::ssize_t>(number_of_timesteps)},
+    {static_cast<py::ssize_t>(number_of_timesteps * sizeof(double)), static_cast<py::ssize_t>(sizeof(double))},
+    flows,
+    py::capsule(flows, [](void*){})
+  );
+  view.attr("setflags")(py::arg("write") = false);
+  return view;
+}
+
+void Routing_Py_Adapter::route(const std::vector<std::string> &nexus_ids, const double *flows,
+                          int number_of_timesteps, long start_time, int delta_time)
+{
+  std::vector<std::string> arg_vector;
+
+  arg_vector.push_back("-f");
+
+  arg_vector.push_back(this->t_route_config_path);
+
+  //Cast vector of args to Python list 
+  py::list arg_list = py::cast(arg_vector);
+
+  py::object ngen_main = get_main();
+
+  ngen_main(arg_list,
+            py::arg("nexus_ids") = py::cast(nexus_ids),
+            py::arg("nexus_flows") = flow_view(flows, nexus_ids.size(), number_of_timesteps),
+            py::arg("start_time") = start_time,
+            py::arg("delta_time") = delta_time);
+
+  std::cout << "Finished routing" << std::endl;
+}
+
+void Routing_Py_Adapter::route_chunk(const std::vector<std::string> &nexus_ids, const double *flows,
+                          int number_of_timesteps, long start_time, int delta_time, bool final_chunk)
+{
+  py::gil_scoped_acquire acquire;
+
+  std::vector<std::string> arg_vector;
+
+  arg_vector.push_back("-f");
+
+  arg_vector.push_back(this->t_route_config_path);
+
+  py::list arg_list = py::cast(arg_vector);
+
+  py::object ngen_main = get_main();
+
+  ngen_main(arg_list,
+            py::arg("nexus_ids") = py::cast(nexus_ids),
+            py::arg("nexus_flows") = flow_view(flows, nexus_ids.size(), number_of_timesteps),
+            py::arg("start_time") = start_time,
+            py::arg("delta_time") = delta_time,
+            py::arg("final_chunk") = final_chunk);
+
+  if (final_chunk) {
+    std::cout << "Finished routing" << std::endl;
+  }
 }
 
 void Routing_Py_Adapter::route(int number_of_timesteps, int delta_time)
@@ -50,14 +153,7 @@ void Routing_Py_Adapter::route(int number_of_timesteps, int delta_time)
 
   //Create object for the ngen_main subroutine
 
-  py::object ngen_main;
-  try {
-    // Try the legacy method first... this time because if we lose an exeption, we should favor one from the newer version.
-    ngen_main = t_route_module.attr("ngen_main");
-  }
-  catch (const pybind11::error_already_set& e){
-    ngen_main = t_route_module.attr("main_v04");
-  }
+  py::object ngen_main = get_main();
 
   ngen_main(arg_list);
 
@@ -0,0 +1,101 @@
+#include "ColumnarOutputWriter.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace utils {
+
+    ColumnarOutputWriter::ColumnarOutputWriter(std::size_t timesteps_per_write) : timesteps_per_write(timesteps_per_write)
+    {}
+
+    ColumnarOutputWriter::~ColumnarOutputWriter() = default;
+
+    std::size_t ColumnarOutputWriter::add_table(const std::string& name, const std::vector<std::string>& feature_ids,
+                                                const std::vector<std::vector<std::string>>& feature_variables)
+    {
+        if (feature_variables.size() != feature_ids.size()) {
+            throw std::invalid_argument("Output table '" + name + "' has " + std::to_string(feature_ids.size())
+                                        + " features but variables for " + std::to_string(feature_variables.size()));
+        }
+
+        table_data table;
+        table.name = name;
+        table.feature_ids = feature_ids;
+        table.feature_columns.resize(feature_ids.size());
+        std::unordered_map<std::string, std::size_t> columns;
+        for (std::size_t f = 0; f < feature_ids.size(); ++f) {
+            for (const std::string& variable : feature_variables[f]) {
+                auto it = columns.find(variable);
+                if (it == columns.end()) {
+                    it = columns.emplace(variable, table.variables.size()).first;
+                    table.variables.push_back(variable);
+                }
+                table.feature_columns[f].push_back(it->second);
+            }
+        }
+
+        table.timesteps_per_write = timesteps_per_write;
+        if (table.timesteps_per_write == 0) {
+            const std::size_t row_size = std::max<std::size_t>(1, feature_ids.size() * table.variables.size());
+            table.timesteps_per_write = std::max<std::size_t>(1, std::min<std::size_t>(24, (std::size_t(1) << 22) / row_size));
+        }
+        table.values.assign(table.variables.size(),
+                            std::vector<double>(table.timesteps_per_write * feature_ids.size(),
+                                                std::numeric_limits<double>::quiet_NaN()));
+        table.times.reserve(table.timesteps_per_write);
+
+        tables.push_back(std::move(table));
+        define_table(tables.size() - 1);
+        return tables.size() - 1;
+    }
+
+    void ColumnarOutputWriter::set_values(std::size_t table, std::size_t feature, const double* values, std::size_t count)
+    {
+        table_data& t = tables.at(table);
+        const std::vector<std::size_t>& columns = t.feature_columns.at(feature);
+        const std::size_t offset = t.times.size() * t.feature_ids.size() + feature;
+        for (std::size_t i = 0; i < std::min(count, columns.size()); ++i) {
+            t.values[columns[i]][offset] = values[i];
+        }
+    }
+
+    void ColumnarOutputWriter::end_time_step(std::size_t table, time_t epoch_time)
+    {
+        table_data& t = tables.at(table);
+        t.times.push_back(static_cast<double>(epoch_time));
+        if (t.times.size() == t.timesteps_per_write) {
+            flush_table(table);
+        }
+    }
+
+    void ColumnarOutputWriter::flush()
+    {
+        for (std::size_t i = 0; i < tables.size(); ++i) {
+            flush_table(i);
+        }
+    }
+
+    std::size_t ColumnarOutputWriter::get_timesteps_per_write(std::size_t table) const
+    {
+        return tables.at(table).timesteps_per_write;
+    }
+
+    void ColumnarOutputWriter::flush_table(std::size_t table)
+    {
+        table_data& t = tables[table];
+        if (t.times.empty()) {
+            return;
+        }
+        write_rows(table);
+        t.first_time_index += t.times.size();
+        // Features that are not set in a time step are missing values
+        const std::size_t written = t.times.size() * t.feature_ids.size();
+        for (auto& column : t.values) {
+            std::fill(column.begin(), column.begin() + written, std::numeric_limits<double>::quiet_NaN());
+        }
+        t.times.clear();
+    }
+
+} // namespace utils
@@ -0,0 +1,167 @@
+#include "NetCDFOutputWriter.hpp"
+
+#include <stdexcept>
+
+#if NGEN_WITH_NETCDF
+
+#include <netcdf>
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+
+namespace utils {
+
+    struct NetCDFOutputWriter::file_data {
+        netCDF::NcFile nc_file;
+        // Indexed like the writer's tables
+        std::vector<netCDF::NcVar> time_vars;
+        std::vector<std::vector<netCDF::NcVar>> value_vars;
+
+        explicit file_data(const std::string& path) : nc_file(path, netCDF::NcFile::replace, netCDF::NcFile::nc4) {}
+    };
+
+    namespace {
+
+        std::string netcdf_name(const std::string& name)
+        {
+            std::string valid = name;
+            for (char& c : valid) {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.' && c != '-' && c != '+' && c != '@') {
+                    c = '_';
+                }
+            }
+            if (valid.empty() || !(std::isalpha(static_cast<unsigned char>(valid[0])) || valid[0] == '_')) {
+                valid = "_" + valid;
+            }
+            return valid;
+        }
+
+    } // namespace
+
+    NetCDFOutputWriter::NetCDFOutputWriter(const std::string& path, std::size_t timesteps_per_write, int compression_level)
+        : ColumnarOutputWriter(timesteps_per_write),
+          compression_level(std::max(0, std::min(9, compression_level))),
+          file(new file_data(path))
+    {}
+
+    NetCDFOutputWriter::~NetCDFOutputWriter()
+    {
+        try {
+            close();
+        }
+        catch (const std::exception& e) {
+            #ifndef NGEN_QUIET
+            std::cerr << "WARNING: failed to finish writing NetCDF output: " << e.what() << std::endl;
+            #endif
+        }
+    }
+
+    void NetCDFOutputWriter::close()
+    {
+        if (file == nullptr) {
+            return;
+        }
+        flush();
+        file->nc_file.close();
+        file = nullptr;
+    }
+
+    void NetCDFOutputWriter::define_table(std::size_t table)
+    {
+        const table_data& t = get_table(table);
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot add output table '" + t.name + "' to a closed NetCDF file");
+        }
+        netCDF::NcGroup group = file->nc_file.addGroup(netcdf_name(t.name));
+        netCDF::NcDim time_dim = group.addDim("time");
+        netCDF::NcDim feature_dim = group.addDim("feature", t.feature_ids.size());
+
+        netCDF::NcVar time_var = group.addVar("time", netCDF::ncDouble, std::vector<netCDF::NcDim>{time_dim});
+        time_var.putAtt("units", "seconds since 1970-01-01 00:00:00");
+        time_var.putAtt("calendar", "standard");
+
+        netCDF::NcVar ids_var = group.addVar("ids", netCDF::ncString, std::vector<netCDF::NcDim>{feature_dim});
+        if (!t.feature_ids.empty()) {
+            std::vector<const char*> ids;
+            ids.reserve(t.feature_ids.size());
+            for (const auto& id : t.feature_ids) {
+                ids.push_back(id.c_str());
+            }
+            ids_var.putVar(std::vector<std::size_t>{0}, std::vector<std::size_t>{ids.size()}, ids.data());
+        }
+
+        // A chunk holds one write of up to about 128K values
+        std::vector<std::size_t> chunk_sizes = {
+            t.timesteps_per_write,
+            std::max<std::size_t>(1, std::min(t.feature_ids.size(), (std::size_t(1) << 17) / t.timesteps_per_write))
+        };
+        std::unordered_set<std::string> names = {"time", "ids"};
+        std::vector<netCDF::NcVar> value_vars;
+        for (const std::string& variable : t.variables) {
+            std::string name = netcdf_name(variable);
+            for (int n = 2; names.count(name) != 0; ++n) {
+                name = netcdf_name(variable) + "_" + std::to_string(n);
+            }
+            names.insert(name);
+
+            netCDF::NcVar var = group.addVar(name, netCDF::ncDouble, std::vector<netCDF::NcDim>{time_dim, feature_dim});
+            if (!t.feature_ids.empty()) {
+                var.setChunking(netCDF::NcVar::nc_CHUNKED, chunk_sizes);
+                var.setCompression(true, compression_level > 0, compression_level);
+            }
+            var.setFill(true, std::numeric_limits<double>::quiet_NaN());
+            var.putAtt("long_name", variable);
+            value_vars.push_back(var);
+        }
+
+        file->time_vars.push_back(time_var);
+        file->value_vars.push_back(std::move(value_vars));
+    }
+
+    void NetCDFOutputWriter::write_rows(std::size_t table)
+    {
+        if (file == nullptr) {
+            return;
+        }
+        const table_data& t = get_table(table);
+        const std::size_t num_times = t.times.size();
+        file->time_vars[table].putVar(std::vector<std::size_t>{t.first_time_index}, std::vector<std::size_t>{num_times},
+                                      t.times.data());
+        if (t.feature_ids.empty()) {
+            return;
+        }
+        const std::vector<std::size_t> start = {t.first_time_index, 0};
+        const std::vector<std::size_t> count = {num_times, t.feature_ids.size()};
+        for (std::size_t v = 0; v < t.variables.size(); ++v) {
+            file->value_vars[table][v].putVar(start, count, t.values[v].data());
+        }
+    }
+
+} // namespace utils
+
+#else // NGEN_WITH_NETCDF
+
+namespace utils {
+
+    struct NetCDFOutputWriter::file_data {};
+
+    NetCDFOutputWriter::NetCDFOutputWriter(const std::string& path, std::size_t timesteps_per_write, int compression_level)
+        : ColumnarOutputWriter(timesteps_per_write), compression_level(compression_level)
+    {
+        throw std::runtime_error("This functionality isn't available. Compile NGen with NGEN_WITH_NETCDF=ON to enable NetCDF output");
+    }
+
+    NetCDFOutputWriter::~NetCDFOutputWriter() = default;
+
+    void NetCDFOutputWriter::close() {}
+
+    void NetCDFOutputWriter::define_table(std::size_t table) {}
+
+    void NetCDFOutputWriter::write_rows(std::size_t table) {}
+
+} // namespace utils
+
+#endif // NGEN_WITH_NETCDF
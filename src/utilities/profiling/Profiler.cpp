@@ -0,0 +1,224 @@
+#include "Profiler.hpp"
+
+#include <array>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+
+    std::atomic<bool> Profiler::enabled(false);
+
+    constexpr std::size_t Profiler::MAX_TRACE_EVENTS;
+
+    namespace {
+
+        struct Event {
+            const std::string* name; // key of the owning thread's stats map, which is stable
+            Profiler::clock::time_point start;
+            Profiler::clock::duration duration;
+            Profiler::Category category;
+        };
+
+        struct Thread_Data {
+            std::array<std::unordered_map<std::string, Profiler::Stat>, Profiler::NUM_CATEGORIES> stats;
+            std::vector<Event> events;
+            std::size_t dropped_events = 0;
+            std::size_t thread_index = 0;
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Thread_Data>> threads;
+            // Bumped by reset, invalidating each thread's cached Thread_Data
+            std::size_t generation = 0;
+            bool trace = false;
+            Profiler::clock::time_point origin = Profiler::clock::now();
+        };
+
+        Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        struct Local_Data {
+            Thread_Data* data = nullptr;
+            std::size_t generation = 0;
+        };
+
+        thread_local Local_Data local;
+
+        Thread_Data& thread_data()
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            if (local.data == nullptr || local.generation != reg.generation) {
+                reg.threads.emplace_back(new Thread_Data());
+                local.data = reg.threads.back().get();
+                local.data->thread_index = reg.threads.size() - 1;
+                local.generation = reg.generation;
+            }
+            return *local.data;
+        }
+
+        void write_json_string(std::ostream& stream, const std::string& str)
+        {
+            stream << '"';
+            for (char c : str) {
+                if (c == '"' || c == '\\') {
+                    stream << '\\' << c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    stream << escaped;
+                }
+                else {
+                    stream << c;
+                }
+            }
+            stream << '"';
+        }
+
+    } // namespace
+
+    void Profiler::enable(bool trace)
+    {
+        Registry& reg = registry();
+        {
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.trace = trace;
+            if (reg.threads.empty()) {
+                reg.origin = clock::now();
+            }
+        }
+        enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void Profiler::disable()
+    {
+        enabled.store(false, std::memory_order_relaxed);
+    }
+
+    void Profiler::reset()
+    {
+        disable();
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.threads.clear();
+        reg.trace = false;
+        ++reg.generation;
+    }
+
+    void Profiler::record(Category category, const std::string& name, clock::time_point start, clock::time_point end)
+    {
+        // Only the first lookup per thread takes the registry lock
+        Thread_Data& data = (local.data != nullptr && local.generation == registry().generation) ? *local.data
+                                                                                               : thread_data();
+        auto& stats = data.stats[category];
+        auto it = stats.find(name);
+        if (it == stats.end()) {
+            it = stats.emplace(name, Stat()).first;
+        }
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        Stat& stat = it->second;
+        ++stat.calls;
+        stat.total_seconds += seconds;
+        if (seconds > stat.max_seconds) {
+            stat.max_seconds = seconds;
+        }
+
+        if (registry().trace) {
+            if (data.events.size() < MAX_TRACE_EVENTS) {
+                data.events.push_back(Event{&it->first, start, end - start, category});
+            }
+            else {
+                ++data.dropped_events;
+            }
+        }
+    }
+
+    const char* Profiler::category_name(Category category)
+    {
+        switch (category) {
+            case CATCHMENT: return "catchment";
+            case BMI_UPDATE: return "bmi_update";
+            case BMI_SET_VALUE: return "bmi_set_value";
+            case BMI_GET_VALUE: return "bmi_get_value";
+            case FORCING: return "forcing";
+            case MPI_WAIT: return "mpi_wait";
+            case OUTPUT: return "output";
+            default: return "unknown";
+        }
+    }
+
+    std::map<std::string, Profiler::Stat> Profiler::summary(Category category)
+    {
+        std::map<std::string, Stat> merged;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& data : reg.threads) {
+            for (const auto& entry : data->stats[category]) {
+                Stat& stat = merged[entry.first];
+                stat.calls += entry.second.calls;
+                stat.total_seconds += entry.second.total_seconds;
+                if (entry.second.max_seconds > stat.max_seconds) {
+                    stat.max_seconds = entry.second.max_seconds;
+                }
+            }
+        }
+        return merged;
+    }
+
+    void Profiler::write_summary(std::ostream& stream)
+    {
+        stream << "category,name,calls,total_seconds,mean_seconds,max_seconds\n";
+        stream << std::setprecision(9);
+        for (int c = 0; c < NUM_CATEGORIES; ++c) {
+            const Category category = static_cast<Category>(c);
+            for (const auto& entry : summary(category)) {
+                const Stat& stat = entry.second;
+                stream << category_name(category) << ',' << entry.first << ',' << stat.calls << ','
+                       << stat.total_seconds << ',' << stat.total_seconds / stat.calls << ',' << stat.max_seconds
+                       << '\n';
+            }
+        }
+    }
+
+    void Profiler::write_catchment_times(std::ostream& stream)
+    {
+        stream << "id,seconds\n";
+        stream << std::setprecision(9);
+        for (const auto& entry : summary(CATCHMENT)) {
+            stream << entry.first << ',' << entry.second.total_seconds << '\n';
+        }
+    }
+
+    void Profiler::write_trace(std::ostream& stream, int process_id)
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        std::size_t dropped = 0;
+        bool first = true;
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        stream << std::fixed << std::setprecision(3);
+        for (const auto& data : reg.threads) {
+            dropped += data->dropped_events;
+            for (const Event& event : data->events) {
+                const double ts = std::chrono::duration<double, std::micro>(event.start - reg.origin).count();
+                const double dur = std::chrono::duration<double, std::micro>(event.duration).count();
+                stream << (first ? "\n" : ",\n") << "{\"name\":";
+                write_json_string(stream, *event.name);
+                stream << ",\"cat\":\"" << category_name(event.category) << "\",\"ph\":\"X\",\"pid\":" << process_id
+                       << ",\"tid\":" << data->thread_index << ",\"ts\":" << ts << ",\"dur\":" << dur << '}';
+                first = false;
+            }
+        }
+        stream << "\n],\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+    }
+
+} // namespace utils
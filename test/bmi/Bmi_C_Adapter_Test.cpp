@@ -488,6 +488,51 @@ TEST_F(Bmi_C_Adapter_Test, Update_until_0_b) {
     adapter->Finalize();
 }
 
+/** Test the model is recognized as implementing the serialization extension. */
+TEST_F(Bmi_C_Adapter_Test, Serialization_0_a) {
+    adapter->Initialize();
+    ASSERT_TRUE(adapter->is_serializable());
+    adapter->Finalize();
+}
+
+/** Test a serialized state restores the time and values of the model, so it continues as it would have. */
+TEST_F(Bmi_C_Adapter_Test, Serialization_0_b) {
+    adapter->Initialize();
+    double value_1 = 7.0;
+    double value_2 = 10.0;
+    adapter->SetValue("INPUT_VAR_1", &value_1);
+    adapter->SetValue("INPUT_VAR_2", &value_2);
+    adapter->Update();
+    double saved_time = adapter->GetCurrentTime();
+    std::vector<char> state = adapter->get_serialized_state();
+    ASSERT_EQ(state.size(), adapter->GetVarNbytes("serialization_state"));
+
+    adapter->Update();
+    double expected_output = GetValue<double>(*adapter, "OUTPUT_VAR_2")[0];
+    double expected_time = adapter->GetCurrentTime();
+
+    double other_value = 3.0;
+    adapter->SetValue("INPUT_VAR_2", &other_value);
+    adapter->Update();
+
+    adapter->set_serialized_state(state);
+    ASSERT_EQ(saved_time, adapter->GetCurrentTime());
+    ASSERT_EQ(value_2, GetValue<double>(*adapter, "INPUT_VAR_2")[0]);
+    adapter->Update();
+    ASSERT_EQ(expected_time, adapter->GetCurrentTime());
+    ASSERT_EQ(expected_output, GetValue<double>(*adapter, "OUTPUT_VAR_2")[0]);
+    adapter->Finalize();
+}
+
+/** Test the model releases its serialized state once it has been copied out. */
+TEST_F(Bmi_C_Adapter_Test, Serialization_0_c) {
+    adapter->Initialize();
+    adapter->get_serialized_state();
+    std::vector<char> state(adapter->GetVarNbytes("serialization_state"));
+    ASSERT_THROW(adapter->GetValue("serialization_state", state.data()), std::runtime_error);
+    adapter->Finalize();
+}
+
 /** Test output 1 variable grid (id) can be retrieved. */
 TEST_F(Bmi_C_Adapter_Test, DISABLED_GetVarGrid_0_a) {
     int out_var_index = 0;
@@ -226,6 +226,14 @@ TEST_F(Bmi_Cpp_Adapter_Test, SetValue_0_c) {
     ASSERT_EQ(value_2, retrieved);
 }
 
+/** Test a model without the serialization extension is recognized as such, and fails to serialize its state. */
+TEST_F(Bmi_Cpp_Adapter_Test, Serialization_0_a) {
+    adapter->Initialize();
+    ASSERT_FALSE(adapter->is_serializable());
+    ASSERT_THROW(adapter->get_serialized_state(), std::runtime_error);
+    adapter->Finalize();
+}
+
 
 
 //Everything below this line is identical to Bmi_C_Adapter_Test.cpp ... 
@@ -0,0 +1,128 @@
+#ifdef NGEN_BMI_PY_TESTS_ACTIVE
+
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pybind11/embed.h>
+namespace py = pybind11;
+
+#include "Bmi_Py_Batch_Adapter.hpp"
+
+using namespace models::bmi;
+using namespace utils::ngenPy;
+
+class Bmi_Py_Batch_Test : public ::testing::Test {
+private:
+    static std::shared_ptr<InterpreterUtil> interpreter;
+protected:
+
+    static int friend_get_update_count(const Bmi_Py_Batch &batch) {
+        return py::int_(batch.bmi_model->attr("update_count"));
+    }
+
+    void SetUp() override;
+
+    static void SetUpTestSuite();
+
+    std::string module_name = "test_bmi_py.bmi_model_batched";
+    std::string bmi_init_config = "./test/data/bmi/test_bmi_python/test_bmi_python_config_0.yml";
+    std::shared_ptr<Bmi_Py_Batch> batch;
+    std::vector<std::shared_ptr<Bmi_Py_Batch_Adapter>> adapters;
+};
+//Make sure the interpreter is instansiated and lives throught the test class
+std::shared_ptr<InterpreterUtil> Bmi_Py_Batch_Test::interpreter = InterpreterUtil::getInstance();
+
+void Bmi_Py_Batch_Test::SetUp() {
+    batch = std::make_shared<Bmi_Py_Batch>(module_name);
+    for (int i = 0; i < 3; ++i) {
+        adapters.push_back(std::make_shared<Bmi_Py_Batch_Adapter>(module_name, bmi_init_config, batch, true));
+    }
+}
+
+void Bmi_Py_Batch_Test::SetUpTestSuite() {
+    InterpreterUtil::addToPyPath("./extern/");
+}
+
+/**
+ * Test each catchment is a row of the shared model, with variables sized for one row.
+ */
+TEST_F(Bmi_Py_Batch_Test, Rows_0_a) {
+    ASSERT_EQ(batch->num_rows(), 3u);
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        ASSERT_EQ(adapters[i]->get_row(), i);
+        ASSERT_EQ(adapters[i]->GetVarNbytes("INPUT_VAR_1"), sizeof(double));
+    }
+}
+
+/**
+ * Test the model is updated once per time step for all rows, with the inputs set for each row.
+ */
+TEST_F(Bmi_Py_Batch_Test, Update_0_a) {
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        double value = 10.0 + i;
+        adapters[i]->SetValue("INPUT_VAR_1", &value);
+        adapters[i]->prepare_update();
+    }
+    for (auto &adapter : adapters) {
+        adapter->Update();
+    }
+    ASSERT_EQ(friend_get_update_count(*batch), 1);
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        double value;
+        adapters[i]->GetValue("OUTPUT_VAR_1", &value);
+        ASSERT_EQ(value, 10.0 + i);
+        ASSERT_EQ(adapters[i]->GetCurrentTime(), 3600.0);
+    }
+}
+
+/**
+ * Test a row lags the model time until its own update, after another row has updated the model.
+ */
+TEST_F(Bmi_Py_Batch_Test, Update_0_b) {
+    for (auto &adapter : adapters) {
+        adapter->prepare_update();
+    }
+    adapters[0]->Update();
+    ASSERT_EQ(adapters[0]->GetCurrentTime(), 3600.0);
+    ASSERT_EQ(adapters[1]->GetCurrentTime(), 0.0);
+}
+
+/**
+ * Test inputs set for only some rows leave the values of the other rows unchanged.
+ */
+TEST_F(Bmi_Py_Batch_Test, Update_0_c) {
+    double value = 4.0;
+    adapters[1]->SetValue("INPUT_VAR_2", &value);
+    for (auto &adapter : adapters) {
+        adapter->prepare_update();
+    }
+    for (auto &adapter : adapters) {
+        adapter->Update();
+    }
+    double output;
+    adapters[0]->GetValue("OUTPUT_VAR_2", &output);
+    ASSERT_EQ(output, 0.0);
+    adapters[1]->GetValue("OUTPUT_VAR_2", &output);
+    ASSERT_EQ(output, 8.0);
+}
+
+/**
+ * Test the model cannot be updated before the inputs of every row have been prepared.
+ */
+TEST_F(Bmi_Py_Batch_Test, Update_0_d) {
+    adapters[0]->prepare_update();
+    ASSERT_THROW(adapters[0]->Update(), std::runtime_error);
+}
+
+/**
+ * Test the shared model of a Python type is kept separate for each model type name it is configured with.
+ */
+TEST_F(Bmi_Py_Batch_Test, GetShared_0_a) {
+    std::shared_ptr<Bmi_Py_Batch> first = Bmi_Py_Batch::get_shared(module_name, "first");
+    ASSERT_EQ(Bmi_Py_Batch::get_shared(module_name, "first"), first);
+    ASSERT_NE(Bmi_Py_Batch::get_shared(module_name, "second"), first);
+}
+
+#endif  // NGEN_BMI_PY_TESTS_ACTIVE
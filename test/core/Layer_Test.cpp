@@ -0,0 +1,464 @@
+#include "gtest/gtest.h"
+#include "Bmi_Testing_Util.hpp"
+#include "Checkpoint.hpp"
+#include "FileChecker.h"
+#include "Layer.hpp"
+#include "StreamHandler.hpp"
+#include <Formulation_Manager.hpp>
+#include <HY_Features.hpp>
+
+#include <features/Features.hpp>
+#include <JSONProperty.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#ifdef NGEN_BMI_PY_TESTS_ACTIVE
+#include "Bmi_Py_Batch_Adapter.hpp"
+#endif
+
+class Layer_Test : public ::testing::Test {
+
+    protected:
+
+    void SetUp() override {
+        realization_config = make_realization_config(
+                "{"
+                  "\"name\":\"bmi_c++\","
+                  "\"params\": {"
+                    "\"model_type_name\": \"test_bmi_cpp\","
+                    "\"library_file\": \"{{EXTERN_LIB_DIR_PATH}}" BMI_TEST_CPP_LIB_NAME "\","
+                    "\"init_config\": \"{{BMI_C_INIT_DIR_PATH}}/test_bmi_c_config_0.txt\","
+                    "\"main_output_variable\": \"OUTPUT_VAR_2\","
+                    "\"variables_names_map\": { "
+                      "\"INPUT_VAR_2\": \"TMP_2maboveground\","
+                      "\"INPUT_VAR_1\": \"precip_rate\""
+                    "},"
+                    "\"create_function\": \"bmi_model_create\","
+                    "\"destroy_function\": \"bmi_model_destroy\","
+                    "\"uses_forcing_file\": false"
+                  "} "
+                "} ");
+
+        fabric = std::make_shared<geojson::FeatureCollection>();
+        add_feature(fabric, "cat-52", 1.5);
+        add_feature(fabric, "cat-67", 2.5);
+    }
+
+    /** Build a realization config with the given global formulation, reading forcing from the test CSV files. */
+    std::string make_realization_config(const std::string& formulation)
+    {
+        std::string config = "{ "
+            "\"global\": { "
+              "\"formulations\": [ " + formulation + "], "
+              "\"forcing\": { "
+                  "\"file_pattern\": \".*{{id}}.*.csv\", "
+                  "\"path\": \"{{FORCING_DIR_PATH}}\", "
+                  "\"provider\": \"CsvPerFeature\" "
+              "} "
+            "}, "
+            "\"time\": { "
+                "\"start_time\": \"2015-12-01 00:00:00\", "
+                "\"end_time\": \"2015-12-30 23:00:00\", "
+                "\"output_interval\": 3600 "
+            "}, "
+            "\"output_root\": \"" + testing::TempDir() + "\" "
+        "}";
+        replace_paths(config, "{{EXTERN_LIB_DIR_PATH}}", "extern/test_bmi_cpp/cmake_build/");
+        replace_paths(config, "{{EXTERN_C_LIB_DIR_PATH}}", "extern/test_bmi_c/cmake_build/");
+        replace_paths(config, "{{BMI_C_INIT_DIR_PATH}}", "data/bmi/test_bmi_c");
+        replace_paths(config, "{{BMI_PY_INIT_DIR_PATH}}", "data/bmi/test_bmi_python");
+        replace_paths(config, "{{FORCING_DIR_PATH}}", "data/forcing/");
+        return config;
+    }
+
+    /** Build the global formulation of the test C model, which can save and restore its state. */
+    std::string make_c_formulation()
+    {
+        return "{"
+                 "\"name\":\"bmi_c\","
+                 "\"params\": {"
+                   "\"model_type_name\": \"test_bmi_c\","
+                   "\"library_file\": \"{{EXTERN_C_LIB_DIR_PATH}}" BMI_TEST_C_LIB_NAME SHARED_LIB_FILE_EXTENSION "\","
+                   "\"init_config\": \"{{BMI_C_INIT_DIR_PATH}}/test_bmi_c_config_0.txt\","
+                   "\"main_output_variable\": \"OUTPUT_VAR_1\","
+                   "\"registration_function\": \"register_bmi\","
+                   "\"variables_names_map\": { "
+                     "\"INPUT_VAR_2\": \"TMP_2maboveground\","
+                     "\"INPUT_VAR_1\": \"precip_rate\""
+                   "},"
+                   "\"uses_forcing_file\": false"
+                 "} "
+               "} ";
+    }
+
+    /** Build the global formulation of the test Python model, either batched or as one model per catchment. */
+    std::string make_python_formulation(bool batched)
+    {
+        std::string python_type = batched ? "test_bmi_py.bmi_model_batched" : "test_bmi_py.bmi_model";
+        return "{"
+                 "\"name\":\"bmi_python\","
+                 "\"params\": {"
+                   "\"model_type_name\": \"" + python_type + "\","
+                   "\"python_type\": \"" + python_type + "\","
+                   "\"python_batched\": " + (batched ? "true" : "false") + ","
+                   "\"init_config\": \"{{BMI_PY_INIT_DIR_PATH}}/test_bmi_python_config_0.yml\","
+                   "\"main_output_variable\": \"OUTPUT_VAR_1\","
+                   "\"variables_names_map\": { "
+                     "\"INPUT_VAR_2\": \"TMP_2maboveground\","
+                     "\"INPUT_VAR_1\": \"precip_rate\""
+                   "},"
+                   "\"uses_forcing_file\": false"
+                 "} "
+               "} ";
+    }
+
+    void add_feature(geojson::GeoJSON collection, const std::string& id, double area)
+    {
+        geojson::PropertyMap properties{
+            {"toid", geojson::JSONProperty("toid", std::string("nex-1"))},
+            {"areasqkm", geojson::JSONProperty("areasqkm", area)}
+        };
+        collection->add_feature(std::make_shared<geojson::PointFeature>(
+            geojson::PointFeature(geojson::coordinate_t(0.0, 0.0), id, properties)));
+    }
+
+    void replace_paths(std::string& input, const std::string& pattern, const std::string& replacement)
+    {
+        std::vector<std::string> v{path_options.size()};
+        for(unsigned int i = 0; i < path_options.size(); i++)
+            v[i] = path_options[i] + replacement;
+        boost::replace_all(input, pattern, utils::FileChecker::find_first_readable(v));
+    }
+
+    /** Build the catchment formulations and features of the fabric from the realization config. */
+    std::shared_ptr<hy_features::HY_Features> make_features()
+    {
+        std::stringstream stream(realization_config);
+        auto manager = std::make_shared<realization::Formulation_Manager>(stream);
+        manager->read(fabric, utils::StreamHandler());
+        std::string link_key = "toid";
+        return std::make_shared<hy_features::HY_Features>(fabric, &link_key, manager);
+    }
+
+    std::shared_ptr<ngen::Layer> make_layer(hy_features::HY_Features& features,
+                                            const std::vector<std::string>& units,
+                                            geojson::GeoJSON catchment_data)
+    {
+        ngen::LayerDescription description{"surface", "s", 0, 3600};
+        return std::make_shared<ngen::Layer>(description, units, make_time(), features, catchment_data, 0);
+    }
+
+    Simulation_Time make_time(const std::string& start_time = "2015-12-01 00:00:00")
+    {
+        return Simulation_Time(simulation_time_params(start_time, "2015-12-30 23:00:00", 3600));
+    }
+
+    /** Write a copy of the checkpoint file of rank 0 at @p from, holding only its first @p size bytes */
+    void copy_checkpoint(const std::string& from, const std::string& to, std::size_t size)
+    {
+        std::ifstream in(ngen::checkpoint::rank_path(from, 0), std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(to, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), std::min(size, bytes.size()));
+    }
+
+    static bool file_exists(const std::string& path)
+    {
+        return std::ifstream(path).good();
+    }
+
+    std::vector<std::string> path_options = {
+            "",
+            "../",
+            "../../",
+            "./test/",
+            "../test/",
+            "../../test/"
+    };
+
+    std::string realization_config;
+    geojson::GeoJSON fabric;
+};
+
+/** Test each catchment's response reaches the destination nexus, scaled by the catchment area. */
+TEST_F(Layer_Test, UpdateModels_0_a) {
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+
+    layer->update_models();
+    ASSERT_EQ(layer->completed_time_steps(), 1);
+
+    // Identically configured formulations give the responses the layer contributed
+    auto expected_features = make_features();
+    double expected = 0.0;
+    std::vector<std::pair<std::string, double>> areas = {{"cat-52", 1.5}, {"cat-67", 2.5}};
+    for (const auto& area : areas) {
+        auto formulation = std::dynamic_pointer_cast<realization::Catchment_Formulation>(
+            expected_features->catchment_at(area.first));
+        expected += formulation->get_response(0, 3600) * area.second * 1000000 / 3600.0;
+    }
+
+    std::pair<double, int> flows = features->nexus_at("nex-1")->inspect_upstream_flows(0);
+    ASSERT_EQ(flows.second, 2);
+    ASSERT_DOUBLE_EQ(flows.first, expected);
+}
+
+/** Test contributions of later time steps are added for the same contributors as the first. */
+TEST_F(Layer_Test, UpdateModels_0_b) {
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+    auto nexus = features->nexus_at("nex-1");
+
+    for (int t = 0; t < 3; ++t) {
+        layer->update_models();
+        ASSERT_EQ(nexus->inspect_upstream_flows(t).second, 2);
+    }
+    // Flow added by id is counted with that of the layer's records, rather than as a new contributor
+    nexus->add_upstream_flow(1.0, "cat-52", 3);
+    layer->update_models();
+    ASSERT_EQ(nexus->inspect_upstream_flows(3).second, 3);
+}
+
+/** Test BMI formulations are not run concurrently unless they are configured to be thread safe. */
+TEST_F(Layer_Test, IsThreadSafe_0_a) {
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+
+    ASSERT_FALSE(layer->is_thread_safe());
+}
+
+/** Test a layer reports calling into Python only when a formulation does, which keeps routing off its own thread. */
+TEST_F(Layer_Test, UsesPython_0_a) {
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+    ASSERT_FALSE(layer->uses_python());
+
+#ifdef NGEN_BMI_PY_TESTS_ACTIVE
+    realization_config = make_realization_config(make_python_formulation(false));
+    auto python_features = make_features();
+    auto python_layer = make_layer(*python_features, {"cat-52", "cat-67"}, fabric);
+    ASSERT_TRUE(python_layer->uses_python());
+#endif
+}
+
+/** Test a catchment without a formulation is reported, then fails the layer when it is run. */
+TEST_F(Layer_Test, NoFormulation_0_a) {
+    auto features = make_features();
+    geojson::GeoJSON catchment_data = std::make_shared<geojson::FeatureCollection>(*fabric);
+    add_feature(catchment_data, "cat-99", 1.0);
+
+    testing::internal::CaptureStderr();
+    auto layer = make_layer(*features, {"cat-52", "cat-99"}, catchment_data);
+    std::string warnings = testing::internal::GetCapturedStderr();
+#if !NGEN_QUIET
+    ASSERT_NE(warnings.find("cat-99"), std::string::npos);
+    ASSERT_NE(warnings.find("has no formulation"), std::string::npos);
+#endif
+
+    ASSERT_THROW(layer->update_models(), std::runtime_error);
+    std::stringstream state;
+    ASSERT_THROW(layer->write_state(state), std::runtime_error);
+}
+
+#ifdef NGEN_BMI_C_LIB_TESTS_ACTIVE
+/** Test a layer restored from its saved state contributes the same flows as it did after the save. */
+TEST_F(Layer_Test, State_0_a) {
+    realization_config = make_realization_config(make_c_formulation());
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+    ASSERT_NO_THROW(layer->check_state_support());
+
+    for (int t = 0; t < 3; ++t) {
+        layer->update_models();
+    }
+    std::stringstream state;
+    layer->write_state(state);
+
+    std::vector<double> flows;
+    for (int t = 3; t < 6; ++t) {
+        layer->update_models();
+        flows.push_back(features->nexus_at("nex-1")->inspect_upstream_flows(t).first);
+    }
+
+    auto restarted_features = make_features();
+    auto restarted = make_layer(*restarted_features, {"cat-52", "cat-67"}, fabric);
+    restarted->read_state(state);
+    ASSERT_EQ(restarted->completed_time_steps(), 3);
+    for (int t = 3; t < 6; ++t) {
+        restarted->update_models();
+        ASSERT_DOUBLE_EQ(restarted_features->nexus_at("nex-1")->inspect_upstream_flows(t).first, flows[t - 3]);
+    }
+}
+
+/** Test a layer state is only restored for the same catchments, in the same order. */
+TEST_F(Layer_Test, State_0_b) {
+    realization_config = make_realization_config(make_c_formulation());
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+    layer->update_models();
+    std::stringstream state;
+    layer->write_state(state);
+
+    auto reordered = make_layer(*features, {"cat-67", "cat-52"}, fabric);
+    ASSERT_THROW(reordered->read_state(state), std::runtime_error);
+}
+
+/** Test only layers whose formulations can all save their state pass the check made before simulating. */
+TEST_F(Layer_Test, Checkpoint_0_a) {
+    auto cpp_features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> cpp_layers = {make_layer(*cpp_features, {"cat-52", "cat-67"}, fabric)};
+    ASSERT_THROW(ngen::checkpoint::check(1, cpp_layers), std::runtime_error);
+
+    realization_config = make_realization_config(make_c_formulation());
+    auto features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> layers = {make_layer(*features, {"cat-52", "cat-67"}, fabric)};
+    ASSERT_NO_THROW(ngen::checkpoint::check(1, layers));
+}
+
+/** Test a checkpoint restores layer positions, formulation states and unreleased nexus flows. */
+TEST_F(Layer_Test, Checkpoint_0_b) {
+    realization_config = make_realization_config(make_c_formulation());
+    std::string prefix = testing::TempDir() + "layer_test_checkpoint_0_b";
+    auto features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> layers = {make_layer(*features, {"cat-52", "cat-67"}, fabric)};
+    Simulation_Time time = make_time();
+    for (int t = 0; t < 3; ++t) {
+        layers[0]->update_models();
+    }
+    ngen::checkpoint::write(prefix, 0, 1, time, 3, layers, *features);
+
+    std::string path = ngen::checkpoint::rank_path(prefix, 0);
+    ASSERT_TRUE(file_exists(path));
+    ASSERT_FALSE(file_exists(path + ".tmp" + std::to_string(getpid())));
+
+    auto restarted_features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> restarted = {make_layer(*restarted_features, {"cat-52", "cat-67"}, fabric)};
+    Simulation_Time restarted_time = make_time();
+    ASSERT_EQ(ngen::checkpoint::read(prefix, 0, 1, restarted_time, restarted, *restarted_features), 3);
+    ASSERT_EQ(restarted[0]->completed_time_steps(), 3);
+    ASSERT_EQ(restarted_time.get_current_epoch_time(), time.get_start_epoch_time() + 3 * 3600);
+    for (int t = 0; t < 3; ++t) {
+        ASSERT_EQ(restarted_features->nexus_at("nex-1")->inspect_upstream_flows(t),
+                  features->nexus_at("nex-1")->inspect_upstream_flows(t));
+    }
+
+    for (int t = 3; t < 5; ++t) {
+        layers[0]->update_models();
+        restarted[0]->update_models();
+        ASSERT_EQ(restarted_features->nexus_at("nex-1")->inspect_upstream_flows(t),
+                  features->nexus_at("nex-1")->inspect_upstream_flows(t));
+    }
+    std::remove(path.c_str());
+}
+
+/** Test a checkpoint is rejected by a simulation it does not match, or when it is not a whole checkpoint file. */
+TEST_F(Layer_Test, Checkpoint_0_c) {
+    realization_config = make_realization_config(make_c_formulation());
+    std::string prefix = testing::TempDir() + "layer_test_checkpoint_0_c";
+    auto features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> layers = {make_layer(*features, {"cat-52", "cat-67"}, fabric)};
+    Simulation_Time time = make_time();
+    layers[0]->update_models();
+    ngen::checkpoint::write(prefix, 0, 1, time, 1, layers, *features);
+
+    // Another start time
+    Simulation_Time later = make_time("2015-12-02 00:00:00");
+    ASSERT_THROW(ngen::checkpoint::read(prefix, 0, 1, later, layers, *features), std::runtime_error);
+
+    // Another rank
+    std::string other_prefix = testing::TempDir() + "layer_test_checkpoint_0_c_other";
+    std::string other_path = ngen::checkpoint::rank_path(other_prefix, 0);
+    copy_checkpoint(prefix, ngen::checkpoint::rank_path(other_prefix, 1), std::string::npos);
+    ASSERT_THROW(ngen::checkpoint::read(other_prefix, 1, 1, time, layers, *features), std::runtime_error);
+    std::remove(ngen::checkpoint::rank_path(other_prefix, 1).c_str());
+
+    // Not a checkpoint file
+    std::ofstream(other_path) << "not a checkpoint";
+    ASSERT_THROW(ngen::checkpoint::read(other_prefix, 0, 1, time, layers, *features), std::runtime_error);
+
+    // A checkpoint cut short, within the header and within the state
+    copy_checkpoint(prefix, other_path, 16);
+    ASSERT_THROW(ngen::checkpoint::read(other_prefix, 0, 1, time, layers, *features), std::runtime_error);
+    std::ifstream full(ngen::checkpoint::rank_path(prefix, 0), std::ios::binary | std::ios::ate);
+    copy_checkpoint(prefix, other_path, static_cast<std::size_t>(full.tellg()) - 1);
+    ASSERT_THROW(ngen::checkpoint::read(other_prefix, 0, 1, time, layers, *features), std::runtime_error);
+
+    // No checkpoint file
+    std::remove(other_path.c_str());
+    ASSERT_THROW(ngen::checkpoint::read(other_prefix, 0, 1, time, layers, *features), std::runtime_error);
+
+    // The original is still whole
+    ASSERT_EQ(ngen::checkpoint::read(prefix, 0, 1, time, layers, *features), 1);
+    std::remove(ngen::checkpoint::rank_path(prefix, 0).c_str());
+}
+
+/** Test a checkpoint that fails to be written leaves the previous checkpoint in place and no partial file. */
+TEST_F(Layer_Test, Checkpoint_0_d) {
+    realization_config = make_realization_config(make_c_formulation());
+    std::string prefix = testing::TempDir() + "layer_test_checkpoint_0_d";
+    auto features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> layers = {make_layer(*features, {"cat-52", "cat-67"}, fabric)};
+    Simulation_Time time = make_time();
+    layers[0]->update_models();
+    ngen::checkpoint::write(prefix, 0, 1, time, 1, layers, *features);
+
+    // The same layer, but of the C++ test model that cannot save its state
+    SetUp();
+    auto cpp_features = make_features();
+    std::vector<std::shared_ptr<ngen::Layer>> cpp_layers = {make_layer(*cpp_features, {"cat-52", "cat-67"}, fabric)};
+    cpp_layers[0]->update_models();
+    cpp_layers[0]->update_models();
+    ASSERT_THROW(ngen::checkpoint::write(prefix, 0, 1, time, 2, cpp_layers, *cpp_features), std::runtime_error);
+
+    std::string path = ngen::checkpoint::rank_path(prefix, 0);
+    ASSERT_FALSE(file_exists(path + ".tmp" + std::to_string(getpid())));
+    ASSERT_EQ(ngen::checkpoint::read(prefix, 0, 1, time, layers, *features), 1);
+    std::remove(path.c_str());
+}
+#endif  // NGEN_BMI_C_LIB_TESTS_ACTIVE
+
+#ifdef NGEN_BMI_PY_TESTS_ACTIVE
+/** Test catchments of a batched Python model are all prepared, then updated together, giving per catchment results. */
+TEST_F(Layer_Test, UpdateModels_1_a) {
+    std::shared_ptr<utils::ngenPy::InterpreterUtil> interpreter = utils::ngenPy::InterpreterUtil::getInstance();
+    utils::ngenPy::InterpreterUtil::addToPyPath("./extern/");
+
+    realization_config = make_realization_config(make_python_formulation(true));
+    auto features = make_features();
+    auto layer = make_layer(*features, {"cat-52", "cat-67"}, fabric);
+    auto nexus = features->nexus_at("nex-1");
+
+    // Both catchments are rows of the one batched model of the formulation
+    auto batch = models::bmi::Bmi_Py_Batch::get_shared("test_bmi_py.bmi_model_batched",
+                                                       "test_bmi_py.bmi_model_batched");
+    ASSERT_EQ(batch->num_rows(), 2u);
+
+    // The batched model computes the same outputs as the unbatched one, run separately for each catchment
+    realization_config = make_realization_config(make_python_formulation(false));
+    auto expected_features = make_features();
+    std::vector<std::pair<std::string, double>> areas = {{"cat-52", 1.5}, {"cat-67", 2.5}};
+
+    for (int t = 0; t < 3; ++t) {
+        layer->update_models();
+        double expected = 0.0;
+        for (const auto& area : areas) {
+            auto formulation = std::dynamic_pointer_cast<realization::Catchment_Formulation>(
+                expected_features->catchment_at(area.first));
+            expected += formulation->get_response(t, 3600) * area.second * 1000000 / 3600.0;
+        }
+        std::pair<double, int> flows = nexus->inspect_upstream_flows(t);
+        ASSERT_EQ(flows.second, 2);
+        ASSERT_DOUBLE_EQ(flows.first, expected);
+    }
+}
+#endif  // NGEN_BMI_PY_TESTS_ACTIVE
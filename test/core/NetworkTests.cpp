@@ -355,3 +355,30 @@ TEST_F(Network_Test2, test_dfr_filter)
   //ASSERT_FALSE( std::distance(cat0_it, cat2_it) > 0 );
 }
 
+
+TEST_F(Network_Test2, test_levels)
+{
+  //Headwaters are level 0, everything else is one below its deepest upstream neighbor
+  ASSERT_EQ( n.get_level("cat-0"), 0 );
+  ASSERT_EQ( n.get_level("cat-1"), 0 );
+  ASSERT_EQ( n.get_level("cat-3"), 0 );
+  ASSERT_EQ( n.get_level("cat-4"), 0 );
+  ASSERT_EQ( n.get_level("nex-0"), 1 );
+  ASSERT_EQ( n.get_level("cat-2"), 2 );
+  ASSERT_EQ( n.get_level("nex-1"), 3 );
+  ASSERT_EQ( n.num_levels(), 4 );
+  ASSERT_THROW( n.get_level("cat-99"), std::invalid_argument );
+}
+
+TEST_F(Network_Test2, test_level_filter)
+{
+  //Catchments must come in non-decreasing level order, so cat-2 is last and all others are headwaters before it
+  auto catchments = n.filter("cat", network::SortOrder::Level);
+  std::vector<std::string> ids(catchments.begin(), catchments.end());
+  ASSERT_EQ( ids.size(), 5 );
+  ASSERT_EQ( ids.back(), "cat-2" );
+  for(std::size_t i = 1; i < ids.size(); ++i)
+  {
+    ASSERT_LE( n.get_level(ids[i-1]), n.get_level(ids[i]) );
+  }
+}
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 
+#include <thread>
+#include <vector>
+
 #include "core/mediator/UnitsHelper.hpp"
 
 class UnitsHelper_Test : public ::testing::Test {
@@ -61,3 +64,47 @@ TEST_F(UnitsHelper_Test, TestConvertArrayDontModifyInputNoOp){
     ASSERT_EQ( expected,  data2);
     ASSERT_EQ( data.at(2), 3);
 }
+
+TEST_F(UnitsHelper_Test, TestConversionInterned){
+    const UnitsHelper::conversion& c = UnitsHelper::get_conversion("km", "m");
+    ASSERT_EQ( &c, &UnitsHelper::get_conversion("km", "m"));
+    ASSERT_FALSE( c.is_identity());
+    ASSERT_EQ( 2000.0, c.convert(2.0));
+    ASSERT_TRUE( UnitsHelper::get_conversion("m", "meters").is_identity());
+}
+
+TEST_F(UnitsHelper_Test, TestConversionWithOffset){
+    std::vector<double> data = {-273.15, 0, 100};
+    UnitsHelper::get_conversion("degC", "K").convert(data.data(), data.data(), data.size());
+    ASSERT_NEAR(0.0, data[0], 0.000000001);
+    ASSERT_NEAR(273.15, data[1], 0.000000001);
+    ASSERT_NEAR(373.15, data[2], 0.000000001);
+}
+
+TEST_F(UnitsHelper_Test, TestConversionInvalid){
+    ASSERT_THROW(UnitsHelper::get_conversion("m", "s"), std::runtime_error);
+    // Failures are remembered, and still reported
+    ASSERT_THROW(UnitsHelper::get_conversion("m", "s"), std::runtime_error);
+    ASSERT_THROW(UnitsHelper::get_conversion("", "m"), std::runtime_error);
+}
+
+TEST_F(UnitsHelper_Test, TestConcurrentConversions){
+    const std::vector<std::string> units = {"mm", "cm", "km", "m"};
+    std::vector<std::thread> threads;
+    std::vector<double> results(units.size() * 2);
+    for (size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&units, &results, t]() {
+            double sum = 0;
+            for (int i = 0; i < 1000; ++i) {
+                sum += UnitsHelper::get_converted_value("m", 1.0, units[t % units.size()]);
+            }
+            results[t] = sum / 1000;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_NEAR(1000.0, results[0], 0.000000001);
+    ASSERT_NEAR(0.001, results[2 + units.size()], 0.000000001);
+    ASSERT_NEAR(1.0, results[3], 0.000000001);
+}
@@ -2,6 +2,7 @@
 
 #include "gtest/gtest.h"
 #include "HY_PointHydroNexusRemote.hpp"
+#include "RemoteNexusExchange.hpp"
 
 
 #include <vector>
@@ -466,6 +467,163 @@ TEST_F(Nexus_Remote_Test, TestDeadlock1)
     MPI_Barrier(MPI_COMM_WORLD);
 }
 
+//Test the flows of several nexuses between two ranks, in both directions, are exchanged in aggregated messages
+TEST_F(Nexus_Remote_Test, TestExchangeAggregated)
+{
+    if ( mpi_num_procs < 2 ) {
+        GTEST_SKIP();
+    }
+
+    const int num_nexuses = 5;
+    std::vector<std::shared_ptr<HY_PointHydroNexusRemote>> nexuses;
+    RemoteNexusExchange exchange;
+
+    if ( mpi_rank < 2 )
+    {
+        int other = 1 - mpi_rank;
+        // nex-10x flow from rank 0 to rank 1, nex-20x from rank 1 to rank 0
+        for ( int i = 0; i < 2 * num_nexuses; ++i )
+        {
+            int from = i < num_nexuses ? 0 : 1;
+            std::string n = std::to_string((from + 1) * 10) + std::to_string(i % num_nexuses);
+            HY_PointHydroNexusRemote::catcment_location_map_t loc_map;
+            loc_map[from == mpi_rank ? "cat-" + n + "1" : "cat-" + n + "0"] = other;
+            nexuses.push_back(std::make_shared<HY_PointHydroNexusRemote>("nex-" + n,
+                std::vector<std::string>{"cat-" + n + "1"}, std::vector<std::string>{"cat-" + n + "0"}, loc_map));
+            exchange.add_nexus(nexuses.back());
+        }
+    }
+    exchange.setup();
+
+    if ( mpi_rank < 2 )
+    {
+        ASSERT_EQ(exchange.num_send_neighbors(), 1);
+        ASSERT_EQ(exchange.num_receive_neighbors(), 1);
+    }
+    else
+    {
+        ASSERT_EQ(exchange.num_send_neighbors(), 0);
+        ASSERT_EQ(exchange.num_receive_neighbors(), 0);
+    }
+
+    for ( long ts = 0; ts < 3; ++ts )
+    {
+        if ( mpi_rank >= 2 ) break;
+        // add the local flows in reverse slot order, the message leaves with the last one
+        for ( int i = 2 * num_nexuses - 1; i >= 0; --i )
+        {
+            if ( nexuses[i]->is_remote_sender() )
+            {
+                nexuses[i]->add_upstream_flow(stored_discharge[ts] * (i + 1), "cat-" + nexuses[i]->get_id().substr(4) + "0", ts);
+            }
+        }
+        for ( int i = 0; i < 2 * num_nexuses; ++i )
+        {
+            if ( !nexuses[i]->is_remote_sender() )
+            {
+                double received_flow = nexuses[i]->get_downstream_flow("cat-" + nexuses[i]->get_id().substr(4) + "1", ts, 100.0);
+                ASSERT_EQ(stored_discharge[ts] * (i + 1), received_flow);
+            }
+        }
+    }
+
+    exchange.finalize();
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+//Test ranks disagreeing on the nexuses they share is detected during setup
+TEST_F(Nexus_Remote_Test, TestExchangeMismatch)
+{
+    if ( mpi_num_procs < 2 ) {
+        GTEST_SKIP();
+    }
+
+    RemoteNexusExchange exchange;
+    HY_PointHydroNexusRemote::catcment_location_map_t loc_map;
+
+    if ( mpi_rank == 0 )
+    {
+        loc_map["cat-31"] = 1;
+        exchange.add_nexus(std::make_shared<HY_PointHydroNexusRemote>("nex-30", std::vector<std::string>{"cat-31"}, std::vector<std::string>{"cat-30"}, loc_map));
+        ASSERT_NO_THROW(exchange.setup());
+    }
+    else if ( mpi_rank == 1 )
+    {
+        loc_map["cat-40"] = 0;
+        exchange.add_nexus(std::make_shared<HY_PointHydroNexusRemote>("nex-40", std::vector<std::string>{"cat-41"}, std::vector<std::string>{"cat-40"}, loc_map));
+        ASSERT_THROW(exchange.setup(), std::runtime_error);
+    }
+    else
+    {
+        ASSERT_NO_THROW(exchange.setup());
+    }
+
+    exchange.finalize();
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+
+//Test a nexus splitting its flow between receiving catchments on three ranks, with and without an exchange
+TEST_F(Nexus_Remote_Test, TestFanOut)
+{
+    if ( mpi_num_procs < 3 )
+    {
+        GTEST_SKIP();
+    }
+
+    for ( bool use_exchange : {false, true} )
+    {
+        // cat-50 on rank 0 contributes, cat-51, cat-52 and cat-53 on ranks 0, 1 and 2 receive
+        std::vector<std::string> upstream_catchments = {"cat-50"};
+        std::vector<std::string> downstream_catchments = {"cat-51", "cat-52", "cat-53"};
+        std::vector<int> location = {0, 0, 1, 2};
+        HY_PointHydroNexusRemote::catcment_location_map_t loc_map;
+        for ( int i = 0; i < 4; ++i )
+        {
+            if ( location[i] != mpi_rank )
+            {
+                loc_map["cat-5" + std::to_string(i)] = location[i];
+            }
+        }
+
+        std::shared_ptr<HY_PointHydroNexusRemote> nexus;
+        RemoteNexusExchange exchange;
+        if ( mpi_rank < 3 )
+        {
+            nexus = std::make_shared<HY_PointHydroNexusRemote>("nex-50", downstream_catchments, upstream_catchments, loc_map);
+            ASSERT_EQ(nexus->is_remote_sender(), mpi_rank == 0);
+            ASSERT_EQ(nexus->is_primary_copy(), mpi_rank == 0);
+            ASSERT_DOUBLE_EQ(nexus->get_local_share(), 100.0 / 3.0);
+            if ( use_exchange )
+            {
+                exchange.add_nexus(nexus);
+            }
+        }
+        exchange.setup();
+
+        for ( long ts = 0; ts < 3 && mpi_rank < 3; ++ts )
+        {
+            double total = stored_discharge[ts] * 3.0;
+            if ( mpi_rank == 0 )
+            {
+                nexus->add_upstream_flow(total, "cat-50", ts);
+            }
+            std::string receiver = downstream_catchments[mpi_rank];
+            // requests are of the total flow, each rank may take only the share of its own receivers
+            ASSERT_NEAR(nexus->get_downstream_flow(receiver, ts, 10.0), total * 0.1, 1e-12);
+            if ( ts == 0 )
+            {
+                ASSERT_ANY_THROW(nexus->get_downstream_flow(receiver, ts, 30.0));
+            }
+            ASSERT_NEAR(nexus->get_downstream_flow(receiver, ts, 100.0 / 3.0 - 10.0), total * (1.0 / 3.0 - 0.1), 1e-12);
+        }
+
+        exchange.finalize();
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+}
+
+
 TEST_F(Nexus_Remote_Test, DISABLED_TestTree1)
 {
     int tree_height = 2;
@@ -3,9 +3,15 @@
 #include "HY_PointHydroNexus.hpp"
 #include "HY_HydroLocation.hpp"
 #include "HY_IndirectPosition.hpp"
+#include "NexusFlowBuffer.hpp"
 
 #include <vector>
 #include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
 using namespace hy_features::hydrolocation;
 
 class Nexus_Test : public ::testing::Test {
@@ -52,3 +58,249 @@ TEST_F(Nexus_Test, TestInit0)
     HY_PointHydroNexus("nex-0", contrib);
     ASSERT_TRUE( true );
 }
+
+//! Test that flow is conserved across partial downstream requests and that bookkeeping is released afterwards.
+TEST_F(Nexus_Test, TestConservation)
+{
+    HY_PointHydroNexus nexus("nex-0", {"cat-2", "cat-3"}, {"cat-0", "cat-1"});
+    nexus.add_upstream_flow(1.5, "cat-0", 0);
+    nexus.add_upstream_flow(2.5, "cat-1", 0);
+
+    auto upstream = nexus.inspect_upstream_flows(0);
+    ASSERT_DOUBLE_EQ(upstream.first, 4.0);
+    ASSERT_EQ(upstream.second, 2);
+
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 0, 25.0), 1.0);
+    auto requests = nexus.inspect_downstream_requests(0);
+    ASSERT_DOUBLE_EQ(requests.first, 25.0);
+    ASSERT_EQ(requests.second, 1);
+
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-3", 0, 75.0), 3.0);
+    // all flow has been released, so nothing is recorded any more
+    ASSERT_EQ(nexus.inspect_upstream_flows(0).second, 0);
+    ASSERT_EQ(nexus.inspect_downstream_requests(0).second, 0);
+}
+
+//! Test that flow added by contributor index is accounted as that added by the contributor's id.
+TEST_F(Nexus_Test, TestContributorIndex)
+{
+    HY_PointHydroNexus nexus("nex-0", {"cat-2"}, {"cat-0", "cat-1"});
+    std::size_t c0 = nexus.get_contributor_index("cat-0");
+    std::size_t c1 = nexus.get_contributor_index("cat-1");
+    ASSERT_NE(c0, c1);
+    ASSERT_EQ(nexus.get_contributor_index("cat-0"), c0);
+
+    nexus.add_upstream_flow(1.5, c0, 0);
+    nexus.add_upstream_flow(2.5, "cat-1", 0);
+    nexus.add_upstream_flow(1.0, c1, 0);
+    auto upstream = nexus.inspect_upstream_flows(0);
+    ASSERT_DOUBLE_EQ(upstream.first, 5.0);
+    ASSERT_EQ(upstream.second, 3);
+
+    // contributors first seen later keep the indices of earlier ones valid
+    std::size_t c4 = nexus.get_contributor_index("cat-4");
+    nexus.add_upstream_flow(1.0, c4, 1);
+    nexus.add_upstream_flow(2.0, c0, 1);
+    ASSERT_DOUBLE_EQ(nexus.inspect_upstream_flows(1).first, 3.0);
+
+    ASSERT_THROW(nexus.add_upstream_flow(1.0, c4 + 1, 1), std::exception);
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 0, 100.0), 5.0);
+}
+
+//! Test that invalid operations on a time step are rejected.
+TEST_F(Nexus_Test, TestInvalidOperations)
+{
+    HY_PointHydroNexus nexus("nex-0", {"cat-2"}, {"cat-0"});
+
+    // nothing to release yet
+    ASSERT_THROW(nexus.get_downstream_flow("cat-2", 0, 100.0), std::exception);
+
+    nexus.add_upstream_flow(1.0, "cat-0", 0);
+    // no more than 100% may ever be requested
+    ASSERT_THROW(nexus.get_downstream_flow("cat-2", 0, 100.1), std::exception);
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 0, 60.0), 0.6);
+    ASSERT_THROW(nexus.get_downstream_flow("cat-2", 0, 50.0), std::exception);
+    // no water may be added once requests were made
+    ASSERT_THROW(nexus.add_upstream_flow(1.0, "cat-0", 0), std::exception);
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 0, 40.0), 0.4);
+
+    // the time step is complete
+    ASSERT_THROW(nexus.add_upstream_flow(1.0, "cat-0", 0), std::exception);
+    ASSERT_THROW(nexus.get_downstream_flow("cat-2", 0, 10.0), std::exception);
+
+    // time steps before the minimum may not be used
+    nexus.set_mintime(5);
+    ASSERT_THROW(nexus.add_upstream_flow(1.0, "cat-0", 4), std::exception);
+    nexus.add_upstream_flow(1.0, "cat-0", 5);
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 5, 100.0), 1.0);
+}
+
+//! Test many time steps in flight at once, completed out of order, including contributors not known up front.
+TEST_F(Nexus_Test, TestManyOpenTimeSteps)
+{
+    HY_PointHydroNexus nexus("nex-0", {"cat-2"}, {"cat-0"});
+    const long steps = 100;
+    for (long t = 0; t < steps; ++t) {
+        nexus.add_upstream_flow(t, "cat-0", t);
+        nexus.add_upstream_flow(1.0, "cat-1", t);
+    }
+    for (long t = steps - 1; t >= 0; t -= 2) {
+        ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", t, 100.0), t + 1.0);
+    }
+    for (long t = 0; t < steps; t += 2) {
+        ASSERT_EQ(nexus.inspect_upstream_flows(t).second, 2);
+        ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", t, 100.0), t + 1.0);
+    }
+    for (long t = 0; t < steps; ++t) {
+        ASSERT_THROW(nexus.add_upstream_flow(1.0, "cat-0", t), std::exception);
+    }
+    // the ring keeps working once everything before has completed
+    for (long t = steps; t < 10 * steps; ++t) {
+        nexus.add_upstream_flow(2.0, "cat-0", t);
+        ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", t, 100.0), 2.0);
+    }
+}
+
+//! Test that time steps in flight are restored from a checkpoint of the nexus state, including partial requests.
+TEST_F(Nexus_Test, TestStateRoundTrip)
+{
+    HY_PointHydroNexus nexus("nex-0", {"cat-2"}, {"cat-0"});
+    nexus.add_upstream_flow(1.0, "cat-0", 0);
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 0, 100.0), 1.0);
+    nexus.add_upstream_flow(2.0, "cat-0", 1);
+    nexus.add_upstream_flow(3.0, "cat-1", 1);
+    ASSERT_DOUBLE_EQ(nexus.get_downstream_flow("cat-2", 1, 40.0), 2.0);
+    nexus.add_upstream_flow(4.0, "cat-1", 2);
+
+    std::stringstream state;
+    nexus.write_state(state);
+
+    // contributors are seen in another order by the restored nexus
+    HY_PointHydroNexus restored("nex-0", {"cat-2"}, {"cat-0"});
+    restored.add_upstream_flow(9.0, "cat-1", 7);
+    restored.read_state(state);
+
+    ASSERT_THROW(restored.add_upstream_flow(1.0, "cat-0", 0), std::exception);
+    ASSERT_THROW(restored.add_upstream_flow(1.0, "cat-1", 1), std::exception);
+    ASSERT_EQ(restored.inspect_downstream_requests(1).second, 1);
+    ASSERT_DOUBLE_EQ(restored.get_downstream_flow("cat-2", 1, 60.0), 3.0);
+    ASSERT_EQ(restored.inspect_upstream_flows(7).second, 0);
+    auto upstream = restored.inspect_upstream_flows(2);
+    ASSERT_DOUBLE_EQ(upstream.first, 4.0);
+    ASSERT_EQ(upstream.second, 1);
+    restored.add_upstream_flow(1.0, "cat-0", 2);
+    ASSERT_DOUBLE_EQ(restored.get_downstream_flow("cat-2", 2, 100.0), 5.0);
+
+    std::stringstream truncated(state.str().substr(0, 10));
+    ASSERT_THROW(restored.read_state(truncated), std::runtime_error);
+}
+
+TEST_F(Nexus_Test, TestFlowBuffer)
+{
+    NexusFlowBuffer buffer({"nex-1", "nex-2", "nex-3"}, 4);
+    ASSERT_EQ(buffer.num_nexuses(), 3);
+    ASSERT_EQ(buffer.num_times(), 4);
+    ASSERT_EQ(buffer.row("nex-2"), 1);
+    ASSERT_EQ(buffer.row("nex-4"), -1);
+    ASSERT_TRUE(std::isnan(buffer.get(0, 0)));
+
+    for (long t = 0; t < 4; ++t) {
+        buffer.set(buffer.row("nex-3"), t, t + 0.5);
+        buffer.set(buffer.row("nex-1"), t, -t);
+    }
+    // rows of time steps, one row per nexus
+    const double* flows = buffer.data();
+    ASSERT_DOUBLE_EQ(flows[0 * 4 + 3], -3.0);
+    ASSERT_TRUE(std::isnan(flows[1 * 4 + 2]));
+    ASSERT_DOUBLE_EQ(flows[2 * 4 + 1], 1.5);
+    ASSERT_DOUBLE_EQ(buffer.get(2, 3), 3.5);
+
+    // a later, shorter window of time steps
+    buffer.start_window(4, 2);
+    ASSERT_EQ(buffer.first_time_index(), 4);
+    ASSERT_EQ(buffer.num_times(), 2);
+    ASSERT_FALSE(buffer.holds_time(3));
+    ASSERT_TRUE(buffer.holds_time(5));
+    ASSERT_FALSE(buffer.holds_time(6));
+    ASSERT_TRUE(std::isnan(buffer.get(2, 4)));
+    buffer.set(2, 5, 7.0);
+    ASSERT_DOUBLE_EQ(buffer.data()[2 * 2 + 1], 7.0);
+    // writes outside of the window are rejected
+    ASSERT_THROW(buffer.set(2, 6, 1.0), std::out_of_range);
+    ASSERT_THROW(buffer.set(2, 3, 1.0), std::out_of_range);
+    ASSERT_THROW(buffer.set(3, 5, 1.0), std::out_of_range);
+
+    // the window is handed over without copying, leaving no time steps until the next window
+    const double* window_data = buffer.data();
+    NexusFlowBuffer window = buffer.take_window();
+    ASSERT_EQ(buffer.num_times(), 0);
+    ASSERT_THROW(buffer.set(2, 5, 1.0), std::out_of_range);
+    ASSERT_EQ(window.ids(), buffer.ids());
+    ASSERT_EQ(window.first_time_index(), 4);
+    ASSERT_EQ(window.num_times(), 2);
+    ASSERT_EQ(window.data(), window_data);
+    std::vector<double> taken = window.take_flows();
+    ASSERT_EQ(taken.data(), window_data);
+    ASSERT_EQ(taken.size(), 6);
+    ASSERT_EQ(window.num_times(), 0);
+
+    buffer.start_window(6, 2);
+    buffer.set(0, 7, 2.0);
+    ASSERT_DOUBLE_EQ(buffer.get(0, 7), 2.0);
+}
+
+/**
+ * Microbenchmark of nexus flow bookkeeping: two contributions and one 100% request per nexus per time step.
+ *
+ * Disabled by default; run with ``--gtest_also_run_disabled_tests``.  The network size and the number of simulated
+ * hourly time steps can be set with the ``NGEN_NEXUS_BENCH_NEXUSES`` and ``NGEN_NEXUS_BENCH_STEPS`` environment
+ * variables.  Per-operation costs are also projected to a year of hourly steps.
+ */
+TEST_F(Nexus_Test, DISABLED_BenchmarkAddGet)
+{
+    auto param = [](const char* name, long default_value) {
+        const char* value = std::getenv(name);
+        return value != nullptr ? std::atol(value) : default_value;
+    };
+    const long num_nexuses = param("NGEN_NEXUS_BENCH_NEXUSES", 1000000);
+    const long num_steps = param("NGEN_NEXUS_BENCH_STEPS", 48);
+
+    std::vector<std::unique_ptr<HY_PointHydroNexus>> nexuses;
+    std::vector<std::string> contributors, receivers;
+    nexuses.reserve(num_nexuses);
+    contributors.reserve(2 * num_nexuses);
+    receivers.reserve(num_nexuses);
+    for (long n = 0; n < num_nexuses; ++n) {
+        contributors.push_back("cat-" + std::to_string(2 * n));
+        contributors.push_back("cat-" + std::to_string(2 * n + 1));
+        receivers.push_back("cat-" + std::to_string(2 * num_nexuses + n));
+        nexuses.emplace_back(new HY_PointHydroNexus("nex-" + std::to_string(n), {receivers.back()},
+                                                    {contributors[2 * n], contributors[2 * n + 1]}));
+    }
+
+    std::chrono::duration<double> add_time(0), get_time(0);
+    double total = 0.0;
+    for (long t = 0; t < num_steps; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        for (long n = 0; n < num_nexuses; ++n) {
+            nexuses[n]->add_upstream_flow(1.0, contributors[2 * n], t);
+            nexuses[n]->add_upstream_flow(2.0, contributors[2 * n + 1], t);
+        }
+        auto added = std::chrono::steady_clock::now();
+        for (long n = 0; n < num_nexuses; ++n) {
+            total += nexuses[n]->get_downstream_flow(receivers[n], t, 100.0);
+        }
+        auto done = std::chrono::steady_clock::now();
+        add_time += added - start;
+        get_time += done - added;
+    }
+
+    const double adds = 2.0 * num_nexuses * num_steps;
+    const double gets = 1.0 * num_nexuses * num_steps;
+    std::cout << "Nexuses: " << num_nexuses << ", time steps: " << num_steps << std::endl;
+    std::cout << "add_upstream_flow: " << 1e9 * add_time.count() / adds << " ns/call" << std::endl;
+    std::cout << "get_downstream_flow: " << 1e9 * get_time.count() / gets << " ns/call" << std::endl;
+    std::cout << "Projected for 8760 hourly steps: "
+              << (add_time.count() + get_time.count()) * 8760.0 / num_steps << " s" << std::endl;
+    ASSERT_DOUBLE_EQ(total, 3.0 * num_nexuses * num_steps);
+}
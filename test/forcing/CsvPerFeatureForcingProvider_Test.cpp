@@ -10,6 +10,11 @@
 #include <limits.h>
 #include <ctime>
 #include <time.h>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 class CsvPerFeatureForcingProviderTest : public ::testing::Test {
 
@@ -222,3 +227,244 @@ TEST_F(CsvPerFeatureForcingProviderTest, TestForcingUnitHeaderParsing)
         
     }
 }
+
+///Test reading and writing the binary sidecar of a forcing file
+TEST_F(CsvPerFeatureForcingProviderTest, TestForcingBinaryCache)
+{
+    char dir_template[] = "/tmp/ngen_csv_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string dir(dir_template);
+    const std::string csv_path = dir + "/cat-1.csv";
+    const std::string cache_path = csv_path + data_access::CsvForcingTable::CACHE_SUFFIX;
+
+    auto write_csv = [&csv_path](const std::string& second_temp) {
+        std::ofstream out(csv_path, std::ios::trunc);
+        out << "time,TMP_2maboveground,precip_rate\n"
+            << "2015-12-01 00:00:00,280.0,0.0\n"
+            << "2015-12-01 01:00:00," << second_temp << ",0.5\n"
+            << "2015-12-01 02:00:00,282.0,0.0\n";
+    };
+    auto get_temp = [&csv_path]() {
+        forcing_params p(csv_path, "CsvPerFeature", "2015-12-01 00:00:00", "2015-12-01 02:00:00", 0, 0, true);
+        CsvPerFeatureForcingProvider provider(p);
+        time_t t = provider.get_data_start_time() + 3600;
+        return provider.get_value(CatchmentAggrDataSelector("", CSDMS_STD_NAME_SURFACE_TEMP, t, 3600, "K"), data_access::MEAN);
+    };
+
+    write_csv("281.0");
+    struct stat csv_stat;
+    ASSERT_EQ(stat(csv_path.c_str(), &csv_stat), 0);
+    EXPECT_NEAR(get_temp(), 281.0, 0.00001);
+    EXPECT_EQ(access(cache_path.c_str(), R_OK), 0);
+
+    // Same size and modification time, so the sidecar is still considered current and its values are used
+    write_csv("283.0");
+    struct timespec times[2] = { csv_stat.st_atim, csv_stat.st_mtim };
+    ASSERT_EQ(utimensat(AT_FDCWD, csv_path.c_str(), times, 0), 0);
+    EXPECT_NEAR(get_temp(), 281.0, 0.00001);
+
+    // A newer CSV replaces the sidecar
+    times[1].tv_sec += 10;
+    ASSERT_EQ(utimensat(AT_FDCWD, csv_path.c_str(), times, 0), 0);
+    EXPECT_NEAR(get_temp(), 283.0, 0.00001);
+    EXPECT_NEAR(get_temp(), 283.0, 0.00001);
+
+    std::remove(cache_path.c_str());
+    std::remove(csv_path.c_str());
+    rmdir(dir.c_str());
+}
+
+namespace {
+    /** Write a forcing CSV with a record at each of the given times, whose temperature is its row index. */
+    std::string write_indexed_forcing(const std::string& dir, const std::string& name, const std::vector<time_t>& times)
+    {
+        const std::string path = dir + "/" + name;
+        std::ofstream out(path, std::ios::trunc);
+        out << "time,TMP_2maboveground,precip_rate\n";
+        char buffer[32];
+        for (size_t i = 0; i < times.size(); ++i) {
+            struct tm t;
+            gmtime_r(&times[i], &t);
+            strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &t);
+            out << buffer << "," << i << ".0,0.0\n";
+        }
+        return path;
+    }
+
+    double get_indexed_temp(CsvPerFeatureForcingProvider& provider, time_t t, long duration)
+    {
+        return provider.get_value(CatchmentAggrDataSelector("", CSDMS_STD_NAME_SURFACE_TEMP, t, duration, "K"), data_access::MEAN);
+    }
+}
+
+///Test indexing forcing records that are not an hour apart
+TEST_F(CsvPerFeatureForcingProviderTest, TestForcingSubHourlyAndIrregularRecords)
+{
+    char dir_template[] = "/tmp/ngen_csv_index_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string dir(dir_template);
+    const time_t start = 1448928000; // 2015-12-01 00:00:00
+
+    // Every 15 minutes
+    std::vector<time_t> times;
+    for (int i = 0; i < 9; ++i) {
+        times.push_back(start + i * 900);
+    }
+    const std::string quarter_path = write_indexed_forcing(dir, "quarter.csv", times);
+    CsvPerFeatureForcingProvider quarter(forcing_params(quarter_path, "CsvPerFeature", "2015-12-01 00:00:00", "2015-12-01 02:00:00"));
+    EXPECT_EQ(quarter.record_duration(), 900);
+    EXPECT_EQ(quarter.get_ts_index_for_time(start + 900 * 5 + 10), 5);
+    EXPECT_NEAR(get_indexed_temp(quarter, start + 900 * 3, 900), 3.0, 0.00001);
+    // An hour spans four records
+    EXPECT_NEAR(get_indexed_temp(quarter, start + 900 * 4, 3600), 5.5, 0.00001);
+
+    // Hourly, then half-hourly
+    times = { start, start + 3600, start + 7200, start + 9000, start + 10800 };
+    const std::string irregular_path = write_indexed_forcing(dir, "irregular.csv", times);
+    CsvPerFeatureForcingProvider irregular(forcing_params(irregular_path, "CsvPerFeature", "2015-12-01 00:00:00", "2015-12-01 03:00:00"));
+    EXPECT_EQ(irregular.get_ts_index_for_time(start + 3599), 0);
+    EXPECT_EQ(irregular.get_ts_index_for_time(start + 7200), 2);
+    EXPECT_EQ(irregular.get_ts_index_for_time(start + 9100), 3);
+    EXPECT_EQ(irregular.get_ts_index_for_time(start + 20000), 4);
+    EXPECT_NEAR(get_indexed_temp(irregular, start + 7200, 3600), 2.5, 0.00001);
+
+    std::remove(quarter_path.c_str());
+    std::remove(irregular_path.c_str());
+    rmdir(dir.c_str());
+}
+
+///Test time steps late in a multi-year simulation are indexed directly from the record spacing
+TEST_F(CsvPerFeatureForcingProviderTest, TestIndexLateInMultiYearRun)
+{
+    char dir_template[] = "/tmp/ngen_csv_years_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string dir(dir_template);
+    const time_t start = 1420070400; // 2015-01-01 00:00:00
+    const size_t num_hours = 5 * 8760;
+
+    std::vector<time_t> times(num_hours);
+    for (size_t i = 0; i < num_hours; ++i) {
+        times[i] = start + static_cast<time_t>(i) * 3600;
+    }
+    const std::string path = write_indexed_forcing(dir, "years.csv", times);
+    CsvPerFeatureForcingProvider provider(forcing_params(path, "CsvPerFeature", "2015-01-01 00:00:00", "2019-12-30 23:00:00"));
+
+    const size_t late_hour = num_hours - 30;
+    EXPECT_EQ(provider.get_ts_index_for_time(start + static_cast<time_t>(late_hour) * 3600), late_hour);
+    EXPECT_EQ(provider.get_ts_index_for_time(start + static_cast<time_t>(late_hour) * 3600 + 1800), late_hour);
+    EXPECT_NEAR(get_indexed_temp(provider, start + static_cast<time_t>(late_hour) * 3600, 3600), late_hour, 0.00001);
+
+    std::remove(path.c_str());
+    rmdir(dir.c_str());
+}
+
+///Benchmark getting values over a multi-year simulation, which should cost the same at the end as at the beginning
+TEST_F(CsvPerFeatureForcingProviderTest, DISABLED_BenchmarkForcingLookupOverMultiYearRun)
+{
+    char dir_template[] = "/tmp/ngen_csv_bench_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string dir(dir_template);
+    const time_t start = 1420070400; // 2015-01-01 00:00:00
+    const size_t num_hours = 5 * 8760;
+
+    std::vector<time_t> times(num_hours);
+    for (size_t i = 0; i < num_hours; ++i) {
+        times[i] = start + static_cast<time_t>(i) * 3600;
+    }
+    const std::string path = write_indexed_forcing(dir, "years.csv", times);
+    CsvPerFeatureForcingProvider provider(forcing_params(path, "CsvPerFeature", "2015-01-01 00:00:00", "2019-12-30 23:00:00"));
+
+    // The best of several runs of many calls, to be robust to noise
+    auto time_calls = [&provider, start](size_t first_hour) {
+        const int calls = 2000;
+        double best_ns = -1;
+        for (int run = 0; run < 5; ++run) {
+            auto begin = std::chrono::steady_clock::now();
+            double sum = 0;
+            for (int i = 0; i < calls; ++i) {
+                sum += get_indexed_temp(provider, start + static_cast<time_t>(first_hour + i % 24) * 3600, 3600);
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            EXPECT_GT(sum, 0.0);
+            best_ns = best_ns < 0 ? elapsed / calls : std::min(best_ns, elapsed / calls);
+        }
+        return best_ns;
+    };
+
+    const double early_ns = time_calls(1);
+    const double late_ns = time_calls(num_hours - 30);
+    std::cerr << "get_value: " << early_ns << " ns/call in the first day, " << late_ns << " ns/call after "
+              << (num_hours - 30) << " hours" << std::endl;
+    EXPECT_NEAR(get_indexed_temp(provider, start + static_cast<time_t>(num_hours - 30) * 3600, 3600), num_hours - 30, 0.00001);
+    // Walking from the start time made late calls thousands of times slower
+    EXPECT_LT(late_ns, early_ns * 5);
+
+    std::remove(path.c_str());
+    rmdir(dir.c_str());
+}
+
+///Test providers for different features sharing the forcing store
+TEST_F(CsvPerFeatureForcingProviderTest, TestForcingSharedStore)
+{
+    char dir_template[] = "/tmp/ngen_csv_store_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string dir(dir_template);
+    const time_t start = 1448928000; // 2015-12-01 00:00:00
+    const std::vector<time_t> times = { start, start + 3600, start + 7200, start + 10800 };
+
+    std::vector<std::string> paths;
+    std::vector<std::shared_ptr<CsvPerFeatureForcingProvider>> providers;
+    for (int i = 0; i < 9; ++i) {
+        std::string path = dir + "/cat-" + std::to_string(i) + ".csv";
+        std::ofstream out(path, std::ios::trunc);
+        // Every third feature also has a variable the others lack
+        out << (i % 3 == 0 ? "time,TMP_2maboveground,precip_rate,EXTRA [m]\n" : "time,TMP_2maboveground,precip_rate\n");
+        for (size_t t = 0; t < times.size(); ++t) {
+            out << "2015-12-01 0" << t << ":00:00," << (100 * i + t) << ".0,0.0" << (i % 3 == 0 ? ",1.5\n" : "\n");
+        }
+        out.close();
+        paths.push_back(path);
+        // Constructing each provider between reads of the others moves the shared values as the store grows
+        providers.push_back(std::make_shared<CsvPerFeatureForcingProvider>(forcing_params(path, "CsvPerFeature", "2015-12-01 00:00:00", "2015-12-01 03:00:00")));
+        EXPECT_NEAR(get_indexed_temp(*providers[0], start + 7200, 3600), 2.0, 0.00001);
+    }
+    data_access::CsvForcingStore::shrink_shared_stores();
+
+    for (int i = 0; i < 9; ++i) {
+        for (size_t t = 0; t < times.size(); ++t) {
+            EXPECT_NEAR(get_indexed_temp(*providers[i], times[t], 3600), 100 * i + t, 0.00001);
+        }
+        auto names = providers[i]->get_available_variable_names();
+        EXPECT_EQ(std::find(names.begin(), names.end(), "EXTRA") != names.end(), i % 3 == 0);
+        if (i % 3 == 0) {
+            EXPECT_NEAR(providers[i]->get_value(CatchmentAggrDataSelector("", "EXTRA", start, 3600, "m"), data_access::MEAN), 1.5, 0.00001);
+        }
+        else {
+            EXPECT_THROW(providers[i]->get_value(CatchmentAggrDataSelector("", "EXTRA", start, 3600, "m"), data_access::MEAN), std::runtime_error);
+        }
+    }
+    // Features with the same columns share their list of names
+    EXPECT_EQ(providers[1]->get_available_variable_names().data(), providers[2]->get_available_variable_names().data());
+
+    for (const std::string& path : paths) {
+        std::remove(path.c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+///Test forcing stores are shared only for identical record times, including times that agree in their first records
+TEST_F(CsvPerFeatureForcingProviderTest, TestForcingSharedStoreLookup)
+{
+    const time_t start = 1448928000; // 2015-12-01 00:00:00
+    const std::vector<time_t> hourly = { start, start + 3600, start + 7200, start + 10800 };
+    // Same first time, spacing and count, but irregular later on
+    const std::vector<time_t> irregular = { start, start + 3600, start + 7200, start + 9000 };
+
+    auto store = data_access::CsvForcingStore::get_shared_store(hourly);
+    EXPECT_EQ(data_access::CsvForcingStore::get_shared_store(hourly), store);
+    auto irregular_store = data_access::CsvForcingStore::get_shared_store(irregular);
+    EXPECT_NE(irregular_store, store);
+    EXPECT_EQ(irregular_store->get_times(), irregular);
+    EXPECT_EQ(data_access::CsvForcingStore::get_shared_store(irregular), irregular_store);
+    EXPECT_NE(data_access::CsvForcingStore::get_shared_store({ start + 3600, start + 7200 }), store);
+}
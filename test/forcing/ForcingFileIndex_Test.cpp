@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "ForcingFileIndex.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class ForcingFileIndexTest : public ::testing::Test {
+
+    protected:
+
+    void SetUp() override {
+        char dir_template[] = "/tmp/ngen_forcing_index_XXXXXX";
+        ASSERT_NE(mkdtemp(dir_template), nullptr);
+        dir = std::string(dir_template) + "/";
+        for (const std::string& name : {
+                "cat-27_2015-12-01 00_00_00_2015-12-30 23_00_00.csv",
+                "cat-2_2015-12-01 00_00_00_2015-12-30 23_00_00.csv",
+                "cat-52_2015-12-01 00_00_00_2015-12-30 23_00_00.csv",
+                "cat-52_2015-12-01 00_00_00_2015-12-30 23_00_00.csv.ngenbin",
+                "forcing_wb-7.csv",
+                "all.csv" }) {
+            std::ofstream(dir + name) << "time\n";
+            files.push_back(dir + name);
+        }
+        ASSERT_EQ(mkdir((dir + "cat-67.csv").c_str(), 0700), 0);
+    }
+
+    void TearDown() override {
+        for (const std::string& file : files) {
+            std::remove(file.c_str());
+        }
+        rmdir((dir + "cat-67.csv").c_str());
+        rmdir(dir.c_str());
+    }
+
+    std::string dir;
+    std::vector<std::string> files;
+};
+
+TEST_F(ForcingFileIndexTest, TestFindById)
+{
+    data_access::ForcingFileIndex index(dir);
+    EXPECT_EQ(index.size(), 9); // Including ".", ".." and the subdirectory
+
+    const std::string pattern = ".*{{id}}.*.csv";
+    EXPECT_EQ(index.find(pattern, "cat-27"), dir + "cat-27_2015-12-01 00_00_00_2015-12-30 23_00_00.csv");
+    // Not the file of a catchment whose id begins the same way
+    EXPECT_EQ(index.find(pattern, "cat-2"), dir + "cat-2_2015-12-01 00_00_00_2015-12-30 23_00_00.csv");
+    EXPECT_EQ(index.find(pattern, "cat-52"), dir + "cat-52_2015-12-01 00_00_00_2015-12-30 23_00_00.csv");
+    EXPECT_EQ(index.find(pattern, "wb-7"), dir + "forcing_wb-7.csv");
+    EXPECT_EQ(index.find(pattern, "cat-99"), "");
+    // Directories are not forcing files
+    EXPECT_EQ(index.find("{{id}}\\.csv", "cat-67"), "");
+}
+
+TEST_F(ForcingFileIndexTest, TestFindByIdPart)
+{
+    data_access::ForcingFileIndex index(dir);
+    // The id is only part of a token in the file name
+    EXPECT_EQ(index.find("forcing_wb-{{id}}\\.csv", "7"), dir + "forcing_wb-7.csv");
+    EXPECT_EQ(index.find("cat-{{id}}_.*\\.csv", "5"), "");
+}
+
+TEST_F(ForcingFileIndexTest, TestFindWithoutSplitting)
+{
+    data_access::ForcingFileIndex index(dir);
+    // Alternation spans the id, so the pattern is matched whole
+    EXPECT_EQ(index.find("none|{{id}}.csv", "all"), dir + "all.csv");
+    // A group around the id
+    EXPECT_EQ(index.find("(forcing_{{id}})\\.csv", "wb-7"), dir + "forcing_wb-7.csv");
+    // An id with characters that are special in a pattern
+    EXPECT_EQ(index.find("{{id}}csv", "all."), dir + "all.csv");
+}
+
+TEST_F(ForcingFileIndexTest, TestFindWithoutId)
+{
+    data_access::ForcingFileIndex index(dir);
+    EXPECT_EQ(index.find("all\\.csv", "cat-27"), dir + "all.csv");
+    EXPECT_EQ(index.find("all\\.csv", "cat-52"), dir + "all.csv");
+}
+
+TEST_F(ForcingFileIndexTest, TestMissingDirectory)
+{
+    EXPECT_THROW(data_access::ForcingFileIndex(dir + "missing/"), std::runtime_error);
+}
@@ -95,6 +95,15 @@ TEST_F(ForcingsEngineLumpedDataProviderTest, Storage)
     ASSERT_EQ(new_inst->model(), provider_->model());
 }
 
+/**
+ * Tests the provider reports calling into Python, so routing is not run
+ * alongside a simulation using it, as the simulation would be without the GIL.
+ */
+TEST_F(ForcingsEngineLumpedDataProviderTest, CallsPython)
+{
+    ASSERT_TRUE(provider_->calls_python());
+}
+
 TEST_F(ForcingsEngineLumpedDataProviderTest, VariableAccess)
 {
     ASSERT_EQ(provider_->divide(), 11223UL);
@@ -30,6 +30,12 @@ class NetCDFPerFeatureDataProviderTest : public ::testing::Test {
 
     std::shared_ptr<data_access::NetCDFPerFeatureDataProvider> nc_provider;
 
+    std::string forcing_file_name;
+
+    time_t sim_start_t;
+
+    time_t sim_end_t;
+
     typedef struct tm time_type;
 
     std::shared_ptr<time_type> start_date_time;
@@ -58,10 +64,12 @@ void NetCDFPerFeatureDataProviderTest::setupForcing()
         "../data/forcing/cats-27_52_67-2015_12_01-2015_12_30.nc",
         "../../data/forcing/cats-27_52_67-2015_12_01-2015_12_30.nc"
         };
-    std::string forcing_file_name = utils::FileChecker::find_first_readable(forcing_file_names);
+    forcing_file_name = utils::FileChecker::find_first_readable(forcing_file_names);
 
     // Using this to compute epoch times... this is what's done in Formulation_Constructors.hpp, FWIW...
     forcing_params forcing_p(forcing_file_name, "NetCDF", "2015-12-01 00:00:00", "2015-12-30 23:00:00");
+    sim_start_t = forcing_p.simulation_start_t;
+    sim_end_t = forcing_p.simulation_end_t;
 
     nc_provider = std::make_shared<data_access::NetCDFPerFeatureDataProvider>(forcing_file_name, forcing_p.simulation_start_t, forcing_p.simulation_end_t, utils::getStdErr() );
     start_date_time = std::make_shared<time_type>();
@@ -114,4 +122,79 @@ TEST_F(NetCDFPerFeatureDataProviderTest, TestForcingDataRead)
         std::runtime_error);
     
 }
+///Test values do not depend on how many time steps are read at once, including windows spanning blocks
+TEST_F(NetCDFPerFeatureDataProviderTest, TestBlockSizes)
+{
+    NetCDFPerFeatureDataProvider single(forcing_file_name, sim_start_t, sim_end_t, utils::getStdErr(), 1);
+    NetCDFPerFeatureDataProvider blocks(forcing_file_name, sim_start_t, sim_end_t, utils::getStdErr(), 5);
+    ASSERT_EQ(single.get_block_size(), 1);
+    ASSERT_EQ(blocks.get_block_size(), 5);
+    EXPECT_GE(nc_provider->get_block_size(), 1);
+
+    auto start_time = nc_provider->get_data_start_time();
+    auto duration = nc_provider->record_duration();
+    for (const auto& id : nc_provider->get_ids()) {
+        for (int t = 0; t < 48; ++t) {
+            for (long steps : {1, 3}) {
+                CatchmentAggrDataSelector selector(id, CSDMS_STD_NAME_SURFACE_TEMP, start_time + t * duration, duration * steps, "K");
+                double expected = single.get_value(selector, data_access::MEAN);
+                EXPECT_DOUBLE_EQ(blocks.get_value(selector, data_access::MEAN), expected);
+                EXPECT_DOUBLE_EQ(nc_provider->get_value(selector, data_access::MEAN), expected);
+            }
+        }
+    }
+}
+
+//Test blocks read ahead in the background match blocks read when needed, including after skipping back and forth
+TEST_F(NetCDFPerFeatureDataProviderTest, TestPrefetch)
+{
+    NetCDFPerFeatureDataProvider direct(forcing_file_name, sim_start_t, sim_end_t, utils::getStdErr(), 4);
+    NetCDFPerFeatureDataProvider prefetched(forcing_file_name, sim_start_t, sim_end_t, utils::getStdErr(), 4, 2);
+
+    auto start_time = direct.get_data_start_time();
+    auto duration = direct.record_duration();
+    for (int t : {0, 1, 5, 9, 13, 2, 30, 31, 47}) {
+        for (const auto& id : direct.get_ids()) {
+            for (const auto& variable : {std::make_pair(CSDMS_STD_NAME_SURFACE_TEMP, "K"), std::make_pair(CSDMS_STD_NAME_SOLAR_SHORTWAVE, "W m-2")}) {
+                CatchmentAggrDataSelector selector(id, variable.first, start_time + t * duration, duration, variable.second);
+                EXPECT_DOUBLE_EQ(prefetched.get_value(selector, data_access::SUM), direct.get_value(selector, data_access::SUM));
+            }
+        }
+    }
+    prefetched.finalize();
+}
+
+///Test units are converted as if after aggregation, including affine conversions
+TEST_F(NetCDFPerFeatureDataProviderTest, TestBlockUnits)
+{
+    auto start_time = nc_provider->get_data_start_time();
+    auto duration = nc_provider->record_duration();
+    auto id = nc_provider->get_ids()[0];
+
+    for (auto m : {data_access::MEAN, data_access::SUM}) {
+        double kelvin = nc_provider->get_value(CatchmentAggrDataSelector(id, CSDMS_STD_NAME_SURFACE_TEMP, start_time, duration * 4, "K"), m);
+        double celsius = nc_provider->get_value(CatchmentAggrDataSelector(id, CSDMS_STD_NAME_SURFACE_TEMP, start_time, duration * 4, "degC"), m);
+        EXPECT_NEAR(celsius, kelvin - 273.15, 1e-9);
+    }
+}
+
+///Test a selector reused across requests, as by formulations, follows changes to its id and provider
+TEST_F(NetCDFPerFeatureDataProviderTest, TestReusedSelector)
+{
+    NetCDFPerFeatureDataProvider other(forcing_file_name, sim_start_t, sim_end_t, utils::getStdErr(), 1);
+    auto start_time = nc_provider->get_data_start_time();
+    auto duration = nc_provider->record_duration();
+    auto ids = nc_provider->get_ids();
+
+    CatchmentAggrDataSelector selector(ids[0], CSDMS_STD_NAME_SURFACE_TEMP, start_time, duration, "K");
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        selector.set_id(ids[i]);
+        for (int t = 0; t < 3; ++t) {
+            selector.set_init_time(start_time + t * duration);
+            double expected = nc_provider->get_value(CatchmentAggrDataSelector(ids[i], CSDMS_STD_NAME_SURFACE_TEMP, start_time + t * duration, duration, "K"), data_access::SUM);
+            EXPECT_DOUBLE_EQ(nc_provider->get_value(selector, data_access::SUM), expected);
+            EXPECT_DOUBLE_EQ(other.get_value(selector, data_access::SUM), expected);
+        }
+    }
+}
 #endif
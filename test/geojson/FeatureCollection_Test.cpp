@@ -332,3 +332,98 @@ TEST_F(FeatureCollection_Test, copy_filter_test) {
 
     ASSERT_EQ(visitor.get(0), "LineStringFeature");
 }
+
+// Features are read from the stream as they are parsed; they should match
+// those built from a property tree of the whole document, including when
+// an id is only known from the properties after the geometry is read.
+TEST_F(FeatureCollection_Test, stream_read_test) {
+    std::string data = "{ "
+        "\"type\": \"FeatureCollection\", "
+        "\"name\": \"stream \\\"test\\\"\", "
+        "\"features\": [ "
+            "{ "
+                "\"type\": \"Feature\", "
+                "\"geometry\": { "
+                    "\"coordinates\": [ "
+                        "[ [0.0, 0.0], [0.0, 4.0], [4.0, 4.0], [0.0, 0.0] ], "
+                        "[ [1.0, 1.0], [1.0, 2.0], [2.0, 2.0], [1.0, 1.0] ] "
+                    "], "
+                    "\"type\": \"Polygon\" "
+                "}, "
+                "\"properties\": { \"id\": \"cat-1\", \"areasqkm\": 14.75, \"order\": 3, \"toid\": \"nex-2\", "
+                                  "\"flags\": [true, false], \"note\": \"caf\\u00e9\", \"missing\": null } "
+            "}, "
+            "{ "
+                "\"type\": \"Feature\", "
+                "\"id\": \"cat-3\", "
+                "\"properties\": { \"toid\": \"nex-4\" }, "
+                "\"geometry\": { "
+                    "\"type\": \"MultiPolygon\", "
+                    "\"coordinates\": [ "
+                        "[ [ [180.0, 40.0], [180.0, 50.0], [170.0, 50.0], [180.0, 40.0] ] ], "
+                        "[ [ [-170.0, 40.0], [-170.0, 50.0], [-180.0, 50.0], [-170.0, 40.0] ] ] "
+                    "] "
+                "} "
+            "}, "
+            "{ "
+                "\"type\": \"Feature\", "
+                "\"id\": \"nex-2\", "
+                "\"bbox\": [1.5, 2.5, 1.5, 2.5], "
+                "\"geometry\": { \"type\": \"Point\", \"coordinates\": [1.5, 2.5, 10.0] } "
+            "} "
+        "] "
+        "}";
+
+    std::stringstream tree_stream(data);
+    boost::property_tree::ptree tree;
+    boost::property_tree::json_parser::read_json(tree_stream, tree);
+    geojson::GeoJSON expected = geojson::build_collection(tree);
+
+    std::stringstream stream(data);
+    geojson::GeoJSON collection = geojson::read(stream);
+    ASSERT_EQ(3, collection->get_size());
+    for (int i = 0; i < 3; i++) {
+        geojson::Feature actual = collection->get_feature(i);
+        geojson::Feature wanted = expected->get_feature(i);
+        ASSERT_EQ(actual->get_id(), wanted->get_id());
+        ASSERT_EQ(actual->get_type(), wanted->get_type());
+        ASSERT_EQ(actual->get_bounding_box(), wanted->get_bounding_box());
+        ASSERT_EQ(actual->property_keys(), wanted->property_keys());
+        for (const auto& key : wanted->property_keys()) {
+            ASSERT_EQ(actual->get_property(key).get_type(), wanted->get_property(key).get_type()) << key;
+            ASSERT_EQ(actual->get_property(key).as_string(), wanted->get_property(key).as_string()) << key;
+        }
+        ASSERT_EQ(actual->keys(), wanted->keys());
+        ASSERT_EQ(collection->get_feature(wanted->get_id()), actual);
+    }
+
+    geojson::polygon_t polygon = collection->get_feature(0)->geometry<geojson::polygon_t>();
+    ASSERT_EQ(polygon.outer().size(), 4);
+    ASSERT_EQ(polygon.inners().size(), 1);
+    ASSERT_EQ(polygon.inners()[0].size(), 4);
+    ASSERT_EQ(collection->get_feature(0)->get_property("note").as_string(), "caf\xc3\xa9");
+    ASSERT_EQ(collection->get_feature(1)->geometry<geojson::multipolygon_t>().size(), 2);
+    geojson::coordinate_t point = collection->get_feature(2)->geometry<geojson::coordinate_t>();
+    ASSERT_EQ(point.get<0>(), 1.5);
+    ASSERT_EQ(point.get<1>(), 2.5);
+
+    std::stringstream subset_stream(data);
+    geojson::GeoJSON subset = geojson::read(subset_stream, {"nex-2", "cat-1"});
+    ASSERT_EQ(2, subset->get_size());
+    ASSERT_EQ(subset->get_feature(0)->get_id(), "cat-1");
+    ASSERT_EQ(subset->get_feature(0)->geometry<geojson::polygon_t>().inners().size(), 1);
+    ASSERT_EQ(subset->get_feature(1)->get_id(), "nex-2");
+    ASSERT_EQ(subset->get_feature("cat-3"), nullptr);
+
+    std::stringstream topology_stream(data);
+    geojson::GeoJSON topology = geojson::read(topology_stream, {"cat-3", "cat-1"}, false);
+    ASSERT_EQ(2, topology->get_size());
+    ASSERT_EQ(topology->get_feature(0)->get_type(), geojson::FeatureType::Polygon);
+    ASSERT_EQ(topology->get_feature(0)->geometry<geojson::polygon_t>().outer().size(), 0);
+    ASSERT_EQ(topology->get_feature(1)->get_type(), geojson::FeatureType::MultiPolygon);
+    ASSERT_EQ(topology->get_feature(1)->geometry<geojson::multipolygon_t>().size(), 0);
+    ASSERT_EQ(topology->get_feature("cat-3")->get_property("toid").as_string(), "nex-4");
+
+    std::stringstream invalid_stream("{ \"features\": [ { \"id\": \"a\" ");
+    ASSERT_THROW(geojson::read(invalid_stream), std::runtime_error);
+}
@@ -1,9 +1,35 @@
 #include <boost/geometry/io/wkt/write.hpp>
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
 #include "geopackage.hpp"
 #include "FileChecker.h"
 
+// Geometries are compared as WKT, since boost::geometry::equals is not
+// reliable for (valid but) complex polygons in geographic coordinates
+struct wkt_visitor : public boost::static_visitor<std::string>
+{
+    template<typename T>
+    std::string operator()(const T& geometry) const
+    {
+        std::ostringstream out;
+        out << std::setprecision(17) << bg::wkt(geometry);
+        return out.str();
+    }
+};
+
+std::string to_wkt(const geojson::geometry& geometry)
+{
+    return boost::apply_visitor(wkt_visitor{}, geometry);
+}
+
 class GeoPackage_Test : public ::testing::Test
 {
   protected:
@@ -28,12 +54,23 @@ class GeoPackage_Test : public ::testing::Test
         if (this->path2.empty()) {
             FAIL() << "can't find test/data/geopackage/example_3857.gpkg";
         }
+
+        this->path3 = utils::FileChecker::find_first_readable({
+            "test/data/routing/gauge_01073000.gpkg",
+            "../test/data/routing/gauge_01073000.gpkg",
+            "../../test/data/routing/gauge_01073000.gpkg"
+        });
+
+        if (this->path3.empty()) {
+            FAIL() << "can't find test/data/routing/gauge_01073000.gpkg";
+        }
     }
 
     void TearDown() override {};
 
     std::string path;
     std::string path2;
+    std::string path3;
 };
 
 TEST_F(GeoPackage_Test, geopackage_read_test)
@@ -100,3 +137,113 @@ TEST_F(GeoPackage_Test, geopackage_projection_test)
 
     ASSERT_TRUE(third == nullptr);
 }
+
+TEST_F(GeoPackage_Test, geopackage_column_subset_test)
+{
+    const auto gpkg = ngen::geopackage::read(this->path3, "divides", {}, { "toid", "not_a_column" });
+    ASSERT_GT(gpkg->get_size(), 0);
+
+    for (const auto& feature : *gpkg) {
+        EXPECT_TRUE(feature->has_property("toid"));
+        EXPECT_TRUE(feature->has_property("divide_id"));
+        EXPECT_FALSE(feature->has_property("areasqkm"));
+        EXPECT_FALSE(feature->has_property("not_a_column"));
+        EXPECT_FALSE(feature->has_property("geom"));
+        EXPECT_EQ(feature->get_id(), feature->get_property("divide_id").as_string());
+    }
+}
+
+// Geometries other than points are decoded when first used; they should be
+// the same as decoding them directly, and their bounding boxes should come
+// from the geometry headers.
+TEST_F(GeoPackage_Test, geopackage_deferred_geometry_test)
+{
+    const auto gpkg = ngen::geopackage::read(this->path3, "divides", {});
+    ASSERT_GT(gpkg->get_size(), 0);
+
+    ngen::sqlite::database db{this->path3};
+    auto query = db.query("SELECT divide_id, geom FROM divides");
+    query.next();
+    int checked = 0;
+    while (!query.done()) {
+        std::vector<double> bounding_box(4);
+        const geojson::geometry expected = ngen::geopackage::build_geometry(query, "geom", bounding_box);
+        const auto& feature = gpkg->get_feature(query.get<std::string>(0));
+        ASSERT_TRUE(feature != nullptr);
+        EXPECT_EQ(feature->get_bounding_box(), bounding_box);
+
+        const geojson::geometry actual = feature->geometry();
+        EXPECT_EQ(actual.which(), expected.which());
+        EXPECT_EQ(to_wkt(actual), to_wkt(expected));
+        checked++;
+        query.next();
+    }
+    EXPECT_EQ(checked, gpkg->get_size());
+}
+
+TEST_F(GeoPackage_Test, geopackage_concurrent_read_test)
+{
+    const auto serial = ngen::geopackage::read(this->path3, "divides", {}, {}, 1);
+    const auto concurrent = ngen::geopackage::read(this->path3, "divides", {}, {}, 3);
+    ASSERT_GT(serial->get_size(), 2);
+    ASSERT_EQ(serial->get_size(), concurrent->get_size());
+    EXPECT_EQ(serial->get_bounding_box(), concurrent->get_bounding_box());
+
+    for (int i = 0; i < serial->get_size(); i++) {
+        const auto& expected = serial->get_feature(i);
+        const auto& actual = concurrent->get_feature(i);
+        EXPECT_EQ(actual->get_id(), expected->get_id());
+        EXPECT_EQ(actual->get_bounding_box(), expected->get_bounding_box());
+        EXPECT_EQ(actual->get_property("toid").as_string(), expected->get_property("toid").as_string());
+        EXPECT_EQ(to_wkt(actual->geometry()), to_wkt(expected->geometry()));
+    }
+
+    const auto subset = ngen::geopackage::read(this->path, "test", { "Second" }, {}, 2);
+    ASSERT_EQ(1, subset->get_size());
+    EXPECT_EQ(subset->get_feature(0)->get_id(), "Second");
+}
+
+// Subsets are looked up by the index on the ID column when there is one,
+// and otherwise taken while scanning the layer; both should read the same
+// features, even for more ids than can be bound to one statement.
+TEST_F(GeoPackage_Test, geopackage_indexed_subset_test)
+{
+    char indexed_path[] = "/tmp/ngen_geopackage_test_XXXXXX";
+    const int fd = mkstemp(indexed_path);
+    ASSERT_NE(fd, -1);
+    close(fd);
+    {
+        std::ifstream source(this->path3, std::ios::binary);
+        std::ofstream copy(indexed_path, std::ios::binary | std::ios::trunc);
+        copy << source.rdbuf();
+    }
+    sqlite3* conn = nullptr;
+    ASSERT_EQ(sqlite3_open(indexed_path, &conn), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(conn, "CREATE INDEX divides_divide_id ON divides (divide_id)", nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(conn);
+
+    const auto all = ngen::geopackage::read(this->path3, "divides", {});
+    ASSERT_GT(all->get_size(), 2);
+    std::vector<std::string> ids;
+    for (int i = 0; i < 700; i++) {
+        ids.push_back("cat-missing-" + std::to_string(i));
+    }
+    ids.push_back(all->get_feature(0)->get_id());
+    ids.push_back(all->get_feature(2)->get_id());
+    ids.push_back(all->get_feature(0)->get_id());
+
+    const auto scanned = ngen::geopackage::read(this->path3, "divides", ids);
+    const auto indexed = ngen::geopackage::read(indexed_path, "divides", ids);
+    std::remove(indexed_path);
+
+    ASSERT_EQ(2, scanned->get_size());
+    ASSERT_EQ(2, indexed->get_size());
+    for (int i = 0; i < 2; i++) {
+        const auto& expected = scanned->get_feature(i);
+        const auto& actual = indexed->get_feature(expected->get_id());
+        ASSERT_TRUE(actual != nullptr);
+        EXPECT_EQ(actual->get_bounding_box(), expected->get_bounding_box());
+        EXPECT_EQ(actual->get_property("toid").as_string(), expected->get_property("toid").as_string());
+        EXPECT_EQ(to_wkt(actual->geometry()), to_wkt(expected->geometry()));
+    }
+}
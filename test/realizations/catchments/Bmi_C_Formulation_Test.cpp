@@ -18,11 +18,13 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include <iostream>
+#include <map>
 #include <vector>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include "FileChecker.h"
 #include "Formulation_Manager.hpp"
+#include "WrappedDataProvider.hpp"
 #include <boost/date_time.hpp>
 
 using ::testing::MatchesRegex;
@@ -65,6 +67,10 @@ protected:
         return formulation.get_model_type_name();
     }
 
+    static const std::vector<Bmi_Module_Formulation::input_binding>& get_friend_input_bindings(Bmi_C_Formulation& formulation) {
+        return formulation.input_bindings;
+    }
+
     static double get_friend_var_value_as_double(Bmi_C_Formulation& formulation, const std::string& var_name) {
         return formulation.get_var_value_as_double(0, var_name);
     }
@@ -125,7 +131,7 @@ protected:
 void Bmi_C_Formulation_Test::SetUp() {
     testing::Test::SetUp();
 
-#define EX_COUNT 2
+#define EX_COUNT 3
 
     forcing_dir_opts = {"./data/forcing/", "../data/forcing/", "../../data/forcing/"};
     bmi_init_cfg_dir_opts = {
@@ -171,6 +177,16 @@ void Bmi_C_Formulation_Test::SetUp() {
     registration_functions[1] = "register_bmi";
     uses_forcing_file[1] = false;
 
+    // Uses the extra inputs of other types and sizes
+    catchment_ids[2] = "cat-27";
+    model_type_name[2] = "test_bmi_c";
+    forcing_file[2] = find_file(forcing_dir_opts, "cat-27_2015-12-01 00_00_00_2015-12-30 23_00_00.csv");
+    lib_file[2] = find_file(lib_dir_opts, BMI_TEST_C_LOCAL_LIB_NAME);
+    init_config[2] = find_file(bmi_init_cfg_dir_opts, "test_bmi_c_config_2.txt");
+    main_output_variable[2] = "OUTPUT_VAR_1";
+    registration_functions[2] = "register_bmi";
+    uses_forcing_file[2] = false;
+
     std::string variables_with_rain_rate = "                \"output_variables\": [\"OUTPUT_VAR_2\",\n"
                                            "                    \"OUTPUT_VAR_1\"],\n";
 
@@ -192,6 +208,9 @@ void Bmi_C_Formulation_Test::SetUp() {
                          "                \"" + BMI_REALIZATION_CFG_PARAM_OPT__OUTPUT_PRECISION + "\": 6, "
                          "                \"" + BMI_REALIZATION_CFG_PARAM_OPT__VAR_STD_NAMES + "\": { "
                          "                      \"INPUT_VAR_2\": \"" + AORC_FIELD_NAME_TEMP_2M_AG + "\","
+                         "                      \"INPUT_VAR_3\": \"" + AORC_FIELD_NAME_TEMP_2M_AG + "\","
+                         "                      \"INPUT_VAR_4\": \"" + AORC_FIELD_NAME_PRECIP_RATE + "\","
+                         "                      \"INPUT_VAR_5\": \"" + AORC_FIELD_NAME_TEMP_2M_AG + "\","
                          "                      \"INPUT_VAR_1\": \"" + AORC_FIELD_NAME_PRECIP_RATE + "\""
                          "                },"
                          "                \"registration_function\": \"" + registration_functions[i] + "\","
@@ -244,6 +263,51 @@ TEST_F(Bmi_C_Formulation_Test, Initialize_1_a) {
     ASSERT_EQ(header_2, "OUTPUT_VAR_2,OUTPUT_VAR_1");
 }
 
+/** Test a formulation only reports being thread safe when configured as such. */
+TEST_F(Bmi_C_Formulation_Test, Initialize_2_a) {
+    int ex_index = 0;
+
+    Bmi_C_Formulation form_1(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    form_1.create_formulation(config_prop_ptree[ex_index]);
+    ASSERT_FALSE(form_1.is_thread_safe());
+
+    boost::property_tree::ptree thread_safe_tree = config_prop_ptree[ex_index];
+    thread_safe_tree.put(BMI_REALIZATION_CFG_PARAM_OPT__THREAD_SAFE, true);
+    Bmi_C_Formulation form_2(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    form_2.create_formulation(thread_safe_tree);
+    ASSERT_TRUE(form_2.is_thread_safe());
+}
+
+/** Test a formulation whose forcing provider calls into Python is never run concurrently, whatever its config. */
+TEST_F(Bmi_C_Formulation_Test, Initialize_2_b) {
+    int ex_index = 0;
+
+    // Stands in for a provider backed by a Python model, such as the Forcings Engine
+    class Python_Provider : public data_access::WrappedDataProvider {
+    public:
+        using WrappedDataProvider::WrappedDataProvider;
+        bool calls_python() const override { return true; }
+    };
+    CsvPerFeatureForcingProvider csv(*forcing_params_examples[ex_index]);
+    Python_Provider python(&csv);
+    ASSERT_FALSE(csv.calls_python());
+    ASSERT_TRUE(python.calls_python());
+
+    boost::property_tree::ptree thread_safe_tree = config_prop_ptree[ex_index];
+    thread_safe_tree.put(BMI_REALIZATION_CFG_PARAM_OPT__THREAD_SAFE, true);
+    Bmi_C_Formulation form_1(catchment_ids[ex_index], std::make_shared<data_access::WrappedDataProvider>(&csv), utils::StreamHandler());
+    form_1.create_formulation(thread_safe_tree);
+    ASSERT_FALSE(form_1.uses_python());
+    ASSERT_TRUE(form_1.is_thread_safe());
+
+    // Also when the provider is wrapped, as for nested modules
+    Bmi_C_Formulation form_2(catchment_ids[ex_index], std::make_shared<data_access::WrappedDataProvider>(&python), utils::StreamHandler());
+    form_2.create_formulation(thread_safe_tree);
+    ASSERT_TRUE(form_2.uses_python());
+    ASSERT_FALSE(form_2.is_thread_safe());
+    ASSERT_EQ(form_2.get_response(0, 3600), form_1.get_response(0, 3600));
+}
+
 /** Simple test of get response. */
 TEST_F(Bmi_C_Formulation_Test, GetResponse_0_a) {
     int ex_index = 0;
@@ -349,6 +413,112 @@ TEST_F(Bmi_C_Formulation_Test, GetOutputLineForTimestep_1_b) {
     EXPECT_THAT(output, MatchesRegex("580.799988,0.000001"));
 }
 
+/** Test each input is bound to its provider, with the number of values and the native type the model expects. */
+TEST_F(Bmi_C_Formulation_Test, SetInputs_0_a) {
+    int ex_index = 2;
+
+    Bmi_C_Formulation formulation(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+    formulation.get_response(0, 3600);
+
+    const auto& bindings = get_friend_input_bindings(formulation);
+    ASSERT_EQ(bindings.size(), 5);
+    std::map<std::string, int> binding_indices;
+    for (int i = 0; i < bindings.size(); ++i) {
+        binding_indices[bindings[i].bmi_name] = i;
+        // None are read from another module, so all are read through their provider
+        ASSERT_EQ(bindings[i].source, nullptr);
+    }
+    ASSERT_EQ(bindings[binding_indices.at("INPUT_VAR_1")].type, models::bmi::value_type::DOUBLE);
+    ASSERT_EQ(bindings[binding_indices.at("INPUT_VAR_3")].type, models::bmi::value_type::INT);
+    ASSERT_EQ(bindings[binding_indices.at("INPUT_VAR_3")].num_items, 1);
+    ASSERT_EQ(bindings[binding_indices.at("INPUT_VAR_5")].type, models::bmi::value_type::DOUBLE);
+    ASSERT_EQ(bindings[binding_indices.at("INPUT_VAR_5")].num_items, 3);
+}
+
+/** Test a forcing value is set into an input of a non-double type, converted as by a cast. */
+TEST_F(Bmi_C_Formulation_Test, SetInputs_0_b) {
+    int ex_index = 2;
+
+    Bmi_C_Formulation formulation(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    std::shared_ptr<models::bmi::Bmi_C_Adapter> model = get_friend_bmi_model(formulation);
+    for (int i = 0; i < 3; ++i) {
+        formulation.get_response(i, 3600);
+        // Both inputs get the temperature, in its own units, since it cannot be converted to those of either
+        double temperature = models::bmi::GetValue<double>(*model, "INPUT_VAR_2")[0];
+        ASSERT_GT(temperature, 200.0);
+        ASSERT_EQ(models::bmi::GetValue<int>(*model, "INPUT_VAR_3")[0], static_cast<int>(temperature));
+    }
+}
+
+/** Test a scalar forcing value is broadcast to every item of an array input. */
+TEST_F(Bmi_C_Formulation_Test, SetInputs_0_c) {
+    int ex_index = 2;
+
+    Bmi_C_Formulation formulation(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    std::shared_ptr<models::bmi::Bmi_C_Adapter> model = get_friend_bmi_model(formulation);
+    for (int i = 0; i < 3; ++i) {
+        formulation.get_response(i, 3600);
+        double temperature = models::bmi::GetValue<double>(*model, "INPUT_VAR_2")[0];
+        ASSERT_EQ(models::bmi::GetValue<double>(*model, "INPUT_VAR_5"), std::vector<double>(3, temperature));
+    }
+}
+
+/** Test a formulation restored from its saved state repeats the responses and output that followed the save. */
+TEST_F(Bmi_C_Formulation_Test, State_0_a) {
+    int ex_index = 1;
+
+    Bmi_C_Formulation formulation(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+    ASSERT_NO_THROW(formulation.check_state_support());
+
+    // Save shortly before the time step with non-zero rain rate, then continue past it
+    int saved_index = 540;
+    int continued_steps = 5;
+    for (int i = 0; i < saved_index; ++i)
+        formulation.get_response(i, 3600);
+    std::stringstream state;
+    formulation.write_state(state);
+
+    std::vector<double> responses;
+    std::vector<std::string> outputs;
+    for (int i = saved_index; i < saved_index + continued_steps; ++i) {
+        responses.push_back(formulation.get_response(i, 3600));
+        outputs.push_back(formulation.get_output_line_for_timestep(i, ","));
+    }
+
+    // Restore both the formulation that continued and a new one that has not run at all
+    Bmi_C_Formulation restarted(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    restarted.create_formulation(config_prop_ptree[ex_index]);
+    for (Bmi_C_Formulation* restored : {&formulation, &restarted}) {
+        std::stringstream saved(state.str());
+        restored->read_state(saved);
+        for (int i = 0; i < continued_steps; ++i) {
+            ASSERT_EQ(restored->get_response(saved_index + i, 3600), responses[i]);
+            ASSERT_EQ(restored->get_output_line_for_timestep(saved_index + i, ","), outputs[i]);
+        }
+    }
+}
+
+/** Test restoring a truncated state fails, rather than partially restoring the formulation. */
+TEST_F(Bmi_C_Formulation_Test, State_0_b) {
+    int ex_index = 0;
+
+    Bmi_C_Formulation formulation(catchment_ids[ex_index], std::make_shared<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+    formulation.get_response(0, 3600);
+    std::stringstream state;
+    formulation.write_state(state);
+
+    std::string bytes = state.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    ASSERT_THROW(formulation.read_state(truncated), std::runtime_error);
+}
+
 TEST_F(Bmi_C_Formulation_Test, determine_model_time_offset_0_a) {
     int ex_index = 0;
 
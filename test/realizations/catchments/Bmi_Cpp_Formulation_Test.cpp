@@ -251,6 +251,19 @@ TEST_F(Bmi_Cpp_Formulation_Test, GetResponse_0_a) {
     ASSERT_EQ(response, 00);
 }
 
+/** Test a formulation whose model lacks the serialization extension fails the check and cannot save its state. */
+TEST_F(Bmi_Cpp_Formulation_Test, State_0_a) {
+    int ex_index = 0;
+
+    Bmi_Cpp_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    ASSERT_THROW(formulation.check_state_support(), std::runtime_error);
+    std::stringstream state;
+    ASSERT_THROW(formulation.write_state(state), std::runtime_error);
+    ASSERT_EQ(state.str().size(), 0);
+}
+
 /** Test of get response after several iterations. */
 TEST_F(Bmi_Cpp_Formulation_Test, GetResponse_0_b) {
     int ex_index = 0;
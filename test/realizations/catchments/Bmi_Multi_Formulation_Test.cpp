@@ -19,6 +19,7 @@
 #include "CsvPerFeatureForcingProvider.hpp"
 #include "ConfigurationException.hpp"
 #include "FileChecker.h"
+#include "StateStream.hpp"
 
 #if NGEN_WITH_PYTHON
 #include "python/InterpreterUtil.hpp"
@@ -69,6 +70,23 @@ protected:
         return nested->get_var_value_as_double(0, var_name);
     }
 
+    template <class T>
+    static std::vector<T> get_friend_nested_model_values(const Bmi_Multi_Formulation& formulation, const int mod_index,
+                                                         const std::string& var_name) {
+        std::shared_ptr<Bmi_Module_Formulation> nested = std::static_pointer_cast<Bmi_Module_Formulation>(formulation.modules[mod_index]);
+        return models::bmi::GetValue<T>(*nested->get_bmi_model(), var_name);
+    }
+
+    static const Bmi_Module_Formulation::input_binding& get_friend_nested_input_binding(
+            const Bmi_Multi_Formulation& formulation, const int mod_index, const std::string& var_name) {
+        std::shared_ptr<Bmi_Module_Formulation> nested = std::static_pointer_cast<Bmi_Module_Formulation>(formulation.modules[mod_index]);
+        for (const auto& binding : nested->input_bindings) {
+            if (binding.bmi_name == var_name)
+                return binding;
+        }
+        throw std::runtime_error("No input binding for " + var_name + " of nested module " + std::to_string(mod_index));
+    }
+
     static std::string get_friend_catchment_id(Bmi_Multi_Formulation& formulation){
         return formulation.get_catchment_id();
     }
@@ -202,6 +220,8 @@ private:
     inline std::string buildNestedC(const int ex_index, const int nested_index) {
         std::string nested_index_str = std::to_string(nested_index);
         std::string input_var_alias = determineNestedInputAliasValue(ex_index, nested_index);
+        std::string extra_input_var_alias = determineNestedExtraInputAliasValue(ex_index, nested_index, "INPUT_VAR_3");
+        std::string extra_array_input_var_alias = determineNestedExtraInputAliasValue(ex_index, nested_index, "INPUT_VAR_5");
         return  "                        {\n"
                 "                            \"name\": \"" + std::string(BMI_C_TYPE) + "\",\n"
                 "                            \"params\": {\n"
@@ -216,10 +236,14 @@ private:
                 "                                \"registration_function\": \"" + nested_registration_function_lists[ex_index][nested_index] + "\",\n"
 
                 "                                \"variables_names_map\": {\n"
+                "                                    \"OUTPUT_VAR_3\": \"OUTPUT_VAR_3__" + nested_index_str + "\",\n"
                 "                                    \"OUTPUT_VAR_2\": \"OUTPUT_VAR_2__" + nested_index_str + "\",\n"
                 "                                    \"OUTPUT_VAR_1\": \"OUTPUT_VAR_1__" + nested_index_str + "\",\n"
                 "                                    \"INPUT_VAR_2\": \"" + CSDMS_STD_NAME_SURFACE_AIR_PRESSURE + "\",\n"
                 "                                    \"INPUT_VAR_1\": \"" + input_var_alias + "\",\n"
+                "                                    \"INPUT_VAR_3\": \"" + extra_input_var_alias + "\",\n"
+                "                                    \"INPUT_VAR_4\": \"" + extra_input_var_alias + "\",\n"
+                "                                    \"INPUT_VAR_5\": \"" + extra_array_input_var_alias + "\",\n"
                 "                                    \"GRID_VAR_1\": \""  + input_var_alias +"\"\n"
                 "                                },\n"
                 "                                \"uses_forcing_file\": " + (uses_forcing_file[ex_index] ? "true" : "false") + "\n"
@@ -314,6 +338,27 @@ private:
         }
     }
 
+    /**
+     * Determine the mapped alias of one of the extra inputs of the test C model, used by the examples that enable them.
+     *
+     * The extra inputs of the first module are read from forcings.  Those of later modules are read from the second
+     * output of the prior module, except that in the ninth example the array input is read from the prior module's
+     * array output, which has a different number of values.
+     *
+     * @param ex_index The index of the example config, corresponding to other index-specific saved values.
+     * @param nested_index The index of the particular module within the overall example config
+     * @param var_name The name of the extra input.
+     * @return The appropriate input alias value for the example config being generated.
+     */
+    inline std::string determineNestedExtraInputAliasValue(const int ex_index, const int nested_index,
+                                                           const std::string &var_name) {
+        if (nested_index == 0)
+            return AORC_FIELD_NAME_PRECIP_RATE;
+        if (ex_index == 8 && var_name == "INPUT_VAR_5")
+            return "OUTPUT_VAR_3__" + std::to_string(nested_index - 1);
+        return "OUTPUT_VAR_2__" + std::to_string(nested_index - 1);
+    }
+
     inline std::string buildExampleNestedModuleSubConfig(const int ex_index, const int nested_index) {
         std::string bmi_type = nested_module_lists[ex_index][nested_index];
         // Call right language-specific generator function for nested config
@@ -451,7 +496,7 @@ void Bmi_Multi_Formulation_Test::SetUp() {
 
     // Define this manually to set how many nested modules per example, and implicitly how many examples.
     // This means example_module_depth.size() example scenarios with example_module_depth[i] nested modules in each scenario.
-    example_module_depth = {2, 2, 2, 2, 2, 2};
+    example_module_depth = {2, 2, 2, 2, 2, 2, 2, 2, 2};
 
     // Initialize the members for holding required input and result test data for individual example scenarios
     setupExampleDataCollections();
@@ -491,6 +536,19 @@ void Bmi_Multi_Formulation_Test::SetUp() {
     // Cases 4 and 5 Specifically to test output_variables failure cases...
     initializeTestExample(4, "cat-27", {std::string(BMI_FORTRAN_TYPE), std::string(BMI_PYTHON_TYPE)}, { "bogus_variable" });
     initializeTestExample(5, "cat-27", {std::string(BMI_FORTRAN_TYPE), std::string(BMI_PYTHON_TYPE)}, { "OUTPUT_VAR_1" });
+
+    // Case 6 has only C modules, which can save and restore their state
+    initializeTestExample(6, "cat-27", {std::string(BMI_C_TYPE), std::string(BMI_C_TYPE)}, {});
+
+    // Cases 7 and 8 have C modules with extra inputs of other types, units, and sizes than the outputs providing them
+    initializeTestExample(7, "cat-27", {std::string(BMI_C_TYPE), std::string(BMI_C_TYPE)}, {});
+    initializeTestExample(8, "cat-27", {std::string(BMI_C_TYPE), std::string(BMI_C_TYPE)}, {});
+    for (int ex_index : {7, 8}) {
+        for (int j = 0; j < example_module_depth[ex_index]; ++j) {
+            nested_init_config_lists[ex_index][j] = testUtil.getBmiInitConfigFilePath(BMI_C_TYPE, 2);
+        }
+        buildExampleConfig(ex_index);
+    }
    
 }
 
@@ -856,6 +914,175 @@ TEST_F(Bmi_Multi_Formulation_Test, GetIdAndCatchmentId) {
     //ASSERT_EQ(formulation.get_catchment_id(), "id");
 }
 
+/**
+ * Test a formulation restored from its saved state repeats the responses and output of every nested module that
+ * followed the save.
+ */
+TEST_F(Bmi_Multi_Formulation_Test, State_0_a) {
+    int ex_index = 6;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+    ASSERT_NO_THROW(formulation.check_state_support());
+
+    int saved_index = 540;
+    int continued_steps = 5;
+    for (int i = 0; i < saved_index; ++i)
+        formulation.get_response(i, 3600);
+    std::stringstream state;
+    formulation.write_state(state);
+
+    std::vector<double> responses;
+    std::vector<std::string> outputs;
+    std::vector<double> nested_outputs;
+    for (int i = saved_index; i < saved_index + continued_steps; ++i) {
+        responses.push_back(formulation.get_response(i, 3600));
+        outputs.push_back(formulation.get_output_line_for_timestep(i, ","));
+        nested_outputs.push_back(get_friend_nested_var_value<Bmi_Module_Formulation>(formulation, 0, "OUTPUT_VAR_2"));
+    }
+
+    // Restore both the formulation that continued and a new one that has not run at all
+    Bmi_Multi_Formulation restarted(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    restarted.create_formulation(config_prop_ptree[ex_index]);
+    for (Bmi_Multi_Formulation* restored : {&formulation, &restarted}) {
+        std::stringstream saved(state.str());
+        restored->read_state(saved);
+        for (int i = 0; i < continued_steps; ++i) {
+            ASSERT_EQ(restored->get_response(saved_index + i, 3600), responses[i]);
+            ASSERT_EQ(restored->get_output_line_for_timestep(saved_index + i, ","), outputs[i]);
+            ASSERT_EQ(get_friend_nested_var_value<Bmi_Module_Formulation>(*restored, 0, "OUTPUT_VAR_2"), nested_outputs[i]);
+        }
+    }
+}
+
+/** Test a formulation with a nested module that cannot save its state fails the check before any state is written. */
+TEST_F(Bmi_Multi_Formulation_Test, State_0_b) {
+    int ex_index = 0;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+    ASSERT_THROW(formulation.check_state_support(), std::runtime_error);
+
+    std::stringstream state;
+    ASSERT_THROW(formulation.write_state(state), std::runtime_error);
+}
+
+/** Test a state saved for a different number of nested modules is rejected. */
+TEST_F(Bmi_Multi_Formulation_Test, State_0_c) {
+    int ex_index = 6;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    std::stringstream state;
+    utils::state::write<std::int64_t>(state, 0);
+    utils::state::write<std::uint64_t>(state, 3);
+    ASSERT_THROW(formulation.read_state(state), std::runtime_error);
+}
+
+/** Test an input read from an output of another module, of the same type and units, is copied as is. */
+TEST_F(Bmi_Multi_Formulation_Test, SetInputs_7_a) {
+    int ex_index = 7;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    for (int i = 0; i < 3; ++i) {
+        formulation.get_response(i, 3600);
+        ASSERT_EQ(get_friend_nested_model_values<double>(formulation, 1, "INPUT_VAR_1"),
+                  get_friend_nested_model_values<double>(formulation, 0, "OUTPUT_VAR_1"));
+    }
+
+    const auto& binding = get_friend_nested_input_binding(formulation, 1, "INPUT_VAR_1");
+    ASSERT_NE(binding.source, nullptr);
+    ASSERT_EQ(binding.source_name, "OUTPUT_VAR_1");
+    ASSERT_EQ(binding.conversion, nullptr);
+    ASSERT_TRUE(binding.source_buffer.empty());
+}
+
+/** Test an input read from an output of another module, of another type, is converted as by a cast. */
+TEST_F(Bmi_Multi_Formulation_Test, SetInputs_7_b) {
+    int ex_index = 7;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    for (int i = 0; i < 3; ++i) {
+        formulation.get_response(i, 3600);
+        double source_value = get_friend_nested_model_values<double>(formulation, 0, "OUTPUT_VAR_2")[0];
+        ASSERT_GT(source_value, 1.0);
+        ASSERT_EQ(get_friend_nested_model_values<int>(formulation, 1, "INPUT_VAR_3")[0], static_cast<int>(source_value));
+    }
+
+    const auto& binding = get_friend_nested_input_binding(formulation, 1, "INPUT_VAR_3");
+    ASSERT_NE(binding.source, nullptr);
+    ASSERT_EQ(binding.type, models::bmi::value_type::INT);
+    ASSERT_EQ(binding.source_type, models::bmi::value_type::DOUBLE);
+    ASSERT_EQ(binding.conversion, nullptr);
+    ASSERT_EQ(binding.source_buffer.size(), sizeof(double));
+}
+
+/** Test an input read from an output of another module, in other units, is converted to the input's units. */
+TEST_F(Bmi_Multi_Formulation_Test, SetInputs_7_c) {
+    int ex_index = 7;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    for (int i = 0; i < 3; ++i) {
+        formulation.get_response(i, 3600);
+        double source_value = get_friend_nested_model_values<double>(formulation, 0, "OUTPUT_VAR_2")[0];
+        ASSERT_DOUBLE_EQ(get_friend_nested_model_values<double>(formulation, 1, "INPUT_VAR_4")[0], source_value * 1000.0);
+    }
+
+    const auto& binding = get_friend_nested_input_binding(formulation, 1, "INPUT_VAR_4");
+    ASSERT_NE(binding.source, nullptr);
+    ASSERT_NE(binding.conversion, nullptr);
+    ASSERT_FALSE(binding.source_buffer.empty());
+}
+
+/**
+ * Test an input read from an output of another module with fewer values is read through the module as a provider,
+ * with its scalar value broadcast to every item of the input.
+ */
+TEST_F(Bmi_Multi_Formulation_Test, SetInputs_7_d) {
+    int ex_index = 7;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    for (int i = 0; i < 3; ++i) {
+        formulation.get_response(i, 3600);
+        double source_value = get_friend_nested_model_values<double>(formulation, 0, "OUTPUT_VAR_2")[0];
+        ASSERT_EQ(get_friend_nested_model_values<double>(formulation, 1, "INPUT_VAR_5"), std::vector<double>(3, source_value));
+        // The first module's array input is likewise broadcast from its scalar forcing
+        ASSERT_EQ(get_friend_nested_model_values<double>(formulation, 0, "INPUT_VAR_5"),
+                  std::vector<double>(3, get_friend_nested_model_values<double>(formulation, 0, "INPUT_VAR_1")[0]));
+    }
+
+    const auto& binding = get_friend_nested_input_binding(formulation, 1, "INPUT_VAR_5");
+    ASSERT_EQ(binding.source, nullptr);
+    ASSERT_EQ(binding.num_items, 3);
+}
+
+/** Test an array input read from an array output with a different number of values fails when it is set. */
+TEST_F(Bmi_Multi_Formulation_Test, SetInputs_8_a) {
+    int ex_index = 8;
+
+    Bmi_Multi_Formulation formulation(catchment_ids[ex_index], std::make_unique<CsvPerFeatureForcingProvider>(*forcing_params_examples[ex_index]), utils::StreamHandler());
+    formulation.create_formulation(config_prop_ptree[ex_index]);
+
+    try {
+        formulation.get_response(0, 3600);
+        FAIL() << "Expected setting an array input from an output with a different number of values to throw";
+    }
+    catch (const std::runtime_error& e) {
+        std::string message = e.what();
+        ASSERT_NE(message.find("Mismatch in item count for variable 'INPUT_VAR_5'"), std::string::npos);
+        ASSERT_NE(message.find("model expects 3, provider returned 2"), std::string::npos);
+    }
+}
+
 TEST_F(Bmi_Multi_Formulation_Test, GetAvailableVariableNames) {
     int ex_index = 1;
 
@@ -0,0 +1,181 @@
+#include <NGenConfig.h>
+
+#include "gtest/gtest.h"
+#include <cmath>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#if NGEN_WITH_NETCDF
+#include <netcdf>
+#endif
+
+#include "ColumnarOutputWriter.hpp"
+#include "NetCDFOutputWriter.hpp"
+
+//Keeps a copy of each write instead of storing it
+class RecordingWriter : public utils::ColumnarOutputWriter {
+    public:
+
+    struct write {
+        std::size_t table;
+        std::size_t first_time_index;
+        std::vector<double> times;
+        std::vector<std::vector<double>> values;
+    };
+
+    explicit RecordingWriter(std::size_t timesteps_per_write) : utils::ColumnarOutputWriter(timesteps_per_write) {}
+
+    const table_data& table(std::size_t t) const {
+        return get_table(t);
+    }
+
+    std::vector<std::size_t> defined;
+    std::vector<write> writes;
+
+    protected:
+
+    void define_table(std::size_t table) override {
+        defined.push_back(table);
+    }
+
+    void write_rows(std::size_t table) override {
+        const table_data& t = get_table(table);
+        write w{table, t.first_time_index, t.times, {}};
+        for (const auto& column : t.values) {
+            w.values.emplace_back(column.begin(), column.begin() + t.times.size() * t.feature_ids.size());
+        }
+        writes.push_back(std::move(w));
+    }
+};
+
+class ColumnarOutputWriterTest : public ::testing::Test {
+
+    protected:
+
+    ColumnarOutputWriterTest() {}
+
+    ~ColumnarOutputWriterTest() override {}
+
+    const std::vector<std::string> ids = {"cat-1", "cat-2", "cat-3"};
+};
+
+//Test a table's variables are the union of its features' variables
+TEST_F(ColumnarOutputWriterTest, TestTables)
+{
+    RecordingWriter writer(2);
+    std::size_t catchments = writer.add_table("catchments", ids, {{"a", "b"}, {"b", "c"}, {}});
+    std::size_t nexuses = writer.add_table("nexus", {"nex-1"}, {{"flow"}});
+
+    ASSERT_EQ(catchments, 0);
+    ASSERT_EQ(nexuses, 1);
+    EXPECT_EQ(writer.defined, std::vector<std::size_t>({0, 1}));
+    EXPECT_EQ(writer.table(catchments).variables, std::vector<std::string>({"a", "b", "c"}));
+    EXPECT_EQ(writer.table(catchments).feature_columns[1], std::vector<std::size_t>({1, 2}));
+    EXPECT_EQ(writer.table(nexuses).variables, std::vector<std::string>({"flow"}));
+    EXPECT_THROW(writer.add_table("bad", ids, {{"a"}}), std::invalid_argument);
+}
+
+//Test values are written a block of time steps at a time, with NaN where a feature has no value
+TEST_F(ColumnarOutputWriterTest, TestBuffering)
+{
+    RecordingWriter writer(2);
+    std::size_t table = writer.add_table("catchments", ids, {{"a", "b"}, {"b"}, {"a"}});
+
+    for (int t = 0; t < 3; ++t) {
+        writer.set_values(table, 0, {10.0 + t, 20.0 + t});
+        writer.set_values(table, 1, {30.0 + t});
+        if (t != 1) {
+            writer.set_values(table, 2, {40.0 + t});
+        }
+        writer.end_time_step(table, 3600 * t);
+        EXPECT_EQ(writer.writes.size(), t == 0 ? 0 : 1);
+    }
+    writer.flush();
+    writer.flush();
+    ASSERT_EQ(writer.writes.size(), 2);
+
+    const RecordingWriter::write& first = writer.writes[0];
+    EXPECT_EQ(first.first_time_index, 0);
+    EXPECT_EQ(first.times, std::vector<double>({0, 3600}));
+    // a: [time][feature]
+    EXPECT_EQ(first.values[0][0], 10.0);
+    EXPECT_TRUE(std::isnan(first.values[0][1]));
+    EXPECT_EQ(first.values[0][2], 40.0);
+    EXPECT_EQ(first.values[0][3], 11.0);
+    EXPECT_TRUE(std::isnan(first.values[0][5]));
+    // b
+    EXPECT_EQ(first.values[1][3], 21.0);
+    EXPECT_EQ(first.values[1][4], 31.0);
+
+    const RecordingWriter::write& second = writer.writes[1];
+    EXPECT_EQ(second.first_time_index, 2);
+    EXPECT_EQ(second.times, std::vector<double>({7200}));
+    ASSERT_EQ(second.values[0].size(), 3);
+    EXPECT_EQ(second.values[0][0], 12.0);
+    EXPECT_TRUE(std::isnan(second.values[0][1]));
+    EXPECT_EQ(second.values[0][2], 42.0);
+}
+
+//Test the default number of buffered time steps is bounded by the size of a table
+TEST_F(ColumnarOutputWriterTest, TestDefaultTimesteps)
+{
+    RecordingWriter writer(0);
+    std::size_t small = writer.add_table("small", ids, {{"a"}, {"a"}, {"a"}});
+    const std::vector<std::string> large_ids(1 << 20, "cat");
+    std::size_t large = writer.add_table("large", large_ids, std::vector<std::vector<std::string>>(large_ids.size(), {"a", "b"}));
+
+    EXPECT_EQ(writer.get_timesteps_per_write(small), 24);
+    EXPECT_EQ(writer.get_timesteps_per_write(large), 2);
+}
+
+//Test a NetCDF file holds a group per table, with the values of each time step
+TEST_F(ColumnarOutputWriterTest, TestNetCDF)
+{
+#if !NGEN_WITH_NETCDF
+    GTEST_SKIP() << "NetCDF is not available";
+#else
+    std::string path = testing::TempDir();
+    if (path.back() != '/') {
+        path.append("/");
+    }
+    path.append("ngen__ColumnarOutputWriter_Test.nc");
+
+    {
+        utils::NetCDFOutputWriter writer(path, 2, 1);
+        std::size_t table = writer.add_table("surface layer", ids, {{"Total Discharge"}, {"Total Discharge", "b"}, {"b"}});
+        for (int t = 0; t < 3; ++t) {
+            writer.set_values(table, 0, {1.0 + t});
+            writer.set_values(table, 1, {2.0 + t, 3.0 + t});
+            writer.set_values(table, 2, {4.0 + t});
+            writer.end_time_step(table, 3600 * t);
+        }
+    }
+
+    netCDF::NcFile file(path, netCDF::NcFile::read);
+    netCDF::NcGroup group = file.getGroup("surface_layer");
+    ASSERT_FALSE(group.isNull());
+    EXPECT_EQ(group.getDim("time").getSize(), 3);
+    EXPECT_EQ(group.getDim("feature").getSize(), 3);
+
+    std::vector<double> times(3);
+    group.getVar("time").getVar(times.data());
+    EXPECT_EQ(times, std::vector<double>({0, 3600, 7200}));
+
+    std::vector<double> discharge(9);
+    group.getVar("Total_Discharge").getVar(discharge.data());
+    EXPECT_EQ(discharge[0], 1.0);
+    EXPECT_EQ(discharge[1], 2.0);
+    EXPECT_TRUE(std::isnan(discharge[2]));
+    EXPECT_EQ(discharge[6], 3.0);
+    EXPECT_EQ(discharge[7], 4.0);
+
+    std::vector<double> b(9);
+    group.getVar("b").getVar(b.data());
+    EXPECT_TRUE(std::isnan(b[0]));
+    EXPECT_EQ(b[8], 6.0);
+
+    file.close();
+    unlink(path.c_str());
+#endif
+}
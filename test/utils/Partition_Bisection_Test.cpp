@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "core/Partition_Bisection.hpp"
+
+class PartitionBisectionTest : public ::testing::Test {
+
+    protected:
+
+    PartitionBisectionTest() {}
+
+    ~PartitionBisectionTest() override {}
+
+    using edge_list = std::vector<std::pair<std::size_t, std::size_t>>;
+
+    static edge_list path(std::size_t n)
+    {
+        edge_list edges;
+        for (std::size_t i = 1; i < n; ++i) {
+            edges.emplace_back(i - 1, i);
+        }
+        return edges;
+    }
+
+    static void expect_balanced(const std::vector<double>& weights, double limit)
+    {
+        for (double w : weights) {
+            EXPECT_LE(w, limit);
+        }
+    }
+};
+
+//Test a path is cut into contiguous, equally weighted pieces
+TEST_F(PartitionBisectionTest, TestPath)
+{
+    Partition_Bisection partitioner(std::vector<double>(1000, 1.0), path(1000));
+    std::vector<int> parts = partitioner.partition(4);
+
+    ASSERT_EQ(parts.size(), 1000);
+    EXPECT_EQ(partitioner.edge_cut(parts), 3.0);
+    expect_balanced(partitioner.partition_weights(parts, 4), 250 * 1.03);
+}
+
+//Test a (river network like) binary tree is balanced with few cut edges
+TEST_F(PartitionBisectionTest, TestTree)
+{
+    const std::size_t n = (1 << 12) - 1;
+    edge_list edges;
+    for (std::size_t i = 1; i < n; ++i) {
+        edges.emplace_back(i, (i - 1) / 2);
+    }
+    Partition_Bisection partitioner(std::vector<double>(n, 1.0), edges);
+    std::vector<int> parts = partitioner.partition(8);
+
+    std::vector<double> weights = partitioner.partition_weights(parts, 8);
+    expect_balanced(weights, n / 8.0 * 1.03);
+    EXPECT_GT(*std::min_element(weights.begin(), weights.end()), 0.0);
+    // cutting off 7 subtrees of 511 vertices each is optimal
+    EXPECT_LE(partitioner.edge_cut(parts), 3 * 7);
+}
+
+//Test partitions are balanced by vertex weight rather than count
+TEST_F(PartitionBisectionTest, TestWeighted)
+{
+    std::vector<double> vertex_weights(1100, 1.0);
+    std::fill(vertex_weights.begin(), vertex_weights.begin() + 100, 10.0);
+    Partition_Bisection partitioner(vertex_weights, path(1100));
+    std::vector<int> parts = partitioner.partition(2);
+
+    expect_balanced(partitioner.partition_weights(parts, 2), 1000 * 1.03);
+    EXPECT_EQ(partitioner.edge_cut(parts), 1.0);
+    // a single cut near the end of the heavy vertices, rather than halfway along the path
+    EXPECT_GE(std::count(parts.begin(), parts.end(), parts[0]), 95);
+    EXPECT_LE(std::count(parts.begin(), parts.end(), parts[0]), 105);
+}
+
+//Test every partition gets a vertex, even when a vertex outweighs all others, and without edges
+TEST_F(PartitionBisectionTest, TestUnbalanceable)
+{
+    Partition_Bisection heavy({100.0, 1.0, 1.0, 1.0}, path(4));
+    std::vector<int> parts = heavy.partition(2);
+    EXPECT_NE(parts[0], parts[1]);
+    EXPECT_EQ(parts[1], parts[2]);
+    EXPECT_EQ(parts[2], parts[3]);
+
+    Partition_Bisection isolated(std::vector<double>(10, 1.0), edge_list());
+    parts = isolated.partition(5);
+    for (double w : isolated.partition_weights(parts, 5)) {
+        EXPECT_EQ(w, 2.0);
+    }
+
+    parts = isolated.partition(10);
+    std::sort(parts.begin(), parts.end());
+    EXPECT_EQ(std::unique(parts.begin(), parts.end()) - parts.begin(), 10);
+}
+
+//Test invalid graphs and partition counts are rejected
+TEST_F(PartitionBisectionTest, TestInvalid)
+{
+    EXPECT_THROW(Partition_Bisection({1.0, -1.0}, path(2)), std::invalid_argument);
+    EXPECT_THROW(Partition_Bisection({1.0, 1.0}, {{0, 2}}), std::out_of_range);
+
+    Partition_Bisection partitioner({1.0, 1.0}, path(2));
+    EXPECT_THROW(partitioner.partition(0), std::invalid_argument);
+    EXPECT_THROW(partitioner.partition(3), std::invalid_argument);
+    EXPECT_EQ(partitioner.partition(1), std::vector<int>({0, 0}));
+}
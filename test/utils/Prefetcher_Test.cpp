@@ -0,0 +1,152 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Prefetcher.hpp"
+
+using utils::Prefetcher;
+
+class PrefetcherTest : public ::testing::Test {
+
+    protected:
+
+    PrefetcherTest() : gate(gate_promise.get_future().share()) {}
+
+    ~PrefetcherTest() override {}
+
+    //Loader doubling its key, which waits for open_gate() and records the order of loads
+    int load(int key) {
+        gate.wait();
+        {
+            std::lock_guard<std::mutex> lock(loads_mutex);
+            loads.push_back(key);
+        }
+        if (key < 0) {
+            throw std::invalid_argument("negative key");
+        }
+        return key * 2;
+    }
+
+    void open_gate() {
+        gate_promise.set_value();
+    }
+
+    std::vector<int> get_loads() {
+        std::lock_guard<std::mutex> lock(loads_mutex);
+        return loads;
+    }
+
+    std::promise<void> gate_promise;
+    std::shared_future<void> gate;
+    std::mutex loads_mutex;
+    std::vector<int> loads;
+};
+
+//Test requested and unrequested keys are loaded, each once
+TEST_F(PrefetcherTest, TestTake)
+{
+    open_gate();
+    Prefetcher<int, int> prefetcher([this](const int& key) { return load(key); }, 4);
+
+    EXPECT_TRUE(prefetcher.request(1));
+    EXPECT_TRUE(prefetcher.request(2));
+    EXPECT_TRUE(prefetcher.request(2));
+    EXPECT_EQ(prefetcher.take(1), 2);
+    EXPECT_EQ(prefetcher.take(2), 4);
+    EXPECT_EQ(prefetcher.take(7), 14);
+    EXPECT_EQ(prefetcher.size(), 0);
+    EXPECT_EQ(get_loads(), std::vector<int>({1, 2, 7}));
+}
+
+//Test requests beyond the capacity are refused until values are taken
+TEST_F(PrefetcherTest, TestCapacity)
+{
+    Prefetcher<int, int> prefetcher([this](const int& key) { return load(key); }, 2);
+
+    EXPECT_TRUE(prefetcher.request(1));
+    EXPECT_TRUE(prefetcher.request(2));
+    EXPECT_FALSE(prefetcher.request(3));
+    EXPECT_EQ(prefetcher.size(), 2);
+
+    open_gate();
+    EXPECT_EQ(prefetcher.take(1), 2);
+    EXPECT_TRUE(prefetcher.request(3));
+    EXPECT_EQ(prefetcher.take(3), 6);
+    EXPECT_EQ(prefetcher.take(2), 4);
+}
+
+//Test a key that is needed is loaded ahead of the queued ones
+TEST_F(PrefetcherTest, TestPriority)
+{
+    Prefetcher<int, int> prefetcher([this](const int& key) { return load(key); }, 4);
+
+    prefetcher.request(1);
+    prefetcher.request(2);
+    prefetcher.request(3);
+    std::thread consumer([&]() { EXPECT_EQ(prefetcher.take(3), 6); });
+    // Give the consumer time to wait for its key
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    open_gate();
+    consumer.join();
+    EXPECT_EQ(prefetcher.take(2), 4);
+    EXPECT_EQ(prefetcher.take(1), 2);
+
+    // The worker may have started loading 1 before 3 was needed
+    std::vector<int> order = get_loads();
+    ASSERT_EQ(order.size(), 3);
+    EXPECT_EQ(order.back(), 2);
+}
+
+//Test discarded keys are not loaded, or are dropped once loaded
+TEST_F(PrefetcherTest, TestDiscard)
+{
+    Prefetcher<int, int> prefetcher([this](const int& key) { return load(key); }, 4);
+
+    for (int key = 1; key <= 4; ++key) {
+        prefetcher.request(key);
+    }
+    prefetcher.discard_if([](const int& key) { return key % 2 == 0; });
+    EXPECT_EQ(prefetcher.size(), 2);
+
+    open_gate();
+    EXPECT_EQ(prefetcher.take(3), 6);
+    EXPECT_EQ(prefetcher.take(1), 2);
+    EXPECT_EQ(prefetcher.size(), 0);
+    for (int key : get_loads()) {
+        EXPECT_EQ(key % 2, 1);
+    }
+}
+
+//Test loader errors are raised by take, without stopping the prefetcher
+TEST_F(PrefetcherTest, TestError)
+{
+    open_gate();
+    Prefetcher<int, int> prefetcher([this](const int& key) { return load(key); }, 4);
+
+    prefetcher.request(-1);
+    prefetcher.request(5);
+    EXPECT_THROW(prefetcher.take(-1), std::invalid_argument);
+    EXPECT_EQ(prefetcher.take(5), 10);
+}
+
+//Test a key being taken is kept when discarded, whether it is queued or loading
+TEST_F(PrefetcherTest, TestDiscardWhileTaking)
+{
+    Prefetcher<int, int> prefetcher([this](const int& key) { return load(key); }, 4);
+
+    prefetcher.request(1);
+    prefetcher.request(2);
+    std::thread consumer([&]() {
+        EXPECT_EQ(prefetcher.take(1), 2);
+        EXPECT_EQ(prefetcher.take(2), 4);
+    });
+    // Give the consumer time to wait for its first key
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    prefetcher.discard_if([](const int& key) { return true; });
+    open_gate();
+    consumer.join();
+    EXPECT_EQ(prefetcher.size(), 0);
+}
@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Profiler.hpp"
+
+using utils::Profiler;
+using utils::Profile_Scope;
+
+class ProfilerTest : public ::testing::Test {
+
+    protected:
+
+    ProfilerTest() {}
+
+    ~ProfilerTest() override {}
+
+    void SetUp() override {
+        Profiler::reset();
+    }
+
+    void TearDown() override {
+        Profiler::reset();
+    }
+
+    const std::string cat_1 = "cat-1";
+    const std::string cat_2 = "cat-2";
+};
+
+//Test nothing is recorded unless profiling is enabled
+TEST_F(ProfilerTest, TestDisabled)
+{
+    ASSERT_FALSE(Profiler::is_enabled());
+    {
+        Profile_Scope scope(Profiler::CATCHMENT, cat_1);
+    }
+    EXPECT_TRUE(Profiler::summary(Profiler::CATCHMENT).empty());
+
+    Profiler::enable(false);
+    Profiler::disable();
+    {
+        Profile_Scope scope(Profiler::CATCHMENT, cat_1);
+    }
+    EXPECT_TRUE(Profiler::summary(Profiler::CATCHMENT).empty());
+}
+
+//Test intervals are totaled per category and name
+TEST_F(ProfilerTest, TestSummary)
+{
+    Profiler::enable(false);
+    auto t0 = Profiler::clock::now();
+    Profiler::record(Profiler::CATCHMENT, cat_1, t0, t0 + std::chrono::milliseconds(10));
+    Profiler::record(Profiler::CATCHMENT, cat_1, t0, t0 + std::chrono::milliseconds(30));
+    Profiler::record(Profiler::CATCHMENT, cat_2, t0, t0 + std::chrono::milliseconds(5));
+    Profiler::record(Profiler::BMI_UPDATE, cat_1, t0, t0 + std::chrono::milliseconds(1));
+
+    auto catchments = Profiler::summary(Profiler::CATCHMENT);
+    ASSERT_EQ(catchments.size(), 2);
+    EXPECT_EQ(catchments[cat_1].calls, 2);
+    EXPECT_NEAR(catchments[cat_1].total_seconds, 0.040, 1e-9);
+    EXPECT_NEAR(catchments[cat_1].max_seconds, 0.030, 1e-9);
+    EXPECT_EQ(catchments[cat_2].calls, 1);
+    EXPECT_EQ(Profiler::summary(Profiler::BMI_UPDATE).size(), 1);
+    EXPECT_TRUE(Profiler::summary(Profiler::FORCING).empty());
+
+    std::stringstream times;
+    Profiler::write_catchment_times(times);
+    EXPECT_EQ(times.str(), "id,seconds\ncat-1,0.04\ncat-2,0.005\n");
+
+    std::stringstream summary;
+    Profiler::write_summary(summary);
+    std::string line;
+    std::getline(summary, line);
+    EXPECT_EQ(line, "category,name,calls,total_seconds,mean_seconds,max_seconds");
+    std::getline(summary, line);
+    EXPECT_EQ(line, "catchment,cat-1,2,0.04,0.02,0.03");
+}
+
+//Test totals from several threads are merged
+TEST_F(ProfilerTest, TestThreads)
+{
+    Profiler::enable(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([this]() {
+            for (int j = 0; j < 100; ++j) {
+                Profile_Scope scope(Profiler::CATCHMENT, cat_1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(Profiler::summary(Profiler::CATCHMENT)[cat_1].calls, 400);
+}
+
+//Test intervals are written as complete events of a Chrome trace
+TEST_F(ProfilerTest, TestTrace)
+{
+    Profiler::enable(true);
+    const std::string quoted = "a \"quoted\" name";
+    {
+        Profile_Scope scope(Profiler::FORCING, quoted);
+    }
+    {
+        Profile_Scope scope(Profiler::MPI_WAIT, cat_1);
+    }
+
+    std::stringstream trace;
+    Profiler::write_trace(trace, 3);
+    std::string json = trace.str();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+    EXPECT_NE(json.find("{\"name\":\"a \\\"quoted\\\" name\",\"cat\":\"forcing\",\"ph\":\"X\",\"pid\":3,\"tid\":0,"),
+              std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"cat-1\",\"cat\":\"mpi_wait\",\"ph\":\"X\",\"pid\":3,\"tid\":0,"), std::string::npos);
+    EXPECT_NE(json.find("\"dropped_events\":0}}"), std::string::npos);
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "StateStream.hpp"
+
+class StateStreamTest : public ::testing::Test {
+
+    protected:
+
+    StateStreamTest() {}
+
+    ~StateStreamTest() override {}
+
+    //The written state, truncated to its first size bytes
+    std::stringstream truncated(std::size_t size) {
+        std::string bytes = out.str();
+        return std::stringstream(bytes.substr(0, size));
+    }
+
+    std::stringstream out;
+};
+
+//Test values, strings and byte blocks are read back as written, in order
+TEST_F(StateStreamTest, TestRoundTrip) {
+    std::vector<char> bytes = {'a', '\0', 'b'};
+    utils::state::write<std::int64_t>(out, -42);
+    utils::state::write_string(out, "cat-52");
+    utils::state::write_bytes(out, bytes);
+    utils::state::write<double>(out, 1.5);
+    utils::state::write_string(out, "");
+
+    std::stringstream in(out.str());
+    ASSERT_EQ(utils::state::read<std::int64_t>(in), -42);
+    ASSERT_EQ(utils::state::read_string(in), "cat-52");
+    ASSERT_EQ(utils::state::read_bytes(in), bytes);
+    ASSERT_EQ(utils::state::read<double>(in), 1.5);
+    ASSERT_EQ(utils::state::read_string(in), "");
+}
+
+//Test strings and byte blocks are prefixed with their 64-bit length
+TEST_F(StateStreamTest, TestLengthPrefix) {
+    utils::state::write_string(out, "nex-1");
+    ASSERT_EQ(out.str().size(), sizeof(std::uint64_t) + 5);
+
+    std::stringstream in(out.str());
+    ASSERT_EQ(utils::state::read<std::uint64_t>(in), 5u);
+}
+
+//Test reading past the end of a truncated state throws, rather than returning partial values
+TEST_F(StateStreamTest, TestTruncated) {
+    utils::state::write<std::int64_t>(out, 7);
+    utils::state::write_string(out, "cat-67");
+
+    std::stringstream value = truncated(sizeof(std::int64_t) - 1);
+    ASSERT_THROW(utils::state::read<std::int64_t>(value), std::runtime_error);
+
+    std::stringstream length = truncated(sizeof(std::int64_t) + 3);
+    utils::state::read<std::int64_t>(length);
+    ASSERT_THROW(utils::state::read_string(length), std::runtime_error);
+
+    std::stringstream content = truncated(out.str().size() - 1);
+    utils::state::read<std::int64_t>(content);
+    ASSERT_THROW(utils::state::read_string(content), std::runtime_error);
+}
+
+//Test a length larger than the remaining state throws, without allocating the whole length up front
+TEST_F(StateStreamTest, TestOversizedLength) {
+    utils::state::write<std::uint64_t>(out, std::uint64_t(1) << 60);
+    out << "short";
+
+    std::stringstream in(out.str());
+    ASSERT_THROW(utils::state::read_bytes(in), std::runtime_error);
+}
+
+//Test an expected string is consumed when it matches, and otherwise named in the error
+TEST_F(StateStreamTest, TestExpectString) {
+    utils::state::write_string(out, "surface");
+    utils::state::write_string(out, "cat-52");
+
+    std::stringstream in(out.str());
+    utils::state::expect_string(in, "surface", "layer");
+    try {
+        utils::state::expect_string(in, "cat-67", "catchment");
+        FAIL() << "Expected a mismatched catchment to throw";
+    }
+    catch (const std::runtime_error& e) {
+        std::string message = e.what();
+        ASSERT_NE(message.find("catchment 'cat-52'"), std::string::npos);
+        ASSERT_NE(message.find("'cat-67'"), std::string::npos);
+    }
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "ThreadPool.hpp"
+
+using utils::ThreadPool;
+
+class ThreadPoolTest : public ::testing::Test {
+
+    protected:
+
+    ThreadPoolTest() {}
+
+    ~ThreadPoolTest() override {}
+
+};
+
+//Test every index of the range is visited exactly once
+TEST_F(ThreadPoolTest, TestParallelForVisitsAll)
+{
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.size(), 4);
+
+    std::vector<int> visits(1000, 0);
+    pool.parallel_for(visits.size(), [&](std::size_t i) { visits[i] += 1; });
+
+    for (std::size_t i = 0; i < visits.size(); ++i) {
+        ASSERT_EQ(visits[i], 1) << "index " << i;
+    }
+}
+
+//Test the pool can be reused for many consecutive loops, as is done once per time step
+TEST_F(ThreadPoolTest, TestParallelForReuse)
+{
+    ThreadPool pool(3);
+    std::vector<double> values(257);
+
+    for (int step = 0; step < 200; ++step) {
+        pool.parallel_for(values.size(), [&](std::size_t i) { values[i] = step * 1.0 + i; }, 8);
+        double sum = std::accumulate(values.begin(), values.end(), 0.0);
+        ASSERT_DOUBLE_EQ(sum, step * 257.0 + (256.0 * 257.0) / 2.0);
+    }
+}
+
+//Test a single thread pool executes serially and in order
+TEST_F(ThreadPoolTest, TestSerialFallback)
+{
+    ThreadPool pool(0);
+    ASSERT_EQ(pool.size(), 1);
+
+    std::vector<std::size_t> order;
+    pool.parallel_for(10, [&](std::size_t i) { order.push_back(i); });
+
+    ASSERT_EQ(order.size(), 10);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+//Test an exception thrown by the loop body is rethrown on the calling thread and the pool stays usable
+TEST_F(ThreadPoolTest, TestExceptionPropagation)
+{
+    ThreadPool pool(4);
+
+    ASSERT_THROW(
+        pool.parallel_for(100, [](std::size_t i) {
+            if (i == 42) throw std::runtime_error("failed at 42");
+        }),
+        std::runtime_error
+    );
+
+    std::atomic<std::size_t> count{0};
+    pool.parallel_for(100, [&](std::size_t) { ++count; });
+    ASSERT_EQ(count.load(), 100);
+}